@@ -0,0 +1,230 @@
+/*
+  bench/allocations.h - counts the heap allocations of a benchmark and
+  tells how they would fragment the heap of the ESP8266. It replaces the
+  global operator new and delete, so a program includes it from one file
+  only.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <new>
+
+
+// Allocations
+// Counters since the start of the program, take a copy before the code to
+// measure and subtract it after.
+struct Allocations
+{
+    uint64_t count = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;
+
+    static Allocations &total()
+    {
+        static Allocations value;
+        return value;
+    }
+
+    static Allocations since(const Allocations &start)
+    {
+        Allocations delta;
+        delta.count = total().count - start.count;
+        delta.frees = total().frees - start.frees;
+        delta.bytes = total().bytes - start.bytes;
+        return delta;
+    }
+};
+
+
+// HeapModel
+// The allocator of the host packs blocks by size and hides fragmentation.
+// While a HeapModel is alive, every block allocated is also placed first
+// fit in a heap of the given size, with the 8 bytes granularity and the
+// header of the ESP8266 one, and removed when it is freed. fragmentation()
+// is computed like ESP.getHeapFragmentation(): 100 - 100 * largest free
+// block / free bytes.
+class HeapModel
+{
+private:
+    static const size_t BLOCK = 8;
+
+    // offset -> size, of the free areas and of the blocks in use
+    std::map<size_t, size_t> _free;
+    std::map<void *, std::pair<size_t, size_t>> _used;
+    size_t _failures = 0;
+    bool _busy = false;
+
+    static HeapModel *&current()
+    {
+        static HeapModel *model = nullptr;
+        return model;
+    }
+
+    void place(void *p, size_t size)
+    {
+        size = (size + 4 + BLOCK - 1) / BLOCK * BLOCK;
+        for (auto it = _free.begin(); it != _free.end(); ++it) {
+            if (it->second >= size) {
+                size_t offset = it->first;
+                size_t left = it->second - size;
+                _free.erase(it);
+                if (left) {
+                    _free[offset + size] = left;
+                }
+                _used[p] = std::make_pair(offset, size);
+                return;
+            }
+        }
+        _failures++;
+    }
+
+    void remove(void *p)
+    {
+        auto used = _used.find(p);
+        if (used == _used.end()) {
+            return;
+        }
+        size_t offset = used->second.first;
+        size_t size = used->second.second;
+        _used.erase(used);
+        auto next = _free.lower_bound(offset);
+        if (next != _free.end() && next->first == offset + size) {
+            size += next->second;
+            next = _free.erase(next);
+        }
+        if (next != _free.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset) {
+                previous->second += size;
+                return;
+            }
+        }
+        _free[offset] = size;
+    }
+
+public:
+    explicit HeapModel(size_t size)
+    {
+        _free[0] = size;
+        current() = this;
+    }
+
+    ~HeapModel()
+    {
+        current() = nullptr;
+    }
+
+    HeapModel(const HeapModel &) = delete;
+    HeapModel &operator=(const HeapModel &) = delete;
+
+    // the model allocates too, these are not counted
+    static bool isBusy()
+    {
+        return current() && current()->_busy;
+    }
+
+    static void allocated(void *p, size_t size)
+    {
+        HeapModel *model = current();
+        if (model && !model->_busy) {
+            model->_busy = true;
+            model->place(p, size);
+            model->_busy = false;
+        }
+    }
+
+    static void freed(void *p)
+    {
+        HeapModel *model = current();
+        if (model && !model->_busy) {
+            model->_busy = true;
+            model->remove(p);
+            model->_busy = false;
+        }
+    }
+
+    size_t freeBytes() const
+    {
+        size_t total = 0;
+        for (const auto &area : _free) {
+            total += area.second;
+        }
+        return total;
+    }
+
+    size_t maxFreeBlock() const
+    {
+        size_t largest = 0;
+        for (const auto &area : _free) {
+            largest = std::max(largest, area.second);
+        }
+        return largest;
+    }
+
+    double fragmentation() const
+    {
+        size_t total = freeBytes();
+        return total ? 100.0 - 100.0 * maxFreeBlock() / total : 0;
+    }
+
+    // blocks that did not fit
+    size_t failures() const
+    {
+        return _failures;
+    }
+};
+
+void *operator new(size_t size)
+{
+    if (!HeapModel::isBusy()) {
+        Allocations::total().count++;
+        Allocations::total().bytes += size;
+    }
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    HeapModel::allocated(p, size);
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    if (p) {
+        if (!HeapModel::isBusy()) {
+            Allocations::total().frees++;
+        }
+        HeapModel::freed(p);
+        free(p);
+    }
+}
+
+void operator delete[](void *p) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    operator delete(p);
+}
@@ -0,0 +1,72 @@
+/*
+  bench/bench.h - timing and reporting helpers of the host benchmarks.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+// Bench
+// Every measure is printed as one "name value unit" line so runs can be
+// diffed. With --quick on the command line, the iteration counts are
+// divided by 1000: ctest uses it to check that the benchmarks still run.
+class Bench
+{
+private:
+    static bool &quick()
+    {
+        static bool value = false;
+        return value;
+    }
+
+public:
+    static void init(int argc, char **argv)
+    {
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "--quick") == 0) {
+                quick() = true;
+            }
+        }
+    }
+
+    static uint64_t iterations(uint64_t n)
+    {
+        if (!quick()) {
+            return n;
+        }
+        return n >= 1000 ? n / 1000 : 1;
+    }
+
+    static double now()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void report(const char *name, double value, const char *unit)
+    {
+        printf("%-48s %14.2f %s\n", name, value, unit);
+        fflush(stdout);
+    }
+
+    // runs body(i) for i in [0, n) and reports the rate, returns seconds
+    template<typename F>
+    static double run(const char *name, uint64_t n, F body)
+    {
+        double start = now();
+        for (uint64_t i = 0; i < n; i++) {
+            body(i);
+        }
+        double elapsed = now() - start;
+        report(name, elapsed > 0 ? n / elapsed : 0, "ops/s");
+        return elapsed;
+    }
+};
@@ -0,0 +1,236 @@
+/*
+  bench/bench_bridge.cpp - macro benchmark of the TCP to serial bridge: a
+  client thread talks to the simulated printer through the data port while
+  the main thread runs the bridge like the sketch loop does. G-code is
+  also streamed by megabytes while each pass of that loop is timed.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+#include "netclient.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <PrinterSimulator.h>
+
+#include "bridge.h"
+#include "config.h"
+#include "webinterface.h"
+
+// passes of the bridge loop: the longest one, in seconds, and how many
+// took more than a millisecond, the time the sketch gives the UART
+struct LoopTimes
+{
+    double worst = 0;
+    uint32_t over1ms = 0;
+};
+
+// runs the bridge until body, on its own thread, returns
+template<typename F>
+static LoopTimes withClient(uint16_t port, F body)
+{
+    std::atomic<bool> done(false);
+    std::thread client([&]() {
+        NetClient net;
+        if (net.connect(port)) {
+            body(net);
+        }
+        done = true;
+    });
+    LoopTimes times;
+    while (!done) {
+        double start = Bench::now();
+        BRIDGE::processFromTCP2Serial();
+        BRIDGE::processFromSerial2TCP();
+        double elapsed = Bench::now() - start;
+        times.worst = std::max(times.worst, elapsed);
+        times.over1ms += elapsed > 1e-3;
+    }
+    client.join();
+    return times;
+}
+
+// round trip of M105, from the client to the printer and back
+static int latency(const char *name, uint16_t port, unsigned long baud)
+{
+    PrinterSimulator printer(PrinterSimulator::Firmware_Marlin);
+    Serial.attach(&printer);
+    Serial.begin(baud);
+
+    const int requests = (int)Bench::iterations(2000);
+    std::vector<double> latencies;
+    int failures = 0;
+    double elapsed = 0;
+    withClient(port, [&](NetClient &net) {
+        std::string line;
+        double start = Bench::now();
+        for (int i = 0; i < requests; i++) {
+            double t0 = Bench::now();
+            net.send("M105\n");
+            if (!net.readUntil("\n", line, 2000) || line.compare(0, 4, "ok T") != 0) {
+                failures++;
+            }
+            latencies.push_back(Bench::now() - t0);
+        }
+        elapsed = Bench::now() - start;
+    });
+    Serial.attach(nullptr);
+
+    if (latencies.empty()) {
+        return requests;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::string prefix = std::string("bridge.m105.") + name;
+    Bench::report((prefix + ".requests").c_str(), requests / elapsed, "req/s");
+    Bench::report((prefix + ".latency_p50").c_str(), latencies[latencies.size() / 2] * 1e6, "us");
+    Bench::report((prefix + ".latency_p99").c_str(), latencies[latencies.size() * 99 / 100] * 1e6, "us");
+    Bench::report((prefix + ".failures").c_str(), failures, "req");
+    return failures;
+}
+
+// M20 of a full SD card, what the printer sends in one burst; it needs
+// a baud rate, all at once it would overflow the receive buffer
+static int listing(const char *name, uint16_t port, unsigned long baud)
+{
+    PrinterSimulator printer(PrinterSimulator::Firmware_Marlin);
+    for (int i = 0; i < 200; i++) {
+        printer.setFile("/gcodes/part_" + std::to_string(i) + "_layer_height_0.2mm.gco", "G28\n");
+    }
+    Serial.attach(&printer);
+    Serial.begin(baud);
+
+    const int listings = (int)Bench::iterations(20);
+    size_t bytes = 0;
+    int failures = 0;
+    double elapsed = 0;
+    withClient(port, [&](NetClient &net) {
+        std::string text;
+        double start = Bench::now();
+        for (int i = 0; i < listings; i++) {
+            net.send("M20\n");
+            if (!net.readUntil("End file list\n", text, 2000)) {
+                failures++;
+                continue;
+            }
+            bytes += text.size();
+            if (!net.readUntil("ok\n", text, 2000)) {
+                failures++;
+            }
+            bytes += text.size();
+        }
+        elapsed = Bench::now() - start;
+    });
+    Serial.attach(nullptr);
+
+    std::string prefix = std::string("bridge.m20.") + name;
+    Bench::report((prefix + ".throughput").c_str(), elapsed > 0 ? bytes / elapsed / 1e3 : 0, "KB/s");
+    // share of the serial line the bridge keeps busy
+    Bench::report((prefix + ".wire_usage").c_str(), elapsed > 0 ? 100.0 * bytes * 10 / (baud * elapsed) : 0, "%");
+    Bench::report((prefix + ".failures").c_str(), failures, "req");
+    return failures;
+}
+
+// G-code streamed like host software does it: lines are sent as long as
+// the ones not acknowledged yet fit the receive buffer of the printer.
+// Moves take no time, the wire and the bridge are what is measured.
+static int streaming(const char *name, uint16_t port, unsigned long baud, size_t total)
+{
+    PrinterSimulator::Options options;
+    options.commandTime = 0;
+    options.moveTime = 0;
+    PrinterSimulator printer(PrinterSimulator::Firmware_Marlin, options);
+    Serial.attach(&printer);
+    Serial.begin(baud);
+
+    std::vector<std::string> gcode;
+    for (int i = 0; i < 1000; i++) {
+        char line[64];
+        snprintf(line, sizeof(line), "G1 X%d.%03d Y%d.%03d E%d.%05d F1800\n", i % 200, i * 7 % 1000,
+                 i * 3 % 200, i * 11 % 1000, i / 100, i * 13 % 100000);
+        gcode.push_back(line);
+    }
+    size_t sent = 0;
+    size_t lines = 0;
+    int failures = 0;
+    double elapsed = 0;
+    LoopTimes loop = withClient(port, [&](NetClient &net) {
+        std::deque<size_t> pending;
+        size_t pendingBytes = 0;
+        std::string answer;
+        std::string batch;
+        double start = Bench::now();
+        while (sent < total || !pending.empty()) {
+            batch.clear();
+            while (sent < total) {
+                const std::string &line = gcode[lines % gcode.size()];
+                if (pendingBytes + line.size() >= options.rxBufferSize) {
+                    break;
+                }
+                batch += line;
+                pending.push_back(line.size());
+                pendingBytes += line.size();
+                sent += line.size();
+                lines++;
+            }
+            if (!batch.empty()) {
+                net.send(batch);
+            }
+            if (!net.readUntil("\n", answer, 2000)) {
+                failures++;
+                break;
+            }
+            if (answer.compare(0, 2, "ok") == 0 && !pending.empty()) {
+                pendingBytes -= pending.front();
+                pending.pop_front();
+            }
+        }
+        elapsed = Bench::now() - start;
+    });
+    Serial.attach(nullptr);
+
+    std::string prefix = std::string("bridge.stream.") + name;
+    Bench::report((prefix + ".bytes").c_str(), sent, "bytes");
+    Bench::report((prefix + ".throughput").c_str(), elapsed > 0 ? sent / elapsed / 1e3 : 0, "KB/s");
+    Bench::report((prefix + ".lines").c_str(), elapsed > 0 ? lines / elapsed : 0, "lines/s");
+    // the longest the sketch loop spent in the bridge at once; on the host
+    // it includes the simulated printer and the scheduler
+    Bench::report((prefix + ".worst_loop").c_str(), loop.worst * 1e6, "us");
+    Bench::report((prefix + ".loops_over_1ms").c_str(), loop.over1ms, "loops");
+    Bench::report((prefix + ".lost").c_str(), printer.stats().rxOverruns + printer.stats().boardOverruns, "bytes");
+    Bench::report((prefix + ".failures").c_str(), failures, "");
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    CONFIG::SetFirmwareTarget(MARLIN);
+    WiFi.mode(WIFI_STA);
+    uint16_t port = NetClient::freePort();
+    data_server = new WiFiServer(port);
+    data_server->begin();
+    data_server->setNoDelay(true);
+    web_interface = new WEBINTERFACE_CLASS(NetClient::freePort());
+
+    int failures = 0;
+    // without baud rate the wire costs nothing, what remains is the bridge
+    failures += latency("unpaced", port, 0);
+    failures += latency("115200", port, 115200);
+    failures += latency("250000", port, 250000);
+    failures += listing("115200", port, 115200);
+    failures += listing("250000", port, 250000);
+    failures += streaming("unpaced", port, 0, Bench::iterations(8 * 1024 * 1024));
+    failures += streaming("250000", port, 250000, Bench::iterations(1024 * 1024));
+    return failures ? 1 : 0;
+}
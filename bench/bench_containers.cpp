@@ -0,0 +1,203 @@
+/*
+  bench/bench_containers.cpp - micro benchmark of the fixed capacity
+  containers: logins and logouts in the session table of the web
+  interface, and the small vectors of the command handlers, against the
+  heap based structures they replaced.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+#include "allocations.h"
+
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "containers.h"
+#include "webinterface.h"
+
+// sessions in the pool, linked in an intrusive list
+class PoolSessions
+{
+private:
+    ObjectPool<auth_ip, MAX_AUTH_IP> _pool;
+    IntrusiveList<auth_ip> _list;
+
+public:
+    ~PoolSessions()
+    {
+        while (auth_ip *session = _list.pop()) {
+            _pool.release(session);
+        }
+    }
+
+    auth_ip *add()
+    {
+        auth_ip *item = _pool.acquire();
+        if (item) {
+            _list.push(item);
+        }
+        return item;
+    }
+
+    bool clear(IPAddress ip)
+    {
+        auth_ip *previous = nullptr;
+        for (auth_ip *current = _list.first(); current; previous = current, current = current->_next) {
+            if (current->ip == ip) {
+                _list.unlink(previous, current);
+                _pool.release(current);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auth_ip *get(IPAddress ip)
+    {
+        for (auth_ip *current = _list.first(); current; current = current->_next) {
+            if (current->ip == ip) {
+                return current;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// one new auth_ip per login, deleted at logout
+class HeapSessions
+{
+private:
+    auth_ip *_head = nullptr;
+    size_t _size = 0;
+
+public:
+    ~HeapSessions()
+    {
+        while (_head) {
+            auth_ip *next = _head->_next;
+            delete _head;
+            _head = next;
+        }
+    }
+
+    auth_ip *add()
+    {
+        if (_size >= MAX_AUTH_IP) {
+            return nullptr;
+        }
+        auth_ip *item = new auth_ip;
+        item->_next = _head;
+        _head = item;
+        _size++;
+        return item;
+    }
+
+    bool clear(IPAddress ip)
+    {
+        auth_ip *previous = nullptr;
+        for (auth_ip *current = _head; current; previous = current, current = current->_next) {
+            if (current->ip == ip) {
+                (previous ? previous->_next : _head) = current->_next;
+                delete current;
+                _size--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auth_ip *get(IPAddress ip)
+    {
+        for (auth_ip *current = _head; current; current = current->_next) {
+            if (current->ip == ip) {
+                return current;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// browsers of a few hosts log in, send requests and log out
+template<typename Sessions>
+static void sessions(const char *name, uint64_t count)
+{
+    std::string prefix = std::string("containers.sessions.") + name;
+    std::string label = prefix + ".login_request_logout";
+    Sessions table;
+    uint32_t found = 0;
+    Allocations start = Allocations::total();
+    Bench::run(label.c_str(), count, [&](uint64_t i) {
+        IPAddress ip(192, 168, 0, i % MAX_AUTH_IP);
+        auth_ip *session = table.add();
+        if (session) {
+            session->ip = ip;
+            session->last_time = i;
+        }
+        for (int r = 0; r < 4; r++) {
+            found += table.get(IPAddress(192, 168, 0, (i + r) % MAX_AUTH_IP)) != nullptr;
+        }
+        if (i % 3 == 0) {
+            table.clear(IPAddress(192, 168, 0, (i * 7) % MAX_AUTH_IP));
+        }
+    });
+    Allocations used = Allocations::since(start);
+    Bench::report((prefix + ".allocations_per_login").c_str(), (double)used.count / count, "allocs");
+    Bench::report((prefix + ".lookups_found").c_str(), 100.0 * found / (count * 4), "%");
+}
+
+// what the [ESP998] handler gathers before answering
+struct Source
+{
+    const char *name;
+    int pos;
+};
+
+static void vectors(uint64_t count)
+{
+    uint64_t total = 0;
+    std::string label = "containers.static_vector.fill_erase";
+    Allocations start = Allocations::total();
+    Bench::run(label.c_str(), count, [&](uint64_t i) {
+        StaticVector<Source, 3> sources;
+        sources.push({"INFO", (int)(i & 7)});
+        sources.push({"ERROR", (int)(i & 3)});
+        sources.push({"STATUS", (int)(i & 1)});
+        sources.erase(i % 3);
+        for (Source &s : sources) {
+            total += s.pos;
+        }
+    });
+    Bench::report("containers.static_vector.allocations_per_fill", (double)Allocations::since(start).count / count, "allocs");
+
+    label = "containers.std_vector.fill_erase";
+    start = Allocations::total();
+    Bench::run(label.c_str(), count, [&](uint64_t i) {
+        std::vector<Source> sources;
+        sources.push_back({"INFO", (int)(i & 7)});
+        sources.push_back({"ERROR", (int)(i & 3)});
+        sources.push_back({"STATUS", (int)(i & 1)});
+        sources.erase(sources.begin() + i % 3);
+        for (Source &s : sources) {
+            total += s.pos;
+        }
+    });
+    Bench::report("containers.std_vector.allocations_per_fill", (double)Allocations::since(start).count / count, "allocs");
+    if (total == 0) {
+        Bench::report("containers.vectors.empty", 1, "");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    uint64_t count = Bench::iterations(1000000);
+    sessions<PoolSessions>("pool", count);
+    sessions<HeapSessions>("heap", count);
+    vectors(count);
+    return 0;
+}
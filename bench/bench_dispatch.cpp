@@ -0,0 +1,146 @@
+/*
+  bench/bench_dispatch.cpp - micro benchmark of the route lookup of the web
+  server: the uris the web UI requests, the routes of WEBINTERFACE_CLASS
+  among them and static files that none of them takes, go through
+  _findHandler() and its binary search on the uri hash, then through the
+  walk of the handler list, every canHandle() in registration order, that
+  it replaced.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+#include "allocations.h"
+
+#include <string>
+#include <vector>
+
+#include <ESP8266WebServer.h>
+#include <FS.h>
+#include "detail/RequestHandlersImpl.h"
+
+// the routes of WEBINTERFACE_CLASS with every feature on, in its order
+static const char *const routes[] = {
+    "/",
+    "/command",
+    "/command_silent",
+    "/upload_serial",
+    "/files",
+    "/updatefw",
+    "/login",
+    "/STATUS",
+    "/events",
+    "/ws",
+    "/description.xml",
+    "/generate_204",
+    "/gconnectivitycheck.gstatic.com",
+    "/fwlink/",
+};
+static const size_t ROUTE_COUNT = sizeof(routes) / sizeof(routes[0]);
+
+static void handler() {}
+
+// Dispatcher
+// The server with its route lookup in reach, and the same routes in a
+// list walked the way every request was dispatched before.
+class Dispatcher : public ESP8266WebServer
+{
+private:
+    std::vector<RequestHandler *> _list;
+
+public:
+    Dispatcher() : ESP8266WebServer(80)
+    {
+        for (const char *uri : routes) {
+            on(uri, HTTP_ANY, handler, handler);
+            _list.push_back(new FunctionRequestHandler(handler, handler, uri, HTTP_ANY));
+        }
+    }
+
+    ~Dispatcher()
+    {
+        for (RequestHandler *handler : _list) {
+            delete handler;
+        }
+    }
+
+    RequestHandler *binary(HTTPMethod method, const String &uri)
+    {
+        return _findHandler(method, uri);
+    }
+
+    RequestHandler *linear(HTTPMethod method, const String &uri)
+    {
+        for (RequestHandler *handler : _list) {
+            if (handler->canHandle(method, uri)) {
+                return handler;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// index of the route a handler takes, ROUTE_COUNT for none
+static size_t routeOf(RequestHandler *handler)
+{
+    for (size_t i = 0; handler && i < ROUTE_COUNT; i++) {
+        if (handler->canHandle(HTTP_GET, routes[i])) {
+            return i;
+        }
+    }
+    return ROUTE_COUNT;
+}
+
+static bool measure(const char *name, Dispatcher &dispatcher, const std::vector<String> &uris, uint64_t count)
+{
+    // both lookups agree before they are timed
+    bool ok = true;
+    for (const String &uri : uris) {
+        ok = routeOf(dispatcher.binary(HTTP_GET, uri)) == routeOf(dispatcher.linear(HTTP_GET, uri)) && ok;
+    }
+
+    std::string prefix = std::string("dispatch.") + name;
+    uint64_t found = 0;
+    Allocations start = Allocations::total();
+    double elapsed = Bench::run((prefix + ".binary").c_str(), count, [&](uint64_t i) {
+        found += dispatcher.binary(HTTP_GET, uris[i % uris.size()]) != nullptr;
+    });
+    Allocations used = Allocations::since(start);
+    Bench::report((prefix + ".binary.ns_per_lookup").c_str(), 1e9 * elapsed / count, "ns");
+    Bench::report((prefix + ".binary.allocations_per_lookup").c_str(), (double)used.count / count, "allocs");
+
+    start = Allocations::total();
+    double linear = Bench::run((prefix + ".linear").c_str(), count, [&](uint64_t i) {
+        found += dispatcher.linear(HTTP_GET, uris[i % uris.size()]) != nullptr;
+    });
+    used = Allocations::since(start);
+    Bench::report((prefix + ".linear.ns_per_lookup").c_str(), 1e9 * linear / count, "ns");
+    Bench::report((prefix + ".linear.allocations_per_lookup").c_str(), (double)used.count / count, "allocs");
+    Bench::report((prefix + ".binary_speedup").c_str(), elapsed > 0 ? linear / elapsed : 0, "x");
+    Bench::report((prefix + ".routed").c_str(), count ? 50.0 * found / count : 0, "%");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    Dispatcher dispatcher;
+    uint64_t count = Bench::iterations(1000000);
+
+    // the polling of the web UI, then the routes alike
+    std::vector<String> polling = { "/command", "/command", "/command", "/files", "/upload_serial", "/" };
+    std::vector<String> every;
+    for (const char *uri : routes) {
+        every.push_back(uri);
+    }
+    // files of the web UI, no route takes them and they go to onNotFound()
+    std::vector<String> statics = { "/index.html", "/favicon.ico", "/js/app.js", "/css/style.css", "/404.htm" };
+
+    bool ok = measure("polling", dispatcher, polling, count);
+    ok = measure("every_route", dispatcher, every, count) && ok;
+    ok = measure("static_files", dispatcher, statics, count) && ok;
+    return ok ? 0 : 1;
+}
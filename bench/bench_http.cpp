@@ -0,0 +1,93 @@
+/*
+  bench/bench_http.cpp - macro benchmark of the web server: a client thread
+  sends GET requests over loopback while the main thread runs handleClient()
+  like the sketch loop does, over one keep-alive connection and then with a
+  new connection for each request.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+#include "netclient.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ESP8266WebServer.h>
+
+
+// GET requests from a client thread, over one keep-alive connection or
+// over a new connection each time
+static int requests(uint16_t port, ESP8266WebServer &server, bool keepAlive)
+{
+    const int count = (int)Bench::iterations(500);
+    std::atomic<bool> done(false);
+    std::vector<double> latencies;
+    int failures = 0;
+    double elapsed = 0;
+    std::thread client([&]() {
+        NetClient net;
+        std::string body;
+        if (!net.connect(port)) {
+            failures = count;
+            done = true;
+            return;
+        }
+        double start = Bench::now();
+        for (int i = 0; i < count; i++) {
+            const char *uri = (i % 4 == 3) ? "/data" : "/ping";
+            double t0 = Bench::now();
+            net.send(std::string("GET ") + uri + " HTTP/1.1\r\nHost: esp3d\r\n" +
+                     (keepAlive ? "" : "Connection: close\r\n") + "\r\n");
+            // the answer to "Connection: close" says so and reconnects
+            if (net.readResponse(body, 2000, port) != 200) {
+                failures++;
+                // the server dropped the connection, start a new one
+                net.connect(port);
+            }
+            latencies.push_back(Bench::now() - t0);
+        }
+        elapsed = Bench::now() - start;
+        done = true;
+    });
+    while (!done) {
+        server.handleClient();
+    }
+    client.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    std::string prefix = keepAlive ? "http.keepalive" : "http.close";
+    Bench::report((prefix + ".requests").c_str(), count / elapsed, "req/s");
+    Bench::report((prefix + ".latency_p50").c_str(), latencies[latencies.size() / 2] * 1e6, "us");
+    Bench::report((prefix + ".latency_p99").c_str(), latencies[latencies.size() * 99 / 100] * 1e6, "us");
+    Bench::report((prefix + ".failures").c_str(), failures, "req");
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    uint16_t port = NetClient::freePort();
+    ESP8266WebServer server(port);
+    String payload;
+    for (int i = 0; i < 64; i++) {
+        payload += "0123456789abcdef";
+    }
+    server.on("/ping", HTTP_GET, [&server]() {
+        server.send(200, "text/plain", "pong");
+    });
+    server.on("/data", HTTP_GET, [&server, &payload]() {
+        server.send(200, "application/octet-stream", payload);
+    });
+    server.begin();
+
+    int failures = requests(port, server, true);
+    failures += requests(port, server, false);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+/*
+  bench/bench_jsonwriter.cpp - micro benchmark of the JSON answers: the
+  SPIFFS file list of handleFileList() written by JSONWriter in chunks,
+  against the String it was built in before and sent at once. The answers
+  are timed without a client, the writes go nowhere, then both are fetched
+  over loopback and must be the same JSON. Objects nested deeper than
+  JSONWriter::MaxDepth must be left out and the answer stay balanced.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+#include "allocations.h"
+#include "netclient.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include "config.h"
+#include "jsonwriter.h"
+#include "webinterface.h"
+
+static uint16_t webPort;
+
+struct FileEntry {
+    String name;
+    String size;
+};
+
+static std::vector<FileEntry> files;
+
+static void listFiles(size_t count)
+{
+    files.clear();
+    for (size_t i = 0; i < count; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "model_%04u.gcode", (unsigned)i);
+        files.push_back({ name, CONFIG::formatBytes(1024 * (i * 37 % 5000) + i) });
+    }
+}
+
+static void writerAnswer()
+{
+    JSONWriter json;
+    json.beginObject();
+    json.beginArray("files");
+    for (const FileEntry &file : files) {
+        json.beginObject();
+        json.member("name", file.name);
+        json.member("size", file.size);
+        json.endObject();
+    }
+    json.endArray();
+    json.member("path", "/");
+    json.member("status", "Ok");
+    json.endObject();
+    json.end();
+}
+
+// as handleFileList() did before JSONWriter
+static void stringAnswer()
+{
+    String jsonfile = "{\"files\":[";
+    for (size_t i = 0; i < files.size(); i++) {
+        if (i > 0) {
+            jsonfile += ",";
+        }
+        jsonfile += "{\"name\":\"";
+        jsonfile += files[i].name;
+        jsonfile += "\",\"size\":\"";
+        jsonfile += files[i].size;
+        jsonfile += "\"}";
+    }
+    jsonfile += "],\"path\":\"/\",\"status\":\"Ok\"}";
+    web_interface->web_server.sendHeader("Cache-Control", "no-cache");
+    web_interface->web_server.send(200, "application/json", jsonfile);
+}
+
+// 40 arrays inside each other with an item in each
+static void deepAnswer()
+{
+    JSONWriter json;
+    json.beginObject();
+    for (int i = 0; i < 40; i++) {
+        json.beginArray(i ? NULL : "deep");
+        json.memberRaw(NULL, "1");
+    }
+    for (int i = 0; i < 40; i++) {
+        json.endArray();
+    }
+    json.member("status", "Ok");
+    json.endObject();
+    json.end();
+}
+
+static void measure(size_t count, uint64_t answers)
+{
+    answers = std::max(answers, (uint64_t)1);
+    listFiles(count);
+    std::string prefix = "jsonwriter.files_" + std::to_string(count);
+    Allocations start = Allocations::total();
+    double elapsed = Bench::run((prefix + ".writer").c_str(), answers, [](uint64_t) {
+        writerAnswer();
+    });
+    Allocations used = Allocations::since(start);
+    Bench::report((prefix + ".writer.us_per_answer").c_str(), 1e6 * elapsed / answers, "us");
+    Bench::report((prefix + ".writer.allocations_per_answer").c_str(), (double)used.count / answers, "allocs");
+    Bench::report((prefix + ".writer.bytes_per_answer").c_str(), (double)used.bytes / answers, "bytes");
+
+    start = Allocations::total();
+    double string = Bench::run((prefix + ".string").c_str(), answers, [](uint64_t) {
+        stringAnswer();
+    });
+    used = Allocations::since(start);
+    Bench::report((prefix + ".string.us_per_answer").c_str(), 1e6 * string / answers, "us");
+    Bench::report((prefix + ".string.allocations_per_answer").c_str(), (double)used.count / answers, "allocs");
+    Bench::report((prefix + ".string.bytes_per_answer").c_str(), (double)used.bytes / answers, "bytes");
+    Bench::report((prefix + ".writer_speedup").c_str(), elapsed > 0 ? string / elapsed : 0, "x");
+}
+
+// the body of a chunked answer, or of one with a Content-Length
+static bool fetch(NetClient &net, const char *uri, std::string &body)
+{
+    std::string head;
+    body.clear();
+    if (!net.send(std::string("GET ") + uri + " HTTP/1.1\r\nHost: esp3d\r\n\r\n") ||
+        !net.readUntil("\r\n\r\n", head, 2000)) {
+        return false;
+    }
+    size_t pos = head.find("Content-Length: ");
+    if (pos != std::string::npos) {
+        return net.readBytes(strtoul(head.c_str() + pos + 16, nullptr, 10), body, 2000);
+    }
+    for (;;) {
+        std::string line;
+        std::string chunk;
+        if (!net.readUntil("\r\n", line, 2000)) {
+            return false;
+        }
+        size_t size = strtoul(line.c_str(), nullptr, 16);
+        if (!net.readBytes(size + 2, chunk, 2000)) {
+            return false;
+        }
+        if (size == 0) {
+            return true;
+        }
+        body.append(chunk, 0, size);
+    }
+}
+
+static int checks()
+{
+    listFiles(300);
+    web_interface->web_server.on("/writer", HTTP_GET, writerAnswer);
+    web_interface->web_server.on("/string", HTTP_GET, stringAnswer);
+    web_interface->web_server.on("/deep", HTTP_GET, deepAnswer);
+    web_interface->web_server.begin();
+
+    std::string writer, string, deep;
+    std::atomic<bool> done(false);
+    bool fetched = false;
+    std::thread client([&]() {
+        NetClient net;
+        fetched = net.connect(webPort) && fetch(net, "/writer", writer) && fetch(net, "/string", string) &&
+                  fetch(net, "/deep", deep);
+        done = true;
+    });
+    while (!done) {
+        web_interface->web_server.handleClient();
+    }
+    client.join();
+
+    // the object takes a level, the arrays the others
+    std::string expected = "{\"deep\":[1";
+    for (int i = 2; i < JSONWriter::MaxDepth; i++) {
+        expected += ",[1";
+    }
+    expected += std::string(JSONWriter::MaxDepth - 1, ']') + ",\"status\":\"Ok\"}";
+    int failures = !fetched;
+    failures += writer.empty() || writer != string;
+    failures += deep != expected;
+    Bench::report("jsonwriter.checks.failures", failures, "");
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    WiFi.mode(WIFI_STA);
+    webPort = NetClient::freePort();
+    web_interface = new WEBINTERFACE_CLASS(webPort);
+
+    measure(10, Bench::iterations(20000));
+    measure(100, Bench::iterations(2000));
+    measure(1000, Bench::iterations(200));
+    return checks() ? 1 : 0;
+}
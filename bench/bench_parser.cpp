@@ -0,0 +1,124 @@
+/*
+  bench/bench_parser.cpp - micro benchmark and fuzz harness of the request
+  parser: typical requests of the web UI go through _requestReady() and
+  _parseRequest() straight from a slot buffer, without network, then the
+  same requests damaged at random. The heap allocations of each request
+  are counted, the parser should make none: headers and arguments point
+  into the slot. The malloc() of a body larger than the slot is not seen,
+  it would need a client to read from.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+#include "allocations.h"
+
+#include <string>
+#include <vector>
+
+#include <ESP8266WebServer.h>
+
+// Parser
+// The server with its parsing steps in reach. The client is never
+// connected, bodies that are not in the buffer are read as missing.
+class Parser : public ESP8266WebServer
+{
+private:
+    HTTPClientSlot _slot;
+    WiFiClient _client;
+
+public:
+    Parser() : ESP8266WebServer(80)
+    {
+        const char *headers[] = { "Cookie", "If-None-Match" };
+        collectHeaders(headers, 2);
+    }
+
+    // false when the request is incomplete or refused
+    bool parse(const std::string &request)
+    {
+        size_t len = std::min(request.size(), (size_t)HTTP_HEAD_BUFLEN - 1);
+        memcpy(_slot.buf, request.data(), len);
+        _slot.received = len;
+        size_t headLen = _requestReady(_slot);
+        if (!headLen) {
+            return false;
+        }
+        return _parseRequest(_client, _slot.buf, headLen, _slot.received);
+    }
+};
+
+// what the web UI sends
+static const std::vector<std::string> corpus = {
+    "GET / HTTP/1.1\r\nHost: esp3d.local\r\nConnection: keep-alive\r\nAccept-Encoding: gzip, deflate\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\nAccept: text/html\r\n\r\n",
+    "GET /command?plain=M105&PAGEID=0 HTTP/1.1\r\nHost: esp3d.local\r\nCookie: ESPSESSIONID=0123456789ABCDEF\r\n\r\n",
+    "GET /files?path=%2Fgcodes%2F&action=list&filename=&PAGEID=0 HTTP/1.1\r\nHost: esp3d.local\r\n\r\n",
+    "GET /index.html.gz HTTP/1.1\r\nHost: esp3d.local\r\nIf-None-Match: \"0a1b2c3d\"\r\nRange: bytes=0-1023\r\n\r\n",
+    "POST /login HTTP/1.1\r\nHost: esp3d.local\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+    "Content-Length: 40\r\n\r\nUSER=admin&PASSWORD=admin&SUBMIT=yes&x=1",
+    "POST /command HTTP/1.1\r\nHost: esp3d.local\r\nContent-Type: text/plain\r\nContent-Length: 24\r\n\r\n"
+    "[ESP401]P=129 T=B V=10\r\n",
+};
+
+// one byte changed, the head cut short, a line doubled or a CRLF added
+static std::string damage(const std::string &request, uint32_t &seed)
+{
+    seed = seed * 1103515245 + 12345;
+    uint32_t r = seed >> 8;
+    std::string text = request;
+    size_t pos = r % text.size();
+    switch ((seed >> 4) & 3) {
+    case 0:
+        text[pos] = (char)(r >> 12);
+        break;
+    case 1:
+        text.resize(pos);
+        break;
+    case 2: {
+        size_t eol = text.find("\r\n", pos);
+        if (eol != std::string::npos) {
+            text.insert(eol, text.substr(pos, eol - pos));
+        }
+        break;
+    }
+    default:
+        text.insert(pos, "\r\n");
+        break;
+    }
+    return text;
+}
+
+static void measure(const char *name, Parser &parser, const std::vector<std::string> &requests, uint64_t count)
+{
+    std::string prefix = std::string("parser.") + name;
+    uint64_t parsed = 0;
+    Allocations start = Allocations::total();
+    double elapsed = Bench::run(prefix.c_str(), count, [&](uint64_t i) {
+        parsed += parser.parse(requests[i % requests.size()]);
+    });
+    Allocations used = Allocations::since(start);
+    Bench::report((prefix + ".ns_per_request").c_str(), 1e9 * elapsed / count, "ns");
+    Bench::report((prefix + ".parsed").c_str(), 100.0 * parsed / count, "%");
+    Bench::report((prefix + ".allocations_per_request").c_str(), (double)used.count / count, "allocs");
+    Bench::report((prefix + ".bytes_per_request").c_str(), (double)used.bytes / count, "bytes");
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    Parser parser;
+    uint64_t count = Bench::iterations(200000);
+    measure("webui", parser, corpus, count);
+
+    std::vector<std::string> damaged;
+    uint32_t seed = 1;
+    for (int i = 0; i < 5000; i++) {
+        damaged.push_back(damage(corpus[i % corpus.size()], seed));
+    }
+    measure("fuzz", parser, damaged, count);
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+  bench/bench_sdupload.cpp - macro benchmark of the serial SD upload:
+  SdUploader sends a G-code file to the simulated printer of each firmware
+  dialect, at the usual baud rates, with and without line noise. Unpaced
+  runs then push 10 MB through a printer that takes no time, so what is
+  left is the cost of SdUploader itself.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+
+#include <string>
+
+#include <Arduino.h>
+#include <PrinterSimulator.h>
+
+#include "config.h"
+#include "sdupload.h"
+
+// the web server hands the upload over in blocks of this size
+static const size_t BLOCK_SIZE = 2048;
+
+struct Run
+{
+    const char *name;
+    PrinterSimulator::Firmware firmware;
+    // 0 for an unpaced run
+    unsigned long baud;
+    double corruptRate;
+};
+
+static const Run runs[] = {
+    {"sdupload.marlin.115200", PrinterSimulator::Firmware_Marlin, 115200, 0},
+    {"sdupload.marlin.250000", PrinterSimulator::Firmware_Marlin, 250000, 0},
+    {"sdupload.repetier.115200", PrinterSimulator::Firmware_Repetier, 115200, 0},
+    {"sdupload.repetier.250000", PrinterSimulator::Firmware_Repetier, 250000, 0},
+    {"sdupload.smoothieware.115200", PrinterSimulator::Firmware_Smoothieware, 115200, 0},
+    {"sdupload.smoothieware.250000", PrinterSimulator::Firmware_Smoothieware, 250000, 0},
+    {"sdupload.marlin.250000.noisy", PrinterSimulator::Firmware_Marlin, 250000, 0.0005},
+    {"sdupload.repetier.250000.noisy", PrinterSimulator::Firmware_Repetier, 250000, 0.0005},
+};
+
+static const Run unpaced[] = {
+    {"sdupload.marlin.unpaced", PrinterSimulator::Firmware_Marlin, 0, 0},
+    {"sdupload.repetier.unpaced", PrinterSimulator::Firmware_Repetier, 0, 0},
+    {"sdupload.smoothieware.unpaced", PrinterSimulator::Firmware_Smoothieware, 0, 0},
+};
+
+static void report(const char *run, const char *measure, double value, const char *unit)
+{
+    std::string name = std::string(run) + "." + measure;
+    Bench::report(name.c_str(), value, unit);
+}
+
+// false when the file did not arrive whole
+static bool upload(const Run &run, const std::string &gcode, size_t lines)
+{
+    PrinterSimulator::Options options;
+    options.corruptRate = run.corruptRate;
+    if (!run.baud) {
+        options.commandTime = 0;
+        options.sdLineTime = 0;
+        options.sdBlockTime = 0;
+    }
+    PrinterSimulator printer(run.firmware, options);
+    CONFIG::SetFirmwareTarget(run.firmware);
+    Serial.attach(&printer);
+    Serial.begin(run.baud);
+
+    double start = Bench::now();
+    bool done = SdUploader::begin("/bench.gco");
+    for (size_t offset = 0; done && offset < gcode.size(); offset += BLOCK_SIZE) {
+        size_t len = std::min(BLOCK_SIZE, gcode.size() - offset);
+        done = SdUploader::write((const uint8_t *)gcode.data() + offset, len);
+    }
+    done = done && SdUploader::end();
+    double elapsed = Bench::now() - start;
+    auto file = printer.files().find("/bench.gco");
+    bool whole = done && (file != printer.files().end()) && (file->second == gcode);
+    Serial.println("M29");
+    Serial.flush();
+    Serial.attach(nullptr);
+
+    const PrinterSimulator::Stats &stats = printer.stats();
+    report(run.name, "lines", lines / elapsed, "lines/s");
+    report(run.name, "throughput", gcode.size() / elapsed / 1e3, "KB/s");
+    // share of the wire time spent on the file itself, the rest is line
+    // numbers, checksums, commands, resent lines and idle time
+    if (run.baud) {
+        report(run.name, "wire_efficiency", 100.0 * gcode.size() * 10 / (run.baud * elapsed), "%");
+    }
+    report(run.name, "overhead", 100.0 * (stats.bytesReceived - gcode.size()) / gcode.size(), "%");
+    if (run.corruptRate > 0) {
+        report(run.name, "resends", stats.resends, "lines");
+    }
+    report(run.name, "complete", whole ? 1 : 0, "");
+    return whole;
+}
+
+// about size bytes of moves
+static std::string makeGcode(size_t size, size_t &lines)
+{
+    std::string gcode;
+    for (lines = 0; gcode.size() < size; lines++) {
+        gcode += "G1 X" + std::to_string(lines % 200) + ".5 Y" + std::to_string(lines * 7 % 200) + " E" + std::to_string(lines) + ".25\n";
+    }
+    return gcode;
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+
+    size_t lines;
+    std::string gcode = makeGcode(Bench::iterations(90 * 1024), lines);
+    int failures = 0;
+    for (const Run &run : runs) {
+        // line noise may still defeat the protocol, only a clean wire must work
+        if (!upload(run, gcode, lines) && run.corruptRate == 0) {
+            failures++;
+        }
+    }
+    gcode = makeGcode(Bench::iterations(10 * 1024 * 1024), lines);
+    for (const Run &run : unpaced) {
+        if (!upload(run, gcode, lines)) {
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+/*
+  bench/bench_serial_lines.cpp - micro benchmark of the printer output
+  path: LineFramer, ResponseClassifier and PrinterState on typical Marlin,
+  Repetier and Smoothieware answers, without serial port nor network. The
+  heap allocations of the path are counted, it should make none. The
+  classifier alone is then compared with the indexOf() chain it replaced.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+#include "allocations.h"
+
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "lineframer.h"
+#include "printerstate.h"
+#include "responseclassifier.h"
+
+// what each firmware target answers while it prints
+struct Dialect
+{
+    const char *name;
+    uint8_t firmware;
+    std::vector<const char *> lines;
+};
+
+static const Dialect dialects[] = {
+    { "marlin", MARLIN, {
+        "ok\n",
+        "ok T:210.0 /210.0 B:60.0 /60.0 @:64 B@:0\n",
+        "echo:busy: processing\n",
+        " T:209.8 /210.0 B:59.9 /60.0 @:70 B@:12 W:?\n",
+        "X:10.00 Y:20.00 Z:0.30 E:0.00 Count X:800 Y:1600 Z:120\n",
+        "SD printing byte 1234/56789\n",
+        "Resend: 42\n",
+        "echo:Unknown command: \"M999\"\n",
+    } },
+    { "repetier", REPETIER, {
+        "ok 1234\n",
+        "T:210.00 /210 B:60.00 /60 B@:0 @:64\n",
+        "wait\n",
+        "ok 1235\n",
+        "X:10.00 Y:20.00 Z:0.300 E:0.0000\n",
+        "SD printing byte 1234/56789\n",
+        "Resend:1236\n",
+        "Info:Continue printing\n",
+    } },
+    { "smoothieware", SMOOTHIEWARE, {
+        "ok\n",
+        "ok T:210.0 /210.0 @255 B:60.0 /60.0 @0\n",
+        "T:209.8 /210.0 @250 B:59.9 /60.0 @12\n",
+        "X:10.0000 Y:20.0000 Z:0.3000 E:0.0000\n",
+        "SD printing byte 1234/56789\n",
+        "Not currently playing\n",
+        "error:Unsupported command - M999\n",
+        "info: Temperature reached\n",
+    } },
+};
+
+static uint32_t classified;
+static uint32_t flagged;
+
+static void onLine(const char *line, size_t len)
+{
+    Response response;
+    ResponseClassifier::classify(line, len, response);
+    PrinterState::update(line, response);
+    classified++;
+    flagged += response.flags != 0;
+}
+
+// 64 KB of answers through the framer, the classifier and the printer
+// state, as check_command() gets them from the serial port
+static bool measure(const Dialect &dialect, uint64_t passes)
+{
+    ResponseClassifier::setFirmwareTarget(dialect.firmware);
+    std::string stream;
+    while (stream.size() < 64 * 1024) {
+        for (const char *line : dialect.lines) {
+            stream += line;
+        }
+    }
+    size_t count = 0;
+    for (char c : stream) {
+        count += c == '\n';
+    }
+
+    std::string prefix = std::string("serial_lines.") + dialect.name;
+    std::string label = prefix + ".feed_64KB";
+    classified = 0;
+    flagged = 0;
+    LineFramer<128> framer(onLine);
+    Allocations start = Allocations::total();
+    double elapsed = Bench::run(label.c_str(), passes, [&](uint64_t) {
+        framer.feed((const uint8_t *)stream.data(), stream.size());
+    });
+    Allocations used = Allocations::since(start);
+    Bench::report((prefix + ".lines").c_str(), passes * count / elapsed, "lines/s");
+    Bench::report((prefix + ".throughput").c_str(), passes * stream.size() / elapsed / 1e6, "MB/s");
+    Bench::report((prefix + ".allocations_per_line").c_str(), (double)used.count / (passes * count), "allocs");
+    Bench::report((prefix + ".classified_with_flags").c_str(), 100.0 * flagged / classified, "%");
+    return classified == passes * count;
+}
+
+// the String::indexOf() chain check_command() ran on each line before the
+// classifier, payloads copied out and unquoted as it did
+static uint16_t indexOfChain(const String &buffer, uint8_t fw)
+{
+    uint16_t flags = 0;
+    if ((buffer.indexOf("T:") > -1) || (buffer.indexOf("B:") > -1)) {
+        flags |= Response_Temperature;
+    }
+    if ((fw == REPETIER4DV) || (fw == REPETIER)) {
+        if ((buffer.indexOf("busy:") > -1) || (buffer.startsWith("wait"))) {
+            return flags | Response_Busy;
+        }
+        if (buffer.startsWith("ok")) {
+            return flags | Response_Ok;
+        }
+    }
+    int errorPos, infoPos, statusPos;
+    if (fw == SMOOTHIEWARE) {
+        errorPos = buffer.indexOf(F("error:"));
+        infoPos = buffer.indexOf(F("info:"));
+        statusPos = buffer.indexOf(F("warning:"));
+    } else {
+        errorPos = buffer.indexOf(F("Error:"));
+        infoPos = buffer.indexOf(F("Info:"));
+        statusPos = buffer.indexOf((fw == MARLIN) ? F("echo:") : F("Status:"));
+    }
+    int espPos = buffer.indexOf("[ESP");
+    if (espPos > -1 && buffer.indexOf("]", espPos) > -1) {
+        flags |= Response_EspCommand;
+    }
+    if (errorPos > -1 && !(buffer.indexOf(F("Format error")) != -1 || buffer.indexOf("wait") == errorPos + 6)) {
+        String ss = buffer.substring(errorPos + 6);
+        ss.replace("\"", "");
+        ss.replace("'", "");
+        flags |= Response_Error;
+    }
+    if (infoPos > -1) {
+        String ss = buffer.substring(infoPos + 5);
+        ss.replace("\"", "");
+        ss.replace("'", "");
+        flags |= Response_Info;
+    }
+    if (statusPos > -1) {
+        String ss = buffer.substring(statusPos + 5);
+        ss.replace("\"", "");
+        ss.replace("'", "");
+        flags |= Response_Status;
+    }
+    return flags;
+}
+
+// the same lines through ResponseClassifier::classify() and through the
+// indexOf() chain, both without the framer
+static bool compare(const Dialect &dialect, uint64_t passes)
+{
+    ResponseClassifier::setFirmwareTarget(dialect.firmware);
+    std::vector<std::string> lines;
+    std::vector<String> buffers;
+    for (const char *line : dialect.lines) {
+        lines.push_back(std::string(line, strlen(line) - 1));
+        buffers.push_back(String(lines.back().c_str()));
+    }
+    std::string prefix = std::string("serial_lines.") + dialect.name;
+    uint64_t count = passes * lines.size();
+    uint32_t checksum = 0;
+
+    Allocations start = Allocations::total();
+    double elapsed = Bench::run((prefix + ".classify").c_str(), count, [&](uint64_t i) {
+        const std::string &line = lines[i % lines.size()];
+        Response response;
+        ResponseClassifier::classify(line.data(), line.size(), response);
+        checksum += response.flags;
+    });
+    Allocations used = Allocations::since(start);
+    Bench::report((prefix + ".classify.ns_per_line").c_str(), 1e9 * elapsed / count, "ns");
+    Bench::report((prefix + ".classify.allocations_per_line").c_str(), (double)used.count / count, "allocs");
+
+    start = Allocations::total();
+    double chain = Bench::run((prefix + ".indexof_chain").c_str(), count, [&](uint64_t i) {
+        checksum += indexOfChain(buffers[i % buffers.size()], dialect.firmware);
+    });
+    used = Allocations::since(start);
+    Bench::report((prefix + ".indexof_chain.ns_per_line").c_str(), 1e9 * chain / count, "ns");
+    Bench::report((prefix + ".indexof_chain.allocations_per_line").c_str(), (double)used.count / count, "allocs");
+    Bench::report((prefix + ".classify_speedup").c_str(), elapsed > 0 ? chain / elapsed : 0, "x");
+    return checksum != 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    uint64_t passes = Bench::iterations(2000);
+    bool ok = true;
+    for (const Dialect &dialect : dialects) {
+        ok = measure(dialect, passes) && ok;
+    }
+    for (const Dialect &dialect : dialects) {
+        ok = compare(dialect, passes * 100) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+/*
+  bench/bench_settings.cpp - micro benchmark of the settings cache: reads
+  and writes through CONFIG, then the flash work of the [ESP401] burst the
+  web UI sends when its settings page is saved.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+
+#include <string>
+#include <unistd.h>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <FS.h>
+
+#include "command.h"
+#include "config.h"
+
+// one [ESP401] per field of the printer and network settings pages, the
+// %d gets a value of its own at each burst so every field changes
+static const char *const burst[] = {
+    "P=129 T=B V=%d",
+    "P=460 T=B V=%d",
+    "P=164 T=I V=%d",
+    "P=168 T=I V=%d",
+    "P=172 T=I V=%d",
+    "P=121 T=I V=%d",
+    "P=125 T=I V=%d",
+    "P=130 T=S V=esp3d%d",
+    "P=331 T=S V=data %d",
+    "P=100 T=A V=192.168.1.%d",
+};
+static const int BURST_SIZE = sizeof(burst) / sizeof(burst[0]);
+
+static uint32_t journalSize()
+{
+    File file = SPIFFS.open(SETTINGS_FILE, "r");
+    return file ? file.size() : 0;
+}
+
+// sends bursts of [ESP401] like the web UI; between two commands the
+// sketch loop calls CONFIG::update(), which commits nothing before the
+// settings stay unchanged for SETTINGS_COMMIT_DELAY. flush() stands for
+// that delay at the end of each burst. writeThrough commits each command
+// instead, as every write did before the cache.
+static void bursts(const char *name, int count, bool writeThrough)
+{
+    std::string prefix = std::string("settings.esp401_burst.") + name;
+    uint32_t commits = CONFIG::commitCount();
+    uint32_t erases = EEPROM.eraseCount();
+    uint64_t journalBytes = 0;
+    uint32_t journal = journalSize();
+    char params[64];
+    double start = Bench::now();
+    for (int i = 0; i < count; i++) {
+        for (const char *command : burst) {
+            snprintf(params, sizeof(params), command, 10 + (i % 2) * 10 + BURST_SIZE);
+            COMMAND::execute_command(401, params, NO_PIPE, LEVEL_ADMIN);
+            if (writeThrough) {
+                CONFIG::flush();
+            } else {
+                CONFIG::update();
+            }
+            // a smaller journal was rewritten as one snapshot
+            uint32_t size = journalSize();
+            journalBytes += (size >= journal) ? size - journal : size;
+            journal = size;
+        }
+        CONFIG::flush();
+        uint32_t size = journalSize();
+        journalBytes += (size >= journal) ? size - journal : size;
+        journal = size;
+    }
+    double elapsed = Bench::now() - start;
+    Bench::report((prefix + ".commands").c_str(), count * BURST_SIZE / elapsed, "cmd/s");
+    Bench::report((prefix + ".commits").c_str(), (double)(CONFIG::commitCount() - commits) / count, "per burst");
+    Bench::report((prefix + ".eeprom_erases").c_str(), (double)(EEPROM.eraseCount() - erases) / count, "per burst");
+    Bench::report((prefix + ".journal_bytes").c_str(), (double)journalBytes / count, "per burst");
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    std::string dir = "/tmp/esp3d_bench_settings_" + std::to_string(getpid());
+    host_setDataDir(dir);
+    SPIFFS.begin();
+    SPIFFS.format();
+
+    uint64_t count = Bench::iterations(1000000);
+    uint32_t checksum = 0;
+    Bench::run("settings.read_byte", count, [&](uint64_t i) {
+        byte value;
+        CONFIG::read_byte(EP_REFRESH_PAGE_TIME + (i & 1), &value);
+        checksum += value;
+    });
+    Bench::run("settings.read_buffer_int", count, [&](uint64_t) {
+        int value;
+        CONFIG::read_buffer(EP_XY_FEEDRATE, (byte *)&value, INTEGER_LENGTH);
+        checksum += value;
+    });
+    Bench::run("settings.read_string_hostname", count / 10, [&](uint64_t) {
+        char hostname[MAX_HOSTNAME_LENGTH + 1];
+        CONFIG::read_string(EP_HOSTNAME, hostname, MAX_HOSTNAME_LENGTH);
+        checksum += hostname[0];
+    });
+    Bench::run("settings.write_byte", count, [&](uint64_t i) {
+        CONFIG::write_byte(EP_REFRESH_PAGE_TIME, (byte)(i & 7));
+    });
+    CONFIG::flush();
+
+    int burstCount = (int)Bench::iterations(2000);
+    bursts("write_back", burstCount, false);
+    bursts("write_through", burstCount, true);
+    // without SPIFFS the settings go to the EEPROM sector, one erase per commit
+    SPIFFS.end();
+    bursts("write_back.eeprom", burstCount, false);
+    bursts("write_through.eeprom", burstCount, true);
+
+    std::string command = "rm -rf " + dir;
+    if (system(command.c_str()) != 0 || checksum == 0) {
+        return 1;
+    }
+    return 0;
+}
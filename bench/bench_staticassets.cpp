@@ -0,0 +1,238 @@
+/*
+  bench/bench_staticassets.cpp - macro benchmark of the static assets index
+  with a few hundred files on SPIFFS, as a web UI with its icons, scripts
+  and translations has: the index is built, then a client thread fetches
+  every file, revalidates it and asks for missing ones over loopback while
+  the main thread runs handleClient() like the sketch loop does. Two names
+  with the same FNV hash must each get their own file, and files uploaded
+  past the room left at startup must still be indexed.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+#include "netclient.h"
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <FS.h>
+
+#include "config.h"
+#include "staticassets.h"
+#include "webinterface.h"
+
+static uint16_t webPort;
+
+// files on SPIFFS, with the path the browser asks for
+struct Asset {
+    std::string name;
+    std::string path;
+    std::string content;
+};
+
+static std::vector<Asset> assets;
+
+static void createAsset(const std::string &name)
+{
+    Asset asset;
+    asset.name = name;
+    asset.path = name.compare(name.size() - 3, 3, ".gz") == 0 ? name.substr(0, name.size() - 3) : name;
+    while (asset.content.size() < 1024) {
+        asset.content += "content of " + name + "\n";
+    }
+    File file = SPIFFS.open(name.c_str(), "w");
+    file.write((const uint8_t *)asset.content.data(), asset.content.size());
+    file.close();
+    assets.push_back(asset);
+}
+
+// FNV-1a like the index, the birthday bound finds a pair in about 2^16 names
+static void collidingNames(std::string &first, std::string &second)
+{
+    std::unordered_map<uint32_t, std::string> seen;
+    for (uint32_t i = 0;; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "/lang/%08x.json", i);
+        uint32_t hash = 2166136261u;
+        for (const char *p = name; *p; p++) {
+            hash = (hash ^ (uint8_t)*p) * 16777619u;
+        }
+        auto found = seen.find(hash);
+        if (found != seen.end()) {
+            first = found->second;
+            second = name;
+            return;
+        }
+        seen[hash] = name;
+    }
+}
+
+// GET on a keep-alive connection, etag is sent as If-None-Match when not
+// empty and replaced by the ETag of the answer; reconnects when the server
+// announced it closes the connection
+static int get(NetClient &net, const std::string &path, std::string &etag, std::string &body)
+{
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: esp3d\r\n";
+    if (!etag.empty()) {
+        request += "If-None-Match: " + etag + "\r\n";
+    }
+    std::string head;
+    if (!net.send(request + "\r\n") || !net.readUntil("\r\n\r\n", head, 2000)) {
+        return -1;
+    }
+    size_t length = 0;
+    size_t pos = head.find("Content-Length: ");
+    if (pos != std::string::npos) {
+        length = strtoul(head.c_str() + pos + 16, nullptr, 10);
+    }
+    body.clear();
+    if (!net.readBytes(length, body, 2000)) {
+        return -1;
+    }
+    etag.clear();
+    pos = head.find("ETag: ");
+    if (pos != std::string::npos) {
+        etag = head.substr(pos + 6, head.find("\r\n", pos) - pos - 6);
+    }
+    if (head.find("Connection: close") != std::string::npos) {
+        net.connect(webPort);
+    }
+    return atoi(head.c_str() + 9);
+}
+
+// runs the web server until body, on its own thread, returns
+template<typename F>
+static void withClient(F body)
+{
+    std::atomic<bool> done(false);
+    std::thread client([&]() {
+        NetClient net;
+        if (net.connect(webPort)) {
+            body(net);
+        }
+        done = true;
+    });
+    while (!done) {
+        web_interface->web_server.handleClient();
+    }
+    client.join();
+}
+
+static void beginTime()
+{
+    int count = (int)Bench::iterations(200);
+    if (count < 1) {
+        count = 1;
+    }
+    double start = Bench::now();
+    for (int i = 0; i < count; i++) {
+        StaticAssets::begin();
+    }
+    double elapsed = Bench::now() - start;
+    Bench::report("staticassets.begin", 1e3 * elapsed / count, "ms");
+    Bench::report("staticassets.memory", StaticAssets::memoryUsed(), "bytes");
+    Bench::report("staticassets.memory_per_file", (double)StaticAssets::memoryUsed() / assets.size(), "bytes");
+}
+
+// every file once, then revalidated with its ETag, then missing names
+// which get the redirecting page; a file served without ETag was not
+// found in the index
+static int requests(const char *name)
+{
+    std::string prefix = std::string("staticassets.") + name;
+    int failures = 0;
+    withClient([&](NetClient &net) {
+        std::string body;
+        std::vector<std::string> etags(assets.size());
+        double start = Bench::now();
+        for (size_t i = 0; i < assets.size(); i++) {
+            if (get(net, assets[i].path, etags[i], body) != 200 || body != assets[i].content || etags[i].empty()) {
+                failures++;
+            }
+        }
+        double elapsed = Bench::now() - start;
+        Bench::report((prefix + ".hit").c_str(), assets.size() / elapsed, "req/s");
+        // the contents differ, so do the ETags unless two names share an entry
+        failures += assets.size() - std::set<std::string>(etags.begin(), etags.end()).size();
+
+        start = Bench::now();
+        for (size_t i = 0; i < assets.size(); i++) {
+            std::string etag = etags[i];
+            if (get(net, assets[i].path, etag, body) != 304) {
+                failures++;
+            }
+        }
+        elapsed = Bench::now() - start;
+        Bench::report((prefix + ".not_modified").c_str(), assets.size() / elapsed, "req/s");
+
+        start = Bench::now();
+        for (size_t i = 0; i < assets.size(); i++) {
+            std::string etag;
+            if (get(net, assets[i].path + ".missing", etag, body) != 200 || body.find("Unknown page") == std::string::npos) {
+                failures++;
+            }
+        }
+        elapsed = Bench::now() - start;
+        Bench::report((prefix + ".miss").c_str(), assets.size() / elapsed, "req/s");
+    });
+    Bench::report((prefix + ".failures").c_str(), failures, "req");
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    std::string dir = "/tmp/esp3d_bench_staticassets_" + std::to_string(getpid());
+    host_setDataDir(dir);
+    SPIFFS.begin();
+    SPIFFS.format();
+    WiFi.mode(WIFI_STA);
+    webPort = NetClient::freePort();
+    web_interface = new WEBINTERFACE_CLASS(webPort);
+    const char *headers[] = { "Cookie", "If-None-Match" };
+    web_interface->web_server.collectHeaders(headers, 2);
+    web_interface->web_server.begin();
+
+    char name[32];
+    for (int i = 0; i < 100; i++) {
+        snprintf(name, sizeof(name), "/icons/icon%03d.svg", i);
+        createAsset(name);
+        snprintf(name, sizeof(name), "/js/module%03d.js.gz", i);
+        createAsset(name);
+        snprintf(name, sizeof(name), "/css/theme%03d.css", i);
+        createAsset(name);
+    }
+    std::string first, second;
+    collidingNames(first, second);
+    createAsset(first);
+    createAsset(second);
+
+    beginTime();
+    int failures = requests("startup");
+
+    // uploads reported one by one, past the room left by begin()
+    for (int i = 0; i < 40; i++) {
+        snprintf(name, sizeof(name), "/upload/file%03d.htm", i);
+        createAsset(name);
+        StaticAssets::fileChanged(name);
+    }
+    Bench::report("staticassets.memory_after_uploads", StaticAssets::memoryUsed(), "bytes");
+    failures += requests("after_uploads");
+
+    std::string command = "rm -rf " + dir;
+    if (system(command.c_str()) != 0) {
+        return 1;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+/*
+  bench/bench_storestrings.cpp - micro benchmark of the rolling message
+  lists: a million messages of the usual lengths go through add() and
+  get(), against a list of heap strings like the one they replaced.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+#include "allocations.h"
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "storestrings.h"
+
+// size and length of the info/error/status lists of the web interface
+static const int LIST_SIZE = 30;
+static const int LIST_LENGTH = 100;
+// free heap of the board once connected, and blocks the rest of the
+// firmware holds at any time
+static const size_t HEAP_SIZE = 24 * 1024;
+static const size_t OTHER_BLOCKS = 100;
+
+// the lists of the web interface
+class Ring : public STORESTRINGS_CLASS
+{
+public:
+    Ring() : STORESTRINGS_CLASS(LIST_SIZE, LIST_LENGTH) {}
+};
+
+// one new char[] per message, oldest deleted once the list is full
+class HeapList
+{
+private:
+    std::list<char *> _strings;
+
+public:
+    ~HeapList()
+    {
+        for (char *s : _strings) {
+            delete[] s;
+        }
+    }
+
+    void add(const char *string)
+    {
+        if (_strings.size() == LIST_SIZE) {
+            delete[] _strings.front();
+            _strings.pop_front();
+        }
+        size_t size = std::min(strlen(string), (size_t)LIST_LENGTH);
+        char *copy = new char[size + 1];
+        memcpy(copy, string, size);
+        copy[size] = 0;
+        _strings.push_back(copy);
+    }
+
+    const char *get(int pos)
+    {
+        auto it = _strings.begin();
+        std::advance(it, pos);
+        return *it;
+    }
+};
+
+// add() and get() rates, then the fragmentation left by the same adds
+template<typename List>
+static void measure(const char *name, const std::vector<std::string> &messages, uint64_t count)
+{
+    std::string prefix = std::string("storestrings.") + name;
+    size_t checksum = 0;
+    {
+        List list;
+        std::string label = prefix + ".add";
+        Allocations start = Allocations::total();
+        Bench::run(label.c_str(), count, [&](uint64_t i) {
+            list.add(messages[i % messages.size()].c_str());
+        });
+        Allocations used = Allocations::since(start);
+        Bench::report((prefix + ".allocations").c_str(), used.count, "allocs");
+        Bench::report((prefix + ".allocations_per_add").c_str(), (double)used.count / count, "allocs");
+        Bench::run((prefix + ".get").c_str(), count, [&](uint64_t i) {
+            checksum += list.get(i % LIST_SIZE)[0];
+        });
+    }
+
+    // the same messages while the rest of the firmware allocates and frees
+    // blocks of its own, in a heap the size of the free one of the board
+    HeapModel heap(HEAP_SIZE);
+    List list;
+    std::vector<char *> others;
+    others.reserve(OTHER_BLOCKS + 1);
+    double fragmentation = 0;
+    size_t smallest = HEAP_SIZE;
+    for (uint64_t i = 0; i < count; i++) {
+        list.add(messages[i % messages.size()].c_str());
+        others.push_back(new char[16 + (i * 13) % 100]);
+        if (others.size() > OTHER_BLOCKS) {
+            size_t pos = (i * 31) % others.size();
+            delete[] others[pos];
+            others[pos] = others.back();
+            others.pop_back();
+        }
+        fragmentation += heap.fragmentation();
+        smallest = std::min(smallest, heap.maxFreeBlock());
+    }
+    for (char *p : others) {
+        delete[] p;
+    }
+    Bench::report((prefix + ".heap_fragmentation").c_str(), fragmentation / count, "%");
+    Bench::report((prefix + ".heap_min_max_free_block").c_str(), smallest, "bytes");
+    Bench::report((prefix + ".heap_failures").c_str(), heap.failures(), "allocs");
+    if (checksum == 0) {
+        Bench::report((prefix + ".empty").c_str(), 1, "");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    // status and error lines of a few words, some of them too long
+    std::vector<std::string> messages;
+    for (int i = 0; i < 64; i++) {
+        messages.push_back("Message " + std::to_string(i) + std::string((i * 37) % 140, 'x'));
+    }
+    uint64_t count = Bench::iterations(1000000);
+
+    measure<Ring>("ring", messages, count);
+    measure<HeapList>("heap_list", messages, count);
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+  bench/bench_upload.cpp - macro benchmark of multipart file uploads: a
+  client thread posts files of a few megabytes over loopback while the
+  main thread runs handleClient() like the sketch loop does. The upload
+  handler only counts the bytes, what is measured is the parser finding
+  the boundary and handing the data over.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+#include "netclient.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <ESP8266WebServer.h>
+
+// the client writes the body in pieces of this size, like a browser does
+static const size_t SEND_SIZE = 16 * 1024;
+
+static int upload(const char *name, uint16_t port, ESP8266WebServer &server, size_t size, size_t &received,
+                  uint32_t &writes)
+{
+    std::string data;
+    for (size_t i = 0; data.size() < size; i++) {
+        data += "G1 X" + std::to_string(i % 200) + ".5 Y" + std::to_string(i * 7 % 200) + " E" + std::to_string(i) + ".25\n";
+    }
+    data.resize(size);
+    std::string form = "--XyZ\r\n"
+                       "Content-Disposition: form-data; name=\"file\"; filename=\"bench.gcode\"\r\n"
+                       "Content-Type: application/octet-stream\r\n"
+                       "\r\n" + data + "\r\n--XyZ--\r\n";
+    std::string request = "POST /upload HTTP/1.1\r\nHost: esp3d\r\n"
+                          "Content-Type: multipart/form-data; boundary=XyZ\r\n"
+                          "Content-Length: " + std::to_string(form.size()) + "\r\n\r\n" + form;
+
+    received = 0;
+    writes = 0;
+    std::atomic<bool> done(false);
+    int status = -1;
+    double elapsed = 0;
+    std::thread client([&]() {
+        NetClient net;
+        std::string body;
+        if (net.connect(port)) {
+            double start = Bench::now();
+            for (size_t offset = 0; offset < request.size(); offset += SEND_SIZE) {
+                net.send(request.substr(offset, SEND_SIZE));
+            }
+            status = net.readResponse(body, 5000, port);
+            elapsed = Bench::now() - start;
+        }
+        done = true;
+    });
+    while (!done) {
+        server.handleClient();
+    }
+    client.join();
+
+    std::string prefix = std::string("upload.") + name;
+    Bench::report((prefix + ".throughput").c_str(), elapsed > 0 ? size / elapsed / 1e6 : 0, "MB/s");
+    Bench::report((prefix + ".handler_calls").c_str(), (double)writes * 1024 * 1024 / size, "per MB");
+    bool whole = status == 200 && received == size;
+    Bench::report((prefix + ".complete").c_str(), whole ? 1 : 0, "");
+    return whole ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    uint16_t port = NetClient::freePort();
+    ESP8266WebServer server(port);
+    size_t received = 0;
+    uint32_t writes = 0;
+    server.on("/upload", HTTP_POST, [&server]() {
+        server.send(200, "text/plain", "done");
+    }, [&server, &received, &writes]() {
+        HTTPUpload &upload = server.upload();
+        if (upload.status == UPLOAD_FILE_WRITE) {
+            received += upload.currentSize;
+            writes++;
+        }
+    });
+    server.begin();
+
+    int failures = 0;
+    failures += upload("64KB", port, server, Bench::iterations(64 * 1024), received, writes);
+    failures += upload("1MB", port, server, Bench::iterations(1024 * 1024), received, writes);
+    failures += upload("16MB", port, server, Bench::iterations(16 * 1024 * 1024), received, writes);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,312 @@
+/*
+  bench/bench_websocket.cpp - macro benchmark of the websocket terminal
+  against the raw TCP data port: the same M105 round trips and the same
+  G-code stream go to the simulated printer through /ws and through the
+  data port, while the main thread runs the web server and the bridge like
+  the sketch loop does. A handshake without "Connection: Upgrade" must be
+  refused.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "bench.h"
+#include "netclient.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <PrinterSimulator.h>
+
+#include "bridge.h"
+#include "config.h"
+#include "webinterface.h"
+
+static uint16_t dataPort;
+static uint16_t webPort;
+
+// Terminal
+// Lines to and from the printer, over the data port or over /ws where
+// they travel as masked binary frames one way and server frames the other.
+class Terminal
+{
+private:
+    NetClient _net;
+    bool _ws;
+    std::string _text;
+
+    bool readFrame(int timeout_ms)
+    {
+        std::string head;
+        if (!_net.readBytes(2, head, timeout_ms)) {
+            return false;
+        }
+        uint8_t opcode = head[0] & 0x0F;
+        uint64_t len = (uint8_t)head[1] & 0x7F;
+        std::string ext;
+        if (len == 126 || len == 127) {
+            size_t size = (len == 126) ? 2 : 8;
+            if (!_net.readBytes(size, ext, timeout_ms)) {
+                return false;
+            }
+            len = 0;
+            for (char c : ext) {
+                len = (len << 8) | (uint8_t)c;
+            }
+        }
+        std::string payload;
+        if (!_net.readBytes(len, payload, timeout_ms)) {
+            return false;
+        }
+        if (opcode == WS_TEXT || opcode == WS_BINARY || opcode == WS_CONTINUATION) {
+            _text += payload;
+        }
+        return opcode != WS_CLOSE;
+    }
+
+public:
+    explicit Terminal(bool ws) : _ws(ws) {}
+
+    bool open()
+    {
+        if (!_ws) {
+            return _net.connect(dataPort);
+        }
+        std::string head;
+        return _net.connect(webPort) &&
+               _net.send("GET /ws HTTP/1.1\r\nHost: esp3d\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                         "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n") &&
+               _net.readUntil("\r\n\r\n", head, 2000) &&
+               head.compare(0, 12, "HTTP/1.1 101") == 0;
+    }
+
+    void close()
+    {
+        _net.close();
+    }
+
+    bool send(const std::string &text)
+    {
+        if (!_ws) {
+            return _net.send(text);
+        }
+        std::string frame;
+        frame += (char)(0x80 | WS_BINARY);
+        if (text.size() < 126) {
+            frame += (char)(0x80 | text.size());
+        } else {
+            frame += (char)(0x80 | 126);
+            frame += (char)(text.size() >> 8);
+            frame += (char)(text.size() & 0xFF);
+        }
+        static const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+        frame.append((const char *)mask, 4);
+        for (size_t i = 0; i < text.size(); i++) {
+            frame += (char)(text[i] ^ mask[i % 4]);
+        }
+        return _net.send(frame);
+    }
+
+    bool readLine(std::string &line, int timeout_ms)
+    {
+        if (!_ws) {
+            return _net.readUntil("\n", line, timeout_ms);
+        }
+        size_t pos;
+        while ((pos = _text.find('\n')) == std::string::npos) {
+            if (!readFrame(timeout_ms)) {
+                return false;
+            }
+        }
+        line = _text.substr(0, pos + 1);
+        _text.erase(0, pos + 1);
+        return true;
+    }
+};
+
+// runs the web server and the bridge until body, on its own thread, returns
+template<typename F>
+static void withTerminal(bool ws, F body)
+{
+    std::atomic<bool> done(false);
+    std::thread client([&]() {
+        Terminal terminal(ws);
+        if (terminal.open()) {
+            body(terminal);
+        }
+        terminal.close();
+        done = true;
+    });
+    while (!done) {
+        web_interface->web_server.handleClient();
+        BRIDGE::processFromTCP2Serial();
+        BRIDGE::processFromSerial2TCP();
+    }
+    client.join();
+    // let the bridge see the closed connection before the next run
+    for (int i = 0; i < 100; i++) {
+        web_interface->web_server.handleClient();
+        BRIDGE::processFromTCP2Serial();
+        BRIDGE::processFromSerial2TCP();
+        delay(1);
+    }
+}
+
+// round trip of M105, from the client to the printer and back
+static int latency(const char *name, bool ws)
+{
+    PrinterSimulator printer(PrinterSimulator::Firmware_Marlin);
+    Serial.attach(&printer);
+    Serial.begin(0);
+
+    const int requests = (int)Bench::iterations(2000);
+    std::vector<double> latencies;
+    int failures = 0;
+    double elapsed = 0;
+    withTerminal(ws, [&](Terminal &terminal) {
+        std::string line;
+        double start = Bench::now();
+        for (int i = 0; i < requests; i++) {
+            double t0 = Bench::now();
+            terminal.send("M105\n");
+            if (!terminal.readLine(line, 2000) || line.compare(0, 4, "ok T") != 0) {
+                failures++;
+            }
+            latencies.push_back(Bench::now() - t0);
+        }
+        elapsed = Bench::now() - start;
+    });
+    Serial.attach(nullptr);
+
+    if (latencies.empty()) {
+        return requests;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::string prefix = std::string("websocket.m105.") + name;
+    Bench::report((prefix + ".requests").c_str(), requests / elapsed, "req/s");
+    Bench::report((prefix + ".latency_p50").c_str(), latencies[latencies.size() / 2] * 1e6, "us");
+    Bench::report((prefix + ".latency_p99").c_str(), latencies[latencies.size() * 99 / 100] * 1e6, "us");
+    Bench::report((prefix + ".failures").c_str(), failures, "req");
+    return failures;
+}
+
+// G-code streamed like host software does it, one line per frame on /ws,
+// as many as fit the receive buffer of the printer; moves take no time
+static int streaming(const char *name, bool ws, size_t total)
+{
+    PrinterSimulator::Options options;
+    options.commandTime = 0;
+    options.moveTime = 0;
+    PrinterSimulator printer(PrinterSimulator::Firmware_Marlin, options);
+    Serial.attach(&printer);
+    Serial.begin(0);
+
+    std::vector<std::string> gcode;
+    for (int i = 0; i < 1000; i++) {
+        char line[64];
+        snprintf(line, sizeof(line), "G1 X%d.%03d Y%d.%03d E%d.%05d F1800\n", i % 200, i * 7 % 1000,
+                 i * 3 % 200, i * 11 % 1000, i / 100, i * 13 % 100000);
+        gcode.push_back(line);
+    }
+    size_t sent = 0;
+    size_t lines = 0;
+    int failures = 0;
+    double elapsed = 0;
+    withTerminal(ws, [&](Terminal &terminal) {
+        std::deque<size_t> pending;
+        size_t pendingBytes = 0;
+        std::string answer;
+        double start = Bench::now();
+        while (sent < total || !pending.empty()) {
+            while (sent < total) {
+                const std::string &line = gcode[lines % gcode.size()];
+                if (pendingBytes + line.size() >= options.rxBufferSize) {
+                    break;
+                }
+                terminal.send(line);
+                pending.push_back(line.size());
+                pendingBytes += line.size();
+                sent += line.size();
+                lines++;
+            }
+            if (!terminal.readLine(answer, 2000)) {
+                failures++;
+                break;
+            }
+            if (answer.compare(0, 2, "ok") == 0 && !pending.empty()) {
+                pendingBytes -= pending.front();
+                pending.pop_front();
+            }
+        }
+        elapsed = Bench::now() - start;
+    });
+    Serial.attach(nullptr);
+
+    std::string prefix = std::string("websocket.stream.") + name;
+    Bench::report((prefix + ".throughput").c_str(), elapsed > 0 ? sent / elapsed / 1e3 : 0, "KB/s");
+    Bench::report((prefix + ".lines").c_str(), elapsed > 0 ? lines / elapsed : 0, "lines/s");
+    Bench::report((prefix + ".lost").c_str(), printer.stats().rxOverruns + printer.stats().boardOverruns, "bytes");
+    Bench::report((prefix + ".failures").c_str(), failures, "");
+    return failures;
+}
+
+// the upgrade needs "Connection: Upgrade", without it the answer is 400
+static int handshakeChecks()
+{
+    static const char *const requests[] = {
+        "GET /ws HTTP/1.1\r\nHost: esp3d\r\nUpgrade: websocket\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n",
+        "GET /ws HTTP/1.1\r\nHost: esp3d\r\nUpgrade: websocket\r\nConnection: keep-alive\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n",
+    };
+    int failures = 0;
+    for (const char *request : requests) {
+        std::atomic<bool> done(false);
+        int status = -1;
+        std::thread client([&]() {
+            NetClient net;
+            std::string body;
+            if (net.connect(webPort) && net.send(request)) {
+                status = net.readResponse(body, 2000, webPort);
+            }
+            done = true;
+        });
+        while (!done) {
+            web_interface->web_server.handleClient();
+        }
+        client.join();
+        failures += status != 400;
+    }
+    Bench::report("websocket.handshake_without_upgrade.failures", failures, "req");
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    Bench::init(argc, argv);
+    CONFIG::SetFirmwareTarget(MARLIN);
+    WiFi.mode(WIFI_STA);
+    dataPort = NetClient::freePort();
+    data_server = new WiFiServer(dataPort);
+    data_server->begin();
+    data_server->setNoDelay(true);
+    webPort = NetClient::freePort();
+    web_interface = new WEBINTERFACE_CLASS(webPort);
+    web_interface->web_server.begin();
+
+    int failures = handshakeChecks();
+    // without baud rate the wire costs nothing, what remains is the transport
+    failures += latency("tcp", false);
+    failures += latency("ws", true);
+    failures += streaming("tcp", false, Bench::iterations(1024 * 1024));
+    failures += streaming("ws", true, Bench::iterations(1024 * 1024));
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+/*
+  bench/netclient.h - blocking TCP client of the macro benchmarks, it plays
+  the browser or the host software talking to the sketch over loopback.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+
+// NetClient
+class NetClient
+{
+private:
+    int _fd = -1;
+    std::string _buffer;
+
+public:
+    ~NetClient()
+    {
+        close();
+    }
+
+    // an unused port, for servers that cannot bind port 0
+    static uint16_t freePort()
+    {
+        int s = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        bind(s, (struct sockaddr *)&addr, sizeof(addr));
+        getsockname(s, (struct sockaddr *)&addr, &len);
+        ::close(s);
+        return ntohs(addr.sin_port);
+    }
+
+    bool connect(uint16_t port)
+    {
+        close();
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int flag = 1;
+        setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+        return ::connect(_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+    }
+
+    void close()
+    {
+        if (_fd >= 0) {
+            ::close(_fd);
+            _fd = -1;
+        }
+        _buffer.clear();
+    }
+
+    bool send(const std::string &data)
+    {
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = ::send(_fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+    // waits at most timeout_ms for more data, false on timeout or close
+    bool receive(int timeout_ms)
+    {
+        struct pollfd pfd = {_fd, POLLIN, 0};
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            return false;
+        }
+        char buf[4096];
+        ssize_t n = recv(_fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return false;
+        }
+        _buffer.append(buf, n);
+        return true;
+    }
+
+    // takes everything up to and including delimiter
+    bool readUntil(const std::string &delimiter, std::string &out, int timeout_ms)
+    {
+        size_t pos;
+        while ((pos = _buffer.find(delimiter)) == std::string::npos) {
+            if (!receive(timeout_ms)) {
+                return false;
+            }
+        }
+        out = _buffer.substr(0, pos + delimiter.size());
+        _buffer.erase(0, pos + delimiter.size());
+        return true;
+    }
+
+    bool readBytes(size_t count, std::string &out, int timeout_ms)
+    {
+        while (_buffer.size() < count) {
+            if (!receive(timeout_ms)) {
+                return false;
+            }
+        }
+        out = _buffer.substr(0, count);
+        _buffer.erase(0, count);
+        return true;
+    }
+
+    // reads one HTTP response with a Content-Length body, returns the
+    // status; reconnects when the server announced it closes the connection
+    int readResponse(std::string &body, int timeout_ms, uint16_t port)
+    {
+        std::string head;
+        if (!readUntil("\r\n\r\n", head, timeout_ms)) {
+            return -1;
+        }
+        size_t length = 0;
+        size_t pos = head.find("Content-Length: ");
+        if (pos != std::string::npos) {
+            length = strtoul(head.c_str() + pos + 16, nullptr, 10);
+        }
+        if (!readBytes(length, body, timeout_ms)) {
+            return -1;
+        }
+        if (head.find("Connection: close") != std::string::npos) {
+            connect(port);
+        }
+        return atoi(head.c_str() + 9);
+    }
+};
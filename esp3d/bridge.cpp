@@ -28,9 +28,16 @@
 WiFiServer * data_server;
 WiFiClient serverClients[MAX_SRV_CLIENTS];
 #endif
+#ifdef WS_DATA_FEATURE
+WebSocket wsClients[MAX_WS_CLIENTS];
+#endif
 
 bool BRIDGE::header_sent = false;
 String BRIDGE::buffer_web = "";
+RingBuffer<BRIDGE_BUFFER_SIZE> BRIDGE::serialRing;
+#ifdef TCP_IP_DATA_FEATURE
+RingBuffer<BRIDGE_BUFFER_SIZE> BRIDGE::tcpRing;
+#endif
 
 void BRIDGE::print (const String & data, tpipe output)
 {
@@ -140,39 +147,99 @@ void BRIDGE::send2TCP(const char * data)
             delay(0);
         }
     }
+#ifdef WS_DATA_FEATURE
+    for(uint8_t i = 0; i < MAX_WS_CLIENTS; i++) {
+        if (wsClients[i].connected()) {
+            wsClients[i].sendFrame((const uint8_t *)data, strlen(data));
+            delay(0);
+        }
+    }
+#endif
+}
+#endif
+
+#ifdef WS_DATA_FEATURE
+bool BRIDGE::hasWebSocketRoom()
+{
+    for(uint8_t i = 0; i < MAX_WS_CLIENTS; i++) {
+        if (!wsClients[i].connected()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BRIDGE::addWebSocket(WiFiClient client)
+{
+    for(uint8_t i = 0; i < MAX_WS_CLIENTS; i++) {
+        if (!wsClients[i].connected()) {
+            wsClients[i].attach(client);
+            return true;
+        }
+    }
+    client.stop();
+    return false;
 }
 #endif
 
 bool BRIDGE::processFromSerial2TCP()
 {
-    uint8_t i;
-    //check UART for data
-    if(Board::printerPort.available()) {
-        size_t len = Board::printerPort.available();
-        uint8_t sbuf[len];
-        Board::printerPort.readBytes(sbuf, len);
+    //move what the UART driver holds into the ring in one or two bulk reads
+    size_t len = Board::printerPort.available();
+    while (len > 0) {
+        uint8_t *dst;
+        size_t room = serialRing.writeSpan(dst);
+        if (room == 0) {
+            break;
+        }
+        if (room > len) {
+            room = len;
+        }
+        room = Board::printerPort.readBytes(dst, room);
+        if (room == 0) {
+            break;
+        }
+        serialRing.commit(room);
+        len -= room;
+    }
+    if (serialRing.isEmpty()) {
+        return false;
+    }
+    //then hand each contiguous span to the consumers, no extra copy
+    const uint8_t *data;
+    while ((len = serialRing.readSpan(data)) > 0) {
 #ifdef TCP_IP_DATA_FEATURE
-          if (WiFi.getMode()!=WIFI_OFF ) {
+        if (WiFi.getMode()!=WIFI_OFF ) {
             //push UART data to all connected tcp clients
-            for(i = 0; i < MAX_SRV_CLIENTS; i++) {
+            for(uint8_t i = 0; i < MAX_SRV_CLIENTS; i++) {
                 if (serverClients[i] && serverClients[i].connected()) {
-                    serverClients[i].write(sbuf, len);
+                    serverClients[i].write(data, len);
                     delay(0);
                 }
             }
+#ifdef WS_DATA_FEATURE
+            //one whole frame per span, at most two when the ring wraps, so
+            //many short printer lines do not cost one frame each and what
+            //read_buffer_serial sends never lands inside a frame
+            for(uint8_t i = 0; i < MAX_WS_CLIENTS; i++) {
+                if (wsClients[i].connected()) {
+                    wsClients[i].sendFrame(data, len);
+                    delay(0);
+                }
+            }
+#endif
         }
 #endif
         //process data if any
-        COMMAND::read_buffer_serial(sbuf, len);
-        return true;
-    } else {
-        return false;
+        COMMAND::read_buffer_serial(data, len);
+        serialRing.consume(len);
     }
+    return true;
 }
 #ifdef TCP_IP_DATA_FEATURE
 void BRIDGE::processFromTCP2Serial()
 {
-    uint8_t i,data;
+    uint8_t i;
     //check if there are any new clients
     if (data_server->hasClient()) {
         for(i = 0; i < MAX_SRV_CLIENTS; i++) {
@@ -191,19 +258,56 @@ void BRIDGE::processFromTCP2Serial()
     }
     //check clients for data
     //to avoid any pollution if Uploading file to SDCard
-    if ((web_interface->blockserial) == false) {
+    if (!web_interface->isSerialLocked()) {
         for(i = 0; i < MAX_SRV_CLIENTS; i++) {
             if (serverClients[i] && serverClients[i].connected()) {
-                if(serverClients[i].available()) {
-                    //get data from the tcp client and push it to the UART
-                    while(serverClients[i].available()) {
-                        data = serverClients[i].read();
-                        Board::printerPort.write(data);
-                        COMMAND::read_buffer_tcp(data);
+                //only take what fits, the rest stays in the tcp window
+                size_t len;
+                uint8_t *dst;
+                while (serverClients[i].available() && (len = tcpRing.writeSpan(dst)) > 0) {
+                    int got = serverClients[i].read(dst, len);
+                    if (got <= 0) {
+                        break;
+                    }
+                    COMMAND::read_buffer_tcp(dst, got);
+                    tcpRing.commit(got);
+                }
+            }
+        }
+#ifdef WS_DATA_FEATURE
+        //payload is unmasked in place, straight in the ring
+        for(i = 0; i < MAX_WS_CLIENTS; i++) {
+            if (wsClients[i].connected()) {
+                size_t len;
+                uint8_t *dst;
+                while ((len = tcpRing.writeSpan(dst)) > 0) {
+                    size_t got = wsClients[i].read(dst, len);
+                    if (got == 0) {
+                        break;
                     }
+                    COMMAND::read_buffer_tcp(dst, got);
+                    tcpRing.commit(got);
                 }
             }
         }
+#endif
+        //push to the UART only what its tx fifo can take without blocking
+        const uint8_t *data;
+        size_t len;
+        while ((len = tcpRing.readSpan(data)) > 0) {
+            size_t room = Board::printerPort.availableForWrite();
+            if (room == 0) {
+                break;
+            }
+            if (len > room) {
+                len = room;
+            }
+            len = Board::printerPort.write(data, len);
+            if (len == 0) {
+                break;
+            }
+            tcpRing.consume(len);
+        }
     }
 }
 #endif
@@ -22,15 +22,25 @@
 #define BRIDGE_H
 #include <WiFiServer.h>
 #include "config.h"
+#include "ringbuffer.h"
 #ifdef TCP_IP_DATA_FEATURE
 extern WiFiServer * data_server;
 #endif
+#ifdef WS_DATA_FEATURE
+#include <WebSocket.h>
+#endif
 
 class BRIDGE
 {
 public:
     static bool header_sent;
     static String buffer_web;
+    //serial -> tcp/parser direction
+    static RingBuffer<BRIDGE_BUFFER_SIZE> serialRing;
+#ifdef TCP_IP_DATA_FEATURE
+    //tcp -> serial direction
+    static RingBuffer<BRIDGE_BUFFER_SIZE> tcpRing;
+#endif
     static bool processFromSerial2TCP();
 
     static void print (const String & data, tpipe output);
@@ -48,5 +58,10 @@ public:
     static void send2TCP(const String & data);
     static void send2TCP(const char * data);
 #endif
+#ifdef WS_DATA_FEATURE
+    static bool hasWebSocketRoom();
+    //client must come from WebServer::upgradeWebSocket()
+    static bool addWebSocket(WiFiClient client);
+#endif
 };
 #endif
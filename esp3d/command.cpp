@@ -22,6 +22,14 @@
 #include "wificonf.h"
 #include "webinterface.h"
 #include "board.h"
+#include "responseclassifier.h"
+#include "printerstate.h"
+#include "commandqueue.h"
+#include "eventstream.h"
+#include "staticassets.h"
+#include "settings.h"
+#include "settingsstore.h"
+#include "containers.h"
 
 #ifndef FS_NO_GLOBALS
 #define FS_NO_GLOBALS
@@ -33,8 +41,12 @@
 #else
 #define MAX_GPIO 37
 #endif
-String COMMAND::buffer_serial;
-String COMMAND::buffer_tcp;
+//printer answers like "ok" are shorter than commands
+LineFramer<COMMAND_LINE_SIZE> COMMAND::serial_framer(COMMAND::process_serial_line, 1);
+#ifdef TCP_IP_DATA_FEATURE
+//Minimum is something like M10 so 3 char
+LineFramer<COMMAND_LINE_SIZE> COMMAND::tcp_framer(COMMAND::process_tcp_line, 4);
+#endif
 
 #define ERROR_CMD_MSG (output == WEB_PIPE)?F("Error: Wrong Command"):F("Cmd Error")
 #define INCORRECT_CMD_MSG (output == WEB_PIPE)?F("Error: Incorrect Command"):F("Incorrect Cmd")
@@ -529,566 +541,14 @@ bool COMMAND::execute_command(int cmd,String cmd_params, tpipe output, level_aut
     //Get full EEPROM settings content
     //[ESP400]
     case 400: {
-        char sbuf[MAX_DATA_LENGTH+1];
-        uint8_t ipbuf[4];
-        byte bbuf=0;
-        int ibuf=0;
         parameter = get_param(cmd_params,"", true);
         delay(0);
         //Start JSON
         BRIDGE::println(F("{\"EEPROM\":["), output);
         auto bulkAccessor = CONFIG::beginBulkAccess();
+        Settings::print(cmd_params, output);
+        delay(0);
 
-        if (cmd_params == "network" || cmd_params == "") {
-            
-            //1- Baud Rate
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_BAUD_RATE), output);
-            BRIDGE::print(F("\",\"T\":\"I\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_BAUD_RATE,  (byte *)&ibuf, INTEGER_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(ibuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Baud Rate\",\"O\":[{\"9600\":\"9600\"},{\"19200\":\"19200\"},{\"38400\":\"38400\"},{\"57600\":\"57600\"},{\"115200\":\"115200\"},{\"230400\":\"230400\"},{\"250000\":\"250000\"}]}"), output);
-            BRIDGE::println(F(","), output);
-            
-            //2-Sleep Mode
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_SLEEP_MODE), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_SLEEP_MODE, &bbuf )) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Sleep Mode\",\"O\":[{\"None\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(WIFI_NONE_SLEEP), output);
-#ifdef ARDUINO_ARCH_ESP8266
-            BRIDGE::print(F("\"},{\"Light\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(WIFI_LIGHT_SLEEP), output);
-#endif
-            BRIDGE::print(F("\"},{\"Modem\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(WIFI_MODEM_SLEEP), output);
-            BRIDGE::print(F("\"}]}"), output);
-            BRIDGE::println(F(","), output);
-            
-            //3-Web Port
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_WEB_PORT), output);
-            BRIDGE::print(F("\",\"T\":\"I\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_WEB_PORT,  (byte *)&ibuf, INTEGER_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(ibuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Web Port\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MAX_WEB_PORT), output);
-            BRIDGE::print(F("\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MIN_WEB_PORT), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //4-Data Port
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_DATA_PORT), output);
-            BRIDGE::print(F("\",\"T\":\"I\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_DATA_PORT,  (byte *)&ibuf, INTEGER_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(ibuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Data Port\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MAX_DATA_PORT), output);
-            BRIDGE::print(F("\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MIN_DATA_PORT), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-#ifdef AUTHENTICATION_FEATURE
-             //5-Admin password
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_ADMIN_PWD), output);
-            BRIDGE::print(F("\",\"T\":\"S\",\"V\":\""), output);
-            if (!CONFIG::read_string(EP_ADMIN_PWD, sbuf, MAX_LOCAL_PASSWORD_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(F("********"), output);
-            }
-            BRIDGE::print(F("\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MAX_LOCAL_PASSWORD_LENGTH), output);
-            BRIDGE::print(F("\",\"H\":\"Admin Password\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MIN_LOCAL_PASSWORD_LENGTH), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //6-User password
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_USER_PWD), output);
-            BRIDGE::print(F("\",\"T\":\"S\",\"V\":\""), output);
-            if (!CONFIG::read_string(EP_USER_PWD, sbuf, MAX_LOCAL_PASSWORD_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(F("********"), output);
-            }
-            BRIDGE::print(F("\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MAX_LOCAL_PASSWORD_LENGTH), output);
-            BRIDGE::print(F("\",\"H\":\"User Password\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MIN_LOCAL_PASSWORD_LENGTH), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-#endif
-            //7-Hostname
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_HOSTNAME), output);
-            BRIDGE::print(F("\",\"T\":\"S\",\"V\":\""), output);
-            if (!CONFIG::read_string(EP_HOSTNAME, sbuf, MAX_HOSTNAME_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(sbuf, output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Hostname\" ,\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MAX_HOSTNAME_LENGTH), output);
-            BRIDGE::print(F("\", \"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MIN_HOSTNAME_LENGTH), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-            
-            //8-wifi mode
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_WIFI_MODE), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_WIFI_MODE, &bbuf )) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Wifi mode\",\"O\":[{\"AP\":\"1\"},{\"STA\":\"2\"}]}"), output);
-            BRIDGE::println(F(","), output);
-
-            //9-STA SSID
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_STA_SSID), output);
-            BRIDGE::print(F("\",\"T\":\"S\",\"V\":\""), output);
-            if (!CONFIG::read_string(EP_STA_SSID, sbuf, MAX_SSID_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(sbuf, output);
-            }
-            BRIDGE::print(F("\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MAX_SSID_LENGTH), output);
-            BRIDGE::print(F("\",\"H\":\"Station SSID\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MIN_SSID_LENGTH), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //10-STA password
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_STA_PASSWORD), output);
-            BRIDGE::print(F("\",\"T\":\"S\",\"V\":\""), output);
-            if (!CONFIG::read_string(EP_STA_PASSWORD, sbuf, MAX_PASSWORD_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(F("********"), output);
-            }
-            BRIDGE::print(F("\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MAX_PASSWORD_LENGTH), output);
-            BRIDGE::print(F("\",\"H\":\"Station Password\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MIN_PASSWORD_LENGTH), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-            
-            //11-Station Network Mode
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_STA_PHY_MODE), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_STA_PHY_MODE, &bbuf )) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Station Network Mode\",\"O\":[{\"11b\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(WIFI_PHY_MODE_11B), output);
-            BRIDGE::print(F("\"},{\"11g\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(WIFI_PHY_MODE_11G), output);
-            BRIDGE::print(F("\"},{\"11n\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(WIFI_PHY_MODE_11N), output);
-            BRIDGE::print(F("\"}]}"), output);
-            BRIDGE::println(F(","), output);
-
-            //12-STA IP mode
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_STA_IP_MODE), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_STA_IP_MODE, &bbuf )) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Station IP Mode\",\"O\":[{\"DHCP\":\"1\"},{\"Static\":\"2\"}]}"), output);
-            BRIDGE::println(F(","), output);
-
-            //13-STA static IP
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_STA_IP_VALUE), output);
-            BRIDGE::print(F("\",\"T\":\"A\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_STA_IP_VALUE,(byte *)ipbuf, IP_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(IPAddress(ipbuf).toString().c_str(), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Station Static IP\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //14-STA static Mask
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_STA_MASK_VALUE), output);
-            BRIDGE::print(F("\",\"T\":\"A\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_STA_MASK_VALUE,(byte *)ipbuf, IP_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(IPAddress(ipbuf).toString().c_str(), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Station Static Mask\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //15-STA static Gateway
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_STA_GATEWAY_VALUE), output);
-            BRIDGE::print(F("\",\"T\":\"A\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_STA_GATEWAY_VALUE,(byte *)ipbuf, IP_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(IPAddress(ipbuf).toString().c_str(), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Station Static Gateway\"}"), output);
-            BRIDGE::println(F(","), output);
-
-           //16-AP SSID
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_AP_SSID), output);
-            BRIDGE::print(F("\",\"T\":\"S\",\"V\":\""), output);
-            if (!CONFIG::read_string(EP_AP_SSID, sbuf, MAX_SSID_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(sbuf, output);
-            }
-            BRIDGE::print(F("\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MAX_SSID_LENGTH), output);
-            BRIDGE::print(F("\",\"H\":\"AP SSID\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MIN_SSID_LENGTH), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //17-AP password
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_AP_PASSWORD), output);
-            BRIDGE::print(F("\",\"T\":\"S\",\"V\":\""), output);
-            if (!CONFIG::read_string(EP_AP_PASSWORD, sbuf, MAX_PASSWORD_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(F("********"), output);
-            }
-            BRIDGE::print(F("\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MAX_PASSWORD_LENGTH), output);
-            BRIDGE::print(F("\",\"H\":\"AP Password\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MIN_PASSWORD_LENGTH), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //18 - AP Network Mode
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_AP_PHY_MODE), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_AP_PHY_MODE, &bbuf )) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"AP Network Mode\",\"O\":[{\"11b\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(WIFI_PHY_MODE_11B), output);
-            BRIDGE::print(F("\"},{\"11g\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(WIFI_PHY_MODE_11G), output);
-            BRIDGE::print(F("\"}]}"), output);
-            BRIDGE::println(F(","), output);
-
-            //19-AP SSID visibility
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_SSID_VISIBLE), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_SSID_VISIBLE, &bbuf )) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"SSID Visible\",\"O\":[{\"No\":\"0\"},{\"Yes\":\"1\"}]}"), output);
-            BRIDGE::println(F(","), output);
-            
-            //20-AP Channel
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_CHANNEL), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_CHANNEL, &bbuf )) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"AP Channel\",\"O\":["), output);
-            for (int i=1; i < 12 ; i++) {
-                BRIDGE::print(F("{\""), output);
-                BRIDGE::print((const char *)CONFIG::intTostr(i), output);
-                BRIDGE::print(F("\":\""), output);
-                BRIDGE::print((const char *)CONFIG::intTostr(i), output);
-                BRIDGE::print(F("\"}"), output);
-                if (i<11) {
-                    BRIDGE::print(F(","), output);
-                }
-            }
-            BRIDGE::print(F("]}"), output);
-            BRIDGE::println(F(","), output);
-
-            //21-AP Authentication
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_AUTH_TYPE), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_AUTH_TYPE, &bbuf )) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Authentication\",\"O\":[{\"Open\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(AUTH_OPEN), output);
-            BRIDGE::print(F("\"},{\"WPA\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(AUTH_WPA_PSK), output);
-            BRIDGE::print(F("\"},{\"WPA2\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(AUTH_WPA2_PSK), output);
-            BRIDGE::print(F("\"},{\"WPA/WPA2\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(AUTH_WPA_WPA2_PSK), output);
-            BRIDGE::print(F("\"}]}"), output);
-            BRIDGE::println(F(","), output);
-
-            //22-AP IP mode
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_AP_IP_MODE), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_AP_IP_MODE, &bbuf )) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"AP IP Mode\",\"O\":[{\"DHCP\":\"1\"},{\"Static\":\"2\"}]}"), output);
-            BRIDGE::println(F(","), output);
-
-            //23-AP static IP
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_AP_IP_VALUE), output);
-            BRIDGE::print(F("\",\"T\":\"A\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_AP_IP_VALUE,(byte *)ipbuf, IP_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(IPAddress(ipbuf).toString().c_str(), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"AP Static IP\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //24-AP static Mask
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_AP_MASK_VALUE), output);
-            BRIDGE::print(F("\",\"T\":\"A\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_AP_MASK_VALUE,(byte *)ipbuf, IP_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(IPAddress(ipbuf).toString().c_str(), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"AP Static Mask\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //25-AP static Gateway
-            BRIDGE::print(F("{\"F\":\"network\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_AP_GATEWAY_VALUE), output);
-            BRIDGE::print(F("\",\"T\":\"A\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_AP_GATEWAY_VALUE,(byte *)ipbuf, IP_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(IPAddress(ipbuf).toString().c_str(), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"AP Static Gateway\"}"), output);
-            delay(0);
-        }
-        
-        if (cmd_params == "printer" || cmd_params == "") {
-            if (cmd_params == "") {
-                BRIDGE::println(F(","), output);
-            }
-            //Target FW
-            BRIDGE::print(F("{\"F\":\"printer\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_TARGET_FW), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_TARGET_FW, &bbuf )) {
-                BRIDGE::print(F("Unknown"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Target FW\",\"O\":[{\"Repetier\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(REPETIER), output);
-            BRIDGE::print(F("\"},{\"Repetier for Davinci\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(REPETIER4DV), output);
-            BRIDGE::print(F("\"},{\"Marlin\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MARLIN), output);
-            BRIDGE::print(F("\"},{\"Marlin Kimbra\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MARLINKIMBRA), output);
-            BRIDGE::print(F("\"},{\"Smoothieware\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(SMOOTHIEWARE), output);
-            BRIDGE::print(F("\"},{\"Unknown\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(UNKNOWN_FW), output);
-            BRIDGE::print(F("\"}]}"), output);
-            BRIDGE::println(F(","), output);
-            
-            //Refresh time 1
-            BRIDGE::print(F("{\"F\":\"printer\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_REFRESH_PAGE_TIME), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_REFRESH_PAGE_TIME, &bbuf )) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Temperature Refresh Time\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MAX_REFRESH), output);
-            BRIDGE::print(F("\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MIN_REFRESH), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-            
-            //Refresh time 2
-            BRIDGE::print(F("{\"F\":\"printer\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_REFRESH_PAGE_TIME2), output);
-            BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-            if (!CONFIG::read_byte(EP_REFRESH_PAGE_TIME2, &bbuf )) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Position Refresh Time\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MAX_REFRESH), output);
-            BRIDGE::print(F("\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MIN_REFRESH), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //XY feedrate
-            BRIDGE::print(F("{\"F\":\"printer\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_XY_FEEDRATE), output);
-            BRIDGE::print(F("\",\"T\":\"I\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_XY_FEEDRATE,  (byte *)&ibuf, INTEGER_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(ibuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"XY feedrate\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MAX_XY_FEEDRATE), output);
-            BRIDGE::print(F("\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MIN_XY_FEEDRATE), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //Z feedrate
-            BRIDGE::print(F("{\"F\":\"printer\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_Z_FEEDRATE), output);
-            BRIDGE::print(F("\",\"T\":\"I\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_Z_FEEDRATE,  (byte *)&ibuf, INTEGER_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(ibuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"Z feedrate\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MAX_Z_FEEDRATE), output);
-            BRIDGE::print(F("\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MIN_Z_FEEDRATE), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //E feedrate
-            BRIDGE::print(F("{\"F\":\"printer\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_E_FEEDRATE), output);
-            BRIDGE::print(F("\",\"T\":\"I\",\"V\":\""), output);
-            if (!CONFIG::read_buffer(EP_E_FEEDRATE,  (byte *)&ibuf, INTEGER_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print((const char *)CONFIG::intTostr(ibuf), output);
-            }
-            BRIDGE::print(F("\",\"H\":\"E feedrate\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MAX_E_FEEDRATE), output);
-            BRIDGE::print(F("\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MIN_E_FEEDRATE), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            //Camera address, data string
-            BRIDGE::print(F("{\"F\":\"printer\",\"P\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(EP_DATA_STRING), output);
-            BRIDGE::print(F("\",\"T\":\"S\",\"V\":\""), output);
-            if (!CONFIG::read_string(EP_DATA_STRING, sbuf, MAX_DATA_LENGTH)) {
-                BRIDGE::print(F("???"), output);
-            } else {
-                BRIDGE::print(sbuf, output);
-            }
-            BRIDGE::print(F("\",\"S\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MAX_DATA_LENGTH), output);
-            BRIDGE::print(F("\",\"H\":\"Camera address\",\"M\":\""), output);
-            BRIDGE::print((const char *)CONFIG::intTostr(MIN_DATA_LENGTH), output);
-            BRIDGE::print(F("\"}"), output);
-            BRIDGE::println(F(","), output);
-
-            if (Board::pVoltageMonitor != NULL) {
-                // Voltage monitor correction
-                BRIDGE::print(F("{\"F\":\"printer\",\"P\":\""), output);
-                BRIDGE::print((const char *)CONFIG::intTostr(EP_VMON_CORRECTION_PPM), output);
-                BRIDGE::print(F("\",\"T\":\"I\",\"V\":\""), output);
-                if (!CONFIG::read_buffer(EP_VMON_CORRECTION_PPM, (byte *)&ibuf, INTEGER_LENGTH)) {
-                    BRIDGE::print(F("???"), output);
-                } else {
-                    BRIDGE::print((const char *)CONFIG::intTostr(ibuf), output);
-                }
-                BRIDGE::print(F("\",\"H\":\"Voltage Monitor Correction (ppm)\",\"S\":\""), output);
-                BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MAX_VMON_CORRECTION_PPM), output);
-                BRIDGE::print(F("\",\"M\":\""), output);
-                BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MIN_VMON_CORRECTION_PPM), output);
-                BRIDGE::print(F("\"}"), output);
-                BRIDGE::println(F(","), output);
-
-                // Voltage monitor target voltage
-                BRIDGE::print(F("{\"F\":\"printer\",\"P\":\""), output);
-                BRIDGE::print((const char *)CONFIG::intTostr(EP_VMON_TARGET_VOLTAGE_mV), output);
-                BRIDGE::print(F("\",\"T\":\"I\",\"V\":\""), output);
-                if (!CONFIG::read_buffer(EP_VMON_TARGET_VOLTAGE_mV, (byte *)&ibuf, INTEGER_LENGTH)) {
-                    BRIDGE::print(F("???"), output);
-                } else {
-                    BRIDGE::print((const char *)CONFIG::intTostr(ibuf), output);
-                }
-                BRIDGE::print(F("\",\"H\":\"Voltage Monitor Target Voltage (mV)\",\"S\":\""), output);
-                BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MAX_VMON_TARGET_VOLTAGE_mV), output);
-                BRIDGE::print(F("\",\"M\":\""), output);
-                BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MIN_VMON_TARGET_VOLTAGE_mV), output);
-                BRIDGE::print(F("\"}"), output);
-                BRIDGE::println(F(","), output);
-
-                // Voltage monitor alarm threshold in percent
-                BRIDGE::print(F("{\"F\":\"printer\",\"P\":\""), output);
-                BRIDGE::print((const char *)CONFIG::intTostr(EP_VMON_ALARM_THRESHOLD), output);
-                BRIDGE::print(F("\",\"T\":\"B\",\"V\":\""), output);
-                if (!CONFIG::read_byte(EP_VMON_ALARM_THRESHOLD, &bbuf )) {
-                    BRIDGE::print(F("???"), output);
-                } else {
-                    BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
-                }
-                BRIDGE::print(F("\",\"H\":\"Voltage Monitor Alarm Threshold (%)\",\"S\":\""), output);
-                BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MAX_VMON_ALARM_THRESHOLD), output);
-                BRIDGE::print(F("\",\"M\":\""), output);
-                BRIDGE::print((const char *)CONFIG::intTostr(DEFAULT_MIN_VMON_ALARM_THRESHOLD), output);
-                BRIDGE::print(F("\"}"), output);
-            }
-            delay(0);
-        }
         //end EEPROM
         BRIDGE::println(F("],\n"), output);
         bulkAccessor.close();
@@ -1125,10 +585,10 @@ bool COMMAND::execute_command(int cmd,String cmd_params, tpipe output, level_aut
         String sval = get_param(cmd_params,"V=", true);
         sval.trim();
         int pos = spos.toInt();
-        if ((pos == 0 && spos != "0") || (pos > LAST_EEPROM_ADDRESS || pos < 0)) {
+        SettingEntry entry;
+        if ((pos == 0 && spos != "0") || !Settings::find(pos, entry)) {
             response = false;
-        }
-        if (!(styp == "B" || styp == "S" || styp == "A" || styp == "I")) {
+        } else if (styp.length() != 1 || styp[0] != entry.type) {
             response = false;
         }
         if (sval.length() == 0) {
@@ -1139,49 +599,21 @@ bool COMMAND::execute_command(int cmd,String cmd_params, tpipe output, level_aut
 #ifdef AUTHENTICATION_FEATURE
         if (response) {
             //check authentication
-            level_authenticate_type auth_need = LEVEL_ADMIN;
-            for (int i = 0; i < AUTH_ENTRY_NB; i++) {
-                if (Setting[i][0] == pos ) {
-                    auth_need = (level_authenticate_type)(Setting[i][1]);
-                    i = AUTH_ENTRY_NB;
-                }
-            }
+            level_authenticate_type auth_need = (entry.flags & SETTING_ADMIN) ? LEVEL_ADMIN : LEVEL_USER;
             if ((auth_need == LEVEL_ADMIN && auth_type == LEVEL_USER) || (auth_type == LEVEL_GUEST)) {
                 response = false;
             }
         }
 #endif
         if (response) {
-            if (styp == "B") {
-                byte bbuf = sval.toInt();
-                if(!CONFIG::write_byte(pos,bbuf)) {
-                    response = false;
-                    } else {
-                    //dynamique refresh is better than restart the board
-                    if (pos == EP_TARGET_FW) CONFIG::InitFirmwareTarget();
-                    if (pos == EP_IS_DIRECT_SD){
-                        CONFIG::InitDirectSD();
-                        }
+            if (!Settings::write(entry, sval)) {
+                response = false;
+            } else {
+                //dynamique refresh is better than restart the board
+                if (pos == EP_TARGET_FW) CONFIG::InitFirmwareTarget();
+                if (pos == EP_IS_DIRECT_SD){
+                    CONFIG::InitDirectSD();
                     }
-                }
-            if (styp == "I") {
-                int ibuf = sval.toInt();
-                if(!CONFIG::write_buffer(pos,(const byte *)&ibuf,INTEGER_LENGTH)) {
-                    response = false;
-                }
-            }
-            if (styp == "S") {
-                if(!CONFIG::write_string(pos,sval.c_str())) {
-                    response = false;
-                }
-            }
-            if (styp == "A") {
-                byte ipbuf[4];
-                if (CONFIG::split_ip(sval.c_str(),ipbuf) < 4) {
-                    response = false;
-                } else if(!CONFIG::write_buffer(pos,ipbuf,IP_LENGTH)) {
-                    response = false;
-                }
             }
         }
         if(!response) {
@@ -1340,7 +772,7 @@ bool COMMAND::execute_command(int cmd,String cmd_params, tpipe output, level_aut
     //[ESP700]<filename>
     case 700: { //read local file
         //be sure serial is locked
-        if ((web_interface->blockserial)) {
+        if (web_interface->isSerialLocked()) {
             break;
         }
         cmd_params.trim() ;
@@ -1410,6 +842,9 @@ bool COMMAND::execute_command(int cmd,String cmd_params, tpipe output, level_aut
 			 //SPIFFS.end();
 			 delay(0);
 			 SPIFFS.format();
+			 //settings journal was erased too
+			 SettingsStore::compact();
+			 StaticAssets::begin();
 			 //SPIFFS.begin();
 			 BRIDGE::println(F("...Done"), output);
             } else {
@@ -1483,6 +918,47 @@ bool COMMAND::execute_command(int cmd,String cmd_params, tpipe output, level_aut
         if (CONFIG::check_update_presence( ))  BRIDGE::println("yes", output);
         else BRIDGE::println("no", output);
         break;
+#if defined(ERROR_MSG_FEATURE) || defined(INFO_MSG_FEATURE) || defined(STATUS_MSG_FEATURE)
+    //list status/error/info messages newer than since, oldest first
+    //one line per message: <seq> <time> <INFO|ERROR|STATUS> <text>
+    //[ESP998]since=<seq>
+    case 998: {
+        uint32_t since = strtoul(get_param(cmd_params, "since=", false).c_str(), NULL, 10);
+        struct source {
+            STORESTRINGS_CLASS * list;
+            const char * name;
+            int pos;
+        };
+        StaticVector<source, 3> sources;
+#ifdef INFO_MSG_FEATURE
+        sources.push({&web_interface->info_msg, "INFO", web_interface->info_msg.first_after(since)});
+#endif
+#ifdef ERROR_MSG_FEATURE
+        sources.push({&web_interface->error_msg, "ERROR", web_interface->error_msg.first_after(since)});
+#endif
+#ifdef STATUS_MSG_FEATURE
+        sources.push({&web_interface->status_msg, "STATUS", web_interface->status_msg.first_after(since)});
+#endif
+        //lists are merged by sequence number
+        while (true) {
+            source * next = NULL;
+            for (source & s : sources) {
+                if (s.pos < s.list->size() && (!next || s.list->getseq(s.pos) < next->list->getseq(next->pos))) {
+                    next = &s;
+                }
+            }
+            if (!next) {
+                break;
+            }
+            BRIDGE::print(String(next->list->getseq(next->pos)) + " " + String(next->list->gettime(next->pos)) + " ", output);
+            BRIDGE::print(next->name, output);
+            BRIDGE::print(" ", output);
+            BRIDGE::println(next->list->get(next->pos), output);
+            next->pos++;
+        }
+        break;
+    }
+#endif
     //[ESP999]<cmd>
     case 999:
         cmd_params.trim();
@@ -1520,6 +996,7 @@ bool COMMAND::execute_command(int cmd,String cmd_params, tpipe output, level_aut
             BRIDGE::printStatus(OK_CMD_MSG, output);
             break;
         }
+        //unknown list: fall through
     default:
         BRIDGE::printStatus(INCORRECT_CMD_MSG, output);
         response = false;
@@ -1527,194 +1004,146 @@ bool COMMAND::execute_command(int cmd,String cmd_params, tpipe output, level_aut
     return response;
 }
 
-bool COMMAND::check_command(const String & buffer, tpipe output, bool handlelockserial)
+bool COMMAND::check_command(const String & buffer, tpipe output)
+{
+    return check_command(buffer.c_str(), buffer.length(), output);
+}
+
+#if defined(ERROR_MSG_FEATURE) || defined(INFO_MSG_FEATURE) || defined(STATUS_MSG_FEATURE)
+//copy message without quotes as they would break the json of the status page
+static void add_message(STORESTRINGS_CLASS & list, const char * msg)
+{
+    char text[COMMAND_LINE_SIZE + 1];
+    size_t len = 0;
+    for (; *msg && len < COMMAND_LINE_SIZE; msg++) {
+        if (*msg != '"' && *msg != '\'') {
+            text[len++] = *msg;
+        }
+    }
+    text[len] = 0;
+    list.add(text);
+}
+#endif
+
+//line must be NUL terminated, len is its length
+bool COMMAND::check_command(const char * line, size_t len, tpipe output)
 {
-    String buffer2;
     LOG("Check Command:")
-    LOG(buffer)
+    LOG(line)
     LOG("\r\n")
-    bool is_temp = false;
-    if ((buffer.indexOf("T:") > -1 ) || (buffer.indexOf("B:") > -1 )) is_temp = true;
+    Response response;
+    ResponseClassifier::classify(line, len, response);
+    bool is_temp = response.is(Response_Temperature);
+#ifdef TCP_IP_DATA_FEATURE
+    //lines from tcp are commands for the printer, not its answers
+    if (output != TCP_PIPE)
+#endif
+    {
+        PrinterState::update(line, response);
+#ifdef EVENTS_FEATURE
+        if (EventStream::hasClients() && response.is(Response_Temperature | Response_Position | Response_SdProgress | Response_SdIdle)) {
+            const String & state = PrinterState::json();
+            EventStream::send("state", state.c_str(), state.length());
+        }
+#endif
+    }
     //feed the WD for safety
     delay(0);
     if (( CONFIG::GetFirmwareTarget()  == REPETIER4DV) || (CONFIG::GetFirmwareTarget() == REPETIER)) {
         //save time no need to continue
-        if ((buffer.indexOf("busy:") > -1) || (buffer.startsWith("wait"))) {
+        if (response.is(Response_Busy | Response_Wait | Response_Ok)) {
             return false;
         }
-        if (buffer.startsWith("ok")) {
-            return false;
-        }
-    }   
-#ifdef ERROR_MSG_FEATURE
-        int Errorpos = -1;
-#endif
-#ifdef INFO_MSG_FEATURE
-        int Infopos = -1;
-#endif
-#ifdef STATUS_MSG_FEATURE
-        int Statuspos = -1;
-#endif
-if (CONFIG::GetFirmwareTarget()  == SMOOTHIEWARE) {
-#ifdef ERROR_MSG_FEATURE
-        Errorpos= buffer.indexOf(F("error:"));
-#endif
-#ifdef INFO_MSG_FEATURE
-        Infopos= buffer.indexOf(F("info:"));
-#endif
-#ifdef STATUS_MSG_FEATURE
-        Statuspos= buffer.indexOf(F("warning:"));
-#endif
-} else {
-#ifdef ERROR_MSG_FEATURE
-        Errorpos= buffer.indexOf(F("Error:"));
-#endif
-#ifdef INFO_MSG_FEATURE
-        Infopos= buffer.indexOf(F("Info:"));
-#endif
-#ifdef STATUS_MSG_FEATURE
-    Statuspos= -1;
-    if (CONFIG::GetFirmwareTarget()  == MARLIN){
-        Statuspos= buffer.indexOf(F("echo:"));
-    }
-    else {
-        Statuspos= buffer.indexOf(F("Status:"));
     }
-
-#endif
-}
-
 #ifdef SERIAL_COMMAND_FEATURE
-        String ESP_Command;
-        int ESPpos = buffer.indexOf("[ESP");
-        if (ESPpos>-1) {
-            //is there the second part?
-            int ESPpos2 = buffer.indexOf("]",ESPpos);
-            if (ESPpos2>-1) {
-                //Split in command and parameters
-                String cmd_part1=buffer.substring(ESPpos+4,ESPpos2);
-                String cmd_part2="";
-                //is there space for parameters?
-                if (ESPpos2<buffer.length()) {
-                    cmd_part2=buffer.substring(ESPpos2+1);
-                }
-                //if command is a valid number then execute command
-                if(cmd_part1.toInt()!=0) {
-                    execute_command(cmd_part1.toInt(),cmd_part2,output);
-                }
-                //if not is not a valid [ESPXXX] command
+    if (response.is(Response_EspCommand)) {
+        const char * ESPpos = ResponseClassifier::field(line, response, ResponseField_EspCommand);
+        //is there the second part?
+        const char * ESPpos2 = strchr(ESPpos, ']');
+        if (ESPpos2) {
+            //Split in command and parameters, if command is a valid number then execute command
+            int cmd = atoi(ESPpos);
+            if(cmd != 0) {
+                execute_command(cmd, String(ESPpos2 + 1), output);
             }
+            //if not is not a valid [ESPXXX] command
         }
+    }
 #endif
 #ifdef ERROR_MSG_FEATURE
-        //Error
-        if (Errorpos>-1 && !(buffer.indexOf(F("Format error"))!=-1 || buffer.indexOf("wait")==Errorpos+6) ) {
-            String ss = buffer.substring(Errorpos+6);
-            ss.replace("\"","");
-            ss.replace("'","");
-            (web_interface->error_msg).add(ss.c_str());
+    //Error
+    if (response.is(Response_Error) && !response.is(Response_FormatError)) {
+        const char * msg = ResponseClassifier::field(line, response, ResponseField_Error);
+        if (strncmp(msg, "wait", 4) != 0) {
+            add_message(web_interface->error_msg, msg);
+#ifdef EVENTS_FEATURE
+            EventStream::send("error", msg);
+#endif
         }
+    }
 #endif
 #ifdef INFO_MSG_FEATURE
-        //Info
-        if (Infopos>-1) {
-            String ss = buffer.substring(Errorpos+5);
-            ss.replace("\"","");
-            ss.replace("'","");
-            (web_interface->info_msg).add(ss.c_str());
-        }
+    //Info
+    if (response.is(Response_Info)) {
+        const char * msg = ResponseClassifier::field(line, response, ResponseField_Info);
+        add_message(web_interface->info_msg, msg);
+#ifdef EVENTS_FEATURE
+        EventStream::send("info", msg);
+#endif
+    }
 #endif
 #ifdef STATUS_MSG_FEATURE
-        //Status
-        if (Statuspos>-1) {
-            String ss ;
-            if (CONFIG::GetFirmwareTarget() == SMOOTHIEWARE)ss = buffer.substring(Errorpos+8);
-            else if (CONFIG::GetFirmwareTarget() == MARLIN) ss = buffer.substring(Errorpos+5);
-            else ss = buffer.substring(Errorpos+7);
-            ss.replace("\"","");
-            ss.replace("'","");
-            (web_interface->info_msg).add(ss.c_str());
-        }
+    //Status
+    if (response.is(Response_Status)) {
+        const char * msg = ResponseClassifier::field(line, response, ResponseField_Status);
+        add_message(web_interface->status_msg, msg);
+#ifdef EVENTS_FEATURE
+        EventStream::send("status", msg);
 #endif
-    
+    }
+#endif
+
     return is_temp;
 }
 
 //read a buffer in an array
-void COMMAND::read_buffer_serial(uint8_t *b, size_t len)
+void COMMAND::read_buffer_serial(const uint8_t *b, size_t len)
 {
-    for (long i = 0; i< len; i++) {
-        read_buffer_serial(b[i]);
-       //*b++;
-    }
+    serial_framer.feed(b, len);
 }
 
 #ifdef TCP_IP_DATA_FEATURE
+//read a buffer in an array
+void COMMAND::read_buffer_tcp(const uint8_t *b, size_t len)
+{
+    tcp_framer.feed(b, len);
+}
+
 //read buffer as char
 void COMMAND::read_buffer_tcp(uint8_t b)
 {
-    static bool previous_was_char=false;
-    static bool iscomment=false;
-//to ensure it is continuous string, no char separated by binaries
-    if (!previous_was_char) {
-        buffer_tcp="";
-        iscomment = false;
-    }
-//is comment ?
-    if (char(b) == ';') {
-        iscomment = true;
-    }
-//it is a char so add it to buffer
-    if (isPrintable(b)) {
-        previous_was_char=true;
-        //add char if not a comment
-        if (!iscomment) {
-            buffer_tcp+=char(b);
-        }
-    } else {
-        previous_was_char=false; //next call will reset the buffer
-    }
-//this is not printable but end of command check if need to handle it
-    if (b==13 || b==10) {
-        //reset comment flag
-        iscomment = false;
-        //Minimum is something like M10 so 3 char
-        if (buffer_tcp.length()>3) {
-            check_command(buffer_tcp, TCP_PIPE);
-        }
-    }
+    tcp_framer.feed(b);
+}
+
+void COMMAND::process_tcp_line(const char * line, size_t len)
+{
+    check_command(line, len, TCP_PIPE);
 }
 #endif
 //read buffer as char
 void COMMAND::read_buffer_serial(uint8_t b)
 {
-    static bool previous_was_char=false;
-    static bool iscomment=false;
-//to ensure it is continuous string, no char separated by binaries
-    if (!previous_was_char) {
-        buffer_serial="";
-        iscomment = false;
-    }
-//is comment ?
-    if (char(b) == ';') {
-        iscomment = true;
-    }
-//it is a char so add it to buffer
-    if (isPrintable(b)) {
-        previous_was_char=true;
-        if (!iscomment) {
-            buffer_serial+=char(b);
-        }
-    } else {
-        previous_was_char=false; //next call will reset the buffer
-    }
-//this is not printable but end of command check if need to handle it
-    if (b==13 || b==10) {
-        //reset comment flag
-        iscomment = false;
-        //Minimum is something like M10 so 3 char
-        if (buffer_serial.length()>3) {
-            check_command(buffer_serial, SERIAL_PIPE);
-        }
-    }
+    serial_framer.feed(b);
+}
+
+void COMMAND::process_serial_line(const char * line, size_t len)
+{
+    //every line goes to the printer state, a bare "ok" ends a busy period,
+    //an [ESP] command or a message needs more than 3 char anyway
+    check_command(line, len, SERIAL_PIPE);
+    //answer to a web command
+    CommandQueue::onSerialLine(line, len);
+#ifdef EVENTS_FEATURE
+    EventStream::send("line", line, len);
+#endif
 }
@@ -22,22 +22,32 @@
 #define COMMAND_h
 #include <Arduino.h>
 #include "bridge.h"
+#include "lineframer.h"
 
 class COMMAND
 {
 public:
-    static String buffer_serial;
-    static String buffer_tcp;
-    static void read_buffer_serial(uint8_t *b, size_t len);
+    static LineFramer<COMMAND_LINE_SIZE> serial_framer;
+#ifdef TCP_IP_DATA_FEATURE
+    static LineFramer<COMMAND_LINE_SIZE> tcp_framer;
+#endif
+    static void read_buffer_serial(const uint8_t *b, size_t len);
     static void read_buffer_serial(uint8_t b);
 #ifdef TCP_IP_DATA_FEATURE
+    static void read_buffer_tcp(const uint8_t *b, size_t len);
     static void read_buffer_tcp(uint8_t b);
 #endif
-    static bool check_command(const String & buffer, tpipe output, bool handlelockserial = true);
+    static bool check_command(const String & buffer, tpipe output);
+    static bool check_command(const char * line, size_t len, tpipe output);
     static bool execute_command(int cmd,String cmd_params, tpipe output, level_authenticate_type auth_level = LEVEL_GUEST);
     static String get_param(const String & cmd_params, const char * id, bool withspace = false);
     static bool isadmin(const String & cmd_params);
     static bool isuser(const String & cmd_params);
+private:
+    static void process_serial_line(const char * line, size_t len);
+#ifdef TCP_IP_DATA_FEATURE
+    static void process_tcp_line(const char * line, size_t len);
+#endif
 };
 
 #endif
@@ -0,0 +1,154 @@
+/*
+  commandqueue.cpp - printer commands from web clients answered asynchronously
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "commandqueue.h"
+#include "board.h"
+#include "webinterface.h"
+#include "responseclassifier.h"
+
+// answer is sent as soon as it comes, the end of the body is the close
+static const char COMMAND_RESPONSE_HEADER[] PROGMEM =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+CommandQueue::Entry CommandQueue::_entries[WEB_COMMAND_QUEUE_SIZE];
+uint8_t CommandQueue::_head = 0;
+uint8_t CommandQueue::_count = 0;
+bool CommandQueue::_active = false;
+WiFiClient CommandQueue::_client;
+bool CommandQueue::_silent = false;
+String CommandQueue::_output;
+bool CommandQueue::_dataSent = false;
+uint8_t CommandQueue::_tempCounter = 0;
+Timer CommandQueue::_timer;
+
+bool CommandQueue::push(const String &command, WiFiClient client)
+{
+    if (isFull()) {
+        return false;
+    }
+    Entry &entry = _entries[(_head + _count) % WEB_COMMAND_QUEUE_SIZE];
+    entry.command = command;
+    entry.silent = !client;
+    if (!entry.silent) {
+        client.write_P(COMMAND_RESPONSE_HEADER, strlen_P(COMMAND_RESPONSE_HEADER));
+        entry.client = client;
+    }
+    _count++;
+    return true;
+}
+
+void CommandQueue::update()
+{
+    if (!_active) {
+        //wait for the serial to be free, an SD upload may use it
+        if ((_count == 0) || web_interface->isSerialLocked()) {
+            return;
+        }
+        start();
+        return;
+    }
+    flush();
+    if (!_silent && !_client.connected()) {
+        LOG("Client gone\r\n")
+        finish();
+    } else if (_timer.milliSeconds() > WEB_COMMAND_TIMEOUT) {
+        LOG("Command timeout\r\n")
+        finish();
+    }
+}
+
+void CommandQueue::start()
+{
+    Entry &entry = _entries[_head];
+    _head = (_head + 1) % WEB_COMMAND_QUEUE_SIZE;
+    _count--;
+    _silent = entry.silent;
+    _client = entry.client;
+    entry.client = WiFiClient();
+    //client may have given up while waiting
+    if (!_silent && !_client.connected()) {
+        _client = WiFiClient();
+        entry.command = String();
+        return;
+    }
+    //block tcp input so only this command gets an answer
+    web_interface->lockSerial(SERIAL_LOCK_COMMAND);
+    LOG("Send Command\r\n")
+    Board::printerPort.println(entry.command);
+    entry.command = String();
+    _output = String();
+    _dataSent = false;
+    _tempCounter = 0;
+    _active = true;
+    _timer.restart();
+}
+
+void CommandQueue::onSerialLine(const char *line, size_t len)
+{
+    if (!_active) {
+        return;
+    }
+    _timer.restart();
+    Response response;
+    ResponseClassifier::classify(line, len, response);
+    bool repetier = (CONFIG::GetFirmwareTarget() == REPETIER) || (CONFIG::GetFirmwareTarget() == REPETIER4DV);
+    //if line is command ack - it is the end of the answer
+    if (response.is(Response_Ok | Response_Wait)) {
+        //keep what comes with the ok like temperatures, Repetier only
+        //adds the line number
+        if (!repetier && response.is(Response_Ok) && (len > 2)) {
+            _output += line;
+            _output += "\n";
+        }
+        finish();
+        return;
+    }
+    //it is sending too many temp status should be heating so let's stop
+    if (response.is(Response_Temperature) || (repetier && response.is(Response_Busy))) {
+        if (++_tempCounter > 5) {
+            finish();
+            return;
+        }
+    }
+    if (!_silent) {
+        _output += line;
+        _output += "\n";
+    }
+}
+
+void CommandQueue::flush()
+{
+    if (_output.length() == 0) {
+        return;
+    }
+    if (!_silent) {
+        _client.write(_output.c_str(), _output.length());
+        _dataSent = true;
+    }
+    _output = String();
+}
+
+void CommandQueue::finish()
+{
+    flush();
+    if (!_silent) {
+        if (!_dataSent) {
+            _client.print(F(" \r\n"));
+        }
+        _client.stop();
+    }
+    _client = WiFiClient();
+    _active = false;
+    web_interface->unlockSerial(SERIAL_LOCK_COMMAND);
+    LOG("Release Serial\r\n")
+}
@@ -0,0 +1,59 @@
+/*
+  commandqueue.h - printer commands from web clients answered asynchronously
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include "config.h"
+#include "timer.h"
+
+
+// CommandQueue
+// Web requests only enqueue their command. The main loop sends the commands
+// one after the other, the printer answer reaches the active one through
+// the serial line parser and its HTTP response is completed when "ok" or
+// "wait" comes back or when the printer stays silent for too long. Commands
+// without client (silent commands) are sent the same way and their answer
+// is dropped.
+class CommandQueue
+{
+public:
+    // false if the queue is full, an unconnected client means silent command
+    static bool push(const String &command, WiFiClient client = WiFiClient());
+    static bool isFull()
+    {
+        return _count >= WEB_COMMAND_QUEUE_SIZE;
+    }
+    static void update();
+    static void onSerialLine(const char *line, size_t len);
+
+private:
+    struct Entry
+    {
+        String command;
+        WiFiClient client;
+        bool silent;
+    };
+
+    static Entry _entries[WEB_COMMAND_QUEUE_SIZE];
+    static uint8_t _head;
+    static uint8_t _count;
+    static bool _active;
+    static WiFiClient _client;
+    static bool _silent;
+    static String _output;
+    static bool _dataSent;
+    static uint8_t _tempCounter;
+    static Timer _timer;
+
+    static void start();
+    static void flush();
+    static void finish();
+};
@@ -19,7 +19,8 @@
 */
 #include "config.h"
 #include "board.h"
-#include <EEPROM.h>
+#include "settings.h"
+#include "settingsstore.h"
 #ifndef FS_NO_GLOBALS
 #define FS_NO_GLOBALS
 #endif
@@ -35,16 +36,24 @@ extern "C" {
 #include "esp_wifi.h"
 #endif
 #include "bridge.h"
+#include "responseclassifier.h"
 
 
 uint8_t CONFIG::FirmwareTarget = UNKNOWN_FW;
 volatile int CONFIG::EEPROMAccessor::_numInstances = 0;
 volatile bool CONFIG::EEPROMAccessor::_dirty = false;
+bool CONFIG::EEPROMAccessor::_loaded = false;
+uint32_t CONFIG::EEPROMAccessor::_changeTime = 0;
+uint32_t CONFIG::EEPROMAccessor::_commitCount = 0;
 
 CONFIG::EEPROMAccessor::EEPROMAccessor() : _isClosed(false)
 {
-    if (_numInstances++ == 0)
-        EEPROM.begin(EEPROM_SIZE);
+    //the sector is copied once and stays in RAM
+    if (!_loaded) {
+        _loaded = true;
+        SettingsStore::begin();
+    }
+    ++_numInstances;
 }
 
 CONFIG::EEPROMAccessor::~EEPROMAccessor()
@@ -73,33 +82,66 @@ CONFIG::EEPROMAccessor& CONFIG::EEPROMAccessor::operator=(const CONFIG::EEPROMAc
 void CONFIG::EEPROMAccessor::close()
 {
     if (!_isClosed) {
-        if (--_numInstances == 0) {
-            EEPROM.end();
-            if (_dirty) {
-                _dirty = false;
-                Board::status.print("Cfg. saved");
-            }
-        }
+        --_numInstances;
         _isClosed = true;
     }
 }
 
 uint8_t CONFIG::EEPROMAccessor::read(int address)
 {
-    return EEPROM.read(address);
+    if (address < 0 || address >= EEPROM_SIZE) {
+        return 0;
+    }
+    return SettingsStore::read(address);
 }
 
 void CONFIG::EEPROMAccessor::write(int address, uint8_t value)
 {
-    if (_numInstances > 0)
-        _dirty = true;
+    if (address < 0 || address >= EEPROM_SIZE || SettingsStore::read(address) == value) {
+        return;
+    }
+    _dirty = true;
+    _changeTime = millis();
+    SettingsStore::write(address, value);
+}
 
-    EEPROM.write(address, value);
+// Writes go to the RAM copy only, they are committed to the settings
+// journal once the settings stay unchanged for SETTINGS_COMMIT_DELAY, so a
+// burst of [ESP401] from the web UI makes one record.
+void CONFIG::update()
+{
+    if (EEPROMAccessor::_dirty && EEPROMAccessor::_numInstances == 0 &&
+        (millis() - EEPROMAccessor::_changeTime) >= SETTINGS_COMMIT_DELAY) {
+        flush();
+    }
+}
+
+// Writes changed settings to flash now, needed before a restart
+void CONFIG::flush()
+{
+    if (!EEPROMAccessor::_dirty) {
+        return;
+    }
+    if (SettingsStore::commit()) {
+        EEPROMAccessor::_dirty = false;
+        EEPROMAccessor::_commitCount++;
+        Board::status.print("Cfg. saved");
+    } else {
+        //tried again after the delay
+        EEPROMAccessor::_changeTime = millis();
+        LOG("Error saving settings\r\n")
+    }
+}
+
+uint32_t CONFIG::commitCount()
+{
+    return EEPROMAccessor::_commitCount;
 }
 
 bool CONFIG::SetFirmwareTarget(uint8_t fw){
     if ( fw <= MAX_FW_ID) {
         FirmwareTarget = fw;
+        ResponseClassifier::setFirmwareTarget(fw);
         return true;
     } else return false;
 }
@@ -786,6 +828,7 @@ bool CONFIG::update_settings(){
 void CONFIG::esp_restart()
 {
     LOG("Restarting\r\n")
+    flush();
     Board::status.print(F("Restarting..."));
     Board::printerPort.flush();
     delay(500);
@@ -801,8 +844,8 @@ void CONFIG::esp_restart()
 
 bool CONFIG::is_direct_sd = false;
 
-// The method improves performance when multiple settings are accessed subsequently
-// by preventing CONFIG class from re-reading EEPROM before accessing each setting.
+// The method groups settings accessed subsequently: while an accessor is open
+// changed settings are not written to flash, so they are saved together.
 // An accessor returned by the method should be closed after accessing the settings.
 // If not closed explicitly, accessor does this automatically when its detructor is called.
 CONFIG::EEPROMAccessor CONFIG::beginBulkAccess()
@@ -1221,31 +1264,9 @@ bool CONFIG::write_string(int pos, const char * byte_buffer)
     int maxsize = EEPROM_SIZE;
     size_buffer= strlen(byte_buffer);
     //check if parameters are acceptable
-    switch (pos) {
-    case EP_ADMIN_PWD:
-    case EP_USER_PWD:
-        maxsize = MAX_LOCAL_PASSWORD_LENGTH;
-        break;
-    case EP_AP_SSID:
-    case EP_STA_SSID:
-        maxsize = MAX_SSID_LENGTH;
-        break;
-    case EP_AP_PASSWORD:
-    case EP_STA_PASSWORD:
-        maxsize = MAX_PASSWORD_LENGTH;
-        break;
-    case EP_HOSTNAME:
-        maxsize = MAX_HOSTNAME_LENGTH;
-        break;
-    case EP_TIME_SERVER1:
-    case EP_TIME_SERVER2:
-    case EP_TIME_SERVER3:
-    case EP_DATA_STRING:
-        maxsize = MAX_DATA_LENGTH;
-        break;
-    default:
-        maxsize = EEPROM_SIZE;
-        break;
+    SettingEntry entry;
+    if (Settings::find(pos, entry) && entry.type == SETTING_STRING) {
+        maxsize = entry.max;
     }
     if ((size_buffer==0 && !(pos == EP_DATA_STRING)) ||  pos+size_buffer+1 > EEPROM_SIZE || size_buffer > maxsize  || byte_buffer== NULL) {
         LOG("Error write string\r\n")
@@ -1310,52 +1331,7 @@ bool CONFIG::reset_config()
 
     // Open EEPROM to avoid multiple writes
     EEPROMAccessor eepromAccessor = beginBulkAccess();
-    bool succeeded =
-        write_string(EP_DATA_STRING,"") &&
-        write_byte(EP_WIFI_MODE,DEFAULT_WIFI_MODE) &&
-        write_buffer(EP_BAUD_RATE,(const byte *)&DEFAULT_BAUD_RATE,INTEGER_LENGTH) &&
-        write_string(EP_AP_SSID,FPSTR(DEFAULT_AP_SSID)) &&
-        write_string(EP_AP_PASSWORD,FPSTR(DEFAULT_AP_PASSWORD)) &&
-        write_string(EP_STA_SSID,FPSTR(DEFAULT_STA_SSID)) &&
-        write_string(EP_STA_PASSWORD,FPSTR(DEFAULT_STA_PASSWORD)) &&
-        write_byte(EP_AP_IP_MODE,DEFAULT_AP_IP_MODE) &&
-        write_byte(EP_STA_IP_MODE,DEFAULT_STA_IP_MODE) &&
-        write_buffer(EP_STA_IP_VALUE,DEFAULT_IP_VALUE,IP_LENGTH) &&
-        write_buffer(EP_STA_MASK_VALUE,DEFAULT_MASK_VALUE,IP_LENGTH) &&
-        write_buffer(EP_STA_GATEWAY_VALUE,DEFAULT_GATEWAY_VALUE,IP_LENGTH) &&
-        write_byte(EP_STA_PHY_MODE,DEFAULT_PHY_MODE) &&
-        write_buffer(EP_AP_IP_VALUE,DEFAULT_IP_VALUE,IP_LENGTH) &&
-        write_buffer(EP_AP_MASK_VALUE,DEFAULT_MASK_VALUE,IP_LENGTH) &&
-        write_buffer(EP_AP_GATEWAY_VALUE,DEFAULT_GATEWAY_VALUE,IP_LENGTH) &&
-        write_byte(EP_AP_PHY_MODE,DEFAULT_PHY_MODE) &&
-        write_byte(EP_SLEEP_MODE,DEFAULT_SLEEP_MODE) &&
-        write_byte(EP_CHANNEL,DEFAULT_CHANNEL) &&
-        write_byte(EP_AUTH_TYPE,DEFAULT_AUTH_TYPE) &&
-        write_byte(EP_SSID_VISIBLE,DEFAULT_SSID_VISIBLE) &&
-        write_buffer(EP_WEB_PORT,(const byte*)&DEFAULT_WEB_PORT,INTEGER_LENGTH) &&
-        write_buffer(EP_DATA_PORT,(const byte*)&DEFAULT_DATA_PORT,INTEGER_LENGTH) &&
-        write_byte(EP_REFRESH_PAGE_TIME,DEFAULT_REFRESH_PAGE_TIME) &&
-        write_byte(EP_REFRESH_PAGE_TIME2,DEFAULT_REFRESH_PAGE_TIME) &&
-        write_string(EP_HOSTNAME,wifi_config.get_default_hostname()) &&
-        write_buffer(EP_XY_FEEDRATE,(const byte *)&DEFAULT_XY_FEEDRATE,INTEGER_LENGTH) &&
-        write_buffer(EP_Z_FEEDRATE,(const byte *)&DEFAULT_Z_FEEDRATE,INTEGER_LENGTH) &&
-        write_buffer(EP_E_FEEDRATE,(const byte *)&DEFAULT_E_FEEDRATE,INTEGER_LENGTH) &&
-        write_string(EP_ADMIN_PWD,FPSTR(DEFAULT_ADMIN_PWD)) &&
-        write_string(EP_USER_PWD,FPSTR(DEFAULT_USER_PWD)) &&
-        write_byte(EP_TARGET_FW, UNKNOWN_FW) &&
-        write_byte(EP_TIMEZONE, DEFAULT_TIME_ZONE) &&
-        write_byte(EP_TIME_ISDST, DEFAULT_TIME_DST) &&
-        write_byte(EP_PRIMARY_SD, DEFAULT_PRIMARY_SD) &&
-        write_byte(EP_SECONDARY_SD, DEFAULT_SECONDARY_SD) &&
-        write_byte(EP_IS_DIRECT_SD, DEFAULT_IS_DIRECT_SD) &&
-        write_byte(EP_DIRECT_SD_CHECK, DEFAULT_DIRECT_SD_CHECK) &&
-        write_byte(EP_SD_CHECK_UPDATE_AT_BOOT, DEFAULT_SD_CHECK_UPDATE_AT_BOOT) &&
-        write_string(EP_TIME_SERVER1,FPSTR(DEFAULT_TIME_SERVER1)) &&
-        write_string(EP_TIME_SERVER2,FPSTR(DEFAULT_TIME_SERVER2)) &&
-        write_string(EP_TIME_SERVER3,FPSTR(DEFAULT_TIME_SERVER3)) &&
-        write_buffer(EP_VMON_CORRECTION_PPM, (const byte *)&DEFAULT_VMON_CORRECTION_PPM, INTEGER_LENGTH) &&
-        write_buffer(EP_VMON_TARGET_VOLTAGE_mV, (const byte *)&DEFAULT_VMON_TARGET_VOLTAGE_mV, INTEGER_LENGTH) &&
-        write_byte(EP_VMON_ALARM_THRESHOLD, DEFAULT_VMON_ALARM_THRESHOLD);
+    bool succeeded = Settings::reset();
     eepromAccessor.close();
 
     return succeeded;
@@ -1412,6 +1388,12 @@ void CONFIG::print_config(tpipe output, bool plaintext)
     BRIDGE::print(formatBytes(ESP.getFreeHeap()).c_str(), output);
     if (!plaintext)BRIDGE::print(F("\","), output);
     else BRIDGE::print(F("\n"), output);
+
+    if (!plaintext)BRIDGE::print(F("\"settings_commits\":\""), output);
+    else BRIDGE::print(F("Settings commits: "), output);
+    BRIDGE::print(String(commitCount()).c_str(), output);
+    if (!plaintext)BRIDGE::print(F("\","), output);
+    else BRIDGE::print(F("\n"), output);
     
     if (!plaintext)BRIDGE::print(F("\""), output);
     BRIDGE::print(F("SDK"), output);
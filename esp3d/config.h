@@ -46,6 +46,7 @@
 #define SPIFFS_FILE_READ FILE_READ
 #define SD_FILE_WRITE FILE_WRITE
 #define SPIFFS_FILE_WRITE FILE_WRITE
+#define SPIFFS_FILE_APPEND FILE_APPEND
 #else
 #define FS_DIR fs::Dir
 #define FS_FILE fs::File
@@ -53,6 +54,7 @@
 #define SPIFFS_FILE_READ "r"
 #define SD_FILE_WRITE FILE_WRITE
 #define SPIFFS_FILE_WRITE "w"
+#define SPIFFS_FILE_APPEND "a"
 #endif
 
 #define MAX_FW_ID REPETIER
@@ -67,6 +69,9 @@
 //number of clients allowed to use data port at once
 #define MAX_SRV_CLIENTS 1
 
+//number of websocket clients allowed to use serial at once
+#define MAX_WS_CLIENTS 1
+
 //comment to disable
 //MDNS_FEATURE: this feature allow  type the name defined
 //in web browser by default: http:\\esp8266.local and connect
@@ -102,6 +107,14 @@
 //TCP_IP_DATA_FEATURE: allow to connect serial from TCP/IP
 #define TCP_IP_DATA_FEATURE
 
+//WS_DATA_FEATURE: same as TCP_IP_DATA_FEATURE from a browser using websocket on /ws
+#define WS_DATA_FEATURE
+
+//websocket reuses the TCP data port buffers
+#if defined(WS_DATA_FEATURE) && !defined(TCP_IP_DATA_FEATURE)
+#undef WS_DATA_FEATURE
+#endif
+
 //DIRECT_PIN_FEATURE: allow to access pin using ESP201 command
 //only those pins which are not used in the bord configuration file
 //are available for direct I/O
@@ -116,9 +129,60 @@
 //STATUS_MSG_FEATURE: catch the status msg and filter it to specific table
 #define STATUS_MSG_FEATURE
 
+//EVENTS_FEATURE: push printer output and messages to web clients on /events
+#define EVENTS_FEATURE
+
 //Serial rx buffer size is 256 but can be extended
 #define SERIAL_RX_BUFFER_SIZE 512
 
+//Size of each serial<->TCP bridge ring buffer, must be a power of 2
+#define BRIDGE_BUFFER_SIZE 1024
+
+//Longest serial/tcp line checked for messages and [ESPxxx] commands
+#define COMMAND_LINE_SIZE 256
+
+//Number of hotends tracked from the printer temperature reports
+#define MAX_EXTRUDERS 4
+
+//SD upload by serial: longest G-code line, lines and bytes the printer
+//can hold before answering (Marlin/Repetier default rx buffer is 128 bytes)
+#define SD_UPLOAD_LINE_SIZE 128
+#define SD_UPLOAD_WINDOW_LINES 4
+#define SD_UPLOAD_WINDOW_BYTES 127
+//time to wait for an acknowledge before sending the window again
+#define SD_UPLOAD_ACK_TIMEOUT 1000
+
+//printer commands from web clients waiting for the serial
+#define WEB_COMMAND_QUEUE_SIZE 4
+//time without answer from printer before closing a web command
+#define WEB_COMMAND_TIMEOUT 2000
+
+//web clients listening to /events at once and backlog of each one,
+//backlog size must be a power of 2
+#define MAX_EVENT_CLIENTS 2
+#define EVENT_CLIENT_BUFFER_SIZE 1024
+//time between two keep alive comments on idle event streams
+#define EVENT_KEEPALIVE 15000
+
+//web sessions authenticated at once, a login beyond that is refused
+#define MAX_AUTH_IP 10
+
+//files of the SPIFFS index, about 16 bytes each plus the name, allocated
+//for what SPIFFS holds at startup; files beyond that are still served but
+//looked up on SPIFFS
+#define STATIC_ASSET_MAX_FILES 384
+
+//JSON answers are sent by chunks of this size, the buffer is on the stack
+#define JSON_CHUNK_SIZE 512
+
+//changed settings are written to flash once unchanged for this time (ms)
+#define SETTINGS_COMMIT_DELAY 2000
+
+//settings journal on SPIFFS, rewritten as one snapshot beyond this size
+#define SETTINGS_FILE "/.settings"
+#define SETTINGS_FILE_NEW "/.settings.new"
+#define SETTINGS_JOURNAL_SIZE 4096
+
 #ifdef ARDUINO_ARCH_ESP32
 #ifdef SSDP_FEATURE
 #undef SSDP_FEATURE
@@ -202,6 +266,13 @@ typedef enum {
     LEVEL_ADMIN = 2
 } level_authenticate_type;
 
+//who waits for the printer answers, tcp input is held meanwhile
+typedef enum {
+    SERIAL_LOCK_NONE = 0,
+    SERIAL_LOCK_COMMAND = 1,
+    SERIAL_LOCK_SD_UPLOAD = 2
+} serial_lock_owner;
+
 
 #define    NO_SD 0
 #define    SD_DIRECTORY 1
@@ -314,54 +385,6 @@ const int32_t DEFAULT_VMON_ALARM_THRESHOLD   = 0;
 
 
 
-const uint16_t Setting[][2] = {
-    {EP_WIFI_MODE, LEVEL_ADMIN},//0
-    {EP_STA_SSID, LEVEL_ADMIN},//1
-    {EP_STA_PASSWORD, LEVEL_ADMIN},//2
-    {EP_STA_IP_MODE, LEVEL_ADMIN},//3
-    {EP_STA_IP_VALUE, LEVEL_ADMIN},//4
-    {EP_STA_MASK_VALUE, LEVEL_ADMIN},//5
-    {EP_STA_GATEWAY_VALUE, LEVEL_ADMIN},//6
-    {EP_BAUD_RATE, LEVEL_ADMIN},//7
-    {EP_STA_PHY_MODE, LEVEL_ADMIN},//8
-    {EP_SLEEP_MODE, LEVEL_ADMIN},//9
-    {EP_CHANNEL, LEVEL_ADMIN},//10
-    {EP_AUTH_TYPE, LEVEL_ADMIN},//11
-    {EP_SSID_VISIBLE, LEVEL_ADMIN},//12
-    {EP_WEB_PORT, LEVEL_ADMIN},//13
-    {EP_DATA_PORT, LEVEL_ADMIN},//14
-    {EP_REFRESH_PAGE_TIME, LEVEL_USER},//15
-    {EP_HOSTNAME, LEVEL_ADMIN},//16
-    {EP_XY_FEEDRATE, LEVEL_USER},//17
-    {EP_Z_FEEDRATE, LEVEL_USER},//18
-    {EP_E_FEEDRATE, LEVEL_USER},//19
-    {EP_ADMIN_PWD, LEVEL_ADMIN},//20
-    {EP_USER_PWD, LEVEL_USER},//21
-    {EP_AP_SSID, LEVEL_ADMIN},//22
-    {EP_AP_PASSWORD, LEVEL_ADMIN},//23
-    {EP_AP_IP_VALUE, LEVEL_ADMIN},//24
-    {EP_AP_MASK_VALUE, LEVEL_ADMIN},//25
-    {EP_AP_GATEWAY_VALUE, LEVEL_ADMIN},//26
-    {EP_AP_IP_MODE, LEVEL_ADMIN},//27
-    {EP_AP_PHY_MODE, LEVEL_ADMIN},//28
-    {EP_DATA_STRING, LEVEL_USER},//29
-    {EP_REFRESH_PAGE_TIME2, LEVEL_USER},//30
-    {EP_TARGET_FW, LEVEL_USER},//31
-    {EP_TIMEZONE, LEVEL_USER},//32
-    {EP_TIME_ISDST, LEVEL_USER},//33
-    {EP_TIME_SERVER1, LEVEL_USER},//34
-    {EP_TIME_SERVER2, LEVEL_USER},//35
-    {EP_TIME_SERVER3, LEVEL_USER},//36
-    {EP_IS_DIRECT_SD, LEVEL_USER},//37
-    {EP_PRIMARY_SD, LEVEL_USER},//38
-    {EP_SECONDARY_SD, LEVEL_USER},//39
-    {EP_DIRECT_SD_CHECK, LEVEL_USER}, //40
-    {EP_SD_CHECK_UPDATE_AT_BOOT, LEVEL_USER}, //41
-    {EP_VMON_CORRECTION_PPM, LEVEL_ADMIN}, //42
-    {EP_VMON_TARGET_VOLTAGE_mV, LEVEL_ADMIN}, //43
-    {EP_VMON_ALARM_THRESHOLD, LEVEL_ADMIN} //44
-};
-#define AUTH_ENTRY_NB 42
 //values
 #define DEFAULT_MAX_REFRESH			120
 #define DEFAULT_MIN_REFRESH			0
@@ -411,6 +434,9 @@ public:
     private:
         static volatile int _numInstances;
         static volatile bool _dirty;
+        static bool _loaded;
+        static uint32_t _changeTime;
+        static uint32_t _commitCount;
         bool _isClosed;
 
         EEPROMAccessor();
@@ -435,6 +461,9 @@ public:
     static bool write_buffer(int pos, const byte * byte_buffer, int size_buffer);
     static bool write_byte(int pos, const byte value);
     static bool reset_config();
+    static void update();
+    static void flush();
+    static uint32_t commitCount();
     static void print_config(tpipe output, bool plaintext);
     static bool SetFirmwareTarget(uint8_t fw);
     static void InitFirmwareTarget();
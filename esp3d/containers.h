@@ -0,0 +1,207 @@
+/*
+  containers.h - fixed capacity containers that do not use the heap
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+
+
+// StaticVector
+// Array of at most N items with a size. Items live in the object itself,
+// so T must be default constructible and cheap to copy.
+template<typename T, size_t N>
+class StaticVector
+{
+private:
+    T _items[N];
+    size_t _size = 0;
+
+public:
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    bool isEmpty() const
+    {
+        return _size == 0;
+    }
+
+    bool isFull() const
+    {
+        return _size == N;
+    }
+
+    // false when the vector is full
+    bool push(const T &item)
+    {
+        if (_size == N) {
+            return false;
+        }
+        _items[_size++] = item;
+        return true;
+    }
+
+    // keeps the order of the items after index
+    void erase(size_t index)
+    {
+        for (size_t i = index + 1; i < _size; i++) {
+            _items[i - 1] = _items[i];
+        }
+        _size--;
+    }
+
+    void clear()
+    {
+        _size = 0;
+    }
+
+    T &operator[](size_t index)
+    {
+        return _items[index];
+    }
+
+    T *begin()
+    {
+        return _items;
+    }
+
+    T *end()
+    {
+        return _items + _size;
+    }
+};
+
+
+// IntrusiveList
+// Singly linked list of items owning their link: T needs a public
+// T *_next member. The list never allocates nor frees an item, it only
+// links it, so an item belongs to at most one list at a time.
+template<typename T>
+class IntrusiveList
+{
+private:
+    T *_head = nullptr;
+    size_t _size = 0;
+
+public:
+    T *first() const
+    {
+        return _head;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    void push(T *item)
+    {
+        item->_next = _head;
+        _head = item;
+        _size++;
+    }
+
+    // previous is the item linked to item, NULL for the first one, so
+    // items are unlinked while walking the list without a second walk.
+    // Returns the item that followed.
+    T *unlink(T *previous, T *item)
+    {
+        T *next = item->_next;
+        if (previous) {
+            previous->_next = next;
+        } else {
+            _head = next;
+        }
+        item->_next = nullptr;
+        _size--;
+        return next;
+    }
+
+    T *pop()
+    {
+        T *item = _head;
+        if (item) {
+            unlink(nullptr, item);
+        }
+        return item;
+    }
+};
+
+
+// ObjectPool
+// Storage for N objects of type T taken from a free list, acquire() and
+// release() are O(1) and replace new and delete. acquire() returns NULL
+// when all objects are in use. Objects still in use when the pool is
+// destroyed are not destroyed, their owner must release them.
+template<typename T, size_t N>
+class ObjectPool
+{
+    static_assert(N > 0, "ObjectPool capacity must not be 0");
+
+private:
+    union Slot {
+        Slot *next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type data;
+    };
+
+    Slot _slots[N];
+    Slot *_free;
+    size_t _used = 0;
+
+public:
+    ObjectPool()
+    {
+        for (size_t i = 0; i + 1 < N; i++) {
+            _slots[i].next = &_slots[i + 1];
+        }
+        _slots[N - 1].next = nullptr;
+        _free = _slots;
+    }
+
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    size_t used() const
+    {
+        return _used;
+    }
+
+    T *acquire()
+    {
+        Slot *slot = _free;
+        if (!slot) {
+            return nullptr;
+        }
+        _free = slot->next;
+        _used++;
+        return new (&slot->data) T();
+    }
+
+    void release(T *item)
+    {
+        item->~T();
+        Slot *slot = reinterpret_cast<Slot *>(item);
+        slot->next = _free;
+        _free = slot;
+        _used--;
+    }
+};
@@ -35,6 +35,9 @@
 #include "bridge.h"
 #include "webinterface.h"
 #include "command.h"
+#include "commandqueue.h"
+#include "eventstream.h"
+#include "staticassets.h"
 
 #ifdef ARDUINO_ARCH_ESP8266
   #include "ESP8266WiFi.h"
@@ -92,6 +95,12 @@ void setup()
     data_server = NULL;
 #endif
     // init:
+    //settings are journaled on SPIFFS, mounted before anything reads them
+#ifdef ARDUINO_ARCH_ESP32
+    SPIFFS.begin(true);
+#else
+	SPIFFS.begin();
+#endif
     Board::init();
     if (Board::pPrinterPortSwitch != NULL)
     {
@@ -148,11 +157,7 @@ void setup()
     //get target FW
     CONFIG::InitFirmwareTarget();
     //Update is done if any so should be Ok
-#ifdef ARDUINO_ARCH_ESP32
-    SPIFFS.begin(true);
-#else
-	SPIFFS.begin();
-#endif
+    StaticAssets::begin();
        
     //setup wifi according settings
     if (!wifi_config.Setup()) {
@@ -190,6 +195,14 @@ void loop()
 #endif
     }
         BRIDGE::processFromSerial2TCP();
+    //send queued web commands and complete their answer
+    CommandQueue::update();
+#ifdef EVENTS_FEATURE
+    //write pending events to web clients
+    EventStream::update();
+#endif
+    //write changed settings to flash
+    CONFIG::update();
     //in case of restart requested
     if (web_interface->restartmodule) {
         CONFIG::esp_restart();
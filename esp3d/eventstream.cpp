@@ -0,0 +1,150 @@
+/*
+  eventstream.cpp - server-sent events pushed to web clients on /events
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "eventstream.h"
+
+#ifdef EVENTS_FEATURE
+
+// the stream never ends, the browser reconnects after "retry" ms if it is cut
+static const char EVENT_STREAM_HEADER[] PROGMEM =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n"
+    "retry: 2000\n\n";
+
+// comment line, keeps proxies from closing and finds dead clients
+static const char EVENT_STREAM_PING[] = ":\n\n";
+
+EventStream::Client EventStream::_clients[MAX_EVENT_CLIENTS];
+uint8_t EventStream::_clientCount = 0;
+Timer EventStream::_keepAlive;
+
+bool EventStream::addClient(WiFiClient client)
+{
+    for (uint8_t i = 0; i < MAX_EVENT_CLIENTS; i++) {
+        Client &c = _clients[i];
+        if (!c.used) {
+            client.setNoDelay(true);
+            client.write_P(EVENT_STREAM_HEADER, strlen_P(EVENT_STREAM_HEADER));
+            c.client = client;
+            c.used = true;
+            c.backlog.clear();
+            c.dropped = 0;
+            c.reported = 0;
+            _clientCount++;
+            LOG("Event client added\r\n")
+            return true;
+        }
+    }
+    return false;
+}
+
+void EventStream::send(const char *event, const char *data, size_t len)
+{
+    if (_clientCount == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < MAX_EVENT_CLIENTS; i++) {
+        Client &c = _clients[i];
+        if (!c.used) {
+            continue;
+        }
+        //tell first what was lost so the order is kept
+        if (c.dropped != c.reported) {
+            char count[11];
+            size_t n = snprintf(count, sizeof(count), "%lu", (unsigned long)c.dropped);
+            if (!push(c, "dropped", count, n)) {
+                c.dropped++;
+                continue;
+            }
+            c.reported = c.dropped;
+        }
+        if (!push(c, event, data, len)) {
+            c.dropped++;
+        }
+    }
+}
+
+bool EventStream::push(Client &c, const char *event, const char *data, size_t len)
+{
+    size_t eventLen = strlen(event);
+    //"event: " event "\ndata: " data "\n\n"
+    if (c.backlog.free() < eventLen + len + 16) {
+        return false;
+    }
+    c.backlog.write((const uint8_t *)"event: ", 7);
+    c.backlog.write((const uint8_t *)event, eventLen);
+    c.backlog.write((const uint8_t *)"\ndata: ", 7);
+    c.backlog.write((const uint8_t *)data, len);
+    c.backlog.write((const uint8_t *)"\n\n", 2);
+    return true;
+}
+
+void EventStream::update()
+{
+    if (_clientCount == 0) {
+        return;
+    }
+    bool ping = _keepAlive.milliSeconds() > EVENT_KEEPALIVE;
+    if (ping) {
+        _keepAlive.restart();
+    }
+    for (uint8_t i = 0; i < MAX_EVENT_CLIENTS; i++) {
+        Client &c = _clients[i];
+        if (!c.used) {
+            continue;
+        }
+        if (!c.client.connected()) {
+            remove(c);
+            continue;
+        }
+        if (ping && (c.backlog.free() >= sizeof(EVENT_STREAM_PING))) {
+            c.backlog.write((const uint8_t *)EVENT_STREAM_PING, sizeof(EVENT_STREAM_PING) - 1);
+        }
+        drain(c);
+    }
+}
+
+void EventStream::drain(Client &c)
+{
+    const uint8_t *data;
+    size_t len;
+    while ((len = c.backlog.readSpan(data)) > 0) {
+#ifdef ARDUINO_ARCH_ESP8266
+        //only what the tcp window takes, a slow client must not stall the loop
+        size_t room = c.client.availableForWrite();
+        if (room == 0) {
+            break;
+        }
+        if (len > room) {
+            len = room;
+        }
+#endif
+        size_t sent = c.client.write(data, len);
+        c.backlog.consume(sent);
+        if (sent < len) {
+            break;
+        }
+        delay(0);
+    }
+}
+
+void EventStream::remove(Client &c)
+{
+    LOG("Event client gone\r\n")
+    c.client.stop();
+    c.client = WiFiClient();
+    c.used = false;
+    c.backlog.clear();
+    _clientCount--;
+}
+
+#endif
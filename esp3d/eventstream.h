@@ -0,0 +1,64 @@
+/*
+  eventstream.h - server-sent events pushed to web clients on /events
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include "config.h"
+#include "timer.h"
+#include "ringbuffer.h"
+
+
+// EventStream
+// Connections kept open after a GET /events get every printer line
+// ("line"), the Error/Info/Status messages ("error", "info", "status") and
+// the printer state JSON ("state") as they are parsed. Each client has its
+// own backlog which is written from the main loop as fast as the client
+// reads; an event which does not fit is dropped and the number of dropped
+// events is sent to that client as a "dropped" event once there is room.
+class EventStream
+{
+public:
+    static bool isFull()
+    {
+        return _clientCount >= MAX_EVENT_CLIENTS;
+    }
+    static bool hasClients()
+    {
+        return _clientCount > 0;
+    }
+    // client must be detached from the web server, false if no free slot
+    static bool addClient(WiFiClient client);
+    // data must not contain new lines
+    static void send(const char *event, const char *data, size_t len);
+    static void send(const char *event, const char *data)
+    {
+        send(event, data, strlen(data));
+    }
+    static void update();
+
+private:
+    struct Client
+    {
+        WiFiClient client;
+        bool used;
+        RingBuffer<EVENT_CLIENT_BUFFER_SIZE> backlog;
+        uint32_t dropped;
+        uint32_t reported;
+    };
+
+    static Client _clients[MAX_EVENT_CLIENTS];
+    static uint8_t _clientCount;
+    static Timer _keepAlive;
+
+    static bool push(Client &c, const char *event, const char *data, size_t len);
+    static void drain(Client &c);
+    static void remove(Client &c);
+};
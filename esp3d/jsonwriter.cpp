@@ -0,0 +1,160 @@
+/*
+  jsonwriter.cpp - JSON answers streamed to the web client in chunks
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "jsonwriter.h"
+#include "webinterface.h"
+
+JSONWriter::JSONWriter(int code)
+    : _len(0), _items(0), _depth(0), _skipped(0)
+{
+    web_interface->web_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    web_interface->web_server.sendHeader("Cache-Control", "no-cache");
+    web_interface->web_server.send(code, "application/json", "");
+}
+
+void JSONWriter::flush()
+{
+    if (_len > 0) {
+        web_interface->web_server.sendContent(_buffer, _len);
+        _len = 0;
+    }
+}
+
+void JSONWriter::put(char c)
+{
+    _buffer[_len++] = c;
+    if (_len == sizeof(_buffer)) {
+        flush();
+    }
+}
+
+void JSONWriter::put(const char *text)
+{
+    while (*text) {
+        put(*text++);
+    }
+}
+
+void JSONWriter::putString(const char *text)
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    put('"');
+    for (; *text; text++) {
+        char c = *text;
+        switch (c) {
+        case '"':
+        case '\\':
+            put('\\');
+            put(c);
+            break;
+        case '\n':
+            put("\\n");
+            break;
+        case '\r':
+            put("\\r");
+            break;
+        case '\t':
+            put("\\t");
+            break;
+        default:
+            if ((uint8_t)c < 0x20) {
+                put("\\u00");
+                put(HEX_DIGITS[c >> 4]);
+                put(HEX_DIGITS[c & 0x0F]);
+            } else {
+                put(c);
+            }
+            break;
+        }
+    }
+    put('"');
+}
+
+void JSONWriter::prefix(const char *key)
+{
+    if (_items & 1) {
+        put(',');
+    }
+    _items |= 1;
+    if (key) {
+        putString(key);
+        put(':');
+    }
+}
+
+void JSONWriter::begin(const char *key, char c)
+{
+    if (_skipped || _depth >= MaxDepth) {
+        _skipped++;
+        return;
+    }
+    prefix(key);
+    put(c);
+    _items <<= 1;
+    _depth++;
+}
+
+void JSONWriter::close(char c)
+{
+    if (_skipped) {
+        _skipped--;
+        return;
+    }
+    if (_depth == 0) {
+        return;
+    }
+    _depth--;
+    _items >>= 1;
+    put(c);
+}
+
+void JSONWriter::beginObject(const char *key)
+{
+    begin(key, '{');
+}
+
+void JSONWriter::endObject()
+{
+    close('}');
+}
+
+void JSONWriter::beginArray(const char *key)
+{
+    begin(key, '[');
+}
+
+void JSONWriter::endArray()
+{
+    close(']');
+}
+
+void JSONWriter::member(const char *key, const char *value)
+{
+    if (_skipped) {
+        return;
+    }
+    prefix(key);
+    putString(value);
+}
+
+void JSONWriter::memberRaw(const char *key, const char *json)
+{
+    if (_skipped) {
+        return;
+    }
+    prefix(key);
+    put(json);
+}
+
+void JSONWriter::end()
+{
+    flush();
+    //last chunk
+    web_interface->web_server.sendContent("");
+}
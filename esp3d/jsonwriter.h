@@ -0,0 +1,62 @@
+/*
+  jsonwriter.h - JSON answers streamed to the web client in chunks
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+
+// JSONWriter
+// Writes a JSON body into a fixed buffer which goes out as one chunk of a
+// chunked response each time it is full, so the memory used by an answer
+// does not depend on its size. Commas between members and items are put
+// by the writer and strings are escaped. Nesting is limited to MaxDepth
+// levels, what a deeper object or array holds is left out, itself
+// included, so the answer stays valid JSON.
+// The response starts with the constructor and is complete after end().
+class JSONWriter
+{
+public:
+    explicit JSONWriter(int code = 200);
+
+    // key is NULL for an array item
+    void beginObject(const char *key = NULL);
+    void endObject();
+    void beginArray(const char *key);
+    void endArray();
+    void member(const char *key, const char *value);
+    void member(const char *key, const String &value)
+    {
+        member(key, value.c_str());
+    }
+    // value is already JSON
+    void memberRaw(const char *key, const char *json);
+    void end();
+
+    // the top level takes one bit of _items
+    static const uint8_t MaxDepth = 31;
+
+private:
+    char _buffer[JSON_CHUNK_SIZE];
+    size_t _len;
+    // one bit per nesting level, set once the level has an item
+    uint32_t _items;
+    uint8_t _depth;
+    // levels opened past MaxDepth, nothing is written while not 0
+    uint16_t _skipped;
+
+    void put(char c);
+    void put(const char *text);
+    void putString(const char *text);
+    void prefix(const char *key);
+    void begin(const char *key, char c);
+    void close(char c);
+    void flush();
+};
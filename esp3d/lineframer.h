@@ -0,0 +1,105 @@
+/*
+  lineframer.h - splits a byte stream into text lines without heap allocation
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+
+enum LineOverflowPolicy
+{
+    LineOverflow_Truncate, // keep the head of a too long line
+    LineOverflow_Discard   // drop a too long line completely
+};
+
+// LineFramer
+// Collects printable characters into a fixed inline buffer and hands every
+// completed line (CR or LF terminated) to the handler as a NUL terminated
+// view, which is only valid during the call. Text after ';' is a comment and
+// is not stored. A non printable byte inside a line restarts the line, so
+// binary noise never reaches the handler. Lines shorter than minLength are
+// ignored.
+template<size_t N>
+class LineFramer
+{
+public:
+    typedef void (*LineHandler)(const char *line, size_t len);
+
+private:
+    LineHandler _handler;
+    size_t _minLength;
+    LineOverflowPolicy _policy;
+    size_t _len = 0;
+    bool _previousWasChar = false;
+    bool _isComment = false;
+    bool _overflow = false;
+    char _buffer[N + 1];
+
+public:
+    LineFramer(LineHandler handler, size_t minLength = 1, LineOverflowPolicy policy = LineOverflow_Truncate)
+        : _handler(handler), _minLength(minLength), _policy(policy)
+    {
+        _buffer[0] = 0;
+    }
+
+    void setMinLength(size_t minLength)
+    {
+        _minLength = minLength;
+    }
+
+    void reset()
+    {
+        _len = 0;
+        _previousWasChar = false;
+        _isComment = false;
+        _overflow = false;
+    }
+
+    void feed(const uint8_t *data, size_t len)
+    {
+        for (size_t i = 0; i < len; i++) {
+            feed(data[i]);
+        }
+    }
+
+    void feed(uint8_t b)
+    {
+        // to ensure it is a continuous string, no char separated by binaries
+        if (!_previousWasChar) {
+            _len = 0;
+            _isComment = false;
+            _overflow = false;
+        }
+        if (b == ';') {
+            _isComment = true;
+        }
+        if (isPrintable(b)) {
+            _previousWasChar = true;
+            if (!_isComment) {
+                if (_len < N) {
+                    _buffer[_len++] = char(b);
+                } else {
+                    _overflow = true;
+                }
+            }
+            return;
+        }
+        _previousWasChar = false;
+        if (b == '\r' || b == '\n') {
+            _isComment = false;
+            if (_overflow && _policy == LineOverflow_Discard) {
+                return;
+            }
+            if (_len >= _minLength && _len > 0) {
+                _buffer[_len] = 0;
+                _handler(_buffer, _len);
+            }
+        }
+    }
+};
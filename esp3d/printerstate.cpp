@@ -0,0 +1,228 @@
+/*
+  printerstate.cpp - printer state parsed from the printer serial output
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "printerstate.h"
+
+// printer sends "busy:" every 2 seconds (Marlin default) while it is busy
+#define BUSY_TIMEOUT_MS 5000
+
+PrinterState::Temperature PrinterState::_extruders[MAX_EXTRUDERS];
+uint8_t PrinterState::_extruderCount = 0;
+PrinterState::Temperature PrinterState::_bed;
+bool PrinterState::_hasBed = false;
+float PrinterState::_position[4];
+bool PrinterState::_hasPosition = false;
+bool PrinterState::_hasSd = false;
+bool PrinterState::_sdPrinting = false;
+uint32_t PrinterState::_sdDone = 0;
+uint32_t PrinterState::_sdSize = 0;
+bool PrinterState::_busy = false;
+Timer PrinterState::_busyTimer;
+bool PrinterState::_jsonBusy = false;
+bool PrinterState::_dirty = true;
+String PrinterState::_json;
+
+// "value" or "value /target", returns false if there is no number
+static bool parseTemperature(const char *p, PrinterState::Temperature &t)
+{
+    char *end;
+    float current = strtod(p, &end);
+    if (end == p) {
+        return false;
+    }
+    t.current = current;
+    while (*end == ' ') {
+        end++;
+    }
+    if (*end == '/') {
+        p = end + 1;
+        float target = strtod(p, &end);
+        if (end != p) {
+            t.target = target;
+        }
+    }
+    return true;
+}
+
+void PrinterState::update(const char *line, const Response &response)
+{
+    if (response.is(Response_Temperature)) {
+        parseTemperatures(line);
+    }
+    if (response.is(Response_Position)) {
+        parsePosition(ResponseClassifier::field(line, response, ResponseField_Position) - 2);
+    }
+    if (response.is(Response_SdProgress)) {
+        parseSdProgress(ResponseClassifier::field(line, response, ResponseField_SdProgress));
+    }
+    if (response.is(Response_SdIdle) && _sdPrinting) {
+        _sdPrinting = false;
+        _dirty = true;
+    }
+    if (response.is(Response_Busy)) {
+        _busy = true;
+        _busyTimer.restart();
+    } else if (response.is(Response_Ok)) {
+        _busy = false;
+    }
+}
+
+void PrinterState::parseTemperatures(const char *line)
+{
+    Temperature active;
+    bool hasActive = false;
+    bool hasIndexed = false;
+    // tokens are "T:", "Tn:" and "B:" at the start of a word
+    for (const char *p = line; *p; p++) {
+        if (p != line && p[-1] != ' ') {
+            continue;
+        }
+        if (p[0] == 'B' && p[1] == ':') {
+            Temperature bed = { 0, _hasBed ? _bed.target : 0 };
+            if (parseTemperature(p + 2, bed)) {
+                _bed = bed;
+                _hasBed = true;
+                _dirty = true;
+            }
+        } else if (p[0] == 'T' && p[1] == ':') {
+            active.current = 0;
+            active.target = _extruderCount ? _extruders[0].target : 0;
+            hasActive = parseTemperature(p + 2, active);
+        } else if (p[0] == 'T' && isdigit(p[1])) {
+            char *end;
+            unsigned long index = strtoul(p + 1, &end, 10);
+            if (*end != ':' || index >= MAX_EXTRUDERS) {
+                continue;
+            }
+            if (parseTemperature(end + 1, _extruders[index])) {
+                hasIndexed = true;
+                if (index >= _extruderCount) {
+                    _extruderCount = index + 1;
+                }
+                _dirty = true;
+            }
+        }
+    }
+    // single hotend printers only report "T:", others report the active one
+    // as "T:" in addition to each "Tn:"
+    if (hasActive && !hasIndexed) {
+        _extruders[0] = active;
+        if (_extruderCount == 0) {
+            _extruderCount = 1;
+        }
+        _dirty = true;
+    }
+}
+
+void PrinterState::parsePosition(const char *text)
+{
+    static const char axes[] = "XYZE";
+    float position[4];
+    uint8_t found = 0;
+    // "X:0.00 Y:0.00 Z:0.00 E:0.00 Count X:..." stops at the first other word
+    for (const char *p = text; *p; ) {
+        const char *axis = strchr(axes, p[0]);
+        if (!axis || !p[0] || p[1] != ':') {
+            break;
+        }
+        char *end;
+        position[axis - axes] = strtod(p + 2, &end);
+        if (end == p + 2) {
+            break;
+        }
+        found |= 1 << (axis - axes);
+        p = end;
+        while (*p == ' ') {
+            p++;
+        }
+    }
+    // X, Y and Z are mandatory, E is optional
+    if ((found & 0x07) != 0x07) {
+        return;
+    }
+    if (!(found & 0x08)) {
+        position[3] = _hasPosition ? _position[3] : 0;
+    }
+    memcpy(_position, position, sizeof(_position));
+    _hasPosition = true;
+    _dirty = true;
+}
+
+void PrinterState::parseSdProgress(const char *text)
+{
+    // "SD printing byte 123/4567"
+    char *end;
+    uint32_t done = strtoul(text, &end, 10);
+    if (end == text || *end != '/') {
+        return;
+    }
+    _sdDone = done;
+    _sdSize = strtoul(end + 1, NULL, 10);
+    _sdPrinting = true;
+    _hasSd = true;
+    _dirty = true;
+}
+
+bool PrinterState::isBusy()
+{
+    return _busy && _busyTimer.milliSeconds() < BUSY_TIMEOUT_MS;
+}
+
+const String &PrinterState::json()
+{
+    bool busy = isBusy();
+    if (!_dirty && busy == _jsonBusy) {
+        return _json;
+    }
+    _json = F("{\"extruders\":[");
+    for (uint8_t i = 0; i < _extruderCount; i++) {
+        if (i > 0) {
+            _json += ",";
+        }
+        _json += F("{\"temp\":");
+        _json += String(_extruders[i].current, 1);
+        _json += F(",\"target\":");
+        _json += String(_extruders[i].target, 1);
+        _json += "}";
+    }
+    _json += "]";
+    if (_hasBed) {
+        _json += F(",\"bed\":{\"temp\":");
+        _json += String(_bed.current, 1);
+        _json += F(",\"target\":");
+        _json += String(_bed.target, 1);
+        _json += "}";
+    }
+    if (_hasPosition) {
+        _json += F(",\"position\":{\"X\":");
+        _json += String(_position[0], 2);
+        _json += F(",\"Y\":");
+        _json += String(_position[1], 2);
+        _json += F(",\"Z\":");
+        _json += String(_position[2], 2);
+        _json += F(",\"E\":");
+        _json += String(_position[3], 2);
+        _json += "}";
+    }
+    if (_hasSd) {
+        _json += F(",\"sd\":{\"printing\":");
+        _json += _sdPrinting ? F("true") : F("false");
+        _json += F(",\"done\":");
+        _json += String(_sdDone);
+        _json += F(",\"size\":");
+        _json += String(_sdSize);
+        _json += "}";
+    }
+    _json += F(",\"busy\":");
+    _json += busy ? F("true") : F("false");
+    _json += "}";
+    _jsonBusy = busy;
+    _dirty = false;
+    return _json;
+}
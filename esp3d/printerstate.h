@@ -0,0 +1,56 @@
+/*
+  printerstate.h - printer state parsed from the printer serial output
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+#include "timer.h"
+#include "responseclassifier.h"
+
+
+// PrinterState
+// Temperatures, position, SD print progress and busy state, updated from
+// every line the printer sends, so web clients can read them without
+// sending M105/M114/M27 themselves.
+class PrinterState
+{
+public:
+    struct Temperature
+    {
+        float current;
+        float target;
+    };
+
+    static void update(const char *line, const Response &response);
+    static bool isBusy();
+    // JSON object of the current state, only rebuilt after a change
+    static const String &json();
+
+private:
+    static Temperature _extruders[MAX_EXTRUDERS];
+    static uint8_t _extruderCount;
+    static Temperature _bed;
+    static bool _hasBed;
+    static float _position[4];
+    static bool _hasPosition;
+    static bool _hasSd;
+    static bool _sdPrinting;
+    static uint32_t _sdDone;
+    static uint32_t _sdSize;
+    static bool _busy;
+    static Timer _busyTimer;
+    static bool _jsonBusy;
+    static bool _dirty;
+    static String _json;
+
+    static void parseTemperatures(const char *line);
+    static void parsePosition(const char *text);
+    static void parseSdProgress(const char *text);
+};
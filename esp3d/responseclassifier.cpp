@@ -0,0 +1,123 @@
+/*
+  responseclassifier.cpp - single pass classification of printer output lines
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "config.h"
+#include "responseclassifier.h"
+
+
+#define FW_ALL          0xFF
+#define FW_ONLY(fw)     (1 << (fw))
+#define FW_EXCEPT(fw)   (FW_ALL & ~FW_ONLY(fw))
+
+struct ResponsePattern
+{
+    const char *text;
+    uint8_t len;
+    uint16_t flag;
+    uint8_t field;
+    bool atStart;
+    uint8_t firmwares;
+};
+
+static const char P_T[] PROGMEM = "T:";
+static const char P_B[] PROGMEM = "B:";
+static const char P_BUSY[] PROGMEM = "busy:";
+static const char P_WAIT[] PROGMEM = "wait";
+static const char P_OK[] PROGMEM = "ok";
+static const char P_ESP[] PROGMEM = "[ESP";
+static const char P_RESEND[] PROGMEM = "Resend:";
+static const char P_FORMAT_ERROR[] PROGMEM = "Format error";
+static const char P_X[] PROGMEM = "X:";
+static const char P_SD_PRINTING[] PROGMEM = "SD printing byte ";
+static const char P_NOT_SD_PRINTING[] PROGMEM = "Not SD printing";
+static const char P_DONE_PRINTING[] PROGMEM = "Done printing file";
+static const char P_ERROR[] PROGMEM = "Error:";
+static const char P_INFO[] PROGMEM = "Info:";
+static const char P_STATUS[] PROGMEM = "Status:";
+static const char P_ECHO[] PROGMEM = "echo:";
+static const char P_ERROR_LC[] PROGMEM = "error:";
+static const char P_INFO_LC[] PROGMEM = "info:";
+static const char P_WARNING[] PROGMEM = "warning:";
+
+static const ResponsePattern patterns[] PROGMEM = {
+    { P_T,                 2,   Response_Temperature,  ResponseField_None,        false, FW_ALL },
+    { P_B,                 2,   Response_Temperature,  ResponseField_None,        false, FW_ALL },
+    { P_BUSY,              5,   Response_Busy,         ResponseField_None,        false, FW_ALL },
+    { P_WAIT,              4,   Response_Wait,         ResponseField_None,        true,  FW_ALL },
+    { P_OK,                2,   Response_Ok,           ResponseField_None,        true,  FW_ALL },
+    { P_ESP,               4,   Response_EspCommand,   ResponseField_EspCommand,  false, FW_ALL },
+    { P_RESEND,            7,   Response_Resend,       ResponseField_Resend,      false, FW_ALL },
+    { P_FORMAT_ERROR,      12,  Response_FormatError,  ResponseField_None,        false, FW_ALL },
+    { P_X,                 2,   Response_Position,     ResponseField_Position,    false, FW_ALL },
+    { P_SD_PRINTING,       17,  Response_SdProgress,   ResponseField_SdProgress,  false, FW_ALL },
+    { P_NOT_SD_PRINTING,   15,  Response_SdIdle,       ResponseField_None,        false, FW_ALL },
+    { P_DONE_PRINTING,     18,  Response_SdIdle,       ResponseField_None,        false, FW_ALL },
+    { P_ERROR,             6,   Response_Error,        ResponseField_Error,       false, FW_EXCEPT(SMOOTHIEWARE) },
+    { P_INFO,              5,   Response_Info,         ResponseField_Info,        false, FW_EXCEPT(SMOOTHIEWARE) },
+    { P_STATUS,            7,   Response_Status,       ResponseField_Status,      false, FW_EXCEPT(SMOOTHIEWARE) & FW_EXCEPT(MARLIN) },
+    { P_ECHO,              5,   Response_Status,       ResponseField_Status,      false, FW_ONLY(MARLIN) },
+    { P_ERROR_LC,          6,   Response_Error,        ResponseField_Error,       false, FW_ONLY(SMOOTHIEWARE) },
+    { P_INFO_LC,           5,   Response_Info,         ResponseField_Info,        false, FW_ONLY(SMOOTHIEWARE) },
+    { P_WARNING,           8,   Response_Status,       ResponseField_Status,      false, FW_ONLY(SMOOTHIEWARE) }
+};
+
+uint8_t ResponseClassifier::_patterns[ResponseClassifier::MaxPatterns];
+char ResponseClassifier::_lead[ResponseClassifier::MaxPatterns];
+uint8_t ResponseClassifier::_count = 0;
+uint8_t ResponseClassifier::_first[96];
+
+void ResponseClassifier::setFirmwareTarget(uint8_t fw)
+{
+    _count = 0;
+    memset(_first, 0, sizeof(_first));
+    // keep the patterns of this target, grouped by first character
+    for (uint8_t c = ' '; c < 0x80; c++) {
+        for (uint8_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+            ResponsePattern p;
+            memcpy_P(&p, &patterns[i], sizeof(ResponsePattern));
+            if (pgm_read_byte(p.text) != c || !(p.firmwares & FW_ONLY(fw)) || _count >= MaxPatterns) {
+                continue;
+            }
+            if (_first[c - ' '] == 0) {
+                _first[c - ' '] = _count + 1;
+            }
+            _lead[_count] = c;
+            _patterns[_count++] = i;
+        }
+    }
+}
+
+void ResponseClassifier::classify(const char *line, size_t len, Response &response)
+{
+    if (_count == 0) {
+        setFirmwareTarget(CONFIG::GetFirmwareTarget());
+    }
+    response.flags = 0;
+    for (size_t pos = 0; pos < len; pos++) {
+        uint8_t c = (uint8_t)line[pos];
+        if (c < ' ' || c >= 0x80 || _first[c - ' '] == 0) {
+            continue;
+        }
+        for (uint8_t k = _first[c - ' '] - 1; k < _count && (uint8_t)_lead[k] == c; k++) {
+            ResponsePattern p;
+            memcpy_P(&p, &patterns[_patterns[k]], sizeof(ResponsePattern));
+            // only the first occurrence of each kind is reported
+            if ((response.flags & p.flag) || (p.atStart && pos != 0) || p.len > len - pos) {
+                continue;
+            }
+            if (memcmp_P(line + pos, p.text, p.len) != 0) {
+                continue;
+            }
+            response.flags |= p.flag;
+            if (p.field != ResponseField_None) {
+                response.fields[p.field] = pos + p.len;
+            }
+        }
+    }
+}
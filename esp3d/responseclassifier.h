@@ -0,0 +1,84 @@
+/*
+  responseclassifier.h - single pass classification of printer output lines
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+
+enum ResponseFlag
+{
+    Response_Temperature = 1 << 0,  // "T:" or "B:" anywhere
+    Response_Busy        = 1 << 1,  // "busy:" anywhere
+    Response_Wait        = 1 << 2,  // line starts with "wait"
+    Response_Ok          = 1 << 3,  // line starts with "ok"
+    Response_Error       = 1 << 4,
+    Response_Info        = 1 << 5,
+    Response_Status      = 1 << 6,
+    Response_EspCommand  = 1 << 7,  // "[ESP"
+    Response_Resend      = 1 << 8,  // "Resend:"
+    Response_FormatError = 1 << 9,  // "Format error"
+    Response_Position    = 1 << 10, // "X:" (M114 report)
+    Response_SdProgress  = 1 << 11, // "SD printing byte "
+    Response_SdIdle      = 1 << 12  // "Not SD printing" or "Done printing file"
+};
+
+enum ResponseField
+{
+    ResponseField_Error,
+    ResponseField_Info,
+    ResponseField_Status,
+    ResponseField_EspCommand,
+    ResponseField_Resend,
+    ResponseField_Position,
+    ResponseField_SdProgress,
+    ResponseField_Count,
+    ResponseField_None = 0xFF
+};
+
+// Response
+// Result of a classification: which patterns were found and, for those
+// carrying a payload, the offset of the text right after the first match.
+struct Response
+{
+    uint16_t flags;
+    uint16_t fields[ResponseField_Count];
+
+    inline bool is(uint16_t flag) const
+    {
+        return (flags & flag) != 0;
+    }
+};
+
+// ResponseClassifier
+// The patterns of the selected firmware target are indexed by their first
+// character, so each line is scanned once whatever the number of patterns.
+class ResponseClassifier
+{
+public:
+    static void setFirmwareTarget(uint8_t fw);
+    static void classify(const char *line, size_t len, Response &response);
+
+    static inline const char *field(const char *line, const Response &response, ResponseField f)
+    {
+        return line + response.fields[f];
+    }
+
+private:
+    static const uint8_t MaxPatterns = 24;
+
+    // patterns of the current firmware target sorted by first character
+    static uint8_t _patterns[MaxPatterns];
+    // first character of each of them, the table itself is in PROGMEM
+    static char _lead[MaxPatterns];
+    static uint8_t _count;
+    // 1 + index in _patterns of the first pattern starting with a given
+    // printable character, 0 if none
+    static uint8_t _first[96];
+};
@@ -0,0 +1,133 @@
+/*
+  ringbuffer.h - fixed capacity single producer / single consumer byte ring
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+
+// RingBuffer
+// Capacity must be a power of two. Head and tail are free running counters,
+// so the ring can be completely filled and no modulo is needed. One side may
+// only produce (writeSpan/commit/write) and the other side may only consume
+// (readSpan/consume/read); under that rule no locking is required.
+template<size_t N>
+class RingBuffer
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer capacity must be a power of two");
+
+private:
+    volatile size_t _head = 0;
+    volatile size_t _tail = 0;
+    uint8_t _buffer[N];
+
+public:
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    size_t available() const
+    {
+        return _head - _tail;
+    }
+
+    size_t free() const
+    {
+        return N - available();
+    }
+
+    bool isEmpty() const
+    {
+        return _head == _tail;
+    }
+
+    bool isFull() const
+    {
+        return available() == N;
+    }
+
+    // Contiguous readable block starting at the oldest byte.
+    size_t readSpan(const uint8_t *&data) const
+    {
+        size_t tail = _tail;
+        size_t used = _head - tail;
+        size_t offset = tail & (N - 1);
+        size_t len = N - offset;
+        data = _buffer + offset;
+        return used < len ? used : len;
+    }
+
+    void consume(size_t len)
+    {
+        _tail += len;
+    }
+
+    // Contiguous writable block starting after the newest byte.
+    size_t writeSpan(uint8_t *&data)
+    {
+        size_t head = _head;
+        size_t room = N - (head - _tail);
+        size_t offset = head & (N - 1);
+        size_t len = N - offset;
+        data = _buffer + offset;
+        return room < len ? room : len;
+    }
+
+    void commit(size_t len)
+    {
+        _head += len;
+    }
+
+    size_t write(const uint8_t *data, size_t len)
+    {
+        size_t done = 0;
+        while (done < len) {
+            uint8_t *dst;
+            size_t n = writeSpan(dst);
+            if (n == 0) {
+                break;
+            }
+            if (n > len - done) {
+                n = len - done;
+            }
+            memcpy(dst, data + done, n);
+            commit(n);
+            done += n;
+        }
+        return done;
+    }
+
+    size_t read(uint8_t *data, size_t len)
+    {
+        size_t done = 0;
+        while (done < len) {
+            const uint8_t *src;
+            size_t n = readSpan(src);
+            if (n == 0) {
+                break;
+            }
+            if (n > len - done) {
+                n = len - done;
+            }
+            memcpy(data + done, src, n);
+            consume(n);
+            done += n;
+        }
+        return done;
+    }
+
+    // Only the consumer side may call clear().
+    void clear()
+    {
+        _tail = _head;
+    }
+};
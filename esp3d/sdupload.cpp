@@ -0,0 +1,296 @@
+/*
+  sdupload.cpp - streams a G-code file to the printer SD card over serial
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "sdupload.h"
+#include "board.h"
+#include "responseclassifier.h"
+
+// consecutive timeouts without any progress before giving up
+#define SD_UPLOAD_MAX_RETRY 5
+// time the firmware may need to open the file after M28
+#define SD_UPLOAD_OPEN_TIMEOUT 2000
+
+SdUploader::Phase SdUploader::_phase = SdUploader::Phase_Idle;
+bool SdUploader::_error = false;
+bool SdUploader::_answered = false;
+bool SdUploader::_numbered = false;
+uint8_t SdUploader::_window = 1;
+uint32_t SdUploader::_base = 0;
+uint32_t SdUploader::_sent = 0;
+uint32_t SdUploader::_next = 0;
+uint8_t SdUploader::_skipOks = 0;
+bool SdUploader::_numberedOks = false;
+uint32_t SdUploader::_lastResend = 0;
+uint8_t SdUploader::_retries = 0;
+Timer SdUploader::_ackTimer;
+char SdUploader::_lines[SD_UPLOAD_WINDOW_LINES][SD_UPLOAD_LINE_SIZE + 20];
+uint8_t SdUploader::_lengths[SD_UPLOAD_WINDOW_LINES];
+char SdUploader::_line[SD_UPLOAD_LINE_SIZE + 1];
+size_t SdUploader::_lineLen = 0;
+bool SdUploader::_isComment = false;
+LineFramer<128> SdUploader::_answers(SdUploader::onAnswer, 2);
+
+bool SdUploader::begin(const String &filename)
+{
+    uint8_t fw = CONFIG::GetFirmwareTarget();
+    _numbered = (fw == MARLIN) || (fw == MARLINKIMBRA) || (fw == REPETIER) || (fw == REPETIER4DV);
+    _window = _numbered ? SD_UPLOAD_WINDOW_LINES : 1;
+    _error = false;
+    _skipOks = 0;
+    _numberedOks = false;
+    _lastResend = 0;
+    _retries = 0;
+    _lineLen = 0;
+    _isComment = false;
+    _base = _sent = _next = _numbered ? 1 : 0;
+    // forget anything the printer said before
+    _answers.reset();
+    while (Board::printerPort.available()) {
+        Board::printerPort.read();
+    }
+    _phase = Phase_Opening;
+    // line numbers must be reset before M28, once the file is open
+    // everything but M29 goes into it
+    if (_numbered) {
+        Board::printerPort.print(F("M110 N0\n"));
+        waitAnswer(SD_UPLOAD_ACK_TIMEOUT);
+    }
+    String command = "M28 " + filename;
+    LOG(command);
+    LOG("\r\n");
+    Board::printerPort.println(command);
+    // some firmwares only say "wait" when idle, so a timeout is not an error
+    waitAnswer(SD_UPLOAD_OPEN_TIMEOUT);
+    _phase = Phase_Sending;
+    return !_error;
+}
+
+bool SdUploader::write(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len && !_error; i++) {
+        char c = data[i];
+        if (c == '\n') {
+            if (!queueLine()) {
+                break;
+            }
+        } else if (c == ';') {
+            //remove/ignore every comment to save transfert time
+            _isComment = true;
+        } else if (c != '\r' && !_isComment) {
+            if (_lineLen >= SD_UPLOAD_LINE_SIZE) {
+                LOG("\r\nlong line detected\r\n");
+                _error = true;
+                break;
+            }
+            _line[_lineLen++] = c;
+        }
+    }
+    return !_error;
+}
+
+bool SdUploader::end()
+{
+    //last line may not have an end of line
+    if (!_error && (_lineLen > 0)) {
+        queueLine();
+    }
+    while (!_error && (_base != _next)) {
+        pump();
+    }
+    _phase = Phase_Idle;
+    return !_error;
+}
+
+bool SdUploader::waitAnswer(uint32_t timeout)
+{
+    Timer timer;
+    timer.restart();
+    _answered = false;
+    while (!_answered && !_error && (timer.milliSeconds() < timeout)) {
+        while (Board::printerPort.available()) {
+            _answers.feed(Board::printerPort.read());
+        }
+        delay(0);
+    }
+    return _answered;
+}
+
+bool SdUploader::queueLine()
+{
+    //ignore empty lines and surrounding blanks
+    size_t start = 0;
+    while ((start < _lineLen) && (_line[start] == ' ' || _line[start] == '\t')) {
+        start++;
+    }
+    while ((_lineLen > start) && (_line[_lineLen - 1] == ' ' || _line[_lineLen - 1] == '\t')) {
+        _lineLen--;
+    }
+    _line[_lineLen] = 0;
+    bool empty = (start == _lineLen);
+    _lineLen = 0;
+    _isComment = false;
+    if (empty) {
+        return true;
+    }
+    //wait for a free slot in the window
+    while (_next - _base >= _window) {
+        if (!pump()) {
+            return false;
+        }
+    }
+    uint8_t slot = _next % SD_UPLOAD_WINDOW_LINES;
+    char *dst = _lines[slot];
+    int len;
+    if (_numbered) {
+        len = snprintf(dst, sizeof(_lines[0]) - 6, "N%lu %s", (unsigned long)_next, _line + start);
+        uint8_t checksum = 0;
+        for (int i = 0; i < len; i++) {
+            checksum ^= (uint8_t)dst[i];
+        }
+        len += snprintf(dst + len, 6, "*%u\n", checksum);
+    } else {
+        len = snprintf(dst, sizeof(_lines[0]), "%s\n", _line + start);
+    }
+    _lengths[slot] = len;
+    _next++;
+    sendPending();
+    return !_error;
+}
+
+void SdUploader::sendPending()
+{
+    size_t inflight = 0;
+    for (uint32_t n = _base; n != _sent; n++) {
+        inflight += _lengths[n % SD_UPLOAD_WINDOW_LINES];
+    }
+    //the oldest line always goes, others only if the printer can hold them
+    while ((_sent != _next) && (_sent - _base < _window)) {
+        uint8_t slot = _sent % SD_UPLOAD_WINDOW_LINES;
+        if ((_sent != _base) && (inflight + _lengths[slot] > SD_UPLOAD_WINDOW_BYTES)) {
+            break;
+        }
+        if (_sent == _base) {
+            _ackTimer.restart();
+        }
+        Board::printerPort.write((const uint8_t *)_lines[slot], _lengths[slot]);
+        LOG(_lines[slot]);
+        inflight += _lengths[slot];
+        _sent++;
+    }
+}
+
+bool SdUploader::pump()
+{
+    while (Board::printerPort.available()) {
+        _answers.feed(Board::printerPort.read());
+    }
+    if (_error) {
+        return false;
+    }
+    if ((_base != _sent) && (_ackTimer.milliSeconds() > SD_UPLOAD_ACK_TIMEOUT)) {
+        if (++_retries > SD_UPLOAD_MAX_RETRY) {
+            LOG("Error detected\r\n");
+            _error = true;
+            return false;
+        }
+        //nothing came back, send the whole window again
+        LOG("Timeout, resend\r\n");
+        _sent = _base;
+    }
+    sendPending();
+    delay(0);
+    return true;
+}
+
+void SdUploader::onAnswer(const char *line, size_t len)
+{
+    LOG(line);
+    LOG("\r\n");
+    Response response;
+    ResponseClassifier::classify(line, len, response);
+    if (_phase == Phase_Opening) {
+        if (response.is(Response_Resend) || strstr(line, "failed")) {
+            LOG("Error start writing\r\n");
+            _error = true;
+        } else if (response.is(Response_Ok | Response_Wait)) {
+            _answered = true;
+        }
+        return;
+    }
+    if (_phase != Phase_Sending) {
+        return;
+    }
+    if (response.is(Response_Resend)) {
+        onResend(strtoul(ResponseClassifier::field(line, response, ResponseField_Resend), NULL, 10));
+    } else if (response.is(Response_Ok)) {
+        onOk(line + 2);
+    }
+}
+
+void SdUploader::onOk(const char *text)
+{
+    //"ok <n>" (Repetier) or "ok N<n>" (Marlin advanced ok) tell the line
+    while (*text == ' ') {
+        text++;
+    }
+    if (*text == 'N') {
+        text++;
+    }
+    if (_numbered && isdigit(*text)) {
+        _numberedOks = true;
+        uint32_t n = strtoul(text, NULL, 10);
+        if ((n >= _base) && (n < _sent)) {
+            _base = n + 1;
+            _retries = 0;
+            _ackTimer.restart();
+        }
+        return;
+    }
+    //the ok following a resend request does not acknowledge anything
+    if (_skipOks > 0) {
+        _skipOks--;
+        return;
+    }
+    if (_base != _sent) {
+        _base++;
+        _retries = 0;
+        _ackTimer.restart();
+    }
+}
+
+void SdUploader::onResend(uint32_t n)
+{
+    _skipOks++;
+    if (!_numbered) {
+        _sent = _base;
+        return;
+    }
+    //lines already in flight after a bad one each trigger the same request,
+    //only the first counts until the line asked for is acknowledged; should
+    //the resent line fail again the acknowledge timeout sends it once more
+    if ((n == _lastResend) && (n == _base)) {
+        return;
+    }
+    if ((n < _base) || (n > _sent)) {
+        //not in the window anymore, cannot recover
+        LOG("Resend out of window\r\n");
+        _error = true;
+        return;
+    }
+    //lines before n were taken but Marlin only says "ok" once it ran them,
+    //these oks are still to come and must not acknowledge the resent lines
+    if (!_numberedOks) {
+        _skipOks += n - _base;
+    }
+    _lastResend = n;
+    _base = n;
+    _sent = n;
+    _retries = 0;
+    _ackTimer.restart();
+}
@@ -0,0 +1,69 @@
+/*
+  sdupload.h - streams a G-code file to the printer SD card over serial
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+#include "timer.h"
+#include "lineframer.h"
+
+
+// SdUploader
+// Sends the lines of the uploaded file between M28 and M29 while keeping
+// several of them in flight. On firmwares which check line numbers every
+// line is sent as "N<n> <line>*<checksum>", "ok" answers are counted as
+// acknowledges and "Resend: <n>" rewinds to a line still held in the
+// window. Other firmwares get one plain line at a time.
+class SdUploader
+{
+public:
+    static bool begin(const String &filename);
+    // false as soon as the transfer failed
+    static bool write(const uint8_t *data, size_t len);
+    // sends what is left and waits for all acknowledges
+    static bool end();
+
+private:
+    enum Phase
+    {
+        Phase_Idle,
+        Phase_Opening,
+        Phase_Sending
+    };
+
+    static Phase _phase;
+    static bool _error;
+    static bool _answered;
+    static bool _numbered;
+    static uint8_t _window;
+    // lines [_base, _next) are held in _lines, [_base, _sent) are on the wire
+    static uint32_t _base;
+    static uint32_t _sent;
+    static uint32_t _next;
+    static uint8_t _skipOks;
+    static bool _numberedOks;
+    static uint32_t _lastResend;
+    static uint8_t _retries;
+    static Timer _ackTimer;
+    static char _lines[SD_UPLOAD_WINDOW_LINES][SD_UPLOAD_LINE_SIZE + 20];
+    static uint8_t _lengths[SD_UPLOAD_WINDOW_LINES];
+    static char _line[SD_UPLOAD_LINE_SIZE + 1];
+    static size_t _lineLen;
+    static bool _isComment;
+    static LineFramer<128> _answers;
+
+    static bool waitAnswer(uint32_t timeout);
+    static bool queueLine();
+    static void sendPending();
+    static bool pump();
+    static void onAnswer(const char *line, size_t len);
+    static void onOk(const char *text);
+    static void onResend(uint32_t n);
+};
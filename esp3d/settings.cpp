@@ -0,0 +1,371 @@
+/*
+  settings.cpp - description of the settings stored in EEPROM
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "settings.h"
+#include "board.h"
+#include "bridge.h"
+#include "wificonf.h"
+
+#define OPTIONS(list) list, sizeof(list) / sizeof(list[0])
+
+#ifdef AUTHENTICATION_FEATURE
+#define SETTING_LOCAL_PWD SETTING_SECRET
+#else
+#define SETTING_LOCAL_PWD (SETTING_SECRET | SETTING_HIDDEN)
+#endif
+
+static const char L_BAUD_RATE[] PROGMEM = "Baud Rate";
+static const char L_SLEEP_MODE[] PROGMEM = "Sleep Mode";
+static const char L_WEB_PORT[] PROGMEM = "Web Port";
+static const char L_DATA_PORT[] PROGMEM = "Data Port";
+static const char L_ADMIN_PWD[] PROGMEM = "Admin Password";
+static const char L_USER_PWD[] PROGMEM = "User Password";
+static const char L_HOSTNAME[] PROGMEM = "Hostname";
+static const char L_WIFI_MODE[] PROGMEM = "Wifi mode";
+static const char L_STA_SSID[] PROGMEM = "Station SSID";
+static const char L_STA_PASSWORD[] PROGMEM = "Station Password";
+static const char L_STA_PHY_MODE[] PROGMEM = "Station Network Mode";
+static const char L_STA_IP_MODE[] PROGMEM = "Station IP Mode";
+static const char L_STA_IP[] PROGMEM = "Station Static IP";
+static const char L_STA_MASK[] PROGMEM = "Station Static Mask";
+static const char L_STA_GATEWAY[] PROGMEM = "Station Static Gateway";
+static const char L_AP_SSID[] PROGMEM = "AP SSID";
+static const char L_AP_PASSWORD[] PROGMEM = "AP Password";
+static const char L_AP_PHY_MODE[] PROGMEM = "AP Network Mode";
+static const char L_SSID_VISIBLE[] PROGMEM = "SSID Visible";
+static const char L_CHANNEL[] PROGMEM = "AP Channel";
+static const char L_AUTH_TYPE[] PROGMEM = "Authentication";
+static const char L_AP_IP_MODE[] PROGMEM = "AP IP Mode";
+static const char L_AP_IP[] PROGMEM = "AP Static IP";
+static const char L_AP_MASK[] PROGMEM = "AP Static Mask";
+static const char L_AP_GATEWAY[] PROGMEM = "AP Static Gateway";
+static const char L_TARGET_FW[] PROGMEM = "Target FW";
+static const char L_REFRESH[] PROGMEM = "Temperature Refresh Time";
+static const char L_REFRESH2[] PROGMEM = "Position Refresh Time";
+static const char L_XY_FEEDRATE[] PROGMEM = "XY feedrate";
+static const char L_Z_FEEDRATE[] PROGMEM = "Z feedrate";
+static const char L_E_FEEDRATE[] PROGMEM = "E feedrate";
+static const char L_DATA_STRING[] PROGMEM = "Camera address";
+static const char L_VMON_CORRECTION[] PROGMEM = "Voltage Monitor Correction (ppm)";
+static const char L_VMON_TARGET[] PROGMEM = "Voltage Monitor Target Voltage (mV)";
+static const char L_VMON_ALARM[] PROGMEM = "Voltage Monitor Alarm Threshold (%)";
+
+static const char O_NONE[] PROGMEM = "None";
+static const char O_LIGHT[] PROGMEM = "Light";
+static const char O_MODEM[] PROGMEM = "Modem";
+static const char O_AP[] PROGMEM = "AP";
+static const char O_STA[] PROGMEM = "STA";
+static const char O_11B[] PROGMEM = "11b";
+static const char O_11G[] PROGMEM = "11g";
+static const char O_11N[] PROGMEM = "11n";
+static const char O_DHCP[] PROGMEM = "DHCP";
+static const char O_STATIC[] PROGMEM = "Static";
+static const char O_NO[] PROGMEM = "No";
+static const char O_YES[] PROGMEM = "Yes";
+static const char O_OPEN[] PROGMEM = "Open";
+static const char O_WPA[] PROGMEM = "WPA";
+static const char O_WPA2[] PROGMEM = "WPA2";
+static const char O_WPA_WPA2[] PROGMEM = "WPA/WPA2";
+static const char O_REPETIER[] PROGMEM = "Repetier";
+static const char O_REPETIER4DV[] PROGMEM = "Repetier for Davinci";
+static const char O_MARLIN[] PROGMEM = "Marlin";
+static const char O_MARLINKIMBRA[] PROGMEM = "Marlin Kimbra";
+static const char O_SMOOTHIEWARE[] PROGMEM = "Smoothieware";
+static const char O_UNKNOWN[] PROGMEM = "Unknown";
+
+static const SettingOption BAUD_RATES[] PROGMEM = {
+    {NULL, 9600}, {NULL, 19200}, {NULL, 38400}, {NULL, 57600},
+    {NULL, 115200}, {NULL, 230400}, {NULL, 250000}
+};
+static const SettingOption SLEEP_MODES[] PROGMEM = {
+    {O_NONE, WIFI_NONE_SLEEP},
+#ifdef ARDUINO_ARCH_ESP8266
+    {O_LIGHT, WIFI_LIGHT_SLEEP},
+#endif
+    {O_MODEM, WIFI_MODEM_SLEEP}
+};
+static const SettingOption WIFI_MODES[] PROGMEM = {
+    {O_AP, AP_MODE}, {O_STA, CLIENT_MODE}
+};
+static const SettingOption STA_PHY_MODES[] PROGMEM = {
+    {O_11B, WIFI_PHY_MODE_11B}, {O_11G, WIFI_PHY_MODE_11G}, {O_11N, WIFI_PHY_MODE_11N}
+};
+static const SettingOption AP_PHY_MODES[] PROGMEM = {
+    {O_11B, WIFI_PHY_MODE_11B}, {O_11G, WIFI_PHY_MODE_11G}
+};
+static const SettingOption IP_MODES[] PROGMEM = {
+    {O_DHCP, DHCP_MODE}, {O_STATIC, STATIC_IP_MODE}
+};
+static const SettingOption YES_NO[] PROGMEM = {
+    {O_NO, 0}, {O_YES, 1}
+};
+static const SettingOption CHANNELS[] PROGMEM = {
+    {NULL, 1}, {NULL, 2}, {NULL, 3}, {NULL, 4}, {NULL, 5}, {NULL, 6},
+    {NULL, 7}, {NULL, 8}, {NULL, 9}, {NULL, 10}, {NULL, 11}
+};
+static const SettingOption AUTH_TYPES[] PROGMEM = {
+    {O_OPEN, AUTH_OPEN}, {O_WPA, AUTH_WPA_PSK}, {O_WPA2, AUTH_WPA2_PSK},
+    {O_WPA_WPA2, AUTH_WPA_WPA2_PSK}
+};
+static const SettingOption FIRMWARES[] PROGMEM = {
+    {O_REPETIER, REPETIER}, {O_REPETIER4DV, REPETIER4DV}, {O_MARLIN, MARLIN},
+    {O_MARLINKIMBRA, MARLINKIMBRA}, {O_SMOOTHIEWARE, SMOOTHIEWARE}, {O_UNKNOWN, UNKNOWN_FW}
+};
+
+//[ESP400] order
+static const SettingEntry SETTINGS[] PROGMEM = {
+    //pos, type, flags, min, max, default value, default data, label, options
+    {EP_BAUD_RATE, SETTING_INTEGER, SETTING_ADMIN, 0, 0, DEFAULT_BAUD_RATE, NULL, L_BAUD_RATE, OPTIONS(BAUD_RATES)},
+    {EP_SLEEP_MODE, SETTING_BYTE, SETTING_ADMIN, 0, 0, DEFAULT_SLEEP_MODE, NULL, L_SLEEP_MODE, OPTIONS(SLEEP_MODES)},
+    {EP_WEB_PORT, SETTING_INTEGER, SETTING_ADMIN, DEFAULT_MIN_WEB_PORT, DEFAULT_MAX_WEB_PORT, DEFAULT_WEB_PORT, NULL, L_WEB_PORT, NULL, 0},
+    {EP_DATA_PORT, SETTING_INTEGER, SETTING_ADMIN, DEFAULT_MIN_DATA_PORT, DEFAULT_MAX_DATA_PORT, DEFAULT_DATA_PORT, NULL, L_DATA_PORT, NULL, 0},
+    {EP_ADMIN_PWD, SETTING_STRING, SETTING_ADMIN | SETTING_LOCAL_PWD, MIN_LOCAL_PASSWORD_LENGTH, MAX_LOCAL_PASSWORD_LENGTH, 0, DEFAULT_ADMIN_PWD, L_ADMIN_PWD, NULL, 0},
+    {EP_USER_PWD, SETTING_STRING, SETTING_LOCAL_PWD, MIN_LOCAL_PASSWORD_LENGTH, MAX_LOCAL_PASSWORD_LENGTH, 0, DEFAULT_USER_PWD, L_USER_PWD, NULL, 0},
+    {EP_HOSTNAME, SETTING_STRING, SETTING_ADMIN | SETTING_HOSTNAME, MIN_HOSTNAME_LENGTH, MAX_HOSTNAME_LENGTH, 0, NULL, L_HOSTNAME, NULL, 0},
+    {EP_WIFI_MODE, SETTING_BYTE, SETTING_ADMIN, 0, 0, DEFAULT_WIFI_MODE, NULL, L_WIFI_MODE, OPTIONS(WIFI_MODES)},
+    {EP_STA_SSID, SETTING_STRING, SETTING_ADMIN, MIN_SSID_LENGTH, MAX_SSID_LENGTH, 0, DEFAULT_STA_SSID, L_STA_SSID, NULL, 0},
+    {EP_STA_PASSWORD, SETTING_STRING, SETTING_ADMIN | SETTING_SECRET, MIN_PASSWORD_LENGTH, MAX_PASSWORD_LENGTH, 0, DEFAULT_STA_PASSWORD, L_STA_PASSWORD, NULL, 0},
+    {EP_STA_PHY_MODE, SETTING_BYTE, SETTING_ADMIN, 0, 0, DEFAULT_PHY_MODE, NULL, L_STA_PHY_MODE, OPTIONS(STA_PHY_MODES)},
+    {EP_STA_IP_MODE, SETTING_BYTE, SETTING_ADMIN, 0, 0, DEFAULT_STA_IP_MODE, NULL, L_STA_IP_MODE, OPTIONS(IP_MODES)},
+    {EP_STA_IP_VALUE, SETTING_IP, SETTING_ADMIN, 0, 0, 0, DEFAULT_IP_VALUE, L_STA_IP, NULL, 0},
+    {EP_STA_MASK_VALUE, SETTING_IP, SETTING_ADMIN, 0, 0, 0, DEFAULT_MASK_VALUE, L_STA_MASK, NULL, 0},
+    {EP_STA_GATEWAY_VALUE, SETTING_IP, SETTING_ADMIN, 0, 0, 0, DEFAULT_GATEWAY_VALUE, L_STA_GATEWAY, NULL, 0},
+    {EP_AP_SSID, SETTING_STRING, SETTING_ADMIN, MIN_SSID_LENGTH, MAX_SSID_LENGTH, 0, DEFAULT_AP_SSID, L_AP_SSID, NULL, 0},
+    {EP_AP_PASSWORD, SETTING_STRING, SETTING_ADMIN | SETTING_SECRET, MIN_PASSWORD_LENGTH, MAX_PASSWORD_LENGTH, 0, DEFAULT_AP_PASSWORD, L_AP_PASSWORD, NULL, 0},
+    {EP_AP_PHY_MODE, SETTING_BYTE, SETTING_ADMIN, 0, 0, DEFAULT_PHY_MODE, NULL, L_AP_PHY_MODE, OPTIONS(AP_PHY_MODES)},
+    {EP_SSID_VISIBLE, SETTING_BYTE, SETTING_ADMIN, 0, 0, DEFAULT_SSID_VISIBLE, NULL, L_SSID_VISIBLE, OPTIONS(YES_NO)},
+    {EP_CHANNEL, SETTING_BYTE, SETTING_ADMIN, 0, 0, DEFAULT_CHANNEL, NULL, L_CHANNEL, OPTIONS(CHANNELS)},
+    {EP_AUTH_TYPE, SETTING_BYTE, SETTING_ADMIN, 0, 0, DEFAULT_AUTH_TYPE, NULL, L_AUTH_TYPE, OPTIONS(AUTH_TYPES)},
+    {EP_AP_IP_MODE, SETTING_BYTE, SETTING_ADMIN, 0, 0, DEFAULT_AP_IP_MODE, NULL, L_AP_IP_MODE, OPTIONS(IP_MODES)},
+    {EP_AP_IP_VALUE, SETTING_IP, SETTING_ADMIN, 0, 0, 0, DEFAULT_IP_VALUE, L_AP_IP, NULL, 0},
+    {EP_AP_MASK_VALUE, SETTING_IP, SETTING_ADMIN, 0, 0, 0, DEFAULT_MASK_VALUE, L_AP_MASK, NULL, 0},
+    {EP_AP_GATEWAY_VALUE, SETTING_IP, SETTING_ADMIN, 0, 0, 0, DEFAULT_GATEWAY_VALUE, L_AP_GATEWAY, NULL, 0},
+    {EP_TARGET_FW, SETTING_BYTE, SETTING_PRINTER, 0, 0, UNKNOWN_FW, NULL, L_TARGET_FW, OPTIONS(FIRMWARES)},
+    {EP_REFRESH_PAGE_TIME, SETTING_BYTE, SETTING_PRINTER, DEFAULT_MIN_REFRESH, DEFAULT_MAX_REFRESH, DEFAULT_REFRESH_PAGE_TIME, NULL, L_REFRESH, NULL, 0},
+    {EP_REFRESH_PAGE_TIME2, SETTING_BYTE, SETTING_PRINTER, DEFAULT_MIN_REFRESH, DEFAULT_MAX_REFRESH, DEFAULT_REFRESH_PAGE_TIME, NULL, L_REFRESH2, NULL, 0},
+    {EP_XY_FEEDRATE, SETTING_INTEGER, SETTING_PRINTER, DEFAULT_MIN_XY_FEEDRATE, DEFAULT_MAX_XY_FEEDRATE, DEFAULT_XY_FEEDRATE, NULL, L_XY_FEEDRATE, NULL, 0},
+    {EP_Z_FEEDRATE, SETTING_INTEGER, SETTING_PRINTER, DEFAULT_MIN_Z_FEEDRATE, DEFAULT_MAX_Z_FEEDRATE, DEFAULT_Z_FEEDRATE, NULL, L_Z_FEEDRATE, NULL, 0},
+    {EP_E_FEEDRATE, SETTING_INTEGER, SETTING_PRINTER, DEFAULT_MIN_E_FEEDRATE, DEFAULT_MAX_E_FEEDRATE, DEFAULT_E_FEEDRATE, NULL, L_E_FEEDRATE, NULL, 0},
+    {EP_DATA_STRING, SETTING_STRING, SETTING_PRINTER, MIN_DATA_LENGTH, MAX_DATA_LENGTH, 0, NULL, L_DATA_STRING, NULL, 0},
+    {EP_VMON_CORRECTION_PPM, SETTING_INTEGER, SETTING_PRINTER | SETTING_ADMIN | SETTING_VMON, DEFAULT_MIN_VMON_CORRECTION_PPM, DEFAULT_MAX_VMON_CORRECTION_PPM, DEFAULT_VMON_CORRECTION_PPM, NULL, L_VMON_CORRECTION, NULL, 0},
+    {EP_VMON_TARGET_VOLTAGE_mV, SETTING_INTEGER, SETTING_PRINTER | SETTING_ADMIN | SETTING_VMON, DEFAULT_MIN_VMON_TARGET_VOLTAGE_mV, DEFAULT_MAX_VMON_TARGET_VOLTAGE_mV, DEFAULT_VMON_TARGET_VOLTAGE_mV, NULL, L_VMON_TARGET, NULL, 0},
+    {EP_VMON_ALARM_THRESHOLD, SETTING_BYTE, SETTING_PRINTER | SETTING_ADMIN | SETTING_VMON, DEFAULT_MIN_VMON_ALARM_THRESHOLD, DEFAULT_MAX_VMON_ALARM_THRESHOLD, DEFAULT_VMON_ALARM_THRESHOLD, NULL, L_VMON_ALARM, NULL, 0},
+    //set by other commands, not listed
+    {EP_TIMEZONE, SETTING_BYTE, SETTING_HIDDEN, 0, 0, DEFAULT_TIME_ZONE, NULL, NULL, NULL, 0},
+    {EP_TIME_ISDST, SETTING_BYTE, SETTING_HIDDEN, 0, 0, DEFAULT_TIME_DST, NULL, NULL, NULL, 0},
+    {EP_TIME_SERVER1, SETTING_STRING, SETTING_HIDDEN, MIN_DATA_LENGTH, MAX_DATA_LENGTH, 0, DEFAULT_TIME_SERVER1, NULL, NULL, 0},
+    {EP_TIME_SERVER2, SETTING_STRING, SETTING_HIDDEN, MIN_DATA_LENGTH, MAX_DATA_LENGTH, 0, DEFAULT_TIME_SERVER2, NULL, NULL, 0},
+    {EP_TIME_SERVER3, SETTING_STRING, SETTING_HIDDEN, MIN_DATA_LENGTH, MAX_DATA_LENGTH, 0, DEFAULT_TIME_SERVER3, NULL, NULL, 0},
+    {EP_IS_DIRECT_SD, SETTING_BYTE, SETTING_HIDDEN, 0, 0, DEFAULT_IS_DIRECT_SD, NULL, NULL, NULL, 0},
+    {EP_PRIMARY_SD, SETTING_BYTE, SETTING_HIDDEN, 0, 0, DEFAULT_PRIMARY_SD, NULL, NULL, NULL, 0},
+    {EP_SECONDARY_SD, SETTING_BYTE, SETTING_HIDDEN, 0, 0, DEFAULT_SECONDARY_SD, NULL, NULL, NULL, 0},
+    {EP_DIRECT_SD_CHECK, SETTING_BYTE, SETTING_HIDDEN, 0, 0, DEFAULT_DIRECT_SD_CHECK, NULL, NULL, NULL, 0},
+    {EP_SD_CHECK_UPDATE_AT_BOOT, SETTING_BYTE, SETTING_HIDDEN, 0, 0, DEFAULT_SD_CHECK_UPDATE_AT_BOOT, NULL, NULL, NULL, 0}
+};
+
+#define SETTINGS_COUNT (sizeof(SETTINGS) / sizeof(SETTINGS[0]))
+
+void Settings::read(uint8_t index, SettingEntry &entry)
+{
+    memcpy_P(&entry, &SETTINGS[index], sizeof(SettingEntry));
+}
+
+bool Settings::find(int pos, SettingEntry &entry)
+{
+    for (uint8_t i = 0; i < SETTINGS_COUNT; i++) {
+        read(i, entry);
+        if (entry.pos == pos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Settings::printP(const char *text, tpipe output)
+{
+    char buffer[33];
+    for (;;) {
+        strncpy_P(buffer, text, sizeof(buffer) - 1);
+        buffer[sizeof(buffer) - 1] = 0;
+        size_t len = strlen(buffer);
+        if (len == 0) {
+            break;
+        }
+        BRIDGE::print(buffer, output);
+        text += len;
+    }
+}
+
+void Settings::printItem(const SettingEntry &entry, tpipe output)
+{
+    char sbuf[MAX_DATA_LENGTH + 1];
+    byte bbuf = 0;
+    int ibuf = 0;
+    uint8_t ipbuf[IP_LENGTH];
+    bool ok = false;
+
+    BRIDGE::print((entry.flags & SETTING_PRINTER) ? F("{\"F\":\"printer\",\"P\":\"") : F("{\"F\":\"network\",\"P\":\""), output);
+    BRIDGE::print((const char *)CONFIG::intTostr(entry.pos), output);
+    sbuf[0] = entry.type;
+    sbuf[1] = 0;
+    BRIDGE::print(F("\",\"T\":\""), output);
+    BRIDGE::print(sbuf, output);
+    BRIDGE::print(F("\",\"V\":\""), output);
+    switch (entry.type) {
+    case SETTING_BYTE:
+        ok = CONFIG::read_byte(entry.pos, &bbuf);
+        if (ok) {
+            BRIDGE::print((const char *)CONFIG::intTostr(bbuf), output);
+        }
+        break;
+    case SETTING_INTEGER:
+        ok = CONFIG::read_buffer(entry.pos, (byte *)&ibuf, INTEGER_LENGTH);
+        if (ok) {
+            BRIDGE::print((const char *)CONFIG::intTostr(ibuf), output);
+        }
+        break;
+    case SETTING_STRING:
+        ok = CONFIG::read_string(entry.pos, sbuf, entry.max);
+        if (ok) {
+            BRIDGE::print((entry.flags & SETTING_SECRET) ? "********" : sbuf, output);
+        }
+        break;
+    case SETTING_IP:
+        ok = CONFIG::read_buffer(entry.pos, ipbuf, IP_LENGTH);
+        if (ok) {
+            BRIDGE::print(IPAddress(ipbuf).toString().c_str(), output);
+        }
+        break;
+    }
+    if (!ok) {
+        BRIDGE::print(F("???"), output);
+    }
+    BRIDGE::print(F("\",\"H\":\""), output);
+    printP(entry.label, output);
+    if (entry.optionCount > 0) {
+        BRIDGE::print(F("\",\"O\":["), output);
+        for (uint8_t i = 0; i < entry.optionCount; i++) {
+            SettingOption option;
+            memcpy_P(&option, &entry.options[i], sizeof(SettingOption));
+            const char *value = CONFIG::intTostr(option.value);
+            BRIDGE::print(i > 0 ? F(",{\"") : F("{\""), output);
+            if (option.label) {
+                printP(option.label, output);
+            } else {
+                BRIDGE::print(value, output);
+            }
+            BRIDGE::print(F("\":\""), output);
+            BRIDGE::print(value, output);
+            BRIDGE::print(F("\"}"), output);
+        }
+        BRIDGE::print(F("]}"), output);
+    } else if (entry.max > entry.min) {
+        BRIDGE::print(F("\",\"S\":\""), output);
+        BRIDGE::print((const char *)CONFIG::intTostr(entry.max), output);
+        BRIDGE::print(F("\",\"M\":\""), output);
+        BRIDGE::print((const char *)CONFIG::intTostr(entry.min), output);
+        BRIDGE::print(F("\"}"), output);
+    } else {
+        BRIDGE::print(F("\"}"), output);
+    }
+}
+
+void Settings::print(const String &section, tpipe output)
+{
+    bool network = (section.length() == 0) || (section == "network");
+    bool printer = (section.length() == 0) || (section == "printer");
+    bool first = true;
+    SettingEntry entry;
+    for (uint8_t i = 0; i < SETTINGS_COUNT; i++) {
+        read(i, entry);
+        if (entry.flags & SETTING_HIDDEN) {
+            continue;
+        }
+        if (!((entry.flags & SETTING_PRINTER) ? printer : network)) {
+            continue;
+        }
+        if ((entry.flags & SETTING_VMON) && Board::pVoltageMonitor == NULL) {
+            continue;
+        }
+        if (!first) {
+            BRIDGE::println(F(","), output);
+        }
+        first = false;
+        printItem(entry, output);
+        delay(0);
+    }
+}
+
+bool Settings::write(const SettingEntry &entry, const String &value)
+{
+    if (entry.type == SETTING_STRING) {
+        if (value.length() < (size_t)entry.min || value.length() > (size_t)entry.max) {
+            return false;
+        }
+        return CONFIG::write_string(entry.pos, value.c_str());
+    }
+    if (entry.type == SETTING_IP) {
+        byte ipbuf[IP_LENGTH];
+        if (CONFIG::split_ip(value.c_str(), ipbuf) < IP_LENGTH) {
+            return false;
+        }
+        return CONFIG::write_buffer(entry.pos, ipbuf, IP_LENGTH);
+    }
+    int ivalue = value.toInt();
+    if (entry.optionCount > 0) {
+        bool listed = false;
+        for (uint8_t i = 0; i < entry.optionCount && !listed; i++) {
+            SettingOption option;
+            memcpy_P(&option, &entry.options[i], sizeof(SettingOption));
+            listed = (option.value == ivalue);
+        }
+        if (!listed) {
+            return false;
+        }
+    } else if (entry.max > entry.min && (ivalue < entry.min || ivalue > entry.max)) {
+        return false;
+    }
+    if (entry.type == SETTING_BYTE) {
+        return CONFIG::write_byte(entry.pos, (byte)ivalue);
+    }
+    return CONFIG::write_buffer(entry.pos, (const byte *)&ivalue, INTEGER_LENGTH);
+}
+
+bool Settings::reset()
+{
+    SettingEntry entry;
+    for (uint8_t i = 0; i < SETTINGS_COUNT; i++) {
+        read(i, entry);
+        bool done = false;
+        switch (entry.type) {
+        case SETTING_BYTE:
+            done = CONFIG::write_byte(entry.pos, (byte)entry.value);
+            break;
+        case SETTING_INTEGER:
+            done = CONFIG::write_buffer(entry.pos, (const byte *)&entry.value, INTEGER_LENGTH);
+            break;
+        case SETTING_STRING:
+            if (entry.flags & SETTING_HOSTNAME) {
+                done = CONFIG::write_string(entry.pos, wifi_config.get_default_hostname());
+            } else if (entry.data) {
+                done = CONFIG::write_string(entry.pos, FPSTR((const char *)entry.data));
+            } else {
+                done = CONFIG::write_string(entry.pos, "");
+            }
+            break;
+        case SETTING_IP:
+            done = CONFIG::write_buffer(entry.pos, (const byte *)entry.data, IP_LENGTH);
+            break;
+        }
+        if (!done) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+/*
+  settings.h - description of the settings stored in EEPROM
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+//kind of value, same letters as the T member of [ESP400]/[ESP401]
+#define SETTING_BYTE    'B'
+#define SETTING_INTEGER 'I'
+#define SETTING_STRING  'S'
+#define SETTING_IP      'A'
+
+//where [ESP400] lists the setting, network is 0
+#define SETTING_PRINTER  0x01
+//only the admin may change it, user otherwise
+#define SETTING_ADMIN    0x02
+//value is listed as ********
+#define SETTING_SECRET   0x04
+//not listed by [ESP400]
+#define SETTING_HIDDEN   0x08
+//listed when the board has a voltage monitor
+#define SETTING_VMON     0x10
+//default is the hostname made of the MAC address
+#define SETTING_HOSTNAME 0x20
+
+struct SettingOption
+{
+    // PROGMEM, NULL when the label is the value itself
+    const char *label;
+    int32_t value;
+};
+
+struct SettingEntry
+{
+    uint16_t pos;
+    char type;
+    uint8_t flags;
+    // value range of bytes and integers, length range of strings,
+    // no range if max is not above min
+    int32_t min;
+    int32_t max;
+    // default of bytes and integers
+    int32_t value;
+    // default of strings (PROGMEM) and IP addresses (4 bytes)
+    const void *data;
+    // PROGMEM, NULL for hidden entries
+    const char *label;
+    const SettingOption *options;
+    uint8_t optionCount;
+};
+
+
+// Settings
+// Every EEPROM setting is one PROGMEM entry of a table giving its position,
+// kind, limits, default, label, options and the level needed to change it.
+// [ESP400] lists the entries in table order, [ESP401] checks a new value
+// against its entry and a reset writes the defaults, so a new setting
+// needs an EP_ position and an entry, nothing else.
+class Settings
+{
+public:
+    // copies the entry of an EEPROM position, false if there is none
+    static bool find(int pos, SettingEntry &entry);
+    // JSON items of [ESP400], section is "network", "printer" or empty
+    static void print(const String &section, tpipe output);
+    // value as given to [ESP401], false if the entry refuses it
+    static bool write(const SettingEntry &entry, const String &value);
+    static bool reset();
+
+private:
+    static void read(uint8_t index, SettingEntry &entry);
+    static void printP(const char *text, tpipe output);
+    static void printItem(const SettingEntry &entry, tpipe output);
+};
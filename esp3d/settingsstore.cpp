@@ -0,0 +1,223 @@
+/*
+  settingsstore.cpp - settings kept in RAM and journaled to SPIFFS
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "settingsstore.h"
+#include <EEPROM.h>
+#ifndef FS_NO_GLOBALS
+#define FS_NO_GLOBALS
+#endif
+#include <FS.h>
+#ifdef ARDUINO_ARCH_ESP32
+#include "SPIFFS.h"
+#endif
+
+#define RECORD_MAGIC 0x5E7A
+#define BLOCK_COUNT (EEPROM_SIZE / SETTINGS_BLOCK_SIZE)
+
+uint8_t SettingsStore::_image[EEPROM_SIZE];
+uint32_t SettingsStore::_dirty[(EEPROM_SIZE / SETTINGS_BLOCK_SIZE + 31) / 32];
+uint32_t SettingsStore::_journalSize = 0;
+bool SettingsStore::_journal = false;
+
+uint32_t SettingsStore::crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+        }
+    }
+    return crc;
+}
+
+bool SettingsStore::isDirty(uint16_t block)
+{
+    return _dirty[block / 32] & (1UL << (block % 32));
+}
+
+void SettingsStore::write(int pos, uint8_t value)
+{
+    if (_image[pos] == value) {
+        return;
+    }
+    _image[pos] = value;
+    uint16_t block = pos / SETTINGS_BLOCK_SIZE;
+    _dirty[block / 32] |= (1UL << (block % 32));
+}
+
+void SettingsStore::begin()
+{
+    //an interrupted compaction left the snapshot aside
+    if (!SPIFFS.exists(SETTINGS_FILE) && SPIFFS.exists(SETTINGS_FILE_NEW)) {
+        SPIFFS.rename(SETTINGS_FILE_NEW, SETTINGS_FILE);
+    }
+    memset(_image, 0xFF, sizeof(_image));
+    memset(_dirty, 0, sizeof(_dirty));
+    _journalSize = 0;
+    bool clean = false;
+    FS_FILE file = SPIFFS.open(SETTINGS_FILE, SPIFFS_FILE_READ);
+    if (file) {
+        clean = replay(file, file.size());
+        file.close();
+    }
+    if (_journalSize == 0) {
+        clean = false;
+        migrate();
+    }
+    //nothing is appended behind a damaged record
+    _journal = clean || compact();
+}
+
+bool SettingsStore::replay(FS_FILE &file, uint32_t size)
+{
+    uint8_t buffer[64];
+    Header header;
+    uint32_t offset = 0;
+    while (offset < size) {
+        if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+            header.magic != RECORD_MAGIC || offset + sizeof(header) + header.length > size) {
+            return false;
+        }
+        uint32_t crc = 0xFFFFFFFF;
+        for (uint16_t done = 0; done < header.length;) {
+            size_t len = min((size_t)(header.length - done), sizeof(buffer));
+            if (file.read(buffer, len) != len) {
+                return false;
+            }
+            crc = crc32(crc, buffer, len);
+            done += len;
+        }
+        if (~crc != header.crc) {
+            return false;
+        }
+        //the record is whole, apply it
+        file.seek(offset + sizeof(header));
+        for (uint16_t done = 0; done < header.length;) {
+            uint16_t run[2];
+            if (file.read((uint8_t *)run, sizeof(run)) != sizeof(run) ||
+                run[0] + run[1] > EEPROM_SIZE || done + sizeof(run) + run[1] > header.length ||
+                file.read(_image + run[0], run[1]) != run[1]) {
+                return false;
+            }
+            done += sizeof(run) + run[1];
+        }
+        offset += sizeof(header) + header.length;
+        _journalSize = offset;
+    }
+    return true;
+}
+
+void SettingsStore::migrate()
+{
+    EEPROM.begin(EEPROM_SIZE);
+    for (int i = 0; i < EEPROM_SIZE; i++) {
+        _image[i] = EEPROM.read(i);
+    }
+    EEPROM.end();
+}
+
+uint32_t SettingsStore::append(const char *filename, const char *mode, bool all)
+{
+    //first pass gives the length and CRC of the record, second one writes it
+    Header header = {RECORD_MAGIC, 0, 0xFFFFFFFF};
+    FS_FILE file;
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            header.crc = ~header.crc;
+            file = SPIFFS.open(filename, mode);
+            if (!file) {
+                return 0;
+            }
+            if (file.write((const uint8_t *)&header, sizeof(header)) != sizeof(header)) {
+                file.close();
+                return 0;
+            }
+        }
+        uint16_t block = 0;
+        while (block < BLOCK_COUNT) {
+            if (!all && !isDirty(block)) {
+                block++;
+                continue;
+            }
+            uint16_t first = block;
+            while (block < BLOCK_COUNT && (all || isDirty(block))) {
+                block++;
+            }
+            uint16_t run[2] = {(uint16_t)(first * SETTINGS_BLOCK_SIZE), (uint16_t)((block - first) * SETTINGS_BLOCK_SIZE)};
+            const uint8_t *data = _image + run[0];
+            if (pass == 0) {
+                header.length += sizeof(run) + run[1];
+                header.crc = crc32(header.crc, (const uint8_t *)run, sizeof(run));
+                header.crc = crc32(header.crc, data, run[1]);
+            } else if (file.write((const uint8_t *)run, sizeof(run)) != sizeof(run) ||
+                       file.write(data, run[1]) != run[1]) {
+                file.close();
+                return 0;
+            }
+        }
+    }
+    file.close();
+    return sizeof(header) + header.length;
+}
+
+bool SettingsStore::commit()
+{
+    if (!_journal) {
+        return commitEEPROM();
+    }
+    if (_journalSize < SETTINGS_JOURNAL_SIZE) {
+        uint32_t size = append(SETTINGS_FILE, SPIFFS_FILE_APPEND, false);
+        if (size) {
+            _journalSize += size;
+            memset(_dirty, 0, sizeof(_dirty));
+            return true;
+        }
+        //part of a record may be written, the journal is rewritten
+        _journalSize = SETTINGS_JOURNAL_SIZE;
+    }
+    return compact() || commitEEPROM();
+}
+
+bool SettingsStore::compact()
+{
+    //the journal is only used again once the snapshot replaced it, a
+    //failure leaves it possibly damaged or missing
+    _journal = false;
+    uint32_t size = append(SETTINGS_FILE_NEW, SPIFFS_FILE_WRITE, true);
+    if (!size) {
+        SPIFFS.remove(SETTINGS_FILE_NEW);
+        return false;
+    }
+    SPIFFS.remove(SETTINGS_FILE);
+    if (!SPIFFS.rename(SETTINGS_FILE_NEW, SETTINGS_FILE)) {
+        return false;
+    }
+    _journalSize = size;
+    memset(_dirty, 0, sizeof(_dirty));
+    _journal = true;
+    return true;
+}
+
+bool SettingsStore::commitEEPROM()
+{
+    EEPROM.begin(EEPROM_SIZE);
+    for (int i = 0; i < EEPROM_SIZE; i++) {
+        EEPROM.write(i, _image[i]);
+    }
+    bool done = EEPROM.commit();
+    EEPROM.end();
+    if (done) {
+        memset(_dirty, 0, sizeof(_dirty));
+        //the EEPROM sector is now newer than what SPIFFS may still hold,
+        //without journal the next boot takes the image from it
+        SPIFFS.remove(SETTINGS_FILE);
+        SPIFFS.remove(SETTINGS_FILE_NEW);
+    }
+    return done;
+}
@@ -0,0 +1,71 @@
+/*
+  settingsstore.h - settings kept in RAM and journaled to SPIFFS
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#ifndef FS_NO_GLOBALS
+#define FS_NO_GLOBALS
+#endif
+#include <FS.h>
+#include "config.h"
+
+//bytes of the image tracked by one dirty bit
+#define SETTINGS_BLOCK_SIZE 16
+
+
+// SettingsStore
+// The settings image keeps the EP_ layout and lives in RAM. A commit
+// appends one record holding the changed blocks to a journal file on
+// SPIFFS, which spreads the writes over its own blocks instead of erasing
+// the same sector each time. A record carries a CRC of its content: a
+// record cut by a power loss fails the check and is dropped with what
+// follows, so a commit is applied whole or not at all. Once the journal
+// reaches SETTINGS_JOURNAL_SIZE it is rewritten as a single snapshot
+// record, written aside and renamed over the journal.
+//
+// The first boot without a journal takes the image from the EEPROM
+// sector. If SPIFFS cannot hold the journal, commits go to the EEPROM
+// sector as before and the journal files are removed, so the next boot
+// takes the image from there.
+class SettingsStore
+{
+public:
+    // loads the image, called by the first settings access
+    static void begin();
+    static uint8_t read(int pos)
+    {
+        return _image[pos];
+    }
+    static void write(int pos, uint8_t value);
+    static bool commit();
+    // rewrites the journal as one snapshot, needed after a SPIFFS format
+    static bool compact();
+
+private:
+    struct Header
+    {
+        uint16_t magic;
+        uint16_t length;
+        uint32_t crc;
+    };
+
+    static uint8_t _image[EEPROM_SIZE];
+    static uint32_t _dirty[(EEPROM_SIZE / SETTINGS_BLOCK_SIZE + 31) / 32];
+    static uint32_t _journalSize;
+    static bool _journal;
+
+    static bool isDirty(uint16_t block);
+    static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len);
+    static bool replay(FS_FILE &file, uint32_t size);
+    static void migrate();
+    // bytes of the record written, 0 on failure
+    static uint32_t append(const char *filename, const char *mode, bool all);
+    static bool commitEEPROM();
+};
@@ -0,0 +1,269 @@
+/*
+  staticassets.cpp - web UI files served from SPIFFS with cache validators
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "staticassets.h"
+#include "webinterface.h"
+#ifdef ARDUINO_ARCH_ESP32
+#include "SPIFFS.h"
+#endif
+
+#define FNV_OFFSET 2166136261UL
+#define FNV_PRIME 16777619UL
+
+//name hashes marking free and removed entries, never given to a file
+#define ENTRY_FREE 0
+#define ENTRY_REMOVED 1
+
+//room left at startup for files uploaded later, and for their names
+#define INDEX_SLACK_FILES 16
+#define INDEX_SLACK_NAMES (INDEX_SLACK_FILES * 32)
+
+StaticAssets::Entry *StaticAssets::_entries = NULL;
+uint16_t StaticAssets::_capacity = 0;
+uint16_t StaticAssets::_count = 0;
+char *StaticAssets::_names = NULL;
+uint16_t StaticAssets::_namesSize = 0;
+uint16_t StaticAssets::_namesUsed = 0;
+bool StaticAssets::_complete = false;
+
+//what begin() finds on its first listing
+static uint16_t listedFiles = 0;
+static uint32_t listedBytes = 0;
+
+uint32_t StaticAssets::fnv(uint32_t hash, const uint8_t *data, size_t len)
+{
+    while (len--) {
+        hash = (hash ^ *data++) * FNV_PRIME;
+    }
+    return hash;
+}
+
+uint32_t StaticAssets::nameHash(const String &filename)
+{
+    uint32_t hash = fnv(FNV_OFFSET, (const uint8_t *)filename.c_str(), filename.length());
+    return (hash > ENTRY_REMOVED) ? hash : hash + 2;
+}
+
+StaticAssets::Entry *StaticAssets::find(const String &filename, uint32_t hash)
+{
+    //capacity is a power of two
+    uint16_t mask = _capacity - 1;
+    for (uint16_t n = 0, i = hash & mask; n < _capacity; n++, i = (i + 1) & mask) {
+        if (_entries[i].nameHash == hash && strcmp(_names + _entries[i].name, filename.c_str()) == 0) {
+            return &_entries[i];
+        }
+        if (_entries[i].nameHash == ENTRY_FREE) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+//false when the table or the name pool is full
+bool StaticAssets::add(const String &filename, uint32_t size)
+{
+    uint32_t hash = nameHash(filename);
+    Entry *entry = find(filename, hash);
+    if (!entry) {
+        //table kept 3/4 full at most so probing stays short
+        size_t len = filename.length() + 1;
+        if (_count >= _capacity * 3 / 4 || _count >= STATIC_ASSET_MAX_FILES || _namesUsed + len > _namesSize) {
+            return false;
+        }
+        uint16_t i = hash & (_capacity - 1);
+        while (_entries[i].nameHash > ENTRY_REMOVED) {
+            i = (i + 1) & (_capacity - 1);
+        }
+        entry = &_entries[i];
+        entry->nameHash = hash;
+        entry->name = _namesUsed;
+        memcpy(_names + _namesUsed, filename.c_str(), len);
+        _namesUsed += len;
+        _count++;
+    }
+    entry->size = size;
+    entry->hash = 0;
+    return true;
+}
+
+//the name stays in the pool until the next begin()
+void StaticAssets::remove(Entry *entry)
+{
+    entry->nameHash = ENTRY_REMOVED;
+    _count--;
+}
+
+void StaticAssets::list(void (*fn)(const String &filename, uint32_t size))
+{
+#ifdef ARDUINO_ARCH_ESP8266
+    FS_DIR dir = SPIFFS.openDir("/");
+    while (dir.next()) {
+        fn(dir.fileName(), dir.fileSize());
+    }
+#else
+    FS_FILE root = SPIFFS.open("/");
+    FS_FILE file = root.openNextFile();
+    while (file) {
+        fn(file.name(), file.size());
+        file = root.openNextFile();
+    }
+#endif
+}
+
+void StaticAssets::countFile(const String &filename, uint32_t size)
+{
+    (void)size;
+    listedFiles++;
+    listedBytes += filename.length() + 1;
+}
+
+void StaticAssets::addFile(const String &filename, uint32_t size)
+{
+    if (!add(filename, size)) {
+        _complete = false;
+    }
+}
+
+void StaticAssets::begin()
+{
+    free(_entries);
+    free(_names);
+    _entries = NULL;
+    _names = NULL;
+    _capacity = 0;
+    _count = 0;
+    _namesSize = 0;
+    _namesUsed = 0;
+    _complete = false;
+
+    listedFiles = 0;
+    listedBytes = 0;
+    list(countFile);
+    uint16_t files = listedFiles + INDEX_SLACK_FILES;
+    if (files > STATIC_ASSET_MAX_FILES) {
+        files = STATIC_ASSET_MAX_FILES;
+    }
+    uint16_t capacity = 16;
+    while (capacity * 3 / 4 < files) {
+        capacity *= 2;
+    }
+    uint32_t namesSize = listedBytes + INDEX_SLACK_NAMES;
+    if (namesSize > 0xFFFF) {
+        namesSize = 0xFFFF;
+    }
+    _entries = (Entry *)calloc(capacity, sizeof(Entry));
+    _names = (char *)malloc(namesSize);
+    if (!_entries || !_names) {
+        //everything is looked up on SPIFFS
+        free(_entries);
+        free(_names);
+        _entries = NULL;
+        _names = NULL;
+        return;
+    }
+    _capacity = capacity;
+    _namesSize = namesSize;
+    _complete = true;
+    list(addFile);
+}
+
+void StaticAssets::fileChanged(const String &filename)
+{
+    Entry *entry = find(filename, nameHash(filename));
+    FS_FILE file = SPIFFS.open(filename, SPIFFS_FILE_READ);
+    if (file) {
+        uint32_t size = file.size();
+        file.close();
+        //no room left, list SPIFFS again with room for more
+        if (!add(filename, size)) {
+            begin();
+        }
+    } else if (entry) {
+        remove(entry);
+    }
+}
+
+size_t StaticAssets::memoryUsed()
+{
+    return _capacity * sizeof(Entry) + _namesSize;
+}
+
+bool StaticAssets::send(const String &path)
+{
+    //dot files hold the settings or mark directories
+    if (path.indexOf("/.") >= 0) {
+        return false;
+    }
+    String filename = path + ".gz";
+    Entry *entry = find(filename, nameHash(filename));
+    if (!entry) {
+        filename = path;
+        entry = find(filename, nameHash(filename));
+    }
+    if (!entry) {
+        if (_complete) {
+            return false;
+        }
+        //not in the index, served without ETag
+        filename = path + ".gz";
+        if (!SPIFFS.exists(filename)) {
+            if (!SPIFFS.exists(path)) {
+                return false;
+            }
+            filename = path;
+        }
+    }
+    FS_FILE file = SPIFFS.open(filename, SPIFFS_FILE_READ);
+    if (!file) {
+        if (entry) {
+            remove(entry);
+        }
+        return false;
+    }
+
+    if (entry) {
+        uint32_t size = file.size();
+        //changed without being reported
+        if (entry->size != size) {
+            entry->size = size;
+            entry->hash = 0;
+        }
+        //0 until computed
+        if (entry->hash == 0) {
+            uint8_t buf[256];
+            uint32_t hash = FNV_OFFSET;
+            while (file.available()) {
+                int len = file.read(buf, sizeof(buf));
+                if (len <= 0) {
+                    break;
+                }
+                hash = fnv(hash, buf, len);
+                delay(0);
+            }
+            file.seek(0);
+            entry->hash = hash;
+        }
+        char etag[24];
+        snprintf(etag, sizeof(etag), "\"%lx-%lx\"", (unsigned long)size, (unsigned long)entry->hash);
+        web_interface->web_server.sendHeader(F("ETag"), etag);
+        if (web_interface->web_server.hasArg("v")) {
+            web_interface->web_server.sendHeader(F("Cache-Control"), F("max-age=31536000, immutable"));
+        } else {
+            web_interface->web_server.sendHeader(F("Cache-Control"), F("no-cache"));
+        }
+        if (web_interface->web_server.header("If-None-Match").indexOf(etag) != -1) {
+            web_interface->web_server.send(304);
+            file.close();
+            return true;
+        }
+    }
+    web_interface->web_server.streamFile(file, web_interface->getContentType(path));
+    file.close();
+    return true;
+}
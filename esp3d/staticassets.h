@@ -0,0 +1,69 @@
+/*
+  staticassets.h - web UI files served from SPIFFS with cache validators
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+
+// StaticAssets
+// SPIFFS is listed once at startup into an open addressing table keyed by
+// a hash of the file name, holding the size and the content hash of each
+// file, so a request finds its file (path.gz preferred to path) without
+// asking SPIFFS and opens it once. The names are kept in one pool and
+// compared on a hit, two names with the same hash get their own entries.
+// The table and the pool are sized for the files found, with room for a
+// few more; anything writing or removing files must report it with
+// fileChanged(), a format with begin(). Past STATIC_ASSET_MAX_FILES, or
+// when memory is short, the missing files are looked up on SPIFFS.
+//
+// Every file goes out with an ETag made of its size and content hash, so
+// it stays the same across restarts as long as the file does. A request
+// whose If-None-Match carries it is answered 304 and the browser keeps its
+// copy. The content hash is computed the first time a file is served. A
+// request with a "v" argument addresses a versioned asset and may be kept
+// by the browser without asking again.
+class StaticAssets
+{
+public:
+    static void begin();
+    // path.gz is preferred to path, false if none of them exists
+    static bool send(const String &path);
+    static void fileChanged(const String &filename);
+    // RAM taken by the table and the names
+    static size_t memoryUsed();
+
+private:
+    struct Entry
+    {
+        uint32_t nameHash;
+        uint32_t size;
+        uint32_t hash;
+        // offset of the name in _names
+        uint16_t name;
+    };
+
+    static Entry *_entries;
+    static uint16_t _capacity;
+    static uint16_t _count;
+    static char *_names;
+    static uint16_t _namesSize;
+    static uint16_t _namesUsed;
+    static bool _complete;
+
+    static uint32_t fnv(uint32_t hash, const uint8_t *data, size_t len);
+    static uint32_t nameHash(const String &filename);
+    static Entry *find(const String &filename, uint32_t nameHash);
+    static bool add(const String &filename, uint32_t size);
+    static void remove(Entry *entry);
+    static void list(void (*fn)(const String &filename, uint32_t size));
+    static void countFile(const String &filename, uint32_t size);
+    static void addFile(const String &filename, uint32_t size);
+};
@@ -18,6 +18,9 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 #include "storestrings.h"
+
+uint32_t STORESTRINGS_CLASS::_lastseq = 0;
+
 //Constructor
 STORESTRINGS_CLASS::STORESTRINGS_CLASS (int maxsize, int maxstringlength)
 {
@@ -30,16 +33,26 @@ STORESTRINGS_CLASS::STORESTRINGS_CLASS (int maxsize, int maxstringlength)
     if (_maxstringlength<4 && _maxstringlength!=-1) {
         _maxstringlength=4;
     }
+    _arena=NULL;
+    _arenasize=0;
+    _index=NULL;
+    _capacity=0;
+    _first=0;
+    _count=0;
+    _head=0;
 }
 //Destructor
 STORESTRINGS_CLASS::~STORESTRINGS_CLASS ()
 {
-    // clear list and content
-    clear();
+    release();
 }
 
 bool STORESTRINGS_CLASS::setsize(int size)
 {
+    if (size != _maxsize) {
+        //buffer is sized on it, so content is lost
+        release();
+    }
     _maxsize=size;
     return true;
 }
@@ -48,86 +61,204 @@ bool STORESTRINGS_CLASS::setlength(int len)
     if (len < 4) {
         return false;
     }
+    if (len != _maxstringlength) {
+        release();
+    }
     _maxstringlength = len;
     return true;
 }
 
-//Clear list and content
+//Allocate buffer and index
+bool STORESTRINGS_CLASS::allocate()
+{
+    int capacity = (_maxsize > 0)?_maxsize:STORESTRINGS_DEFAULT_SIZE;
+    size_t length = (_maxstringlength != -1)?_maxstringlength:STORESTRINGS_DEFAULT_LENGTH;
+    //one string more than the maximum, so a new string always fits
+    //once the oldest ones are removed to respect max size, whatever
+    //the space lost at the end of the buffer when it wraps
+    size_t arenasize = (capacity + 1) * (length + 1);
+    if (arenasize > 0xFFFF) {
+        return false;
+    }
+    _arena = new char[arenasize];
+    _index = new entry[capacity];
+    _arenasize = arenasize;
+    _capacity = capacity;
+    _first = 0;
+    _count = 0;
+    _head = 0;
+    return true;
+}
+
+//Free buffer and index
+void STORESTRINGS_CLASS::release()
+{
+    delete[] _arena;
+    delete[] _index;
+    _arena = NULL;
+    _index = NULL;
+    _arenasize = 0;
+    _capacity = 0;
+    _first = 0;
+    _count = 0;
+    _head = 0;
+}
+
+//Clear content, buffer is kept
 void STORESTRINGS_CLASS::clear()
 {
-    //while list is not empty
-    while(_charlist.size()) {
-        //remove element
-        char * str = _charlist.pop();
-        //destroy it
-        delete str;
+    _first = 0;
+    _count = 0;
+    _head = 0;
+}
+
+//Remove oldest element
+void STORESTRINGS_CLASS::shift()
+{
+    _first = (_first + 1) % _capacity;
+    _count--;
+    if (_count == 0) {
+        _first = 0;
+        _head = 0;
+    }
+}
+
+//Get offset where size bytes can be written, removing oldest elements
+//until there is enough space
+size_t STORESTRINGS_CLASS::reserve(size_t size)
+{
+    while (_count > 0) {
+        size_t tail = at(0).offset;
+        size_t last = at(_count - 1).offset;
+        if (last >= tail) {
+            //used space is [tail, head[, free space at end then at start
+            if (_arenasize - _head >= size) {
+                return _head;
+            }
+            if (tail >= size) {
+                return 0;
+            }
+        } else if (tail - _head >= size) {
+            //buffer has wrapped, free space is [head, tail[
+            return _head;
+        }
+        shift();
     }
+    return 0;
 }
 
 //Add element in storage
 bool STORESTRINGS_CLASS::add (const char * string)
 {
+    if (!_arena && !allocate()) {
+        return false;
+    }
     //if we reach max size
-    if (_maxsize==_charlist.size()) {
+    if (_count == _capacity) {
         //remove oldest one
-        char * str = _charlist.shift();
-        delete str;
+        shift();
     }
-    //add new one
     //get size including \0 at the end
     size_t size = strlen(string)+1;
+    size_t length = (_maxstringlength!=-1)?_maxstringlength:STORESTRINGS_DEFAULT_LENGTH;
     bool need_resize=false;
-    if ( (_maxstringlength!=-1) && (size >_maxstringlength+1 )) {
+    if (size > length+1) {
         need_resize = true;
-        size=_maxstringlength+1;
+        size=length+1;
     }
-    //reserve memory
-    char * ptr = new char[size*sizeof(char)];
+    size_t offset = reserve(size);
+    char * ptr = _arena + offset;
     //copy string to storage
     if (need_resize) {
         //copy maximum length minus 3
-        strncpy(ptr,string,_maxstringlength-3);
-        strcpy(ptr+_maxstringlength-3,"...");
+        memcpy(ptr,string,length-3);
+        strcpy(ptr+length-3,"...");
     } else {
         //copy as it is
-        strcpy(ptr,string);
+        memcpy(ptr,string,size);
     }
-    //add storage to list
-    _charlist.add(ptr);
+    //add offset to index
+    entry & e = at(_count);
+    e.offset = offset;
+    e.seq = ++_lastseq;
+    e.time = millis();
+    _count++;
+    _head = offset + size;
     return true;
 }
 //Remove element at pos position
 bool STORESTRINGS_CLASS::remove(int pos)
 {
     //be sure index is in range
-    if (pos<0 && pos>(_charlist.size()-1)) {
+    if (pos<0 || pos>=_count) {
         return false;
     }
-    //remove item from list
-    char * str = _charlist.remove(pos);
-    //destroy item
-    delete str;
+    if (pos == 0) {
+        shift();
+        return true;
+    }
+    //newer strings are moved down to fill the space, so the buffer keeps
+    //no hole and max size is always reached before the buffer is full
+    size_t dest = at(pos).offset;
+    for (int p=pos; p<_count-1; p++) {
+        const char * str = get(p + 1);
+        size_t size = strlen(str) + 1;
+        if (dest + size > _arenasize) {
+            dest = 0;
+        }
+        memmove(_arena + dest, str, size);
+        at(p) = at(p + 1);
+        at(p).offset = dest;
+        dest += size;
+    }
+    _count--;
+    _head = dest;
     return true;
 }
 //Get element at pos position
 const char * STORESTRINGS_CLASS::get(int pos)
 {
     //be sure index is in range
-    if (pos<0 && pos>(_charlist.size()-1)) {
+    if (pos<0 || pos>=_count) {
         return NULL;
     }
-    return (const char *) _charlist.get(pos);
+    return _arena + at(pos).offset;
+}
+//Get sequence number of element at pos position, 0 if none
+uint32_t STORESTRINGS_CLASS::getseq(int pos)
+{
+    if (pos<0 || pos>=_count) {
+        return 0;
+    }
+    return at(pos).seq;
+}
+//Get time of element at pos position, 0 if none
+uint32_t STORESTRINGS_CLASS::gettime(int pos)
+{
+    if (pos<0 || pos>=_count) {
+        return 0;
+    }
+    return at(pos).time;
+}
+//Get position of first element newer than seq
+int STORESTRINGS_CLASS::first_after(uint32_t seq)
+{
+    //start from newest, so only new elements are parsed
+    int pos = _count;
+    while (pos > 0 && at(pos - 1).seq > seq) {
+        pos--;
+    }
+    return pos;
 }
 //Get index for defined string
 int STORESTRINGS_CLASS::get_index(const char * string)
 {
     //parse the list until it is found
-    for (int p=0; p<_charlist.size(); p++) {
-        if (strcmp ( _charlist.get(p),  string)==0) {
+    for (int p=0; p<_count; p++) {
+        if (strcmp (get(p), string)==0) {
             return p;
         }
     }
     //if not found return -1
     return -1;
 }
-
@@ -21,7 +21,17 @@
 #ifndef STORESTRINGS_h
 #define STORESTRINGS_h
 #include <Arduino.h>
-#include "GenLinkedList.h"
+//capacity used when no maximum size or length is given
+#define STORESTRINGS_DEFAULT_SIZE 16
+#define STORESTRINGS_DEFAULT_LENGTH 100
+
+//strings are kept one after another in a single buffer used as a ring,
+//an index ring gives the offset of each of them, oldest first, with the
+//sequence number and time (millis) of the string
+//sequence numbers are shared by all lists and never reused, even by
+//clear(), so a client can ask for what is newer than the last one it got
+//buffer and index are allocated once at first add, and again only if
+//size or length is changed
 class STORESTRINGS_CLASS
 {
 public:
@@ -36,10 +46,19 @@ public:
     bool remove(int pos);
     const char * get(int pos);
     int get_index(const char * string);
+    uint32_t getseq(int pos);
+    uint32_t gettime(int pos);
+    //position of the first element newer than seq, size() if none
+    int first_after(uint32_t seq);
+    //sequence number of the last element added to any list
+    static inline uint32_t lastseq()
+    {
+        return _lastseq;
+    };
     void clear();
     inline int size()
     {
-        return _charlist.size();
+        return _count;
     };
     bool setsize(int size);
     bool setlength(int len);
@@ -55,7 +74,27 @@ public:
 private:
     int _maxsize;
     int _maxstringlength;
-    GenLinkedList<char *> _charlist;
+    struct entry {
+        uint16_t offset;
+        uint32_t seq;
+        uint32_t time;
+    };
+    static uint32_t _lastseq;
+    char * _arena;
+    size_t _arenasize;
+    entry * _index;
+    int _capacity;
+    int _first;
+    int _count;
+    size_t _head;
+    bool allocate();
+    void release();
+    void shift();
+    size_t reserve(size_t size);
+    inline entry & at(int pos)
+    {
+        return _index[(_first + pos) % _capacity];
+    };
 };
 
 #endif
@@ -40,10 +40,15 @@
 #include "Update.h"
 #endif
 
-#include "GenLinkedList.h"
 #include "storestrings.h"
 #include "command.h"
+#include "printerstate.h"
+#include "sdupload.h"
+#include "commandqueue.h"
+#include "eventstream.h"
 #include "bridge.h"
+#include "staticassets.h"
+#include "jsonwriter.h"
 
 #ifdef SSDP_FEATURE
 #include <ESP8266SSDP.h>
@@ -52,7 +57,6 @@
 //embedded response file if no files on SPIFFS
 #include "nofile.h"
 
-#define MAX_AUTH_IP 10
 #define HIDDEN_PASSWORD "********"
 
 
@@ -70,17 +74,8 @@ const char CONTENT_TYPE_HTML [] PROGMEM ="text/html";
 
 void handle_web_interface_root()
 {
-    String path = F("/index.html");
-    String contentType =  web_interface->getContentType(path);
-    String pathWithGz = path + ".gz";
     //if have a index.html or gzip version this is default root page
-    if((SPIFFS.exists(pathWithGz) || SPIFFS.exists(path)) && !web_interface->web_server.hasArg("fallback") && web_interface->web_server.arg("forcefallback")!="yes") {
-        if(SPIFFS.exists(pathWithGz)) {
-            path = pathWithGz;
-        }
-		FS_FILE file = SPIFFS.open(path, SPIFFS_FILE_READ);
-        web_interface->web_server.streamFile(file, contentType);
-        file.close();
+    if(!web_interface->web_server.hasArg("fallback") && web_interface->web_server.arg("forcefallback")!="yes" && StaticAssets::send(F("/index.html"))) {
         return;
     }
     //if no lets launch the default content
@@ -88,63 +83,59 @@ void handle_web_interface_root()
     web_interface->web_server.send_P(200,CONTENT_TYPE_HTML,PAGE_NOFILES,PAGE_NOFILES_SIZE);
 }
 
+#if defined(ERROR_MSG_FEATURE) || defined(INFO_MSG_FEATURE) || defined(STATUS_MSG_FEATURE)
+//messages of a list newer than since
+static void messages_json(JSONWriter & json, const char * key, STORESTRINGS_CLASS & list, uint32_t since)
+{
+    json.beginArray(key);
+    for (int i=list.first_after(since); i<list.size(); i++) {
+        json.beginObject();
+        json.member("line", list.get(i));
+        json.memberRaw("seq", String(list.getseq(i)).c_str());
+        json.memberRaw("time", String(list.gettime(i)).c_str());
+        json.endObject();
+    }
+    json.endArray();
+}
+#endif
+
 //concat several catched informations temperatures/position/status/flow/speed
 void handle_web_interface_status()
 {
-  //  static const char NO_TEMP_LINE[] PROGMEM = "\"temperature\":\"0\",\"target\":\"0\",\"active\":\"0\"";
     //we do not care if need authentication - just reset counter
     web_interface->is_authenticated();
-    //int tagpos,tagpos2;
-    String buffer2send;
-    String value;
+#if defined(ERROR_MSG_FEATURE) || defined(INFO_MSG_FEATURE) || defined(STATUS_MSG_FEATURE)
+    //only messages newer than since are sent, all of them without it
+    uint32_t since = 0;
+    if (web_interface->web_server.hasArg("since")) {
+        since = strtoul(web_interface->web_server.arg("since").c_str(), NULL, 10);
+    }
+#endif
     //start JSON answer
-    buffer2send="{";
+    JSONWriter json;
+    json.beginObject();
 #ifdef INFO_MSG_FEATURE
     //information
-    buffer2send.concat(F("\"InformationMsg\":["));
-
-    for (int i=0; i<web_interface->info_msg.size(); i++) {
-        if (i>0) {
-            buffer2send+=",";
-        }
-        buffer2send+="{\"line\":\"";
-        buffer2send+=web_interface->info_msg.get(i);
-        buffer2send+="\"}";
-    }
-    buffer2send+="],";
+    messages_json(json, "InformationMsg", web_interface->info_msg, since);
 #endif
 #ifdef ERROR_MSG_FEATURE
     //Error
-    buffer2send.concat(F("\"ErrorMsg\":["));
-    for (int i=0; i<web_interface->error_msg.size(); i++) {
-        if (i>0) {
-            buffer2send+=",";
-        }
-        buffer2send+="{\"line\":\"";
-        buffer2send+=web_interface->error_msg.get(i);
-        buffer2send+="\"}";
-    }
-    buffer2send+="],";
+    messages_json(json, "ErrorMsg", web_interface->error_msg, since);
 #endif
 #ifdef STATUS_MSG_FEATURE
     //Status
-    buffer2send.concat(F("\"StatusMsg\":["));
-
-    for (int i=0; i<web_interface->status_msg.size(); i++) {
-        if (i>0) {
-            buffer2send+=",";
-        }
-        buffer2send+="{\"line\":\"";
-        buffer2send+=web_interface->status_msg.get(i);
-        buffer2send+="\"}";
-    }
-    buffer2send+="],";
+    messages_json(json, "StatusMsg", web_interface->status_msg, since);
 #endif
+#if defined(ERROR_MSG_FEATURE) || defined(INFO_MSG_FEATURE) || defined(STATUS_MSG_FEATURE)
+    //value of since for the next request
+    json.memberRaw("seq", String(STORESTRINGS_CLASS::lastseq()).c_str());
+#endif
+    //printer state as parsed from its answers
+    json.memberRaw("PrinterState", PrinterState::json().c_str());
     //status color
-    buffer2send+=String(F("\"status\":\""))+value +"\"";
-    buffer2send+="}";
-    web_interface->web_server.sendHeader("Cache-Control", "no-cache");
-    web_interface->web_server.send(200, "application/json",buffer2send);
+    json.member("status", "");
+    json.endObject();
+    json.end();
 }
 
 //SPIFFS files uploader handle
@@ -187,8 +178,22 @@ void SPIFFSFileupload()
             filename = String(F("/user")) + upload.filename;
         }
         Board::status.print(F("Start ESP upload"));
+        //dot files are not listed nor served, and the settings journal is one
+        if (filename.indexOf("/.") >= 0) {
+            //nothing to remove if the upload is cancelled later
+            filename = "";
+            web_interface->_upload_status=UPLOAD_STATUS_CANCELLED;
+            Board::status.print(F("Error ESP create"));
+#ifdef ARDUINO_ARCH_ESP8266
+            web_interface->web_server.client().stopAll();
+#else
+            web_interface->web_server.client().stop();
+#endif
+            return;
+        }
         //create file
 		web_interface->fsUploadFile = SPIFFS.open(filename, SPIFFS_FILE_WRITE);
+        StaticAssets::fileChanged(filename);
         //check If creation succeed
         if (web_interface->fsUploadFile) {
             //if yes upload is started
@@ -241,6 +246,7 @@ void SPIFFSFileupload()
         if(web_interface->fsUploadFile) {
             //close it
             web_interface->fsUploadFile.close();
+            StaticAssets::fileChanged(filename);
             web_interface->_upload_status=UPLOAD_STATUS_SUCCESSFUL;
         } else {
             //we have a problem set flag UPLOAD_STATUS_CANCELLED
@@ -251,6 +257,7 @@ void SPIFFSFileupload()
 			web_interface->web_server.client().stop();
 #endif
             SPIFFS.remove(filename);
+            StaticAssets::fileChanged(filename);
             Board::status.print(F("Error ESP close"));
         }
         //Upload cancelled
@@ -265,19 +272,14 @@ void SPIFFSFileupload()
     delay(0);
 }
 
-#define NB_RETRY 5
-#define MAX_RESEND_BUFFER 128
 //SD file upload by serial
 void SDFile_serial_upload()
 {
-    static char buffer_line[MAX_RESEND_BUFFER]; //if need to resend
-    static char previous = 0;
-    static int  buffer_size;
     static bool com_error = false;
-    static bool is_comment = false;
+    //the upload holds the serial from its start to its end
+    static bool owner = false;
     bool client_closed = false;
     static String filename;
-    String response;
     //Guest cannot upload - only admin and user
     if(web_interface->is_authenticated() == LEVEL_GUEST) {
         web_interface->_upload_status=UPLOAD_STATUS_CANCELLED;
@@ -300,13 +302,16 @@ void SDFile_serial_upload()
     //Upload start
     //**************
     if(upload.status == UPLOAD_FILE_START) {
-        //need to lock serial out to avoid garbage in file
-        (web_interface->blockserial) = true;
-        //init flags
-        buffer_size=0;
-        com_error = false;
-        is_comment = false;
-        previous = 0;
+        //need to lock serial out to avoid garbage in file, a web command
+        //waiting for its answer keeps it and the upload is refused
+        owner = web_interface->lockSerial(SERIAL_LOCK_SD_UPLOAD);
+        if (!owner) {
+            com_error = true;
+            web_interface->_upload_status=UPLOAD_STATUS_CANCELLED;
+            Board::status.print(F("SD upload rejected"));
+            LOG("SD upload rejected, serial busy\r\n");
+            return;
+        }
         web_interface->_upload_status= UPLOAD_STATUS_ONGOING;
         Board::status.print(F("Uploading..."));
         Board::printerPort.flush();
@@ -315,57 +320,9 @@ void SDFile_serial_upload()
         write_time = 0;
         filesize = 0;
 #endif
-        LOG("Clear Serial\r\n");
-        if(Board::printerPort.available()) {
-                //get size of buffer
-                size_t len = Board::printerPort.available();
-                uint8_t sbuf[len+1];
-                //read buffer
-                Board::printerPort.readBytes(sbuf, len);
-                //convert buffer to zero end array
-                sbuf[len]='\0';
-                //use string because easier to handle
-                response = (const char*)sbuf;
-                LOG(response);
-                LOG("\r\n");
-                }
-        //command to pritnter to start print
-        String command = "M28 " + upload.filename;
-        LOG(command);
-        LOG("\r\n");
-        Board::printerPort.println(command);
-        Board::printerPort.flush();
         filename = upload.filename;
-        //now need to purge all serial data
-        //let's sleep 1s
-        //delay(1000);
-        for (int retry=0; retry < 400; retry++) { //time out is  5x400ms = 2000ms
-            //if there is something in serial buffer
-            if(Board::printerPort.available()) {
-                //get size of buffer
-                size_t len = Board::printerPort.available();
-                uint8_t sbuf[len+1];
-                //read buffer
-                Board::printerPort.readBytes(sbuf, len);
-                //convert buffer to zero end array
-                sbuf[len]='\0';
-                //use string because easier to handle
-                response =(const char*)sbuf;
-                LOG(response);
-                //if there is a wait it means purge is done
-                if (response.indexOf("wait")>-1) {
-                    LOG("Exit start writing\r\n");
-                    break;
-                }
-               if (response.indexOf("Resend")>-1 || response.indexOf("failed")>-1) {
-                    com_error = true;
-                    web_interface->blockserial = false;
-                    LOG("Error start writing\r\n");
-                    break;
-                }
-            }
-            delay(5);
-        }
+        //command to printer to start writing the file
+        com_error = !SdUploader::begin(filename);
         //Upload write
         //**************
         //upload is on going with data coming by 2K blocks
@@ -375,181 +332,24 @@ void SDFile_serial_upload()
         filesize+=upload.currentSize;
         uint32_t startwrite = millis();
 #endif
-        for (int pos = 0; pos < upload.currentSize; pos++) { //parse full post data
-            if (buffer_size < MAX_RESEND_BUFFER-1) { //raise error/handle if overbuffer - copy is space available
-                //remove/ignore every comment to save transfert time and avoid over buffer issues
-                if (upload.buf[pos] == ';') {
-                    is_comment = true;
-                    previous = ';';
-                }
-                if (!is_comment) {
-                    buffer_line[buffer_size] = upload.buf[pos]; //copy current char to buffer to send/resend
-                    buffer_size++;
-                    //convert buffer to zero end array
-                    buffer_line[buffer_size] = '\0';
-                    //check it is not an end line char and line is not empty
-                    if (((buffer_line[0] == '\n') && (buffer_size==1)) ||((buffer_line[1] == '\n') && (buffer_line[0] == '\r') && (buffer_size==2)) || ((buffer_line[0] == ' ') && (buffer_size==1)) ) {
-                        //ignore empty line
-                        buffer_size=0;
-                        buffer_line[buffer_size] = '\0';
-                    }
-                    //line is not empty so check if last char is an end line
-                    //if error no need to proceed
-                    else if (((buffer_line[buffer_size-1] == '\n')) && (com_error == false)) { //end of line and no error
-                        //if resend use buffer
-                        bool success = false;
-
-                        //check NB_RETRY times if get no error when send line
-                        for (int r = 0 ; r < NB_RETRY ; r++) {
-                            response = "";
-                            //print out line
-                            Board::printerPort.print(buffer_line);
-                            LOG(buffer_line);
-                            //ensure buffer is empty before continuing
-                            Board::printerPort.flush();
-                            //wait for answer with time out
-                            for (int retry=0; retry < 30; retry++) { //time out 30x5ms = 150ms
-                                //if there is serial data
-                                if(Board::printerPort.available()) {
-                                    //get size of available data
-                                    size_t len = Board::printerPort.available();
-                                    uint8_t sbuf[len+1];
-                                    //read serial buffer
-                                    Board::printerPort.readBytes(sbuf, len);
-                                    //convert buffer in zero end array
-                                    sbuf[len]='\0';
-                                    //use string because easier
-                                    response = (const char*)sbuf;
-                                    LOG("Retry:");
-                                    LOG(String(retry));
-                                    LOG("\r\n");
-                                    LOG(response);
-                                    //if buffer contain ok or wait - it means command is pass
-                                    if ((response.indexOf("wait")>-1)||(response.indexOf("ok")>-1)) {
-                                        success = true;
-                                        break;
-                                    }
-                                    //if buffer contain resend then need to resend
-                                    if (response.indexOf("Resend") > -1) { //if error
-                                        success = false;
-                                        break;
-                                    }
-                                }
-                                delay(5);
-                            }
-                            //if command is pass no need to retry
-                            if (success == true) {
-                                break;
-                            }
-                            //purge extra serial if any
-                            if(Board::printerPort.available()) {
-                                //get size of available data
-                                size_t len = Board::printerPort.available();
-                                uint8_t sbuf[len+1];
-                                //read serial buffer
-                                Board::printerPort.readBytes(sbuf, len);
-                                //convert buffer in zero end array
-                                sbuf[len]='\0';
-                            }
-                        }
-                        //if even after the number of retry still have error - then we are in error
-                        if (!success) {
-                            //raise error
-                            LOG("Error detected\r\n");
-                            LOG(response);
-                            com_error = true;
-                        }
-                        //reset buffer for next command
-                        buffer_size = 0;
-                        buffer_line[buffer_size] = '\0';
-                    }
-                } else { //it is a comment
-                    if (upload.buf[pos] == '\r') { //store if CR
-                        previous = '\r';
-                    } else if (upload.buf[pos] == '\n') { //this is the end of the comment
-                        is_comment = false;
-                        if (buffer_size > 0) {
-                            if (previous == '\r') {
-                                pos--;
-                            }
-                            pos--; //do a loop back and process as normal
-                        }
-                        previous = '\n';
-                    }//if not just ignore and continue
-                    else {
-                        previous = upload.buf[pos];
-                    }
-
-                }
-            } else { //raise error
-                LOG("\r\nlong line detected\r\n");
-                LOG(buffer_line);
-                com_error = true;
-            }
-        }
+        com_error = !SdUploader::write(upload.buf, upload.currentSize);
 #ifdef DEBUG_PERFORMANCE
         write_time += (millis()-startwrite);
 #endif
+    } else if (!owner) {
+        //refused upload, nothing was sent to the printer
+        web_interface->_upload_status=UPLOAD_STATUS_CANCELLED;
         //Upload end
         //**************
     } else if(upload.status == UPLOAD_FILE_END) {
-        if (buffer_size > 0) { //if last part does not have '\n'
-            //print the line
-            Board::printerPort.print(buffer_line);
-            if (is_comment && (previous == '\r')) {
-                Board::printerPort.print("\r\n");
-            } else {
-                Board::printerPort.print("\n");
-            }
-            Board::printerPort.flush();
-            //if resend use buffer
-            bool success = false;
-            //check NB_RETRY times if get no error when send line
-            for (int r = 0 ; r < NB_RETRY ; r++) {
-                response = "";
-                Board::printerPort.print(buffer_line);
-                Board::printerPort.flush();
-                //wait for answer with time out
-                for (int retry=0; retry < 20; retry++) { //time out
-                    if(Board::printerPort.available()) {
-                        size_t len = Board::printerPort.available();
-                        uint8_t sbuf[len+1];
-                        Board::printerPort.readBytes(sbuf, len);
-                        sbuf[len]='\0';
-                        response = (const char*)sbuf;
-                        if ((response.indexOf("wait")>-1)||(response.indexOf("ok")>-1)) {
-                            success = true;
-                            break;
-                        }
-                        if (response.indexOf("Resend") > -1) { //if error
-                            success = false;
-                            break;
-                        }
-                    }
-                    delay(5);
-                }
-                if (success == true) {
-                    break;
-                }
-            }
-            if (!success) {
-                //raise error
-                LOG("Error detected 2\r\n");
-                LOG(response);
-                com_error = true;
-            }
-            //reset buffer for next command
-            buffer_size = 0;
-            buffer_line[buffer_size] = '\0';
-
+        //send what is left and wait for the printer to acknowledge all lines
+        if (!com_error) {
+            com_error = !SdUploader::end();
         }
         LOG("Upload finished ");
-        buffer_size=0;
-        buffer_line[buffer_size] = '\0';
         //send M29 command to close file on SD
         Board::printerPort.print(F("\r\nM29\r\n"));
         Board::printerPort.flush();
-        web_interface->blockserial = false;
         delay(1000);//give time to FW
         //resend M29 command to close file on SD as first command may be lost
         Board::printerPort.print(F("\r\nM29\r\n"));
@@ -561,14 +361,13 @@ void SDFile_serial_upload()
         DEBUG_PERF_VARIABLE.add(String(filesize).c_str());
 #endif
         if (com_error) {
-            web_interface->blockserial = false;
             LOG("with error\r\n");
             web_interface->_upload_status=UPLOAD_STATUS_CANCELLED;
             if (!client_closed){
                 //web_interface->web_server.client().stopAll();
                  LOG("Need to stop");
                 client_closed = true;
-            }   
+            }
             filename = "M30 " + filename;
             Board::printerPort.println(filename);
             Board::status.print(F("SD upload failed"));
@@ -580,18 +379,17 @@ void SDFile_serial_upload()
             Board::status.print(F("SD upload done"));
             Board::printerPort.flush();
         }
+        web_interface->unlockSerial(SERIAL_LOCK_SD_UPLOAD);
+        owner = false;
         //Upload cancelled
         //**************
     } else { //UPLOAD_FILE_ABORTED
         LOG("Error, Something happened\r\n");
         com_error = true;
         web_interface->_upload_status=UPLOAD_STATUS_CANCELLED;
-        buffer_size=0;
-        buffer_line[buffer_size] = '\0';
         //send M29 command to close file on SD
         Board::printerPort.print(F("\r\nM29\r\n"));
         Board::printerPort.flush();
-        web_interface->blockserial = false;
         delay(1000);
         //resend M29 command to close file on SD as first command may be lost
         Board::printerPort.print(F("\r\nM29\r\n"));
@@ -600,6 +398,8 @@ void SDFile_serial_upload()
         Board::printerPort.println(filename);
         Board::status.print(F("SD upload failed"));
         Board::printerPort.flush();
+        web_interface->unlockSerial(SERIAL_LOCK_SD_UPLOAD);
+        owner = false;
     }
 }
 
@@ -739,10 +539,11 @@ void handleFileList()
             shortname.replace("/","");
             filename = path + web_interface->web_server.arg("filename");
             filename.replace("//","/");
-            if(!SPIFFS.exists(filename)) {
+            if(!SPIFFS.exists(filename) || filename.startsWith(SETTINGS_FILE)) {
                 status = shortname + F(" does not exists!");
             } else {
                 if (SPIFFS.remove(filename)) {
+                    StaticAssets::fileChanged(filename);
                     status = shortname + F(" deleted");
                     //what happen if no "/." and no other subfiles ?
 #ifdef ARDUINO_ARCH_ESP8266
@@ -759,6 +560,7 @@ void handleFileList()
                         FS_FILE r = SPIFFS.open(path+"/.", SPIFFS_FILE_WRITE);
                         if (r) {
                             r.close();
+                            StaticAssets::fileChanged(path+"/.");
                         }
                     }
                 } else {
@@ -792,11 +594,13 @@ void handleFileList()
 #else
 						String fullpath = file2deleted.name();
 #endif
-                        if (!SPIFFS.remove(fullpath)) {
+                        //the settings journal is kept, a "/." directory matches it
+                        if (!fullpath.startsWith(SETTINGS_FILE) && !SPIFFS.remove(fullpath)) {
                             delete_error = true;
                             status = F("Cannot deleted ") ;
                             status+=fullpath;
                         }
+                        StaticAssets::fileChanged(fullpath);
 #ifdef ARDUINO_ARCH_ESP32     
                      file2deleted = dir.openNextFile();
 #endif
@@ -824,12 +628,14 @@ void handleFileList()
                     status += shortname ;
                 } else {
                     r.close();
+                    StaticAssets::fileChanged(filename);
                     status = shortname + F(" created");
                 }
             }
         }
     }
-    String jsonfile = "{";
+    JSONWriter json;
+    json.beginObject();
 #ifdef ARDUINO_ARCH_ESP8266
     FS_DIR dir = SPIFFS.openDir(path);
 #else
@@ -837,8 +643,7 @@ void handleFileList()
 	if ((path != "/") && (path[path.length()-1]='/'))ptmp = path.substring(0,path.length()-1);
 	FS_FILE dir = SPIFFS.open(ptmp);
 #endif
-    jsonfile+=F("\"files\":[");
-    bool firstentry=true;
+    json.beginArray("files");
     String subdirlist="";
 #ifdef ARDUINO_ARCH_ESP8266
     while (dir.next()) {
@@ -863,15 +668,15 @@ void handleFileList()
             if (subdirlist.indexOf(tag)>-1 || filename.length()==0) { //already in list
                 addtolist = false; //no need to add
             } else {
-                size = -1; //it is subfile so display only directory, size will be -1 to describe it is directory
+                size = "-1"; //it is subfile so display only directory, size will be -1 to describe it is directory
                 if (subdirlist.length()==0) {
                     subdirlist+="*";
                 }
                 subdirlist += filename + "*"; //add to list
             }
         } else {
-            //do not add "." file
-            if (!((filename==".") || (filename==""))) {
+            //do not add "." file nor the settings journal
+            if (!(filename.startsWith(".") || (filename==""))) {
 #ifdef ARDUINO_ARCH_ESP8266
                 size = CONFIG::formatBytes(dir.fileSize());
 #else
@@ -883,26 +688,18 @@ void handleFileList()
             }
         }
         if(addtolist) {
-            if (!firstentry) {
-                jsonfile+=",";
-            } else {
-                firstentry=false;
-            }
-            jsonfile+="{";
-            jsonfile+=F("\"name\":\"");
-            jsonfile+=filename;
-            jsonfile+=F("\",\"size\":\"");
-            jsonfile+=size;
-            jsonfile+="\"";
-            jsonfile+="}";
+            json.beginObject();
+            json.member("name", filename);
+            json.member("size", size);
+            json.endObject();
         }
 #ifdef ARDUINO_ARCH_ESP32
         fileparsed = dir.openNextFile();
 #endif
     }
-    jsonfile+="],";
-    jsonfile+=String(F("\"path\":\"")) + path + "\",";
-    jsonfile+=String(F("\"status\":\"")) + status + "\",";
+    json.endArray();
+    json.member("path", path);
+    json.member("status", status);
     size_t totalBytes;
     size_t usedBytes;
 #ifdef ARDUINO_ARCH_ESP8266
@@ -914,15 +711,12 @@ void handleFileList()
 	totalBytes = SPIFFS.totalBytes();
     usedBytes = SPIFFS.usedBytes();
 #endif
-    jsonfile+=String(F("\"total\":\"")) + CONFIG::formatBytes(totalBytes) + "\",";
-    jsonfile+=String(F("\"used\":\"")) + CONFIG::formatBytes(usedBytes) + "\",";
-    jsonfile.concat(F("\"occupation\":\""));
-    jsonfile+= CONFIG::intTostr(100*usedBytes/totalBytes);
-    jsonfile+="\"";
-    jsonfile+="}";
+    json.member("total", CONFIG::formatBytes(totalBytes));
+    json.member("used", CONFIG::formatBytes(usedBytes));
+    json.member("occupation", CONFIG::intTostr(100*usedBytes/totalBytes));
+    json.endObject();
+    json.end();
     path = "";
-    web_interface->web_server.sendHeader("Cache-Control", "no-cache");
-    web_interface->web_server.send(200, "application/json", jsonfile);
     web_interface->_upload_status=UPLOAD_STATUS_NONE;
 }
 
@@ -942,10 +736,13 @@ void handle_serial_SDFileList()
         sstatus = F("Upload failed");
         web_interface->_upload_status = UPLOAD_STATUS_NONE;
     }
-    String jsonfile = String(F("{\"status\":\"")) + sstatus + "\"}";
-    web_interface->web_server.sendHeader("Cache-Control", "no-cache");
-    web_interface->web_server.send(200, "application/json", jsonfile);
-    web_interface->blockserial = false;
+    JSONWriter json;
+    json.beginObject();
+    json.member("status", sstatus);
+    json.endObject();
+    json.end();
+    //in case the upload did not end, a web command keeps its lock
+    web_interface->unlockSerial(SERIAL_LOCK_SD_UPLOAD);
     web_interface->_upload_status=UPLOAD_STATUS_NONE;
 }
 
@@ -964,7 +761,6 @@ void handle_not_found()
     bool page_not_found = false;
     String path = web_interface->web_server.urlDecode(web_interface->web_server.uri());
     String contentType =  web_interface->getContentType(path);
-    String pathWithGz = path + ".gz";
     LOG("request:")
     LOG(path)
     LOG("\r\n")
@@ -981,13 +777,7 @@ void handle_not_found()
     LOG("type:")
     LOG(contentType)
     LOG("\r\n")
-        if(SPIFFS.exists(pathWithGz) || SPIFFS.exists(path)) {
-            if(SPIFFS.exists(pathWithGz)) {
-                path = pathWithGz;
-            }
-            FS_FILE file = SPIFFS.open(path, SPIFFS_FILE_READ);
-            web_interface->web_server.streamFile(file, contentType);
-            file.close();
+        if(StaticAssets::send(path)) {
             return;
         } else {
             page_not_found = true;
@@ -1015,18 +805,7 @@ void handle_not_found()
         }
 #endif
         LOG("Page not found\r\n")
-        path = F("/404.htm");
-        contentType =  web_interface->getContentType(path);
-        pathWithGz =  path + F(".gz");
-        if(SPIFFS.exists(pathWithGz) || SPIFFS.exists(path)) {
-            if(SPIFFS.exists(pathWithGz)) {
-                path = pathWithGz;
-            }
-            FS_FILE file = SPIFFS.open(path, SPIFFS_FILE_READ);
-            web_interface->web_server.streamFile(file, contentType);
-            file.close();
-           
-        } else {
+        if(!StaticAssets::send(F("/404.htm"))) {
             //if not template use default page
             contentType=FPSTR(PAGE_404);
             String stmp;
@@ -1150,13 +929,13 @@ void handle_login()
         }
         //create Session
         if ((current_auth_level != auth_level) || (auth_level== LEVEL_GUEST)) {
-            auth_ip * current_auth = new auth_ip;
-            current_auth->level = current_auth_level;
-            current_auth->ip=web_interface->web_server.client().remoteIP();
-            strcpy(current_auth->sessionID,web_interface->create_session_ID());
-            strcpy(current_auth->userID,sUser.c_str());
-            current_auth->last_time=millis();
-            if (web_interface->AddAuthIP(current_auth)) {
+            auth_ip * current_auth = web_interface->AddAuthIP();
+            if (current_auth) {
+                current_auth->level = current_auth_level;
+                current_auth->ip=web_interface->web_server.client().remoteIP();
+                strcpy(current_auth->sessionID,web_interface->create_session_ID());
+                strcpy(current_auth->userID,sUser.c_str());
+                current_auth->last_time=millis();
                 String tmps ="ESPSESSIONID="; 
                 tmps+=current_auth->sessionID;
                 web_interface->web_server.sendHeader(F("Set-Cookie"), tmps);
@@ -1172,7 +951,6 @@ void handle_login()
                         auths = F("guest");
                     }
             } else {
-                delete current_auth;
                 msg_alert_error=true;
                 code = 500;
                 smsg = F("Error: Too many connections");
@@ -1219,7 +997,6 @@ void handle_web_command()
         web_interface->web_server.send(403,"text/plain","Not allowed, log in first!\n");
         return;
     }*/
-    String buffer2send = "";
     LOG(String (web_interface->web_server.args()))
     LOG(" Web command\r\n")
 #ifdef DEBUG_ESP3D
@@ -1232,7 +1009,6 @@ void handle_web_command()
     }
 #endif
     String cmd = "";
-    int count ;
     if (web_interface->web_server.hasArg("plain") || web_interface->web_server.hasArg("commandText")) {
         if (web_interface->web_server.hasArg("plain")) {
             cmd = web_interface->web_server.arg("plain");
@@ -1279,136 +1055,52 @@ void handle_web_command()
         return;
     }
         //send command to serial as no need to transfer ESP command
-        //to avoid any pollution if Uploading file to SDCard
-        if ((web_interface->blockserial) == false) {
-            //block every query
-            web_interface->blockserial = true;
-            LOG("Block Serial\r\n")
-            //empty the serial buffer and incoming data
-            LOG("Start PurgeSerial\r\n")
-            if(Board::printerPort.available()) {
-                BRIDGE::processFromSerial2TCP();
-                delay(1);
-            }
-            LOG("End PurgeSerial\r\n")
-            web_interface->web_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
-            web_interface->web_server.sendHeader("Content-Type","text/plain",true);
-            web_interface->web_server.sendHeader("Cache-Control","no-cache");
-            web_interface->web_server.send(200);
-            //send command
-            LOG(String(cmd.length()))
-            LOG("Start PurgeSerial\r\n")
-            if(Board::printerPort.available()) {
-                BRIDGE::processFromSerial2TCP();
-                delay(1);
-            }
-            LOG("End PurgeSerial\r\n")
-            LOG("Send Command\r\n")
-            Board::printerPort.println(cmd);
-            count = 0;
-            String current_buffer;
-            String current_line;
-            //int pos;
-            int temp_counter = 0;
-            String tmp;
-            bool datasent = false;
-            //pickup the list
-            while (count < MAX_TRY) {
-                //give some time between each buffer
-                if (Board::printerPort.available()) {
-                    count = 0;
-                    size_t len = Board::printerPort.available();
-                    uint8_t sbuf[len+1];
-                    //read buffer
-                    Board::printerPort.readBytes(sbuf, len);
-                    //change buffer as string
-                    sbuf[len]='\0';
-                    //add buffer to current one if any
-                    current_buffer += (char * ) sbuf;
-                    while (current_buffer.indexOf("\n") !=-1) {
-                        //remove the possible "\r"
-                        current_buffer.replace("\r","");
-                        //pos = current_buffer.indexOf("\n");
-                        //get line
-                        current_line = current_buffer.substring(0,current_buffer.indexOf("\n"));
-                        //if line is command ack - just exit so save the time out period
-                        if ((current_line == "ok") || (current_line == "wait")) {
-                            count = MAX_TRY;
-                            LOG("Found ok\r\n")
-                            break;
-                        }
-                        //get the line and transmit it
-                        LOG("Check command: ")
-                        LOG(current_line)
-                        LOG("\r\n")
-                        //check command
-                        if ((CONFIG::GetFirmwareTarget() == REPETIER) || (CONFIG::GetFirmwareTarget() == REPETIER4DV)){
-                            //save time no need to continue
-                            if (current_line.indexOf("busy:") > -1) {
-                                temp_counter++;
-                            } else if (COMMAND::check_command(current_line, NO_PIPE, false)) {
-                                    temp_counter ++ ;
-                                }
-                        }else {
-                            if (COMMAND::check_command(current_line, NO_PIPE, false)) {
-                                temp_counter ++ ;
-                            }
-                        }
-                        if (temp_counter > 5) {
-                            break;
-                        }
-                        if ((CONFIG::GetFirmwareTarget()  == REPETIER) || (CONFIG::GetFirmwareTarget() == REPETIER4DV)) {
-                            if (!current_line.startsWith( "ok "))
-                                {
-                                    buffer2send +=current_line;
-                                    buffer2send +="\n";
-                                }
-                        } else {
-                            buffer2send +=current_line;
-                            buffer2send +="\n";
-                        }
-                        if (buffer2send.length() > 1200) {
-                            web_interface->web_server.sendContent(buffer2send);
-                            buffer2send = "";
-                            datasent = true;
-                        }
-                        //current remove line from buffer
-                        tmp = current_buffer.substring(current_buffer.indexOf("\n")+1,current_buffer.length());
-                        current_buffer = tmp;
-                        delay(0);
-                    }
-                    delay (0);
-                } else {
-                    delay(1);
-                }
-                //it is sending too many temp status should be heating so let's exit the loop
-                if (temp_counter > 5) {
-                    count = MAX_TRY;
-                }
-                count++;
-            }
-            //to be sure connection close
-            if (buffer2send.length() > 0) {
-                web_interface->web_server.sendContent(buffer2send);
-                datasent = true;
-            }
-            if (!datasent) {
-                web_interface->web_server.sendContent(F(" \r\n"));
-            }
-            web_interface->web_server.sendContent("");
-            LOG("Start PurgeSerial\r\n")
-            if(Board::printerPort.available()) {
-                BRIDGE::processFromSerial2TCP();
-                delay(1);
-            }
-            LOG("End PurgeSerial\r\n")
-            web_interface->blockserial = false;
-            LOG("Release Serial\r\n")
-        } else {
+        //the answer is sent by the queue when printer gives it
+        if (CommandQueue::isFull()) {
             web_interface->web_server.send(200, "text/plain", F("Serial is busy, retry later!"));
+            return;
         }
+        LOG("Queue Command\r\n")
+        CommandQueue::push(cmd, web_interface->web_server.detachClient());
+    }
+}
+
+#ifdef EVENTS_FEATURE
+//Handle events stream, connection stays open and is fed by the main loop
+void handle_events()
+{
+    if (web_interface->is_authenticated() == LEVEL_GUEST) {
+        web_interface->web_server.send(401, "text/plain", F("Authentication failed!\n"));
+        return;
+    }
+    if (EventStream::isFull()) {
+        web_interface->web_server.send(503, "text/plain", F("Too many event clients!\n"));
+        return;
     }
+    LOG("Events client\r\n")
+    EventStream::addClient(web_interface->web_server.detachClient());
 }
+#endif
+
+#ifdef WS_DATA_FEATURE
+//Handle websocket handshake, then connection is served by the bridge like the data port
+void handle_websocket()
+{
+    if (web_interface->is_authenticated() == LEVEL_GUEST) {
+        web_interface->web_server.send(401, "text/plain", F("Authentication failed!\n"));
+        return;
+    }
+    if (!BRIDGE::hasWebSocketRoom()) {
+        web_interface->web_server.send(503, "text/plain", F("Too many websocket clients!\n"));
+        return;
+    }
+    WiFiClient client = web_interface->web_server.upgradeWebSocket();
+    if (client) {
+        LOG("Websocket client\r\n")
+        BRIDGE::addWebSocket(client);
+    }
+}
+#endif
 
 //Handle web command query and sent ack or fail instead of answer
 void handle_web_command_silent()
@@ -1473,11 +1165,9 @@ void handle_web_command_silent()
         }
     } else {
         //send command to serial as no need to transfer ESP command
-        //to avoid any pollution if Uploading file to SDCard
-        if ((web_interface->blockserial) == false) {
-            LOG("Send Command\r\n")
-            //send command
-            Board::printerPort.println(cmd);
+        //it waits in queue if serial is used by another command or an upload
+        if (CommandQueue::push(cmd)) {
+            LOG("Queue Command\r\n")
             web_interface->web_server.send(200,"text/plain","ok");
         } else {
             web_interface->web_server.send(200, "text/plain", F("Serial is busy, retry later!"));
@@ -1510,6 +1200,12 @@ WEBINTERFACE_CLASS::WEBINTERFACE_CLASS (int port):web_server(port)
 #endif
     //TODO: to be reviewed
     web_server.on(F("/STATUS"), HTTP_ANY, handle_web_interface_status);
+#ifdef EVENTS_FEATURE
+    web_server.on(F("/events"), HTTP_GET, handle_events);
+#endif
+#ifdef WS_DATA_FEATURE
+    web_server.on(F("/ws"), HTTP_GET, handle_websocket);
+#endif
 #ifdef SSDP_FEATURE
     web_server.on(F("/description.xml"), HTTP_GET, handle_SSDP);
 #endif
@@ -1520,7 +1216,7 @@ WEBINTERFACE_CLASS::WEBINTERFACE_CLASS (int port):web_server(port)
     web_server.on(F("/fwlink/"), HTTP_ANY, handle_web_interface_root);
 #endif
     web_server.onNotFound( handle_not_found);
-    blockserial = false;
+    _serial_owner = SERIAL_LOCK_NONE;
     restartmodule=false;
     //rolling list of 4 entries with a maximum of 50 char for each entry
 #ifdef ERROR_MSG_FEATURE
@@ -1536,8 +1232,6 @@ WEBINTERFACE_CLASS::WEBINTERFACE_CLASS (int port):web_server(port)
     status_msg.setlength(50);
 #endif
     fsUploadFile=(FS_FILE)0;
-    _head=NULL;
-    _nb_ip=0;
     _upload_status=UPLOAD_STATUS_NONE;
 }
 //Destructor
@@ -1552,13 +1246,28 @@ WEBINTERFACE_CLASS::~WEBINTERFACE_CLASS()
 #ifdef STATUS_MSG_FEATURE
     status_msg.clear();
 #endif
-    while (_head) {
-        auth_ip * current = _head;
-        _head=_head->_next;
-        delete current;
+#ifdef AUTHENTICATION_FEATURE
+    while (_auth_list.first()) {
+        _auth_pool.release(_auth_list.pop());
+    }
+#endif
+}
+bool WEBINTERFACE_CLASS::lockSerial(serial_lock_owner owner)
+{
+    if ((_serial_owner != SERIAL_LOCK_NONE) && (_serial_owner != owner)) {
+        return false;
+    }
+    _serial_owner = owner;
+    return true;
+}
+
+void WEBINTERFACE_CLASS::unlockSerial(serial_lock_owner owner)
+{
+    if (_serial_owner == owner) {
+        _serial_owner = SERIAL_LOCK_NONE;
     }
-    _nb_ip=0;
 }
+
 //check authentification
 level_authenticate_type  WEBINTERFACE_CLASS::is_authenticated()
 {
@@ -1581,16 +1290,14 @@ level_authenticate_type  WEBINTERFACE_CLASS::is_authenticated()
 }
 
 #ifdef AUTHENTICATION_FEATURE
-//add the information in the linked list if possible
-bool WEBINTERFACE_CLASS::AddAuthIP(auth_ip * item)
+//add a session to the list if possible
+auth_ip * WEBINTERFACE_CLASS::AddAuthIP()
 {
-    if (_nb_ip>MAX_AUTH_IP) {
-        return false;
+    auth_ip * item = _auth_pool.acquire();
+    if (item) {
+        _auth_list.push(item);
     }
-    item->_next=_head;
-    _head=item;
-    _nb_ip++;
-    return true;
+    return item;
 }
 
 //Session ID based on IP and time using 16 char
@@ -1615,24 +1322,16 @@ char * WEBINTERFACE_CLASS::create_session_ID()
 
 
 bool WEBINTERFACE_CLASS::ClearAuthIP(IPAddress ip, const char * sessionID){
-    auth_ip * current = _head;
+    auth_ip * current = _auth_list.first();
     auth_ip * previous = NULL;
     bool done = false;
     while (current) {
         if ((ip == current->ip) && (strcmp(sessionID,current->sessionID)==0)) {
             //remove
             done = true;
-            if (current ==_head) {
-                _head=current->_next;
-                _nb_ip--;
-                delete current;
-                current=_head;
-            } else {
-                previous->_next=current->_next;
-                _nb_ip--;
-                delete current;
-                current=previous->_next;
-            }
+            auth_ip * next = _auth_list.unlink(previous, current);
+            _auth_pool.release(current);
+            current = next;
         } else {
             previous = current;
             current=current->_next;
@@ -1644,19 +1343,11 @@ bool WEBINTERFACE_CLASS::ClearAuthIP(IPAddress ip, const char * sessionID){
 //Get info
 auth_ip * WEBINTERFACE_CLASS::GetAuth(IPAddress ip,const char * sessionID)
 {
-    auth_ip * current = _head;
-    auth_ip * previous = NULL;
-    //get time
-    //uint32_t now = millis();
-    while (current) {
-        if (ip==current->ip) {
-            if (strcmp(sessionID,current->sessionID)==0) {
-                //found
-                return current;
-            }
+    for (auth_ip * current = _auth_list.first(); current; current = current->_next) {
+        if ((ip==current->ip) && (strcmp(sessionID,current->sessionID)==0)) {
+            //found
+            return current;
         }
-        previous = current;
-        current=current->_next;
     }
     return NULL;
 }
@@ -1664,24 +1355,14 @@ auth_ip * WEBINTERFACE_CLASS::GetAuth(IPAddress ip,const char * sessionID)
 //Review all IP to reset timers
 level_authenticate_type WEBINTERFACE_CLASS::ResetAuthIP(IPAddress ip,const char * sessionID)
 {
-    auth_ip * current = _head;
+    auth_ip * current = _auth_list.first();
     auth_ip * previous = NULL;
-    //get time
-    //uint32_t now = millis();
     while (current) {
         if ((millis()-current->last_time)>180000) {
             //remove
-            if (current==_head) {
-                _head=current->_next;
-                _nb_ip--;
-                delete current;
-                current=_head;
-            } else {
-                previous->_next=current->_next;
-                _nb_ip--;
-                delete current;
-                current=previous->_next;
-            }
+            auth_ip * next = _auth_list.unlink(previous, current);
+            _auth_pool.release(current);
+            current = next;
         } else {
             if (ip==current->ip) {
                 if (strcmp(sessionID,current->sessionID)==0) {
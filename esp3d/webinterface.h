@@ -35,8 +35,7 @@
 
 
 #include "storestrings.h"
-
-#define MAX_EXTRUDERS 4
+#include "containers.h"
 
 struct auth_ip {
     IPAddress ip;
@@ -70,9 +69,16 @@ public:
     bool restartmodule;
     String getContentType(const String & filename);
     level_authenticate_type is_authenticated();
-    bool AddAuthIP(auth_ip * item);
-    bool blockserial;
+    //false if another owner holds the serial
+    bool lockSerial(serial_lock_owner owner);
+    //only the owner releases the serial, nothing happens otherwise
+    void unlockSerial(serial_lock_owner owner);
+    inline bool isSerialLocked()
+    {
+        return _serial_owner != SERIAL_LOCK_NONE;
+    };
 #ifdef AUTHENTICATION_FEATURE
+    auth_ip * AddAuthIP();
     level_authenticate_type ResetAuthIP(IPAddress ip,const char * sessionID);
     auth_ip * GetAuth(IPAddress ip,const char * sessionID);
     bool ClearAuthIP(IPAddress ip, const char * sessionID);
@@ -81,8 +87,12 @@ public:
     uint8_t _upload_status;
 
 private:
-    auth_ip * _head;
-    uint8_t _nb_ip;
+    serial_lock_owner _serial_owner;
+#ifdef AUTHENTICATION_FEATURE
+    //sessions are taken from a pool instead of the heap
+    ObjectPool<auth_ip, MAX_AUTH_IP> _auth_pool;
+    IntrusiveList<auth_ip> _auth_list;
+#endif
 };
 
 extern WEBINTERFACE_CLASS * web_interface;
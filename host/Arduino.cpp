@@ -0,0 +1,151 @@
+/*
+  host/Arduino.cpp - time, pins and the global objects of the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "Arduino.h"
+
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+EspClass ESP;
+
+#define HOST_PINS 64
+
+static int digitalPins[HOST_PINS];
+static int analogPins[HOST_PINS];
+static void (*interruptHandlers[HOST_PINS])(void);
+
+static struct PinsInit {
+    PinsInit()
+    {
+        for (int &level : digitalPins) {
+            level = HIGH;
+        }
+    }
+} pinsInit;
+
+static std::chrono::steady_clock::time_point bootTime()
+{
+    static std::chrono::steady_clock::time_point boot = std::chrono::steady_clock::now();
+    return boot;
+}
+
+unsigned long millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - bootTime()).count();
+}
+
+unsigned long micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - bootTime()).count();
+}
+
+void delay(unsigned long ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield()
+{
+    std::this_thread::yield();
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin < HOST_PINS) {
+        digitalPins[pin] = value ? HIGH : LOW;
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    return pin < HOST_PINS ? digitalPins[pin] : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+    return pin < HOST_PINS ? analogPins[pin] : 0;
+}
+
+void analogWrite(uint8_t pin, int value)
+{
+    (void)pin;
+    (void)value;
+}
+
+void host_setDigitalInput(uint8_t pin, int value)
+{
+    if (pin >= HOST_PINS) {
+        return;
+    }
+    int level = value ? HIGH : LOW;
+    bool changed = digitalPins[pin] != level;
+    digitalPins[pin] = level;
+    if (changed && interruptHandlers[pin]) {
+        interruptHandlers[pin]();
+    }
+}
+
+void host_setAnalogInput(uint8_t pin, int value)
+{
+    if (pin < HOST_PINS) {
+        analogPins[pin] = value;
+    }
+}
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode)
+{
+    // every change is reported, handlers check the level themselves
+    (void)mode;
+    if (interrupt < HOST_PINS) {
+        interruptHandlers[interrupt] = handler;
+    }
+}
+
+void detachInterrupt(uint8_t interrupt)
+{
+    if (interrupt < HOST_PINS) {
+        interruptHandlers[interrupt] = nullptr;
+    }
+}
+
+long random(long max)
+{
+    return max > 0 ? rand() % max : 0;
+}
+
+long random(long min, long max)
+{
+    return max > min ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed)
+{
+    srand(seed);
+}
+
+void EspClass::restart()
+{
+    fflush(stdout);
+    exit(0);
+}
@@ -0,0 +1,98 @@
+/*
+  host/Arduino.h - Arduino core subset for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+
+#include "pgmspace.h"
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+#include "IPAddress.h"
+#include "Esp.h"
+#include "Updater.h"
+
+#define DEBUGV(...)
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT          0x00
+#define OUTPUT         0x01
+#define INPUT_PULLUP   0x02
+#define INPUT_PULLDOWN_16 0x04
+
+#define CHANGE  0x03
+#define FALLING 0x02
+#define RISING  0x01
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define LED_BUILTIN 2
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define digitalPinToInterrupt(p) (((p) < 16) ? (p) : -1)
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Time comes from the monotonic clock of the host, delay() really sleeps.
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+inline bool isPrintable(int c)
+{
+    return isprint(c) != 0;
+}
+
+// Digital pins read HIGH, as pulled up on the boards, until written or
+// driven by host_setDigitalInput(). analogRead() returns what
+// host_setAnalogInput() set, 0 otherwise.
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void host_setDigitalInput(uint8_t pin, int value);
+void host_setAnalogInput(uint8_t pin, int value);
+
+// Interrupt handlers run from host_setDigitalInput(), interrupts are never
+// masked since nothing runs concurrently with the sketch.
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t interrupt);
+inline void interrupts() {}
+inline void noInterrupts() {}
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// sketch entry points, see host/main.cpp
+void setup();
+void loop();
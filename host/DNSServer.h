@@ -0,0 +1,41 @@
+/*
+  host/DNSServer.h - captive portal DNS placeholder for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+enum class DNSReplyCode {
+    NoError = 0,
+    FormError = 1,
+    ServerFailure = 2,
+    NonExistentDomain = 3,
+    NotImplemented = 4,
+    Refused = 5
+};
+
+
+// DNSServer
+class DNSServer
+{
+public:
+    void setErrorReplyCode(const DNSReplyCode &replyCode)
+    {
+        (void)replyCode;
+    }
+    bool start(uint16_t port, const String &domainName, const IPAddress &resolvedIP)
+    {
+        (void)port;
+        (void)domainName;
+        (void)resolvedIP;
+        return true;
+    }
+    void processNextRequest() {}
+    void stop() {}
+};
@@ -0,0 +1,72 @@
+/*
+  host/EEPROM.cpp - EEPROM emulation for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "EEPROM.h"
+#include "FS.h"
+
+#include <stdio.h>
+
+#define EEPROM_SECTOR_SIZE 4096
+
+EEPROMClass EEPROM;
+
+
+EEPROMClass::~EEPROMClass()
+{
+    delete[] _data;
+}
+
+void EEPROMClass::begin(size_t size)
+{
+    if (size == 0 || size > EEPROM_SECTOR_SIZE) {
+        return;
+    }
+    size = (size + 3) & ~3;
+    delete[] _data;
+    _data = new uint8_t[size];
+    _size = size;
+    _dirty = false;
+    // an erased sector reads as 0xFF
+    memset(_data, 0xff, size);
+    FILE *file = fopen(host_dataPath("eeprom.bin").c_str(), "rb");
+    if (file) {
+        size_t got = fread(_data, 1, size, file);
+        (void)got;
+        fclose(file);
+    }
+}
+
+bool EEPROMClass::commit()
+{
+    if (!_data) {
+        return false;
+    }
+    if (!_dirty) {
+        return true;
+    }
+    FILE *file = fopen(host_dataPath("eeprom.bin").c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool done = fwrite(_data, 1, _size, file) == _size;
+    done = fclose(file) == 0 && done;
+    _eraseCount++;
+    if (done) {
+        _dirty = false;
+    }
+    return done;
+}
+
+void EEPROMClass::end()
+{
+    commit();
+    delete[] _data;
+    _data = nullptr;
+    _size = 0;
+}
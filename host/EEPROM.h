@@ -0,0 +1,82 @@
+/*
+  host/EEPROM.h - EEPROM emulation for the host build. The sector is the
+  file eeprom.bin of the host data directory, see host_dataPath().
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+
+// EEPROMClass
+// Like the ESP8266 core, begin() loads the whole sector into RAM and
+// commit() erases and programs it again when something changed.
+// eraseCount() counts those sector erases.
+class EEPROMClass
+{
+private:
+    uint8_t *_data = nullptr;
+    size_t _size = 0;
+    bool _dirty = false;
+    uint32_t _eraseCount = 0;
+
+public:
+    ~EEPROMClass();
+
+    void begin(size_t size);
+    uint8_t read(int address)
+    {
+        return (_data && address >= 0 && (size_t)address < _size) ? _data[address] : 0;
+    }
+    void write(int address, uint8_t value)
+    {
+        if (_data && address >= 0 && (size_t)address < _size && _data[address] != value) {
+            _data[address] = value;
+            _dirty = true;
+        }
+    }
+    bool commit();
+    void end();
+
+    uint8_t *getDataPtr()
+    {
+        _dirty = true;
+        return _data;
+    }
+    size_t length() const
+    {
+        return _size;
+    }
+
+    template<typename T>
+    T &get(int address, T &t)
+    {
+        if (_data && address >= 0 && address + sizeof(T) <= _size) {
+            memcpy((uint8_t *)&t, _data + address, sizeof(T));
+        }
+        return t;
+    }
+    template<typename T>
+    const T &put(int address, const T &t)
+    {
+        if (_data && address >= 0 && address + sizeof(T) <= _size) {
+            memcpy(_data + address, (const uint8_t *)&t, sizeof(T));
+            _dirty = true;
+        }
+        return t;
+    }
+
+    uint32_t eraseCount() const
+    {
+        return _eraseCount;
+    }
+};
+
+extern EEPROMClass EEPROM;
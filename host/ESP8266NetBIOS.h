@@ -0,0 +1,28 @@
+/*
+  host/ESP8266NetBIOS.h - NetBIOS name service placeholder for the host
+  build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+
+// ESP8266NetBIOS
+class ESP8266NetBIOS
+{
+public:
+    bool begin(const char *name)
+    {
+        (void)name;
+        return true;
+    }
+    void end() {}
+};
+
+extern ESP8266NetBIOS NBNS;
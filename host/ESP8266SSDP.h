@@ -0,0 +1,85 @@
+/*
+  host/ESP8266SSDP.h - SSDP placeholder for the host build, it keeps the
+  settings and only serves the description schema.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "WiFiClient.h"
+
+
+// SSDPClass
+class SSDPClass
+{
+private:
+    String _name;
+    String _schemaURL;
+    String _url;
+    uint16_t _port = 80;
+
+public:
+    bool begin()
+    {
+        return true;
+    }
+    void schema(WiFiClient client)
+    {
+        client.print(F("HTTP/1.1 200 OK\r\nContent-Type: text/xml\r\nConnection: close\r\n\r\n"
+                       "<?xml version=\"1.0\"?><root xmlns=\"urn:schemas-upnp-org:device-1-0\">"
+                       "<device><friendlyName>"));
+        client.print(_name);
+        client.print(F("</friendlyName></device></root>\r\n"));
+    }
+    void setName(const String &name)
+    {
+        _name = name;
+    }
+    void setSchemaURL(const String &url)
+    {
+        _schemaURL = url;
+    }
+    void setURL(const String &url)
+    {
+        _url = url;
+    }
+    void setHTTPPort(uint16_t port)
+    {
+        _port = port;
+    }
+    void setSerialNumber(const String &serialNumber)
+    {
+        (void)serialNumber;
+    }
+    void setModelName(const String &name)
+    {
+        (void)name;
+    }
+    void setModelNumber(const String &num)
+    {
+        (void)num;
+    }
+    void setModelURL(const String &url)
+    {
+        (void)url;
+    }
+    void setManufacturer(const String &name)
+    {
+        (void)name;
+    }
+    void setManufacturerURL(const String &url)
+    {
+        (void)url;
+    }
+    void setDeviceType(const String &deviceType)
+    {
+        (void)deviceType;
+    }
+};
+
+extern SSDPClass SSDP;
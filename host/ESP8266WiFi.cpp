@@ -0,0 +1,78 @@
+/*
+  host/ESP8266WiFi.cpp - WiFi station and access point for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "ESP8266WiFi.h"
+
+extern "C" {
+#include "user_interface.h"
+}
+
+ESP8266WiFiClass WiFi;
+
+static struct softap_config apConfig = {
+    "ESP3D", "12345678", 5, 1, AUTH_WPA2_PSK, 0, 4, 100
+};
+
+
+extern "C" {
+
+void system_restore(void)
+{
+}
+
+bool system_update_cpu_freq(uint8_t freq)
+{
+    return freq == SYS_CPU_80MHZ || freq == SYS_CPU_160MHZ;
+}
+
+enum dhcp_status wifi_station_dhcpc_status(void)
+{
+    return DHCP_STARTED;
+}
+
+enum dhcp_status wifi_softap_dhcps_status(void)
+{
+    return DHCP_STARTED;
+}
+
+bool wifi_get_ip_info(uint8_t if_index, struct ip_info *info)
+{
+    if (if_index == SOFTAP_IF) {
+        info->ip.addr = WiFi.softAPIP();
+        info->gw.addr = WiFi.softAPIP();
+    } else {
+        info->ip.addr = WiFi.localIP();
+        info->gw.addr = WiFi.gatewayIP();
+    }
+    info->netmask.addr = WiFi.subnetMask();
+    return true;
+}
+
+bool wifi_softap_get_config(struct softap_config *config)
+{
+    *config = apConfig;
+    return true;
+}
+
+bool wifi_softap_set_config_current(struct softap_config *config)
+{
+    apConfig = *config;
+    return true;
+}
+
+struct station_info *wifi_softap_get_station_info(void)
+{
+    return nullptr;
+}
+
+void wifi_softap_free_station_info(void)
+{
+}
+
+}
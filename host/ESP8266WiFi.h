@@ -0,0 +1,252 @@
+/*
+  host/ESP8266WiFi.h - WiFi station and access point for the host build.
+  There is no radio: joining a network succeeds at once and the sockets
+  use the network of the host.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "WiFiClient.h"
+#include "WiFiServer.h"
+
+#define WL_MAC_ADDR_LENGTH 6
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} WiFiMode_t;
+
+typedef enum {
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    WIFI_PHY_MODE_11B = 1,
+    WIFI_PHY_MODE_11G = 2,
+    WIFI_PHY_MODE_11N = 3
+} WiFiPhyMode_t;
+
+typedef enum {
+    WIFI_NONE_SLEEP = 0,
+    WIFI_LIGHT_SLEEP = 1,
+    WIFI_MODEM_SLEEP = 2
+} WiFiSleepType_t;
+
+enum wl_enc_type {
+    ENC_TYPE_WEP = 5,
+    ENC_TYPE_TKIP = 2,
+    ENC_TYPE_CCMP = 4,
+    ENC_TYPE_NONE = 7,
+    ENC_TYPE_AUTO = 8
+};
+
+
+// ESP8266WiFiClass
+class ESP8266WiFiClass
+{
+private:
+    WiFiMode_t _mode = WIFI_OFF;
+    wl_status_t _status = WL_DISCONNECTED;
+    WiFiPhyMode_t _phyMode = WIFI_PHY_MODE_11N;
+    WiFiSleepType_t _sleepMode = WIFI_NONE_SLEEP;
+    String _ssid;
+    String _hostname = "esp3d";
+    IPAddress _localIP = IPAddress(127, 0, 0, 1);
+    IPAddress _gatewayIP = IPAddress(127, 0, 0, 1);
+    IPAddress _subnetMask = IPAddress(255, 0, 0, 0);
+    IPAddress _softAPIP = IPAddress(127, 0, 0, 1);
+
+public:
+    bool mode(WiFiMode_t mode)
+    {
+        _mode = mode;
+        if (!(mode & WIFI_STA)) {
+            _status = WL_DISCONNECTED;
+        }
+        return true;
+    }
+    WiFiMode_t getMode() const
+    {
+        return _mode;
+    }
+    bool enableSTA(bool enable)
+    {
+        return mode((WiFiMode_t)(enable ? _mode | WIFI_STA : _mode & ~WIFI_STA));
+    }
+    bool enableAP(bool enable)
+    {
+        return mode((WiFiMode_t)(enable ? _mode | WIFI_AP : _mode & ~WIFI_AP));
+    }
+    void persistent(bool persistent)
+    {
+        (void)persistent;
+    }
+
+    wl_status_t begin(const char *ssid, const char *passphrase = nullptr)
+    {
+        (void)passphrase;
+        enableSTA(true);
+        _ssid = ssid;
+        _status = WL_CONNECTED;
+        return _status;
+    }
+    bool config(IPAddress local_ip, IPAddress gateway, IPAddress subnet)
+    {
+        _localIP = local_ip;
+        _gatewayIP = gateway;
+        _subnetMask = subnet;
+        return true;
+    }
+    bool disconnect(bool wifioff = false)
+    {
+        _status = WL_DISCONNECTED;
+        if (wifioff) {
+            enableSTA(false);
+        }
+        return true;
+    }
+    wl_status_t status() const
+    {
+        return _status;
+    }
+    bool isConnected() const
+    {
+        return _status == WL_CONNECTED;
+    }
+
+    bool softAP(const char *ssid, const char *passphrase = nullptr)
+    {
+        (void)ssid;
+        (void)passphrase;
+        return enableAP(true);
+    }
+    bool softAPConfig(IPAddress local_ip, IPAddress gateway, IPAddress subnet)
+    {
+        (void)gateway;
+        (void)subnet;
+        _softAPIP = local_ip;
+        return true;
+    }
+
+    bool setPhyMode(WiFiPhyMode_t mode)
+    {
+        _phyMode = mode;
+        return true;
+    }
+    WiFiPhyMode_t getPhyMode() const
+    {
+        return _phyMode;
+    }
+    bool setSleepMode(WiFiSleepType_t type)
+    {
+        _sleepMode = type;
+        return true;
+    }
+    WiFiSleepType_t getSleepMode() const
+    {
+        return _sleepMode;
+    }
+
+    String hostname() const
+    {
+        return _hostname;
+    }
+    bool hostname(const String &name)
+    {
+        _hostname = name;
+        return true;
+    }
+    bool hostname(const char *name)
+    {
+        _hostname = name;
+        return true;
+    }
+
+    IPAddress localIP() const
+    {
+        return _localIP;
+    }
+    IPAddress gatewayIP() const
+    {
+        return _gatewayIP;
+    }
+    IPAddress subnetMask() const
+    {
+        return _subnetMask;
+    }
+    IPAddress dnsIP(uint8_t dns_no = 0) const
+    {
+        (void)dns_no;
+        return _gatewayIP;
+    }
+    IPAddress softAPIP() const
+    {
+        return _softAPIP;
+    }
+
+    uint8_t *macAddress(uint8_t *mac) const
+    {
+        static const uint8_t address[WL_MAC_ADDR_LENGTH] = {0x5c, 0xcf, 0x7f, 0x00, 0xe5, 0xd3};
+        memcpy(mac, address, WL_MAC_ADDR_LENGTH);
+        return mac;
+    }
+    String macAddress() const
+    {
+        return "5C:CF:7F:00:E5:D3";
+    }
+    String softAPmacAddress() const
+    {
+        return "5E:CF:7F:00:E5:D3";
+    }
+
+    String SSID() const
+    {
+        return _ssid;
+    }
+    int32_t RSSI() const
+    {
+        return -50;
+    }
+    int32_t channel() const
+    {
+        return 1;
+    }
+
+    int8_t scanNetworks()
+    {
+        return 0;
+    }
+    void scanDelete() {}
+    String SSID(uint8_t i) const
+    {
+        (void)i;
+        return String();
+    }
+    int32_t RSSI(uint8_t i) const
+    {
+        (void)i;
+        return 0;
+    }
+    uint8_t encryptionType(uint8_t i) const
+    {
+        (void)i;
+        return ENC_TYPE_NONE;
+    }
+};
+
+extern ESP8266WiFiClass WiFi;
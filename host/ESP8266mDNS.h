@@ -0,0 +1,31 @@
+/*
+  host/ESP8266mDNS.h - mDNS responder placeholder for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+
+// MDNSResponder
+class MDNSResponder
+{
+public:
+    bool begin(const char *hostname)
+    {
+        (void)hostname;
+        return true;
+    }
+    void addService(const char *service, const char *proto, uint16_t port)
+    {
+        (void)service;
+        (void)proto;
+        (void)port;
+    }
+    void update() {}
+};
@@ -0,0 +1,84 @@
+/*
+  host/Esp.h - ESP object for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+typedef enum {
+    FM_QIO = 0x00,
+    FM_QOUT = 0x01,
+    FM_DIO = 0x02,
+    FM_DOUT = 0x03,
+    FM_FAST_READ = 0x04,
+    FM_SLOW_READ = 0x05,
+    FM_UNKNOWN = 0xff
+} FlashMode_t;
+
+
+// EspClass
+// Reports a 4 MB ESP8266 running at 80 MHz. restart() ends the process.
+class EspClass
+{
+public:
+    void restart();
+    void reset()
+    {
+        restart();
+    }
+
+    uint32_t getChipId()
+    {
+        return 0x00e5d3d;
+    }
+    const char *getSdkVersion()
+    {
+        return "host";
+    }
+    uint8_t getCpuFreqMHz()
+    {
+        return 80;
+    }
+    uint32_t getFreeHeap()
+    {
+        return 40 * 1024;
+    }
+
+    uint32_t getFlashChipId()
+    {
+        return 0x1640e0;
+    }
+    uint32_t getFlashChipSize()
+    {
+        return 4 * 1024 * 1024;
+    }
+    uint32_t getFlashChipRealSize()
+    {
+        return 4 * 1024 * 1024;
+    }
+    uint32_t getFlashChipSpeed()
+    {
+        return 40000000;
+    }
+    FlashMode_t getFlashChipMode()
+    {
+        return FM_DIO;
+    }
+
+    uint32_t getSketchSize()
+    {
+        return 400 * 1024;
+    }
+    uint32_t getFreeSketchSpace()
+    {
+        return 600 * 1024;
+    }
+};
+
+extern EspClass ESP;
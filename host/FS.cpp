@@ -0,0 +1,309 @@
+/*
+  host/FS.cpp - SPIFFS for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "FS.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// size of the 1 MB SPIFFS partition of a 4 MB module
+#define SPIFFS_HOST_TOTAL_BYTES 957314
+#define SPIFFS_HOST_BLOCK_SIZE  8192
+#define SPIFFS_HOST_PAGE_SIZE   256
+
+fs::FS SPIFFS;
+
+static std::string dataDir;
+
+
+static void makeDirs(const std::string &path)
+{
+    for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        mkdir(path.substr(0, pos).c_str(), 0755);
+    }
+    mkdir(path.c_str(), 0755);
+}
+
+static std::string parentOf(const std::string &path)
+{
+    size_t pos = path.rfind('/');
+    return pos == std::string::npos ? std::string() : path.substr(0, pos);
+}
+
+static bool isFile(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+void host_setDataDir(const std::string &dir)
+{
+    dataDir = dir;
+}
+
+std::string host_dataPath(const std::string &name)
+{
+    if (dataDir.empty()) {
+        const char *env = getenv("ESP3D_HOST_DATA");
+        dataDir = env && *env ? env : "esp3d_data";
+    }
+    makeDirs(dataDir);
+    return dataDir + "/" + name;
+}
+
+namespace fs
+{
+
+struct File::Handle {
+    FILE *file;
+    std::string name;
+
+    Handle(FILE *f, const std::string &n) : file(f), name(n) {}
+    ~Handle()
+    {
+        fclose(file);
+    }
+};
+
+File::File(FILE *file, const std::string &name) : _handle(std::make_shared<Handle>(file, name)) {}
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+    return _handle ? fwrite(buffer, 1, size, _handle->file) : 0;
+}
+
+int File::available()
+{
+    return _handle ? (int)(size() - position()) : 0;
+}
+
+int File::read()
+{
+    return _handle ? fgetc(_handle->file) : -1;
+}
+
+int File::peek()
+{
+    if (!_handle) {
+        return -1;
+    }
+    int c = fgetc(_handle->file);
+    if (c != EOF) {
+        ungetc(c, _handle->file);
+    }
+    return c;
+}
+
+void File::flush()
+{
+    if (_handle) {
+        fflush(_handle->file);
+    }
+}
+
+size_t File::read(uint8_t *buffer, size_t size)
+{
+    return _handle ? fread(buffer, 1, size, _handle->file) : 0;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode)
+{
+    static const int whence[] = {SEEK_SET, SEEK_CUR, SEEK_END};
+    return _handle && fseek(_handle->file, pos, whence[mode]) == 0;
+}
+
+size_t File::position() const
+{
+    return _handle ? ftell(_handle->file) : 0;
+}
+
+size_t File::size() const
+{
+    struct stat st;
+    if (!_handle) {
+        return 0;
+    }
+    fflush(_handle->file);
+    return fstat(fileno(_handle->file), &st) == 0 ? st.st_size : 0;
+}
+
+void File::close()
+{
+    _handle.reset();
+}
+
+const char *File::name() const
+{
+    return _handle ? _handle->name.c_str() : "";
+}
+
+
+bool Dir::next()
+{
+    if (_next >= _names.size()) {
+        return false;
+    }
+    _current = _names[_next++];
+    return true;
+}
+
+size_t Dir::fileSize() const
+{
+    return const_cast<FS &>(SPIFFS).open(_current.c_str(), "r").size();
+}
+
+File Dir::openFile(const char *mode) const
+{
+    return SPIFFS.open(_current.c_str(), mode);
+}
+
+
+std::string FS::realPath(const char *path) const
+{
+    return host_dataPath("spiffs") + path;
+}
+
+void FS::list(const std::string &dir, std::vector<std::string> &names) const
+{
+    DIR *d = opendir((host_dataPath("spiffs") + dir).c_str());
+    if (!d) {
+        return;
+    }
+    while (struct dirent *entry = readdir(d)) {
+        if (entry->d_name[0] == '.' && (!entry->d_name[1] || (entry->d_name[1] == '.' && !entry->d_name[2]))) {
+            continue;
+        }
+        std::string name = dir + "/" + entry->d_name;
+        if (isFile(host_dataPath("spiffs") + name)) {
+            names.push_back(name);
+        } else {
+            list(name, names);
+        }
+    }
+    closedir(d);
+}
+
+bool FS::begin()
+{
+    makeDirs(host_dataPath("spiffs"));
+    _mounted = true;
+    return true;
+}
+
+bool FS::format()
+{
+    std::vector<std::string> names;
+    list("", names);
+    for (const std::string &name : names) {
+        remove(name.c_str());
+    }
+    return true;
+}
+
+bool FS::info(FSInfo &info) const
+{
+    info.totalBytes = totalBytes();
+    info.usedBytes = usedBytes();
+    info.blockSize = SPIFFS_HOST_BLOCK_SIZE;
+    info.pageSize = SPIFFS_HOST_PAGE_SIZE;
+    info.maxOpenFiles = 5;
+    info.maxPathLength = SPIFFS_HOST_NAME_LEN;
+    return true;
+}
+
+size_t FS::totalBytes() const
+{
+    return SPIFFS_HOST_TOTAL_BYTES;
+}
+
+size_t FS::usedBytes() const
+{
+    std::vector<std::string> names;
+    list("", names);
+    size_t used = 0;
+    struct stat st;
+    for (const std::string &name : names) {
+        if (stat(realPath(name.c_str()).c_str(), &st) == 0) {
+            // whole pages, like SPIFFS
+            used += (st.st_size + SPIFFS_HOST_PAGE_SIZE - 1) / SPIFFS_HOST_PAGE_SIZE * SPIFFS_HOST_PAGE_SIZE;
+        }
+    }
+    return used;
+}
+
+File FS::open(const char *path, const char *mode)
+{
+    if (!_mounted || !path || path[0] != '/' || strlen(path) >= SPIFFS_HOST_NAME_LEN) {
+        return File();
+    }
+    std::string real = realPath(path);
+    std::string fmode(mode);
+    if (fmode[0] != 'r') {
+        makeDirs(parentOf(real));
+    } else if (!isFile(real)) {
+        return File();
+    }
+    FILE *file = fopen(real.c_str(), (fmode + "b").c_str());
+    return file ? File(file, path) : File();
+}
+
+bool FS::exists(const char *path) const
+{
+    return _mounted && path && path[0] == '/' && isFile(realPath(path));
+}
+
+Dir FS::openDir(const char *path) const
+{
+    std::vector<std::string> names;
+    if (_mounted) {
+        list("", names);
+    }
+    std::string prefix(path ? path : "");
+    names.erase(std::remove_if(names.begin(), names.end(), [&prefix](const std::string & name) {
+        return name.compare(0, prefix.size(), prefix) != 0;
+    }), names.end());
+    std::sort(names.begin(), names.end());
+    return Dir(std::move(names));
+}
+
+bool FS::remove(const char *path)
+{
+    if (!exists(path)) {
+        return false;
+    }
+    std::string real = realPath(path);
+    if (::remove(real.c_str()) != 0) {
+        return false;
+    }
+    // SPIFFS has no directories, drop the ones left empty
+    std::string root = host_dataPath("spiffs");
+    for (std::string dir = parentOf(real); dir.size() > root.size(); dir = parentOf(dir)) {
+        if (rmdir(dir.c_str()) != 0) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool FS::rename(const char *pathFrom, const char *pathTo)
+{
+    if (!exists(pathFrom) || !pathTo || pathTo[0] != '/' || strlen(pathTo) >= SPIFFS_HOST_NAME_LEN ||
+            exists(pathTo)) {
+        return false;
+    }
+    std::string to = realPath(pathTo);
+    makeDirs(parentOf(to));
+    return ::rename(realPath(pathFrom).c_str(), to.c_str()) == 0;
+}
+
+}
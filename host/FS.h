@@ -0,0 +1,191 @@
+/*
+  host/FS.h - SPIFFS for the host build. Files live in the spiffs
+  directory of the host data directory; like SPIFFS the names are flat
+  paths, a "/a/b" file is kept as a/b and directories only exist for the
+  files they hold.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+// SPIFFS_OBJ_NAME_LEN of the ESP8266 core, including the NUL
+#define SPIFFS_HOST_NAME_LEN 32
+
+// Directory holding eeprom.bin and spiffs/, ESP3D_HOST_DATA or
+// ./esp3d_data unless set before the first use.
+void host_setDataDir(const std::string &dir);
+std::string host_dataPath(const std::string &name);
+
+namespace fs
+{
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+struct FSInfo {
+    size_t totalBytes;
+    size_t usedBytes;
+    size_t blockSize;
+    size_t pageSize;
+    size_t maxOpenFiles;
+    size_t maxPathLength;
+};
+
+
+// File
+// Copies share the open file, close() on any copy closes it for all.
+class File : public Stream
+{
+private:
+    struct Handle;
+    std::shared_ptr<Handle> _handle;
+
+public:
+    File() {}
+    // File(0) is a closed file, like a null FileImplPtr on the ESP8266
+    File(std::nullptr_t) {}
+    File(FILE *file, const std::string &name);
+
+    using Print::write;
+    using Stream::readBytes;
+
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t read(uint8_t *buffer, size_t size);
+    size_t readBytes(char *buffer, size_t length) override
+    {
+        return read((uint8_t *)buffer, length);
+    }
+    bool seek(uint32_t pos, SeekMode mode);
+    bool seek(uint32_t pos)
+    {
+        return seek(pos, SeekSet);
+    }
+    size_t position() const;
+    size_t size() const;
+    void close();
+    const char *name() const;
+    const char *fullName() const
+    {
+        return name();
+    }
+    bool isFile() const
+    {
+        return (bool)_handle;
+    }
+    bool isDirectory() const
+    {
+        return false;
+    }
+    operator bool() const
+    {
+        return (bool)_handle;
+    }
+};
+
+
+// Dir
+// Iterates over the files whose name starts with the path given to
+// FS::openDir(), subdirectories included like on SPIFFS.
+class Dir
+{
+private:
+    std::vector<std::string> _names;
+    size_t _next = 0;
+    std::string _current;
+
+public:
+    Dir() {}
+    explicit Dir(std::vector<std::string> &&names) : _names(std::move(names)) {}
+
+    bool next();
+    String fileName() const
+    {
+        return String(_current.c_str());
+    }
+    size_t fileSize() const;
+    File openFile(const char *mode) const;
+};
+
+
+// FS
+class FS
+{
+private:
+    bool _mounted = false;
+
+    std::string realPath(const char *path) const;
+    void list(const std::string &dir, std::vector<std::string> &names) const;
+
+public:
+    bool begin();
+    void end()
+    {
+        _mounted = false;
+    }
+    bool format();
+    bool info(FSInfo &info) const;
+    size_t totalBytes() const;
+    size_t usedBytes() const;
+
+    File open(const char *path, const char *mode);
+    File open(const String &path, const char *mode)
+    {
+        return open(path.c_str(), mode);
+    }
+    bool exists(const char *path) const;
+    bool exists(const String &path) const
+    {
+        return exists(path.c_str());
+    }
+    Dir openDir(const char *path) const;
+    Dir openDir(const String &path) const
+    {
+        return openDir(path.c_str());
+    }
+    bool remove(const char *path);
+    bool remove(const String &path)
+    {
+        return remove(path.c_str());
+    }
+    bool rename(const char *pathFrom, const char *pathTo);
+    bool rename(const String &pathFrom, const String &pathTo)
+    {
+        return rename(pathFrom.c_str(), pathTo.c_str());
+    }
+};
+
+}
+
+extern fs::FS SPIFFS;
+
+#ifndef FS_NO_GLOBALS
+using fs::FS;
+using fs::File;
+using fs::Dir;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::FSInfo;
+#endif
@@ -0,0 +1,152 @@
+/*
+  host/HardwareSerial.h - UART for the host build. The other end of the
+  line is a SerialDevice attached by the test, a bench or host/main.cpp;
+  with nothing attached the port reads nothing and drops what is written.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include "Stream.h"
+
+#define SERIAL_8N1 0x1c
+
+
+// SerialDevice
+// What is wired to a HardwareSerial: it receives what the board writes and
+// provides what the board reads. available()/read() and write() are called
+// from the sketch loop, a device that keeps time does its work there.
+class SerialDevice
+{
+public:
+    virtual ~SerialDevice() {}
+
+    virtual void begin(unsigned long baud)
+    {
+        (void)baud;
+    }
+    // size of the receive buffer of the board, what overflows it is lost
+    virtual void setRxBufferSize(size_t size)
+    {
+        (void)size;
+    }
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+    virtual int availableForWrite()
+    {
+        return 128;
+    }
+    // returns once everything written has left the board
+    virtual void flush() {}
+};
+
+
+// HardwareSerial
+class HardwareSerial : public Stream
+{
+private:
+    int _uart;
+    unsigned long _baud = 0;
+    size_t _rxBufferSize = 256;
+    SerialDevice *_device = nullptr;
+
+public:
+    explicit HardwareSerial(int uart) : _uart(uart) {}
+
+    using Print::write;
+
+    void attach(SerialDevice *device)
+    {
+        _device = device;
+        if (!_device) {
+            return;
+        }
+        _device->setRxBufferSize(_rxBufferSize);
+        if (_baud) {
+            _device->begin(_baud);
+        }
+    }
+    SerialDevice *device() const
+    {
+        return _device;
+    }
+
+    void begin(unsigned long baud, int config = SERIAL_8N1)
+    {
+        (void)config;
+        _baud = baud;
+        if (_device) {
+            _device->begin(baud);
+        }
+    }
+    void end()
+    {
+        _baud = 0;
+    }
+    unsigned long baudRate() const
+    {
+        return _baud;
+    }
+    size_t setRxBufferSize(size_t size)
+    {
+        _rxBufferSize = size;
+        if (_device) {
+            _device->setRxBufferSize(size);
+        }
+        return size;
+    }
+    size_t getRxBufferSize() const
+    {
+        return _rxBufferSize;
+    }
+    void swap() {}
+    void setDebugOutput(bool enable)
+    {
+        (void)enable;
+    }
+
+    int available() override
+    {
+        return _device ? _device->available() : 0;
+    }
+    int read() override
+    {
+        return _device ? _device->read() : -1;
+    }
+    int peek() override
+    {
+        return _device ? _device->peek() : -1;
+    }
+    int availableForWrite()
+    {
+        return _device ? _device->availableForWrite() : 128;
+    }
+    void flush() override
+    {
+        if (_device) {
+            _device->flush();
+        }
+    }
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        return _device ? _device->write(buffer, size) : size;
+    }
+
+    operator bool() const
+    {
+        return true;
+    }
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
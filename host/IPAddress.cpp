@@ -0,0 +1,37 @@
+/*
+  host/IPAddress.cpp - IPv4 address for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "IPAddress.h"
+
+#include <stdio.h>
+
+const IPAddress INADDR_NONE(0, 0, 0, 0);
+
+
+bool IPAddress::fromString(const char *address)
+{
+    unsigned a, b, c, d;
+    char tail;
+    if (sscanf(address, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4) {
+        return false;
+    }
+    if (a > 255 || b > 255 || c > 255 || d > 255) {
+        return false;
+    }
+    *this = IPAddress(a, b, c, d);
+    return true;
+}
+
+String IPAddress::toString() const
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _address.bytes[0], _address.bytes[1],
+             _address.bytes[2], _address.bytes[3]);
+    return String(buf);
+}
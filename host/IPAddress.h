@@ -0,0 +1,84 @@
+/*
+  host/IPAddress.h - IPv4 address for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "WString.h"
+
+
+// IPAddress
+// Converts to and from uint32_t in network byte order like the ESP8266 core.
+class IPAddress
+{
+private:
+    union {
+        uint8_t bytes[4];
+        uint32_t dword;
+    } _address;
+
+public:
+    IPAddress()
+    {
+        _address.dword = 0;
+    }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+    {
+        _address.bytes[0] = a;
+        _address.bytes[1] = b;
+        _address.bytes[2] = c;
+        _address.bytes[3] = d;
+    }
+    IPAddress(uint32_t address)
+    {
+        _address.dword = address;
+    }
+    IPAddress(const uint8_t *address)
+    {
+        memcpy(_address.bytes, address, 4);
+    }
+
+    bool fromString(const char *address);
+    bool fromString(const String &address)
+    {
+        return fromString(address.c_str());
+    }
+    String toString() const;
+
+    operator uint32_t() const
+    {
+        return _address.dword;
+    }
+    bool operator==(const IPAddress &addr) const
+    {
+        return _address.dword == addr._address.dword;
+    }
+    bool operator!=(const IPAddress &addr) const
+    {
+        return !(*this == addr);
+    }
+    bool operator==(uint32_t addr) const
+    {
+        return _address.dword == addr;
+    }
+    uint8_t operator[](int index) const
+    {
+        return _address.bytes[index];
+    }
+    uint8_t &operator[](int index)
+    {
+        return _address.bytes[index];
+    }
+};
+
+// netinet/in.h has a macro of that name
+#undef INADDR_NONE
+extern const IPAddress INADDR_NONE;
@@ -0,0 +1,18 @@
+/*
+  host/Libraries.cpp - global objects of the host library placeholders.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "ESP8266NetBIOS.h"
+#include "ESP8266SSDP.h"
+#include "Updater.h"
+#include "Wire.h"
+
+SSDPClass SSDP;
+ESP8266NetBIOS NBNS;
+UpdaterClass Update;
+TwoWire Wire;
@@ -0,0 +1,109 @@
+/*
+  host/Print.cpp - Arduino Print for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "Print.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <vector>
+
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (n < size && write(buffer[n])) {
+        n++;
+    }
+    return n;
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    char buf[64];
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    if ((size_t)len < sizeof(buf)) {
+        return write((const uint8_t *)buf, len);
+    }
+    std::vector<char> big(len + 1);
+    va_start(args, format);
+    vsnprintf(big.data(), big.size(), format, args);
+    va_end(args);
+    return write((const uint8_t *)big.data(), len);
+}
+
+size_t Print::print(const __FlashStringHelper *str)
+{
+    return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const String &str)
+{
+    return write((const uint8_t *)str.c_str(), str.length());
+}
+
+size_t Print::print(const char *str)
+{
+    return write(str);
+}
+
+size_t Print::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base)
+{
+    return print(String(value, base));
+}
+
+size_t Print::print(int value, int base)
+{
+    return print(String(value, base));
+}
+
+size_t Print::print(unsigned int value, int base)
+{
+    return print(String(value, base));
+}
+
+size_t Print::print(long value, int base)
+{
+    return print(String(value, base));
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+    return print(String(value, base));
+}
+
+size_t Print::print(long long value, int base)
+{
+    return print(String(value, base));
+}
+
+size_t Print::print(unsigned long long value, int base)
+{
+    return print(String(value, base));
+}
+
+size_t Print::print(double value, int digits)
+{
+    return print(String(value, digits));
+}
+
+size_t Print::println()
+{
+    return write("\r\n");
+}
@@ -0,0 +1,833 @@
+/*
+  host/PrinterSimulator.cpp - 3D printer on the other end of the printer
+  serial port of the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "PrinterSimulator.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <algorithm>
+
+#include "Arduino.h"
+
+#define AMBIENT_TEMPERATURE 20.0f
+// free planner slots in Marlin advanced ok
+#define PLANNER_FREE 15
+#define SD_BLOCK_SIZE 512
+
+
+// first token of a command: "G1", "M105", "T0"
+static bool commandCode(const std::string &text, char &letter, int &number)
+{
+    if (text.empty() || !isalpha((unsigned char)text[0])) {
+        return false;
+    }
+    letter = toupper((unsigned char)text[0]);
+    char *end;
+    number = (int)strtol(text.c_str() + 1, &end, 10);
+    return end != text.c_str() + 1;
+}
+
+static bool is(const std::string &text, char letter, int number)
+{
+    char l;
+    int n;
+    return commandCode(text, l, n) && (l == letter) && (n == number);
+}
+
+// value of the parameter following the command code, "S200" in "M109 S200"
+static bool parameter(const std::string &text, char letter, float &value)
+{
+    size_t pos = text.find(' ');
+    while (pos != std::string::npos) {
+        while (pos < text.size() && text[pos] == ' ') {
+            pos++;
+        }
+        if (pos < text.size() && toupper((unsigned char)text[pos]) == letter) {
+            value = atof(text.c_str() + pos + 1);
+            return true;
+        }
+        pos = text.find(' ', pos);
+    }
+    return false;
+}
+
+// what follows the command code, a file name for M23, M28 and M30
+static std::string argument(const std::string &text)
+{
+    size_t pos = text.find(' ');
+    if (pos == std::string::npos) {
+        return "";
+    }
+    while (pos < text.size() && text[pos] == ' ') {
+        pos++;
+    }
+    return text.substr(pos);
+}
+
+static std::string trim(const std::string &text)
+{
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = text.find_last_not_of(" \t");
+    return text.substr(first, last - first + 1);
+}
+
+static std::string format(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static std::string format(const char *fmt, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return buf;
+}
+
+
+const size_t PrinterSimulator::TX_FIFO_SIZE;
+const uint64_t PrinterSimulator::NEVER;
+
+PrinterSimulator::PrinterSimulator(Firmware firmware) : PrinterSimulator(firmware, Options()) {}
+
+PrinterSimulator::PrinterSimulator(Firmware firmware, const Options &options) :
+    _firmware(firmware), _options(options), _random(options.seed ? options.seed : 1),
+    _autoReportInterval(options.autoReportInterval)
+{
+    _clock = now();
+    _lastActivity = _clock;
+    for (Heater &heater : _heaters) {
+        heater.from = AMBIENT_TEMPERATURE;
+        heater.target = 0;
+        heater.since = _clock;
+    }
+    for (float &axis : _position) {
+        axis = 0;
+    }
+    if (_autoReportInterval) {
+        _nextAutoReport = _clock + _autoReportInterval * 1000000ULL;
+    }
+}
+
+bool PrinterSimulator::firmwareFromName(const char *name, Firmware &firmware)
+{
+    static const struct {
+        const char *name;
+        Firmware firmware;
+    } names[] = {
+        {"marlin", Firmware_Marlin},
+        {"marlinkimbra", Firmware_MarlinKimbra},
+        {"repetier", Firmware_Repetier},
+        {"repetier4dv", Firmware_Repetier4DV},
+        {"smoothieware", Firmware_Smoothieware},
+    };
+    for (const auto &entry : names) {
+        if (name && strcasecmp(name, entry.name) == 0) {
+            firmware = entry.firmware;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PrinterSimulator::setFile(const std::string &name, const std::string &content)
+{
+    _files[name] = content;
+}
+
+float PrinterSimulator::temperature(int heater) const
+{
+    return temperature(heater, std::max(_clock, now()));
+}
+
+uint64_t PrinterSimulator::now()
+{
+    return (uint64_t)micros() * 1000;
+}
+
+bool PrinterSimulator::chance(double rate)
+{
+    if (rate <= 0) {
+        return false;
+    }
+    // xorshift32
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random < rate * 4294967296.0;
+}
+
+bool PrinterSimulator::isMarlin() const
+{
+    return (_firmware == Firmware_Marlin) || (_firmware == Firmware_MarlinKimbra);
+}
+
+bool PrinterSimulator::isRepetier() const
+{
+    return (_firmware == Firmware_Repetier) || (_firmware == Firmware_Repetier4DV);
+}
+
+void PrinterSimulator::update()
+{
+    advance(std::max(_clock, now()));
+}
+
+void PrinterSimulator::begin(unsigned long baud)
+{
+    update();
+    _byteTime = baud ? 10000000000ULL / baud : 0;
+}
+
+void PrinterSimulator::setRxBufferSize(size_t size)
+{
+    _boardRxSize = size;
+}
+
+int PrinterSimulator::available()
+{
+    update();
+    return _boardRx.size();
+}
+
+int PrinterSimulator::read()
+{
+    if (_boardRx.empty()) {
+        update();
+        if (_boardRx.empty()) {
+            return -1;
+        }
+    }
+    uint8_t c = _boardRx.front();
+    _boardRx.pop_front();
+    return c;
+}
+
+int PrinterSimulator::peek()
+{
+    if (_boardRx.empty()) {
+        update();
+        if (_boardRx.empty()) {
+            return -1;
+        }
+    }
+    return _boardRx.front();
+}
+
+size_t PrinterSimulator::write(const uint8_t *buffer, size_t size)
+{
+    update();
+    for (size_t i = 0; i < size; i++) {
+        // like the UART driver, wait for room in the fifo
+        while (_byteTime && _toPrinter.size() >= TX_FIFO_SIZE) {
+            uint64_t t = now();
+            uint64_t due = _toPrinter.front().time;
+            if (due > t) {
+                delayMicroseconds((due - t + 999) / 1000);
+            }
+            update();
+        }
+        WireByte byte;
+        byte.value = buffer[i];
+        byte.lost = false;
+        byte.time = std::max(_clock, _toPrinterEnd) + _byteTime;
+        _toPrinterEnd = byte.time;
+        if (chance(_options.dropRate)) {
+            byte.lost = true;
+            _stats.dropped++;
+        } else if (chance(_options.corruptRate)) {
+            byte.value ^= 1 << (_random % 8);
+            _stats.corrupted++;
+        }
+        _toPrinter.push_back(byte);
+    }
+    advance(_clock);
+    return size;
+}
+
+int PrinterSimulator::availableForWrite()
+{
+    update();
+    if (!_byteTime) {
+        return TX_FIFO_SIZE;
+    }
+    return TX_FIFO_SIZE - std::min(_toPrinter.size(), TX_FIFO_SIZE);
+}
+
+void PrinterSimulator::flush()
+{
+    update();
+    while (!_toPrinter.empty()) {
+        uint64_t t = now();
+        uint64_t due = _toPrinter.back().time;
+        if (due > t) {
+            delayMicroseconds((due - t + 999) / 1000);
+        }
+        update();
+    }
+}
+
+// Runs the events due until the given time in their order: a byte reaches
+// the printer, the running command ends, an unsolicited line is due.
+void PrinterSimulator::advance(uint64_t until)
+{
+    for (;;) {
+        uint64_t byteTime = _toPrinter.empty() ? NEVER : _toPrinter.front().time;
+        uint64_t runTime = _running ? _runEnd : NEVER;
+        uint64_t periodicTime = nextPeriodic();
+        uint64_t t = std::min(byteTime, std::min(runTime, periodicTime));
+        if (t > until) {
+            break;
+        }
+        _clock = std::max(_clock, t);
+        if (t == byteTime) {
+            receiveByte(_toPrinter.front());
+            _toPrinter.pop_front();
+            readLines(t);
+        } else if (t == runTime) {
+            Command command = _queue.front();
+            _queue.pop_front();
+            _running = false;
+            _nextBusy = NEVER;
+            _nextTemperature = NEVER;
+            _lastActivity = t;
+            execute(command, t);
+            readLines(t);
+        } else {
+            periodic(t);
+        }
+        startNext(t);
+    }
+    _clock = std::max(_clock, until);
+    deliverToBoard(_clock);
+}
+
+void PrinterSimulator::receiveByte(const WireByte &byte)
+{
+    if (byte.lost) {
+        return;
+    }
+    if (_rx.size() >= _options.rxBufferSize) {
+        _stats.rxOverruns++;
+        return;
+    }
+    _rx.push_back(byte.value);
+    _stats.bytesReceived++;
+}
+
+// Like the firmwares, a line only leaves the receive buffer when the
+// command queue has room for it.
+void PrinterSimulator::readLines(uint64_t t)
+{
+    while (_queue.size() < _options.queueSize) {
+        auto end = std::find_if(_rx.begin(), _rx.end(), [](uint8_t c) {
+            return c == '\n' || c == '\r';
+        });
+        if (end == _rx.end()) {
+            return;
+        }
+        std::string line(_rx.begin(), end);
+        _rx.erase(_rx.begin(), end + 1);
+        acceptLine(line, t);
+    }
+}
+
+bool PrinterSimulator::acceptLine(std::string line, uint64_t t)
+{
+    size_t comment = line.find(';');
+    if (comment != std::string::npos) {
+        line.erase(comment);
+    }
+    line = trim(line);
+    if (line.empty()) {
+        return false;
+    }
+    _stats.lines++;
+    _lastActivity = t;
+    Command command;
+    command.line = -1;
+    size_t star = line.find('*');
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < star && i < line.size(); i++) {
+        checksum ^= (uint8_t)line[i];
+    }
+    bool checksumOk = (star != std::string::npos) &&
+                      (strtoul(line.c_str() + star + 1, NULL, 10) == checksum);
+    if (toupper((unsigned char)line[0]) == 'N') {
+        char *end;
+        long n = strtol(line.c_str() + 1, &end, 10);
+        std::string text = trim(std::string((const char *)end, line.c_str() + (star == std::string::npos ? line.size() : star)));
+        bool numberOk = (n == _lastLine + 1) || is(text, 'M', 110);
+        if (isRepetier() && (_resendLine >= 0) && (n != _resendLine)) {
+            // still waiting for the line it asked again
+            send(format("skip %ld", n), t);
+            return false;
+        }
+        if (!checksumOk && (!isMarlin() || numberOk)) {
+            _stats.checksumErrors++;
+            if (star == std::string::npos) {
+                requestResend(isRepetier() ? "Missing checksum" : "No Checksum with line number", t);
+            } else {
+                requestResend(isRepetier() ? "Wrong checksum" : "checksum mismatch", t);
+            }
+            return false;
+        }
+        if (!numberOk) {
+            _stats.lineNumberErrors++;
+            if (isRepetier()) {
+                requestResend(format("expected line %ld got %ld", _lastLine + 1, n).c_str(), t);
+            } else {
+                requestResend("Line Number is not Last Line Number+1", t);
+            }
+            return false;
+        }
+        _lastLine = n;
+        _resendLine = -1;
+        command.line = n;
+        command.text = text;
+    } else {
+        if ((star != std::string::npos) && (isMarlin() || !checksumOk)) {
+            _stats.checksumErrors++;
+            requestResend(isMarlin() ? "No Line Number with checksum" : "Wrong checksum", t);
+            return false;
+        }
+        command.text = trim(line.substr(0, star));
+    }
+    _queue.push_back(command);
+    return true;
+}
+
+void PrinterSimulator::requestResend(const char *error, uint64_t t)
+{
+    _stats.resends++;
+    long line = _lastLine + 1;
+    if (_firmware == Firmware_Smoothieware) {
+        send(format("rs N%ld", line), t);
+        return;
+    }
+    if (isMarlin()) {
+        send(format("Error:%s, Last Line: %ld", error, _lastLine), t);
+        send(format("Resend: %ld", line), t);
+        // FlushSerialRequestResend() also drops what is already received
+        _rx.clear();
+    } else {
+        send(format("Error:%s", error), t);
+        send(format("Resend:%ld", line), t);
+        _resendLine = line;
+    }
+    Command none;
+    none.line = -1;
+    sendOk(none, t);
+}
+
+void PrinterSimulator::startNext(uint64_t t)
+{
+    if (_running || _queue.empty()) {
+        return;
+    }
+    _running = true;
+    uint64_t time = duration(_queue.front(), t);
+    _runEnd = t + time;
+    if (isMarlin() && _options.busyInterval && (time >= _options.busyInterval * 1000000ULL)) {
+        _nextBusy = t + _options.busyInterval * 1000000ULL;
+    }
+}
+
+// How long the command keeps the printer from running the next one, also
+// sets what it waits for.
+uint64_t PrinterSimulator::duration(const Command &command, uint64_t t)
+{
+    const std::string &text = command.text;
+    if (_saving && !is(text, 'M', 29)) {
+        uint64_t time = _options.sdLineTime;
+        if ((_savingBytes % SD_BLOCK_SIZE) + text.size() + 1 >= SD_BLOCK_SIZE) {
+            time += _options.sdBlockTime;
+        }
+        return time * 1000;
+    }
+    char letter;
+    int number;
+    if (!commandCode(text, letter, number)) {
+        return _options.commandTime * 1000ULL;
+    }
+    float value;
+    if (letter == 'G') {
+        switch (number) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            return _options.moveTime * 1000ULL;
+        case 4:
+            if (parameter(text, 'P', value)) {
+                return (uint64_t)(value * 1000000);
+            }
+            if (parameter(text, 'S', value)) {
+                return (uint64_t)(value * 1000000000);
+            }
+            break;
+        case 28:
+            return _options.homeTime * 1000ULL;
+        }
+    } else if ((letter == 'M') && ((number == 109) || (number == 190))) {
+        int heater = (number == 109) ? 0 : 1;
+        if (parameter(text, 'S', value) || parameter(text, 'R', value)) {
+            setTarget(heater, value, t);
+        }
+        float goal = std::max(_heaters[heater].target, AMBIENT_TEMPERATURE);
+        float delta = fabsf(goal - temperature(heater, t));
+        if (_options.temperatureInterval) {
+            _nextTemperature = t + _options.temperatureInterval * 1000000ULL;
+        }
+        return _options.commandTime * 1000ULL + (uint64_t)(delta / _options.heatingRate * 1e9);
+    }
+    return _options.commandTime * 1000ULL;
+}
+
+void PrinterSimulator::execute(const Command &command, uint64_t t)
+{
+    const std::string &text = command.text;
+    _stats.commands++;
+    if (_saving) {
+        if (is(text, 'M', 29)) {
+            _saving = false;
+            send("Done saving file.", t);
+            sendOk(command, t);
+            return;
+        }
+        _files[_savingName] += text + "\n";
+        _savingBytes += text.size() + 1;
+        sendOk(command, t);
+        return;
+    }
+    char letter;
+    int number;
+    bool known = commandCode(text, letter, number);
+    float value;
+    std::string name = argument(text);
+    if ((_firmware == Firmware_Smoothieware) && (name.compare(0, 4, "/sd/") == 0)) {
+        name.erase(0, 4);
+    }
+    if (known && (letter == 'G')) {
+        switch (number) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+        case 92: {
+            static const char axes[] = "XYZE";
+            for (int i = 0; i < 4; i++) {
+                if (parameter(text, axes[i], value)) {
+                    _position[i] = (_relative && (number != 92)) ? _position[i] + value : value;
+                }
+            }
+            break;
+        }
+        case 28:
+            _position[0] = _position[1] = _position[2] = 0;
+            break;
+        case 90:
+            _relative = false;
+            break;
+        case 91:
+            _relative = true;
+            break;
+        case 4:
+        case 21:
+        case 29:
+            break;
+        default:
+            known = false;
+            break;
+        }
+    } else if (known && (letter == 'M')) {
+        switch (number) {
+        case 20:
+            send("Begin file list", t);
+            for (const auto &file : _files) {
+                send(format("%s %lu", file.first.c_str(), (unsigned long)file.second.size()), t);
+            }
+            send("End file list", t);
+            break;
+        case 21:
+            send(_options.sdCard ? "echo:SD card ok" : "echo:SD init fail", t);
+            break;
+        case 23:
+            if (_options.sdCard && _files.count(name)) {
+                _selected = name;
+                _sdPrintOffset = 0;
+                send(format("File opened: %s Size: %lu", name.c_str(), (unsigned long)_files[name].size()), t);
+                send("File selected", t);
+            } else {
+                send(format("open failed, File: %s.", name.c_str()), t);
+            }
+            break;
+        case 24:
+            if (!_selected.empty() && !_sdPrinting) {
+                _sdPrinting = true;
+                _sdPrintStart = t;
+            }
+            break;
+        case 25:
+            if (_sdPrinting) {
+                _sdPrintOffset += (t - _sdPrintStart) * _options.sdPrintRate / 1000000000ULL;
+                _sdPrinting = false;
+            }
+            break;
+        case 27:
+            if (_sdPrinting) {
+                uint64_t size = _files[_selected].size();
+                uint64_t offset = _sdPrintOffset + (t - _sdPrintStart) * _options.sdPrintRate / 1000000000ULL;
+                send(format("SD printing byte %lu/%lu", (unsigned long)std::min(offset, size), (unsigned long)size), t);
+            } else {
+                send("Not SD printing", t);
+            }
+            break;
+        case 28:
+            if (!_options.sdCard || name.empty()) {
+                send(format("open failed, File: %s.", name.c_str()), t);
+                break;
+            }
+            _saving = true;
+            _savingName = name;
+            _savingBytes = 0;
+            _files[name].clear();
+            send(format("Writing to file: %s", argument(text).c_str()), t);
+            break;
+        case 30:
+            if (_files.erase(name)) {
+                send(format("File deleted:%s", name.c_str()), t);
+            } else {
+                send(format("Deletion failed, File: %s.", name.c_str()), t);
+            }
+            break;
+        case 104:
+        case 140:
+            if (parameter(text, 'S', value)) {
+                setTarget(number == 104 ? 0 : 1, value, t);
+            }
+            break;
+        case 105:
+            if (isRepetier()) {
+                send(temperatures(t), t);
+                break;
+            }
+            // the temperatures follow the ok on the same line
+            send("ok " + temperatures(t), t);
+            return;
+        case 110:
+            if (parameter(text, 'N', value)) {
+                _lastLine = (long)value;
+            }
+            break;
+        case 114:
+            if (_firmware == Firmware_Smoothieware) {
+                send(format("ok C: X:%.4f Y:%.4f Z:%.4f E:%.4f", _position[0], _position[1], _position[2], _position[3]), t);
+                return;
+            }
+            send(format("X:%.2f Y:%.2f Z:%.2f E:%.2f Count X:0 Y:0 Z:0", _position[0], _position[1], _position[2], _position[3]), t);
+            break;
+        case 115:
+            switch (_firmware) {
+            case Firmware_Marlin:
+                send("FIRMWARE_NAME:Marlin 1.1.9 (Github) SOURCE_CODE_URL:https://github.com/MarlinFirmware/Marlin PROTOCOL_VERSION:1.0 MACHINE_TYPE:3D Printer EXTRUDER_COUNT:1", t);
+                send("Cap:AUTOREPORT_TEMP:1", t);
+                break;
+            case Firmware_MarlinKimbra:
+                send("FIRMWARE_NAME:MK 4.3 (Github) SOURCE_CODE_URL:https://github.com/MagoKimbra/MarlinKimbra PROTOCOL_VERSION:1.0 MACHINE_TYPE:Prusa I3 EXTRUDER_COUNT:1", t);
+                break;
+            case Firmware_Repetier:
+            case Firmware_Repetier4DV:
+                send("FIRMWARE_NAME:Repetier_1.0.3 FIRMWARE_URL:https://github.com/repetier/Repetier-Firmware/ PROTOCOL_VERSION:1.0 MACHINE_TYPE:Mendel EXTRUDER_COUNT:1 REPETIER_PROTOCOL:3", t);
+                break;
+            case Firmware_Smoothieware:
+                send("FIRMWARE_NAME:Smoothieware, FIRMWARE_URL:http%3A//smoothieware.org, X-SOURCE_CODE_URL:https://github.com/Smoothieware/Smoothieware, FIRMWARE_VERSION:edge-3332442, X-FIRMWARE_BUILD_DATE:Jun  1 2018 00:00:00, X-SYSTEM_CLOCK:100MHz, X-AXES:5", t);
+                break;
+            }
+            break;
+        case 155:
+            if (!isMarlin()) {
+                known = false;
+                break;
+            }
+            if (parameter(text, 'S', value)) {
+                _autoReportInterval = (uint32_t)(value * 1000);
+                _nextAutoReport = _autoReportInterval ? t + _autoReportInterval * 1000000ULL : NEVER;
+            }
+            break;
+        case 17:
+        case 18:
+        case 22:
+        case 29:
+        case 82:
+        case 83:
+        case 84:
+        case 106:
+        case 107:
+        case 109:
+        case 112:
+        case 117:
+        case 190:
+        case 220:
+        case 221:
+        case 400:
+        case 500:
+        case 501:
+        case 503:
+            break;
+        default:
+            known = false;
+            break;
+        }
+    } else if (known && (letter == 'T')) {
+        // one extruder, nothing to select
+    } else {
+        known = false;
+    }
+    if (!known) {
+        if (isMarlin()) {
+            send(format("echo:Unknown command: \"%s\"", text.c_str()), t);
+        } else if (isRepetier()) {
+            send(format("Unknown command:%s", text.c_str()), t);
+        }
+    }
+    sendOk(command, t);
+}
+
+uint64_t PrinterSimulator::nextPeriodic() const
+{
+    uint64_t next = std::min(_nextAutoReport, std::min(_nextBusy, _nextTemperature));
+    if (isRepetier() && _options.waitInterval && !_running && _queue.empty()) {
+        next = std::min<uint64_t>(next, _lastActivity + _options.waitInterval * 1000000ULL);
+    }
+    if (_sdPrinting) {
+        next = std::min(next, sdPrintEnd());
+    }
+    return next;
+}
+
+void PrinterSimulator::periodic(uint64_t t)
+{
+    if (_nextBusy <= t) {
+        send("echo:busy: processing", t);
+        _nextBusy = t + _options.busyInterval * 1000000ULL;
+    }
+    if (_nextTemperature <= t) {
+        send(isMarlin() ? " " + temperatures(t) + " W:?" : temperatures(t), t);
+        _nextTemperature = t + _options.temperatureInterval * 1000000ULL;
+    }
+    if (_nextAutoReport <= t) {
+        send(" " + temperatures(t), t);
+        _nextAutoReport = t + _autoReportInterval * 1000000ULL;
+    }
+    if (isRepetier() && _options.waitInterval && !_running && _queue.empty() &&
+            (_lastActivity + _options.waitInterval * 1000000ULL <= t)) {
+        send("wait", t);
+        _lastActivity = t;
+    }
+    if (_sdPrinting && (sdPrintEnd() <= t)) {
+        _sdPrinting = false;
+        _sdPrintOffset = 0;
+        send("Done printing file", t);
+    }
+}
+
+// Schedules the bytes of a line on the wire to the board, after the ones
+// still travelling.
+void PrinterSimulator::send(const std::string &line, uint64_t t)
+{
+    std::string data = line + (_firmware == Firmware_Smoothieware ? "\r\n" : "\n");
+    uint64_t time = std::max(t, _toBoardEnd);
+    for (char c : data) {
+        WireByte byte;
+        byte.value = c;
+        byte.lost = false;
+        if (chance(_options.noiseRate)) {
+            byte.value ^= 1 << (_random % 8);
+            _stats.noise++;
+        }
+        time += _byteTime;
+        byte.time = time;
+        _toBoard.push_back(byte);
+    }
+    _toBoardEnd = time;
+    _stats.bytesSent += data.size();
+}
+
+void PrinterSimulator::sendOk(const Command &command, uint64_t t)
+{
+    if (chance(_options.lostOkRate)) {
+        _stats.lostOks++;
+        return;
+    }
+    if (isMarlin() && _options.advancedOk) {
+        send(format("ok N%ld P%d B%d", _lastLine, PLANNER_FREE, (int)(_options.queueSize - _queue.size())), t);
+    } else if (isRepetier() && (command.line >= 0)) {
+        send(format("ok %ld", command.line), t);
+    } else {
+        send("ok", t);
+    }
+}
+
+std::string PrinterSimulator::temperatures(uint64_t t) const
+{
+    float hotend = temperature(0, t);
+    float bed = temperature(1, t);
+    if (isRepetier()) {
+        return format("T:%.2f /%.0f B:%.2f /%.0f B@:0 @:0", hotend, _heaters[0].target, bed, _heaters[1].target);
+    }
+    if (_firmware == Firmware_Smoothieware) {
+        return format("T:%.1f /%.1f @0 B:%.1f /%.1f @0", hotend, _heaters[0].target, bed, _heaters[1].target);
+    }
+    return format("T:%.2f /%.2f B:%.2f /%.2f @:0 B@:0", hotend, _heaters[0].target, bed, _heaters[1].target);
+}
+
+float PrinterSimulator::temperature(int heater, uint64_t t) const
+{
+    const Heater &h = _heaters[heater];
+    float goal = std::max(h.target, AMBIENT_TEMPERATURE);
+    float change = _options.heatingRate * (float)((t - std::min(t, h.since)) / 1e9);
+    if (goal > h.from) {
+        return std::min(goal, h.from + change);
+    }
+    return std::max(goal, h.from - change);
+}
+
+void PrinterSimulator::setTarget(int heater, float target, uint64_t t)
+{
+    _heaters[heater].from = temperature(heater, t);
+    _heaters[heater].target = target;
+    _heaters[heater].since = t;
+}
+
+uint64_t PrinterSimulator::sdPrintEnd() const
+{
+    auto file = _files.find(_selected);
+    uint64_t size = (file == _files.end()) ? 0 : file->second.size();
+    uint64_t left = (size > _sdPrintOffset) ? size - _sdPrintOffset : 0;
+    return _sdPrintStart + left * 1000000000ULL / std::max<uint32_t>(_options.sdPrintRate, 1);
+}
+
+void PrinterSimulator::deliverToBoard(uint64_t t)
+{
+    while (!_toBoard.empty() && (_toBoard.front().time <= t)) {
+        if (_boardRx.size() < _boardRxSize) {
+            _boardRx.push_back(_toBoard.front().value);
+        } else {
+            _stats.boardOverruns++;
+        }
+        _toBoard.pop_front();
+    }
+}
@@ -0,0 +1,235 @@
+/*
+  host/PrinterSimulator.h - 3D printer on the other end of the printer
+  serial port of the host build, speaking the dialect of one of the
+  firmware targets of esp3d/config.h.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <string>
+
+#include "HardwareSerial.h"
+
+
+// PrinterSimulator
+// Answers G-code like the firmware it emulates: "ok" (Repetier "ok <n>",
+// Marlin "ok N<n> P<n> B<n>" with advanced ok), "wait" when Repetier is
+// idle, "echo:busy: processing" while Marlin runs a long command, line
+// number and checksum checks answered by "Resend", temperature reports
+// (M105, M155 auto-report, while M109/M190 wait) and an SD card where the
+// lines between M28 and M29 are saved.
+//
+// Time is the real one: bytes take 10 bit times at the baud rate given to
+// begin() on the wire in both directions, the printer only reads a line
+// when its command queue has room and what overflows its receive buffer
+// or the one of the board is lost. Nothing runs on its own, every call of
+// the board does the work due since the previous one. Errors are injected
+// on the wire with a seeded generator so a run can be replayed.
+class PrinterSimulator : public SerialDevice
+{
+public:
+    // same values as the firmware targets of esp3d/config.h
+    enum Firmware
+    {
+        Firmware_Repetier4DV = 1,
+        Firmware_Marlin = 2,
+        Firmware_MarlinKimbra = 3,
+        Firmware_Smoothieware = 4,
+        Firmware_Repetier = 5
+    };
+
+    struct Options
+    {
+        // receive buffer and command queue of the printer
+        size_t rxBufferSize = 128;
+        size_t queueSize = 4;
+        // time to run a command, in microseconds
+        uint32_t commandTime = 100;
+        uint32_t moveTime = 2000;
+        uint32_t homeTime = 200000;
+        // a line saved to the SD card, plus each time 512 bytes are flushed
+        uint32_t sdLineTime = 200;
+        uint32_t sdBlockTime = 3000;
+        // SD printing reads the file at this many bytes per second
+        uint32_t sdPrintRate = 2000;
+        // degrees per second when heating or cooling
+        float heatingRate = 10;
+        // Marlin "ok N<n> P<n> B<n>"
+        bool advancedOk = false;
+        bool sdCard = true;
+        // intervals of the unsolicited lines, in milliseconds, 0 for none
+        uint32_t autoReportInterval = 0;
+        uint32_t busyInterval = 2000;
+        uint32_t waitInterval = 1000;
+        uint32_t temperatureInterval = 1000;
+        // probabilities, per byte from the board: one bit flipped, byte lost
+        double corruptRate = 0;
+        double dropRate = 0;
+        // per byte to the board: one bit flipped
+        double noiseRate = 0;
+        // per "ok": never sent
+        double lostOkRate = 0;
+        uint32_t seed = 1;
+    };
+
+    struct Stats
+    {
+        uint32_t bytesReceived = 0;
+        uint32_t bytesSent = 0;
+        uint32_t lines = 0;
+        uint32_t commands = 0;
+        uint32_t resends = 0;
+        uint32_t checksumErrors = 0;
+        uint32_t lineNumberErrors = 0;
+        // lost in the receive buffer of the printer, of the board
+        uint32_t rxOverruns = 0;
+        uint32_t boardOverruns = 0;
+        // injected
+        uint32_t corrupted = 0;
+        uint32_t dropped = 0;
+        uint32_t noise = 0;
+        uint32_t lostOks = 0;
+    };
+
+    explicit PrinterSimulator(Firmware firmware);
+    PrinterSimulator(Firmware firmware, const Options &options);
+
+    // "marlin", "marlinkimbra", "repetier", "repetier4dv" or "smoothieware"
+    static bool firmwareFromName(const char *name, Firmware &firmware);
+
+    Firmware firmware() const
+    {
+        return _firmware;
+    }
+    const Options &options() const
+    {
+        return _options;
+    }
+    const Stats &stats() const
+    {
+        return _stats;
+    }
+
+    // files of the SD card by name, without the "/sd/" of Smoothieware;
+    // saved lines have no line number nor checksum anymore
+    const std::map<std::string, std::string> &files() const
+    {
+        return _files;
+    }
+    void setFile(const std::string &name, const std::string &content);
+    bool isSaving() const
+    {
+        return _saving;
+    }
+
+    float temperature(int heater) const;
+    // let the printer catch up with the time
+    void update();
+
+    void begin(unsigned long baud) override;
+    void setRxBufferSize(size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int availableForWrite() override;
+    void flush() override;
+
+private:
+    // the UART fifo of the board, write() blocks when it is full
+    static const size_t TX_FIFO_SIZE = 128;
+    static const uint64_t NEVER = UINT64_MAX;
+
+    struct WireByte
+    {
+        uint64_t time;
+        uint8_t value;
+        bool lost;
+    };
+
+    struct Command
+    {
+        std::string text;
+        long line;
+    };
+
+    struct Heater
+    {
+        float from;
+        float target;
+        uint64_t since;
+    };
+
+    Firmware _firmware;
+    Options _options;
+    Stats _stats;
+    uint32_t _random;
+
+    // nanoseconds per byte on the wire, 0 when the baud rate is not set
+    uint64_t _byteTime = 0;
+    uint64_t _clock = 0;
+    std::deque<WireByte> _toPrinter;
+    uint64_t _toPrinterEnd = 0;
+    std::deque<WireByte> _toBoard;
+    uint64_t _toBoardEnd = 0;
+    std::deque<uint8_t> _boardRx;
+    size_t _boardRxSize = 256;
+
+    std::deque<uint8_t> _rx;
+    std::deque<Command> _queue;
+    long _lastLine = 0;
+    long _resendLine = -1;
+    bool _running = false;
+    uint64_t _runEnd = 0;
+
+    Heater _heaters[2];
+    float _position[4];
+    bool _relative = false;
+
+    std::map<std::string, std::string> _files;
+    bool _saving = false;
+    std::string _savingName;
+    size_t _savingBytes = 0;
+    std::string _selected;
+    bool _sdPrinting = false;
+    uint64_t _sdPrintStart = 0;
+    uint64_t _sdPrintOffset = 0;
+
+    uint32_t _autoReportInterval;
+    uint64_t _nextAutoReport = NEVER;
+    // last line received or command run, Repetier says "wait" after it
+    uint64_t _lastActivity = 0;
+    uint64_t _nextBusy = NEVER;
+    uint64_t _nextTemperature = NEVER;
+
+    static uint64_t now();
+    bool chance(double rate);
+    bool isMarlin() const;
+    bool isRepetier() const;
+
+    void advance(uint64_t until);
+    void receiveByte(const WireByte &byte);
+    void readLines(uint64_t t);
+    bool acceptLine(std::string line, uint64_t t);
+    void requestResend(const char *error, uint64_t t);
+    void startNext(uint64_t t);
+    uint64_t duration(const Command &command, uint64_t t);
+    void execute(const Command &command, uint64_t t);
+    uint64_t nextPeriodic() const;
+    void periodic(uint64_t t);
+    void send(const std::string &line, uint64_t t);
+    void sendOk(const Command &command, uint64_t t);
+    std::string temperatures(uint64_t t) const;
+    float temperature(int heater, uint64_t t) const;
+    void setTarget(int heater, float target, uint64_t t);
+    uint64_t sdPrintEnd() const;
+    void deliverToBoard(uint64_t t);
+};
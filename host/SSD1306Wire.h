@@ -0,0 +1,71 @@
+/*
+  host/SSD1306Wire.h - SSD1306 OLED driver for the host build, the display
+  is not drawn anywhere.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+
+// SSD1306Wire
+class SSD1306Wire
+{
+public:
+    SSD1306Wire(uint8_t address, uint8_t sda, uint8_t scl)
+    {
+        (void)address;
+        (void)sda;
+        (void)scl;
+    }
+
+    bool init()
+    {
+        return true;
+    }
+    void resetDisplay() {}
+    void displayOn() {}
+    void displayOff() {}
+    void flipScreenVertically() {}
+    void setContrast(uint8_t contrast, uint8_t precharge = 241, uint8_t comdetect = 64)
+    {
+        (void)contrast;
+        (void)precharge;
+        (void)comdetect;
+    }
+    void clear() {}
+    void display() {}
+    void drawString(int16_t x, int16_t y, const String &text)
+    {
+        (void)x;
+        (void)y;
+        (void)text;
+    }
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+    {
+        (void)x0;
+        (void)y0;
+        (void)x1;
+        (void)y1;
+    }
+    void fillRect(int16_t x, int16_t y, int16_t width, int16_t height)
+    {
+        (void)x;
+        (void)y;
+        (void)width;
+        (void)height;
+    }
+    void drawXbm(int16_t x, int16_t y, int16_t width, int16_t height, const uint8_t *xbm)
+    {
+        (void)x;
+        (void)y;
+        (void)width;
+        (void)height;
+        (void)xbm;
+    }
+};
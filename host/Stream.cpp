@@ -0,0 +1,70 @@
+/*
+  host/Stream.cpp - Arduino Stream for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "Arduino.h"
+
+
+int Stream::timedRead()
+{
+    unsigned long start = millis();
+    do {
+        int c = read();
+        if (c >= 0) {
+            return c;
+        }
+        yield();
+    } while (millis() - start < _timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+    size_t n = 0;
+    while (n < length) {
+        int c = timedRead();
+        if (c < 0) {
+            break;
+        }
+        buffer[n++] = (char)c;
+    }
+    return n;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length)
+{
+    size_t n = 0;
+    while (n < length) {
+        int c = timedRead();
+        if (c < 0 || c == terminator) {
+            break;
+        }
+        buffer[n++] = (char)c;
+    }
+    return n;
+}
+
+String Stream::readString()
+{
+    String out;
+    int c;
+    while ((c = timedRead()) >= 0) {
+        out += (char)c;
+    }
+    return out;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+    String out;
+    int c;
+    while ((c = timedRead()) >= 0 && c != terminator) {
+        out += (char)c;
+    }
+    return out;
+}
@@ -0,0 +1,47 @@
+/*
+  host/Stream.h - Arduino Stream for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include "Print.h"
+
+
+// Stream
+// Print that can also be read. The blocking helpers wait at most
+// setTimeout() milliseconds for each byte, like the Arduino core.
+class Stream : public Print
+{
+protected:
+    unsigned long _timeout = 1000;
+
+    int timedRead();
+
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout)
+    {
+        _timeout = timeout;
+    }
+    unsigned long getTimeout() const
+    {
+        return _timeout;
+    }
+
+    virtual size_t readBytes(char *buffer, size_t length);
+    size_t readBytes(uint8_t *buffer, size_t length)
+    {
+        return readBytes((char *)buffer, length);
+    }
+    size_t readBytesUntil(char terminator, char *buffer, size_t length);
+    String readString();
+    String readStringUntil(char terminator);
+};
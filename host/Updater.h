@@ -0,0 +1,55 @@
+/*
+  host/Updater.h - firmware updater for the host build, it accepts an
+  image up to the announced size and drops it.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// UpdaterClass
+class UpdaterClass
+{
+private:
+    size_t _size = 0;
+    size_t _progress = 0;
+    bool _running = false;
+
+public:
+    bool begin(size_t size)
+    {
+        _size = size;
+        _progress = 0;
+        _running = size > 0;
+        return _running;
+    }
+    size_t write(uint8_t *data, size_t len)
+    {
+        (void)data;
+        if (!_running || _progress + len > _size) {
+            _running = false;
+            return 0;
+        }
+        _progress += len;
+        return len;
+    }
+    bool end(bool evenIfRemaining = false)
+    {
+        bool done = _running && (evenIfRemaining || _progress == _size);
+        _running = false;
+        return done;
+    }
+    size_t progress() const
+    {
+        return _progress;
+    }
+};
+
+extern UpdaterClass Update;
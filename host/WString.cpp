@@ -0,0 +1,455 @@
+/*
+  host/WString.cpp - Arduino String for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "WString.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+
+static std::string integer(unsigned long long value, bool negative, unsigned char base)
+{
+    char buf[68];
+    char *p = buf + sizeof(buf) - 1;
+    *p = 0;
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+    do {
+        unsigned digit = value % base;
+        *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value);
+    if (negative) {
+        *--p = '-';
+    }
+    return p;
+}
+
+static std::string signedInteger(long long value, unsigned char base)
+{
+    // like the ESP8266 core, only base 10 shows a sign
+    if (base == 10 && value < 0) {
+        return integer(0ULL - (unsigned long long)value, true, base);
+    }
+    return integer((unsigned long long)value, false, base);
+}
+
+static std::string decimal(double value, unsigned char decimals)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+    return buf;
+}
+
+String::String(unsigned char value, unsigned char base) : _s(integer(value, false, base)) {}
+String::String(int value, unsigned char base) : _s(signedInteger(value, base)) {}
+String::String(unsigned int value, unsigned char base) : _s(integer(value, false, base)) {}
+String::String(long value, unsigned char base) : _s(signedInteger(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _s(integer(value, false, base)) {}
+String::String(long long value, unsigned char base) : _s(signedInteger(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : _s(integer(value, false, base)) {}
+String::String(float value, unsigned char decimals) : _s(decimal(value, decimals)) {}
+String::String(double value, unsigned char decimals) : _s(decimal(value, decimals)) {}
+
+unsigned char String::concat(const String &str)
+{
+    _s += str._s;
+    return 1;
+}
+
+unsigned char String::concat(const char *cstr)
+{
+    if (!cstr) {
+        return 0;
+    }
+    _s += cstr;
+    return 1;
+}
+
+unsigned char String::concat(const char *cstr, unsigned int length)
+{
+    if (!cstr) {
+        return 0;
+    }
+    _s.append(cstr, length);
+    return 1;
+}
+
+unsigned char String::concat(const __FlashStringHelper *str)
+{
+    return concat(reinterpret_cast<const char *>(str));
+}
+
+unsigned char String::concat(char c)
+{
+    _s += c;
+    return 1;
+}
+
+unsigned char String::concat(unsigned char value)
+{
+    return concat(String(value));
+}
+
+unsigned char String::concat(int value)
+{
+    return concat(String(value));
+}
+
+unsigned char String::concat(unsigned int value)
+{
+    return concat(String(value));
+}
+
+unsigned char String::concat(long value)
+{
+    return concat(String(value));
+}
+
+unsigned char String::concat(unsigned long value)
+{
+    return concat(String(value));
+}
+
+unsigned char String::concat(long long value)
+{
+    return concat(String(value));
+}
+
+unsigned char String::concat(unsigned long long value)
+{
+    return concat(String(value));
+}
+
+unsigned char String::concat(float value)
+{
+    return concat(String(value));
+}
+
+unsigned char String::concat(double value)
+{
+    return concat(String(value));
+}
+
+int String::compareTo(const String &s) const
+{
+    return strcmp(c_str(), s.c_str());
+}
+
+bool String::equalsIgnoreCase(const String &s) const
+{
+    return length() == s.length() && strcasecmp(c_str(), s.c_str()) == 0;
+}
+
+bool String::startsWith(const String &prefix) const
+{
+    return startsWith(prefix, 0);
+}
+
+bool String::startsWith(const String &prefix, unsigned int offset) const
+{
+    if (offset > length() || prefix.length() > length() - offset) {
+        return false;
+    }
+    return _s.compare(offset, prefix.length(), prefix._s) == 0;
+}
+
+bool String::endsWith(const String &suffix) const
+{
+    if (suffix.length() > length()) {
+        return false;
+    }
+    return _s.compare(length() - suffix.length(), suffix.length(), suffix._s) == 0;
+}
+
+char String::charAt(unsigned int index) const
+{
+    return operator[](index);
+}
+
+void String::setCharAt(unsigned int index, char c)
+{
+    if (index < length()) {
+        _s[index] = c;
+    }
+}
+
+char String::operator[](unsigned int index) const
+{
+    return index < length() ? _s[index] : 0;
+}
+
+char &String::operator[](unsigned int index)
+{
+    static char dummy;
+    if (index >= length()) {
+        dummy = 0;
+        return dummy;
+    }
+    return _s[index];
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index) const
+{
+    if (!bufsize || !buf) {
+        return;
+    }
+    if (index >= length()) {
+        buf[0] = 0;
+        return;
+    }
+    unsigned int n = bufsize - 1;
+    if (n > length() - index) {
+        n = length() - index;
+    }
+    memcpy(buf, c_str() + index, n);
+    buf[n] = 0;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const
+{
+    size_t pos = _s.find(ch, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const
+{
+    if (fromIndex >= length()) {
+        return -1;
+    }
+    size_t pos = _s.find(str._s, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char ch) const
+{
+    return lastIndexOf(ch, length() - 1);
+}
+
+int String::lastIndexOf(char ch, unsigned int fromIndex) const
+{
+    if (fromIndex >= length()) {
+        return -1;
+    }
+    size_t pos = _s.rfind(ch, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(const String &str) const
+{
+    return lastIndexOf(str, length() - str.length());
+}
+
+int String::lastIndexOf(const String &str, unsigned int fromIndex) const
+{
+    if (str.length() == 0 || str.length() > length() || fromIndex >= length()) {
+        return -1;
+    }
+    size_t pos = _s.rfind(str._s, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const
+{
+    if (beginIndex > endIndex) {
+        unsigned int temp = endIndex;
+        endIndex = beginIndex;
+        beginIndex = temp;
+    }
+    String out;
+    if (beginIndex >= length()) {
+        return out;
+    }
+    if (endIndex > length()) {
+        endIndex = length();
+    }
+    out._s = _s.substr(beginIndex, endIndex - beginIndex);
+    return out;
+}
+
+void String::replace(char find, char replace)
+{
+    for (char &c : _s) {
+        if (c == find) {
+            c = replace;
+        }
+    }
+}
+
+void String::replace(const String &find, const String &replace)
+{
+    if (find.length() == 0) {
+        return;
+    }
+    size_t pos = 0;
+    while ((pos = _s.find(find._s, pos)) != std::string::npos) {
+        _s.replace(pos, find.length(), replace._s);
+        pos += replace.length();
+    }
+}
+
+void String::remove(unsigned int index)
+{
+    remove(index, (unsigned int)-1);
+}
+
+void String::remove(unsigned int index, unsigned int count)
+{
+    if (index >= length()) {
+        return;
+    }
+    if (count > length() - index) {
+        count = length() - index;
+    }
+    _s.erase(index, count);
+}
+
+void String::toLowerCase()
+{
+    for (char &c : _s) {
+        c = tolower((unsigned char)c);
+    }
+}
+
+void String::toUpperCase()
+{
+    for (char &c : _s) {
+        c = toupper((unsigned char)c);
+    }
+}
+
+void String::trim()
+{
+    size_t first = 0;
+    while (first < _s.size() && isspace((unsigned char)_s[first])) {
+        first++;
+    }
+    size_t last = _s.size();
+    while (last > first && isspace((unsigned char)_s[last - 1])) {
+        last--;
+    }
+    _s = _s.substr(first, last - first);
+}
+
+long String::toInt() const
+{
+    return atol(c_str());
+}
+
+float String::toFloat() const
+{
+    return atof(c_str());
+}
+
+double String::toDouble() const
+{
+    return atof(c_str());
+}
+
+String operator+(const String &lhs, const String &rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, const char *rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, const __FlashStringHelper *rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, char rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, unsigned char rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, int rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, unsigned int rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, long rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, unsigned long rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, long long rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, unsigned long long rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, float rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String &lhs, double rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const char *lhs, const String &rhs)
+{
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
@@ -0,0 +1,227 @@
+/*
+  host/WString.h - Arduino String for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+#include "pgmspace.h"
+
+class __FlashStringHelper;
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper *>(p))
+#define F(s) FPSTR(PSTR(s))
+
+
+// String
+// Same interface and semantics as the ESP8266 core String (indexes out of
+// range give empty results instead of throwing), stored in a std::string.
+class String
+{
+private:
+    std::string _s;
+
+    static const char *flash(const __FlashStringHelper *str)
+    {
+        return str ? reinterpret_cast<const char *>(str) : "";
+    }
+
+public:
+    String() {}
+    String(const char *cstr) : _s(cstr ? cstr : "") {}
+    String(const __FlashStringHelper *str) : _s(flash(str)) {}
+    String(const String &str) = default;
+    String(String &&str) = default;
+    explicit String(char c) : _s(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimals = 2);
+    explicit String(double value, unsigned char decimals = 2);
+
+    String &operator=(const String &rhs) = default;
+    String &operator=(String &&rhs) = default;
+    String &operator=(const char *cstr)
+    {
+        _s = cstr ? cstr : "";
+        return *this;
+    }
+    String &operator=(const __FlashStringHelper *str)
+    {
+        _s = flash(str);
+        return *this;
+    }
+
+    unsigned char reserve(unsigned int size)
+    {
+        _s.reserve(size);
+        return 1;
+    }
+    unsigned int length() const
+    {
+        return _s.size();
+    }
+    bool isEmpty() const
+    {
+        return _s.empty();
+    }
+    const char *c_str() const
+    {
+        return _s.c_str();
+    }
+    char *begin()
+    {
+        return &_s[0];
+    }
+    char *end()
+    {
+        return &_s[0] + _s.size();
+    }
+    const std::string &str() const
+    {
+        return _s;
+    }
+
+    unsigned char concat(const String &str);
+    unsigned char concat(const char *cstr);
+    unsigned char concat(const char *cstr, unsigned int length);
+    unsigned char concat(const __FlashStringHelper *str);
+    unsigned char concat(char c);
+    unsigned char concat(unsigned char value);
+    unsigned char concat(int value);
+    unsigned char concat(unsigned int value);
+    unsigned char concat(long value);
+    unsigned char concat(unsigned long value);
+    unsigned char concat(long long value);
+    unsigned char concat(unsigned long long value);
+    unsigned char concat(float value);
+    unsigned char concat(double value);
+
+    template<typename T>
+    String &operator+=(const T &rhs)
+    {
+        concat(rhs);
+        return *this;
+    }
+    String &operator+=(const char *cstr)
+    {
+        concat(cstr);
+        return *this;
+    }
+
+    int compareTo(const String &s) const;
+    bool equals(const String &s) const
+    {
+        return _s == s._s;
+    }
+    bool equals(const char *cstr) const
+    {
+        return _s == (cstr ? cstr : "");
+    }
+    bool equalsIgnoreCase(const String &s) const;
+    bool startsWith(const String &prefix) const;
+    bool startsWith(const String &prefix, unsigned int offset) const;
+    bool endsWith(const String &suffix) const;
+
+    bool operator==(const String &rhs) const
+    {
+        return equals(rhs);
+    }
+    bool operator==(const char *cstr) const
+    {
+        return equals(cstr);
+    }
+    bool operator!=(const String &rhs) const
+    {
+        return !equals(rhs);
+    }
+    bool operator!=(const char *cstr) const
+    {
+        return !equals(cstr);
+    }
+    bool operator<(const String &rhs) const
+    {
+        return compareTo(rhs) < 0;
+    }
+    bool operator>(const String &rhs) const
+    {
+        return compareTo(rhs) > 0;
+    }
+    bool operator<=(const String &rhs) const
+    {
+        return compareTo(rhs) <= 0;
+    }
+    bool operator>=(const String &rhs) const
+    {
+        return compareTo(rhs) >= 0;
+    }
+
+    char charAt(unsigned int index) const;
+    void setCharAt(unsigned int index, char c);
+    char operator[](unsigned int index) const;
+    char &operator[](unsigned int index);
+    void getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const;
+    void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const
+    {
+        getBytes((unsigned char *)buf, bufsize, index);
+    }
+
+    int indexOf(char ch, unsigned int fromIndex = 0) const;
+    int indexOf(const String &str, unsigned int fromIndex = 0) const;
+    int lastIndexOf(char ch) const;
+    int lastIndexOf(char ch, unsigned int fromIndex) const;
+    int lastIndexOf(const String &str) const;
+    int lastIndexOf(const String &str, unsigned int fromIndex) const;
+    String substring(unsigned int beginIndex) const
+    {
+        return substring(beginIndex, length());
+    }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void replace(char find, char replace);
+    void replace(const String &find, const String &replace);
+    void remove(unsigned int index);
+    void remove(unsigned int index, unsigned int count);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const String &lhs, const __FlashStringHelper *rhs);
+String operator+(const String &lhs, char rhs);
+String operator+(const String &lhs, unsigned char rhs);
+String operator+(const String &lhs, int rhs);
+String operator+(const String &lhs, unsigned int rhs);
+String operator+(const String &lhs, long rhs);
+String operator+(const String &lhs, unsigned long rhs);
+String operator+(const String &lhs, long long rhs);
+String operator+(const String &lhs, unsigned long long rhs);
+String operator+(const String &lhs, float rhs);
+String operator+(const String &lhs, double rhs);
+String operator+(const char *lhs, const String &rhs);
+
+inline bool operator==(const char *lhs, const String &rhs)
+{
+    return rhs == lhs;
+}
+
+inline bool operator!=(const char *lhs, const String &rhs)
+{
+    return rhs != lhs;
+}
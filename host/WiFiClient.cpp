@@ -0,0 +1,393 @@
+/*
+  host/WiFiClient.cpp - TCP connection and listener for the host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "WiFiClient.h"
+#include "WiFiServer.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/sockios.h>
+#include <set>
+
+
+struct WiFiClient::Connection {
+    int fd;
+
+    explicit Connection(int socket) : fd(socket)
+    {
+        all().insert(this);
+    }
+    ~Connection()
+    {
+        close();
+        all().erase(this);
+    }
+
+    static std::set<Connection *> &all()
+    {
+        //never destroyed, global clients like the ones of the bridge may
+        //outlive any other static
+        static std::set<Connection *> *connections = new std::set<Connection *>;
+        return *connections;
+    }
+
+    void close()
+    {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+};
+
+static void setNonBlocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+static bool waitFor(int fd, short events, unsigned long timeout)
+{
+    struct pollfd pfd = {fd, events, 0};
+    return poll(&pfd, 1, timeout) > 0 && (pfd.revents & events);
+}
+
+static IPAddress toIPAddress(const struct sockaddr_in &addr)
+{
+    return IPAddress((uint32_t)addr.sin_addr.s_addr);
+}
+
+
+WiFiClient::WiFiClient(int fd)
+{
+    setNonBlocking(fd);
+    _connection = std::make_shared<Connection>(fd);
+}
+
+int WiFiClient::fd() const
+{
+    return _connection ? _connection->fd : -1;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port)
+{
+    stop();
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0) {
+        return 0;
+    }
+    setNonBlocking(s);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    if (::connect(s, (struct sockaddr *)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        ::close(s);
+        return 0;
+    }
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (!waitFor(s, POLLOUT, _timeout) || getsockopt(s, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error) {
+        ::close(s);
+        return 0;
+    }
+    _connection = std::make_shared<Connection>(s);
+    return 1;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port)
+{
+    struct addrinfo hints = {};
+    struct addrinfo *result = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, nullptr, &hints, &result) != 0 || !result) {
+        return 0;
+    }
+    IPAddress ip = toIPAddress(*(struct sockaddr_in *)result->ai_addr);
+    freeaddrinfo(result);
+    return connect(ip, port);
+}
+
+uint8_t WiFiClient::connected()
+{
+    int s = fd();
+    if (s < 0) {
+        return 0;
+    }
+    char c;
+    ssize_t n = recv(s, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+        return 1;
+    }
+    // peer closed or the connection failed: like lwIP, keep the socket
+    // until stop() but report it gone
+    return 0;
+}
+
+void WiFiClient::stop()
+{
+    if (_connection) {
+        _connection->close();
+        _connection.reset();
+    }
+}
+
+void WiFiClient::stopAll()
+{
+    for (Connection *connection : Connection::all()) {
+        connection->close();
+    }
+}
+
+int WiFiClient::available()
+{
+    int s = fd();
+    int count = 0;
+    if (s < 0 || ioctl(s, FIONREAD, &count) < 0) {
+        return 0;
+    }
+    return count;
+}
+
+int WiFiClient::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size)
+{
+    int s = fd();
+    if (s < 0 || !size) {
+        return 0;
+    }
+    ssize_t n = recv(s, buffer, size, MSG_DONTWAIT);
+    return n > 0 ? (int)n : 0;
+}
+
+int WiFiClient::peek()
+{
+    int s = fd();
+    uint8_t c;
+    if (s < 0 || recv(s, &c, 1, MSG_PEEK | MSG_DONTWAIT) != 1) {
+        return -1;
+    }
+    return c;
+}
+
+size_t WiFiClient::readBytes(char *buffer, size_t length)
+{
+    size_t done = 0;
+    unsigned long start = millis();
+    while (done < length && millis() - start < _timeout) {
+        int n = read((uint8_t *)buffer + done, length - done);
+        if (n > 0) {
+            done += n;
+        } else if (!waitFor(fd(), POLLIN, _timeout - (millis() - start))) {
+            break;
+        }
+    }
+    return done;
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size)
+{
+    int s = fd();
+    size_t done = 0;
+    unsigned long start = millis();
+    while (s >= 0 && done < size) {
+        ssize_t n = send(s, buffer + done, size - done, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            done += n;
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            break;
+        }
+        unsigned long elapsed = millis() - start;
+        if (elapsed >= _timeout || !waitFor(s, POLLOUT, _timeout - elapsed)) {
+            break;
+        }
+    }
+    return done;
+}
+
+size_t WiFiClient::write(Stream &stream)
+{
+    uint8_t buf[1460];
+    size_t done = 0;
+    while (stream.available() > 0) {
+        size_t n = stream.readBytes((char *)buf, sizeof(buf));
+        if (!n) {
+            break;
+        }
+        size_t sent = write(buf, n);
+        done += sent;
+        if (sent != n) {
+            break;
+        }
+    }
+    return done;
+}
+
+size_t WiFiClient::availableForWrite()
+{
+    int s = fd();
+    int size = 0;
+    int queued = 0;
+    socklen_t len = sizeof(size);
+    if (s < 0 || getsockopt(s, SOL_SOCKET, SO_SNDBUF, &size, &len) < 0 ||
+            ioctl(s, SIOCOUTQ, &queued) < 0) {
+        return 0;
+    }
+    // the kernel doubles SO_SNDBUF for its own bookkeeping
+    size /= 2;
+    return queued < size ? size - queued : 0;
+}
+
+void WiFiClient::flush()
+{
+    int s = fd();
+    unsigned long start = millis();
+    int queued = 0;
+    while (s >= 0 && ioctl(s, SIOCOUTQ, &queued) == 0 && queued > 0 && millis() - start < _timeout) {
+        delay(1);
+    }
+}
+
+void WiFiClient::setNoDelay(bool nodelay)
+{
+    int s = fd();
+    int flag = nodelay ? 1 : 0;
+    if (s >= 0) {
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+}
+
+bool WiFiClient::getNoDelay() const
+{
+    int s = fd();
+    int flag = 0;
+    socklen_t len = sizeof(flag);
+    return s >= 0 && getsockopt(s, IPPROTO_TCP, TCP_NODELAY, &flag, &len) == 0 && flag;
+}
+
+IPAddress WiFiClient::remoteIP() const
+{
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (fd() < 0 || getpeername(fd(), (struct sockaddr *)&addr, &len) < 0) {
+        return IPAddress();
+    }
+    return toIPAddress(addr);
+}
+
+uint16_t WiFiClient::remotePort() const
+{
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (fd() < 0 || getpeername(fd(), (struct sockaddr *)&addr, &len) < 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+IPAddress WiFiClient::localIP() const
+{
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (fd() < 0 || getsockname(fd(), (struct sockaddr *)&addr, &len) < 0) {
+        return IPAddress();
+    }
+    return toIPAddress(addr);
+}
+
+uint16_t WiFiClient::localPort() const
+{
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (fd() < 0 || getsockname(fd(), (struct sockaddr *)&addr, &len) < 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+
+void WiFiServer::begin()
+{
+    close();
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0) {
+        return;
+    }
+    int flag = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(_port);
+    addr.sin_addr.s_addr = (uint32_t)_addr;
+    if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(s, 8) < 0) {
+        ::close(s);
+        return;
+    }
+    setNonBlocking(s);
+    _fd = s;
+}
+
+bool WiFiServer::hasClient()
+{
+    if (_pending < 0 && _fd >= 0) {
+        _pending = accept(_fd, nullptr, nullptr);
+    }
+    return _pending >= 0;
+}
+
+WiFiClient WiFiServer::available(uint8_t *status)
+{
+    (void)status;
+    if (!hasClient()) {
+        return WiFiClient();
+    }
+    WiFiClient client(_pending);
+    _pending = -1;
+    if (_noDelay) {
+        client.setNoDelay(true);
+    }
+    return client;
+}
+
+uint16_t WiFiServer::localPort() const
+{
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (_fd < 0 || getsockname(_fd, (struct sockaddr *)&addr, &len) < 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+void WiFiServer::close()
+{
+    if (_pending >= 0) {
+        ::close(_pending);
+        _pending = -1;
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
@@ -0,0 +1,88 @@
+/*
+  host/WiFiClient.h - TCP connection for the host build, backed by a
+  non-blocking Linux socket.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <memory>
+
+#include <Arduino.h>
+
+
+// WiFiClient
+// Copies share the connection like on the ESP8266, stop() on any copy
+// closes it for all of them. write() blocks until the data is queued or
+// the stream timeout elapsed.
+class WiFiClient : public Stream
+{
+private:
+    struct Connection;
+    std::shared_ptr<Connection> _connection;
+
+    int fd() const;
+
+public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd);
+
+    using Print::write;
+    using Stream::readBytes;
+
+    int connect(IPAddress ip, uint16_t port);
+    int connect(const char *host, uint16_t port);
+    uint8_t connected();
+    void stop();
+    // closes every connection, before a firmware update
+    static void stopAll();
+
+    int available() override;
+    int read() override;
+    int read(uint8_t *buffer, size_t size);
+    int read(char *buffer, size_t size)
+    {
+        return read((uint8_t *)buffer, size);
+    }
+    int peek() override;
+    size_t readBytes(char *buffer, size_t length) override;
+
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    size_t write_P(PGM_P buffer, size_t size)
+    {
+        return write((const uint8_t *)buffer, size);
+    }
+    // sends what is left to read in stream
+    size_t write(Stream &stream);
+    size_t availableForWrite();
+    void flush() override;
+
+    void setNoDelay(bool nodelay);
+    bool getNoDelay() const;
+
+    IPAddress remoteIP() const;
+    uint16_t remotePort() const;
+    IPAddress localIP() const;
+    uint16_t localPort() const;
+
+    operator bool()
+    {
+        return connected();
+    }
+    bool operator==(const WiFiClient &rhs) const
+    {
+        return _connection == rhs._connection;
+    }
+    bool operator!=(const WiFiClient &rhs) const
+    {
+        return _connection != rhs._connection;
+    }
+};
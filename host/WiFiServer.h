@@ -0,0 +1,69 @@
+/*
+  host/WiFiServer.h - TCP listener for the host build, backed by a
+  non-blocking Linux socket.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include "WiFiClient.h"
+
+
+// WiFiServer
+// Port 0 binds an ephemeral port, localPort() tells which one.
+class WiFiServer
+{
+private:
+    IPAddress _addr;
+    uint16_t _port;
+    int _fd = -1;
+    int _pending = -1;
+    bool _noDelay = false;
+
+public:
+    explicit WiFiServer(uint16_t port) : _port(port) {}
+    WiFiServer(IPAddress addr, uint16_t port) : _addr(addr), _port(port) {}
+    ~WiFiServer()
+    {
+        close();
+    }
+
+    WiFiServer(const WiFiServer &) = delete;
+    WiFiServer &operator=(const WiFiServer &) = delete;
+
+    void begin();
+    void begin(uint16_t port)
+    {
+        _port = port;
+        begin();
+    }
+    bool hasClient();
+    WiFiClient available(uint8_t *status = nullptr);
+    void setNoDelay(bool nodelay)
+    {
+        _noDelay = nodelay;
+    }
+    bool getNoDelay() const
+    {
+        return _noDelay;
+    }
+    uint8_t status() const
+    {
+        return _fd >= 0 ? 1 : 0;
+    }
+    uint16_t localPort() const;
+    void close();
+    void stop()
+    {
+        close();
+    }
+    void end()
+    {
+        close();
+    }
+};
@@ -0,0 +1,21 @@
+/*
+  host/WiFiUdp.h - UDP socket placeholder for the host build, the sketch
+  only stops all of them before a firmware update.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+
+// WiFiUDP
+class WiFiUDP
+{
+public:
+    static void stopAll() {}
+};
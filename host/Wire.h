@@ -0,0 +1,44 @@
+/*
+  host/Wire.h - I2C bus for the host build, nothing answers on it.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+
+// TwoWire
+class TwoWire
+{
+public:
+    void begin(int sda, int scl)
+    {
+        (void)sda;
+        (void)scl;
+    }
+    void setClock(uint32_t frequency)
+    {
+        (void)frequency;
+    }
+    void beginTransmission(uint8_t address)
+    {
+        (void)address;
+    }
+    size_t write(uint8_t data)
+    {
+        (void)data;
+        return 1;
+    }
+    uint8_t endTransmission(bool sendStop = true)
+    {
+        (void)sendStop;
+        return 0;
+    }
+};
+
+extern TwoWire Wire;
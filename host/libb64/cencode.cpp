@@ -0,0 +1,42 @@
+/*
+  host/libb64/cencode.cpp - base64 encoder of the ESP8266 core, for the
+  host build.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "cencode.h"
+
+#include <stdint.h>
+
+static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+
+extern "C" int base64_encode_chars(const char *plaintext_in, int length_in, char *code_out)
+{
+    const uint8_t *in = (const uint8_t *)plaintext_in;
+    char *out = code_out;
+    int i = 0;
+    for (; i + 2 < length_in; i += 3) {
+        uint32_t v = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+        *out++ = alphabet[(v >> 18) & 0x3f];
+        *out++ = alphabet[(v >> 12) & 0x3f];
+        *out++ = alphabet[(v >> 6) & 0x3f];
+        *out++ = alphabet[v & 0x3f];
+    }
+    if (i < length_in) {
+        uint32_t v = in[i] << 16;
+        if (i + 1 < length_in) {
+            v |= in[i + 1] << 8;
+        }
+        *out++ = alphabet[(v >> 18) & 0x3f];
+        *out++ = alphabet[(v >> 12) & 0x3f];
+        *out++ = i + 1 < length_in ? alphabet[(v >> 6) & 0x3f] : '=';
+        *out++ = '=';
+    }
+    *out = 0;
+    return out - code_out;
+}
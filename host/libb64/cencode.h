@@ -0,0 +1,25 @@
+/*
+  host/libb64/cencode.h - base64 encoder of the ESP8266 core, for the host
+  build. Output has no line breaks.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#define base64_encode_expected_len(n) ((((4 * (n)) / 3) + 3) & ~3)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// writes the encoding of plaintext_in and a terminating NUL to code_out,
+// returns the length of the encoding
+int base64_encode_chars(const char *plaintext_in, int length_in, char *code_out);
+
+#ifdef __cplusplus
+}
+#endif
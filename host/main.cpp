@@ -0,0 +1,30 @@
+/*
+  host/main.cpp - runs the sketch on the host: setup() once, then loop()
+  until ESP.restart() ends the process. ESP3D_HOST_PRINTER=marlin (or
+  marlinkimbra, repetier, repetier4dv, smoothieware) wires a simulated
+  printer to the printer port.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include <Arduino.h>
+#include <PrinterSimulator.h>
+
+
+int main()
+{
+    PrinterSimulator::Firmware firmware;
+    if (PrinterSimulator::firmwareFromName(getenv("ESP3D_HOST_PRINTER"), firmware)) {
+        static PrinterSimulator printer(firmware);
+        Serial.attach(&printer);
+    }
+    setup();
+    for (;;) {
+        loop();
+        // the ESP8266 core yields to the network stack between two loops
+        delay(0);
+    }
+}
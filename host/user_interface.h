@@ -0,0 +1,72 @@
+/*
+  host/user_interface.h - NONOS SDK calls used by the sketch, for the host
+  build. The sketch includes this file inside extern "C".
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/queue.h>
+
+#define STATION_IF 0x00
+#define SOFTAP_IF  0x01
+
+#define SYS_CPU_80MHZ  80
+#define SYS_CPU_160MHZ 160
+
+typedef enum {
+    AUTH_OPEN = 0,
+    AUTH_WEP,
+    AUTH_WPA_PSK,
+    AUTH_WPA2_PSK,
+    AUTH_WPA_WPA2_PSK,
+    AUTH_MAX
+} AUTH_MODE;
+
+enum dhcp_status {
+    DHCP_STOPPED,
+    DHCP_STARTED
+};
+
+struct ip_addr {
+    uint32_t addr;
+};
+
+struct ip_info {
+    struct ip_addr ip;
+    struct ip_addr netmask;
+    struct ip_addr gw;
+};
+
+struct softap_config {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    uint8_t ssid_len;
+    uint8_t channel;
+    AUTH_MODE authmode;
+    uint8_t ssid_hidden;
+    uint8_t max_connection;
+    uint16_t beacon_interval;
+};
+
+struct station_info {
+    STAILQ_ENTRY(station_info) next;
+    uint8_t bssid[6];
+    struct ip_addr ip;
+};
+
+void system_restore(void);
+bool system_update_cpu_freq(uint8_t freq);
+
+enum dhcp_status wifi_station_dhcpc_status(void);
+enum dhcp_status wifi_softap_dhcps_status(void);
+bool wifi_get_ip_info(uint8_t if_index, struct ip_info *info);
+bool wifi_softap_get_config(struct softap_config *config);
+bool wifi_softap_set_config_current(struct softap_config *config);
+struct station_info *wifi_softap_get_station_info(void);
+void wifi_softap_free_station_info(void);
@@ -31,82 +31,113 @@
 #define DEBUG_OUTPUT Serial
 #endif
 
-static char* readBytesWithTimeout(WiFiClient& client, size_t maxLength, size_t& dataLength, int timeout_ms)
-{
-  char *buf = nullptr;
-  dataLength = 0;
-  while (dataLength < maxLength) {
-    int tries = timeout_ms;
-    size_t newLength;
-    while (!(newLength = client.available()) && tries--) delay(1);
-    if (!newLength) {
+// case insensitive search of a word in a header value
+static bool _containsWord(const char* text, const char* word) {
+  size_t len = strlen(word);
+  for (; *text; text++) {
+    if (strncasecmp(text, word, len) == 0)
+      return true;
+  }
+  return false;
+}
+
+// NUL terminates the line starting at cursor and moves cursor to the next one
+static char* _nextLine(char*& cursor, char* end) {
+  char* line = cursor;
+  char* eol = (char*) memchr(line, '\n', end - line);
+  if (!eol) {
+    cursor = end;
+    return line;
+  }
+  cursor = eol + 1;
+  if (eol > line && eol[-1] == '\r')
+    eol--;
+  *eol = 0;
+  return line;
+}
+
+size_t WebServer::_requestReady(HTTPClientSlot& slot) {
+  // the head ends with an empty line
+  const char* buf = slot.buf;
+  size_t headLen = 0;
+  for (size_t i = 3; i < slot.received; i++) {
+    if (buf[i] == '\n' && buf[i - 1] == '\r' && buf[i - 2] == '\n' && buf[i - 3] == '\r') {
+      headLen = i + 1;
       break;
     }
-    if (!buf) {
-      buf = (char *) malloc(newLength + 1);
-      if (!buf) {
-        return nullptr;
-      }
-    }
-    else {
-      char* newBuf = (char *) realloc(buf, dataLength + newLength + 1);
-      if (!newBuf) {
-        free(buf);
-        return nullptr;
-      }
-      buf = newBuf;
+  }
+  if (!headLen)
+    return 0;
+  // a body small enough to share the buffer is waited for as well, larger
+  // and multipart ones are read from the client by the parser
+  size_t contentLength = 0;
+  bool multipart = false;
+  const char* line = buf;
+  const char* end = buf + headLen;
+  while (line < end) {
+    const char* eol = (const char*) memchr(line, '\n', end - line);
+    if (!eol)
+      break;
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      contentLength = strtoul(line + 15, NULL, 10);
+    } else if (strncasecmp(line, "Content-Type:", 13) == 0) {
+      const char* value = line + 13;
+      while (*value == ' ')
+        value++;
+      multipart = (strncasecmp(value, "multipart/", 10) == 0);
     }
-    client.readBytes(buf + dataLength, newLength);
-    dataLength += newLength;
-    buf[dataLength] = '\0';
+    line = eol + 1;
   }
-  return buf;
+  // written so that a huge Content-Length cannot wrap
+  if (!multipart && contentLength > 0 && contentLength < HTTP_HEAD_BUFLEN - 1 - headLen &&
+      slot.received < headLen + contentLength)
+    return 0;
+  return headLen;
 }
 
-bool WebServer::_parseRequest(WiFiClient& client) {
-  // Read the first line of HTTP request
-  String req = client.readStringUntil('\r');
-  client.readStringUntil('\n');
-  //reset header value
-  for (int i = 0; i < _headerKeysCount; ++i) {
-    _currentHeaders[i].value =String();
-   }
+bool WebServer::_parseRequest(WiFiClient& client, char* buf, size_t headLen, size_t received) {
+  _resetRequest();
+  _pending = buf + headLen;
+  _pendingLen = received - headLen;
+  char* cursor = buf;
+  char* end = buf + headLen;
 
   // First line of HTTP request looks like "GET /path HTTP/1.1"
   // Retrieve the "/path" part by finding the spaces
-  int addr_start = req.indexOf(' ');
-  int addr_end = req.indexOf(' ', addr_start + 1);
-  if (addr_start == -1 || addr_end == -1) {
+  char* req = _nextLine(cursor, end);
+  char* url = strchr(req, ' ');
+  char* version = url ? strchr(url + 1, ' ') : NULL;
+  if (!url || !version) {
 #ifdef DEBUG_ESP_HTTP_SERVER
     DEBUG_OUTPUT.print("Invalid request: ");
     DEBUG_OUTPUT.println(req);
 #endif
     return false;
   }
-
-  String methodStr = req.substring(0, addr_start);
-  String url = req.substring(addr_start + 1, addr_end);
-  String versionEnd = req.substring(addr_end + 8);
-  _currentVersion = atoi(versionEnd.c_str());
-  String searchStr = "";
-  int hasSearch = url.indexOf('?');
-  if (hasSearch != -1){
-    searchStr = url.substring(hasSearch + 1);
-    url = url.substring(0, hasSearch);
-  }
+  *url++ = 0;
+  *version++ = 0;
+
+  const char* methodStr = req;
+  _currentVersion = (strlen(version) > 7) ? atoi(version + 7) : 0;
+  char* searchStr = strchr(url, '?');
+  if (searchStr)
+    *searchStr++ = 0;
   _currentUri = url;
   _chunked = false;
+  //HTTP/1.1 connections persist unless asked otherwise, HTTP/1.0 ones only on request
+  _requestKeepAlive = (_currentVersion > 0);
+  _requestUpgrade = false;
 
   HTTPMethod method = HTTP_GET;
-  if (methodStr == "POST") {
+  if (strcmp(methodStr, "POST") == 0) {
     method = HTTP_POST;
-  } else if (methodStr == "DELETE") {
+  } else if (strcmp(methodStr, "DELETE") == 0) {
     method = HTTP_DELETE;
-  } else if (methodStr == "OPTIONS") {
+  } else if (strcmp(methodStr, "OPTIONS") == 0) {
     method = HTTP_OPTIONS;
-  } else if (methodStr == "PUT") {
+  } else if (strcmp(methodStr, "PUT") == 0) {
     method = HTTP_PUT;
-  } else if (methodStr == "PATCH") {
+  } else if (strcmp(methodStr, "PATCH") == 0) {
     method = HTTP_PATCH;
   }
   _currentMethod = method;
@@ -117,147 +148,142 @@ bool WebServer::_parseRequest(WiFiClient& client) {
   DEBUG_OUTPUT.print(" url: ");
   DEBUG_OUTPUT.print(url);
   DEBUG_OUTPUT.print(" search: ");
-  DEBUG_OUTPUT.println(searchStr);
+  DEBUG_OUTPUT.println(searchStr ? searchStr : "");
 #endif
 
   //attach handler
-  RequestHandler* handler;
-  for (handler = _firstHandler; handler; handler = handler->next()) {
-    if (handler->canHandle(_currentMethod, _currentUri))
+  _currentHandler = _findHandler(_currentMethod, _currentUri);
+
+  //parse headers, names and values are left in the buffer
+  const char* contentType = "";
+  size_t contentLength = 0;
+  while (cursor < end) {
+    char* headerName = _nextLine(cursor, end);
+    if (!*headerName) break;//no moar headers
+    char* headerValue = strchr(headerName, ':');
+    if (!headerValue) {
       break;
+    }
+    *headerValue++ = 0;
+    while (*headerValue == ' ' || *headerValue == '\t')
+      headerValue++;
+    _collectHeader(headerName, headerValue);
+
+#ifdef DEBUG_ESP_HTTP_SERVER
+    DEBUG_OUTPUT.print("headerName: ");
+    DEBUG_OUTPUT.println(headerName);
+    DEBUG_OUTPUT.print("headerValue: ");
+    DEBUG_OUTPUT.println(headerValue);
+#endif
+
+    if (strcasecmp(headerName, "Content-Type") == 0) {
+      contentType = headerValue;
+    } else if (strcasecmp(headerName, "Content-Length") == 0) {
+      contentLength = strtoul(headerValue, NULL, 10);
+    } else if (strcasecmp(headerName, "Host") == 0) {
+      _hostHeader = headerValue;
+    } else if (strcasecmp(headerName, "Connection") == 0) {
+      _requestKeepAlive = _parseConnectionHeader(headerValue, _requestKeepAlive);
+      _requestUpgrade = _containsWord(headerValue, "upgrade");
+    }
   }
-  _currentHandler = handler;
 
-  String formData;
   // below is needed only when POST type request
   if (method == HTTP_POST || method == HTTP_PUT || method == HTTP_PATCH || method == HTTP_DELETE){
-    String boundaryStr;
-    String headerName;
-    String headerValue;
-    bool isForm = false;
-    bool isEncoded = false;
-    uint32_t contentLength = 0;
-    //parse headers
-    while(1){
-      req = client.readStringUntil('\r');
-      client.readStringUntil('\n');
-      if (req == "") break;//no moar headers
-      int headerDiv = req.indexOf(':');
-      if (headerDiv == -1){
-        break;
-      }
-      headerName = req.substring(0, headerDiv);
-      headerValue = req.substring(headerDiv + 1);
-      headerValue.trim();
-       _collectHeader(headerName.c_str(),headerValue.c_str());
-
-      #ifdef DEBUG_ESP_HTTP_SERVER
-      DEBUG_OUTPUT.print("headerName: ");
-      DEBUG_OUTPUT.println(headerName);
-      DEBUG_OUTPUT.print("headerValue: ");
-      DEBUG_OUTPUT.println(headerValue);
-      #endif
-
-      if (headerName.equalsIgnoreCase("Content-Type")){
-        if (headerValue.startsWith("text/plain")){
-          isForm = false;
-        } else if (headerValue.startsWith("application/x-www-form-urlencoded")){
-          isForm = false;
-          isEncoded = true;
-        } else if (headerValue.startsWith("multipart/")){
-          boundaryStr = headerValue.substring(headerValue.indexOf('=')+1);
-          isForm = true;
-        }
-      } else if (headerName.equalsIgnoreCase("Content-Length")){
-        contentLength = headerValue.toInt();
-      } else if (headerName.equalsIgnoreCase("Host")){
-        _hostHeader = headerValue;
-      }
+    //media types are case insensitive, like _requestReady() reads them
+    bool isEncoded = strncasecmp(contentType, "application/x-www-form-urlencoded", 33) == 0;
+    bool isForm = strncasecmp(contentType, "multipart/", 10) == 0;
+
+    if (!isForm && contentLength > HTTP_MAX_BODY_SIZE) {
+      // refused before anything is allocated, strtoul overflow ends here too
+      _contentLength = CONTENT_LENGTH_NOT_SET;
+      _requestKeepAlive = false;
+      send(413, "text/plain", "Request body too large");
+      return false;
     }
 
     if (!isForm){
-      size_t plainLength;
-      char* plainBuf = readBytesWithTimeout(client, contentLength, plainLength, HTTP_MAX_POST_WAIT);
-      if (plainLength < contentLength) {
-      	free(plainBuf);
-      	return false;
-      }
+      char* plainBuf = NULL;
       if (contentLength > 0) {
-        if (searchStr != "") searchStr += '&';
+        if (_pendingLen >= contentLength) {
+          //whole body came with the head, shift what follows to make
+          //room for its terminating NUL
+          plainBuf = (char*) _pending;
+          size_t after = _pendingLen - contentLength;
+          memmove(plainBuf + contentLength + 1, plainBuf + contentLength, after);
+          _pending = plainBuf + contentLength + 1;
+          _pendingLen = after;
+        } else {
+          _bodyBuf = (char*) malloc(contentLength + 1);
+          if (!_bodyBuf || _bodyReadBytes(client, (uint8_t*) _bodyBuf, contentLength) < contentLength) {
+            return false;
+          }
+          plainBuf = _bodyBuf;
+        }
+        plainBuf[contentLength] = 0;
+      }
+      _parseArguments(searchStr);
+      if (plainBuf) {
         if(isEncoded){
           //url encoded form
-          String decoded = urlDecode(plainBuf);
-          size_t decodedLen = decoded.length();
-          memcpy(plainBuf, decoded.c_str(), decodedLen);
-          plainBuf[decodedLen] = 0;
-          searchStr += plainBuf;
-        }
-        _parseArguments(searchStr);
-        if(!isEncoded){
+          _parseArguments(plainBuf);
+        } else {
           //plain post json or other data
-          RequestArgument& arg = _currentArgs[_currentArgCount++];
-          arg.key = "plain";
-          arg.value = String(plainBuf);
+          _addArgument("plain", plainBuf);
         }
 
-  #ifdef DEBUG_ESP_HTTP_SERVER
+#ifdef DEBUG_ESP_HTTP_SERVER
         DEBUG_OUTPUT.print("Plain: ");
         DEBUG_OUTPUT.println(plainBuf);
-  #endif
-        free(plainBuf);
-      } else {
-        // No content - but we can still have arguments in the URL.
-        _parseArguments(searchStr);
+#endif
       }
     }
 
     if (isForm){
+      const char* boundary = strchr(contentType, '=');
       _parseArguments(searchStr);
-      if (!_parseForm(client, boundaryStr, contentLength)) {
+      if (!_parseForm(client, String(boundary ? boundary + 1 : contentType), contentLength)) {
         return false;
       }
     }
   } else {
-    String headerName;
-    String headerValue;
-    //parse headers
-    while(1){
-      req = client.readStringUntil('\r');
-      client.readStringUntil('\n');
-      if (req == "") break;//no moar headers
-      int headerDiv = req.indexOf(':');
-      if (headerDiv == -1){
-        break;
-      }
-      headerName = req.substring(0, headerDiv);
-      headerValue = req.substring(headerDiv + 2);
-      _collectHeader(headerName.c_str(),headerValue.c_str());
-
-	  #ifdef DEBUG_ESP_HTTP_SERVER
-	  DEBUG_OUTPUT.print("headerName: ");
-	  DEBUG_OUTPUT.println(headerName);
-	  DEBUG_OUTPUT.print("headerValue: ");
-	  DEBUG_OUTPUT.println(headerValue);
-	  #endif
-
-	  if (headerName.equalsIgnoreCase("Host")){
-        _hostHeader = headerValue;
-      }
-    }
     _parseArguments(searchStr);
   }
-  client.flush();
 
 #ifdef DEBUG_ESP_HTTP_SERVER
   DEBUG_OUTPUT.print("Request: ");
   DEBUG_OUTPUT.println(url);
-  DEBUG_OUTPUT.print(" Arguments: ");
-  DEBUG_OUTPUT.println(searchStr);
 #endif
 
   return true;
 }
 
+void WebServer::_resetRequest() {
+  _currentArgCount = 0;
+  for (int i = 0; i < _headerKeysCount; ++i) {
+    _currentHeaders[i].value = "";
+  }
+  _hostHeader = "";
+  _pending = NULL;
+  _pendingLen = 0;
+  if (_bodyBuf) {
+    free(_bodyBuf);
+    _bodyBuf = NULL;
+  }
+  if (_formStrings) {
+    delete[] _formStrings;
+    _formStrings = NULL;
+  }
+}
+
+bool WebServer::_parseConnectionHeader(const char* value, bool keepAlive) {
+  if (_containsWord(value, "close"))
+    return false;
+  if (_containsWord(value, "keep-alive"))
+    return true;
+  return keepAlive;
+}
+
 bool WebServer::_collectHeader(const char* headerName, const char* headerValue) {
   for (int i = 0; i < _headerKeysCount; i++) {
     if (_currentHeaders[i].key.equalsIgnoreCase(headerName)) {
@@ -268,99 +294,170 @@ bool WebServer::_collectHeader(const char* headerName, const char* headerValue)
   return false;
 }
 
-void WebServer::_parseArguments(String data) {
+void WebServer::_parseArguments(char* data) {
 #ifdef DEBUG_ESP_HTTP_SERVER
   DEBUG_OUTPUT.print("args: ");
-  DEBUG_OUTPUT.println(data);
+  DEBUG_OUTPUT.println(data ? data : "");
 #endif
-  if (_currentArgs)
-    delete[] _currentArgs;
-  _currentArgs = 0;
-  if (data.length() == 0) {
-    _currentArgCount = 0;
-    _currentArgs = new RequestArgument[1];
-    return;
-  }
-  _currentArgCount = 1;
-
-  for (int i = 0; i < (int)data.length(); ) {
-    i = data.indexOf('&', i);
-    if (i == -1)
-      break;
-    ++i;
-    ++_currentArgCount;
+  //split and decode in place, an argument without value is skipped
+  while (data && *data) {
+    char* next = strchr(data, '&');
+    if (next)
+      *next++ = 0;
+    char* value = strchr(data, '=');
+    if (value) {
+      *value++ = 0;
+      _addArgument(data, _urlDecodeInPlace(value));
+#ifdef DEBUG_ESP_HTTP_SERVER
+      DEBUG_OUTPUT.print("arg key: ");
+      DEBUG_OUTPUT.print(data);
+      DEBUG_OUTPUT.print(" value: ");
+      DEBUG_OUTPUT.println(value);
+#endif
+    }
+    data = next;
   }
 #ifdef DEBUG_ESP_HTTP_SERVER
   DEBUG_OUTPUT.print("args count: ");
   DEBUG_OUTPUT.println(_currentArgCount);
 #endif
+}
 
-  _currentArgs = new RequestArgument[_currentArgCount+1];
-  int pos = 0;
-  int iarg;
-  for (iarg = 0; iarg < _currentArgCount;) {
-    int equal_sign_index = data.indexOf('=', pos);
-    int next_arg_index = data.indexOf('&', pos);
-#ifdef DEBUG_ESP_HTTP_SERVER
-    DEBUG_OUTPUT.print("pos ");
-    DEBUG_OUTPUT.print(pos);
-    DEBUG_OUTPUT.print("=@ ");
-    DEBUG_OUTPUT.print(equal_sign_index);
-    DEBUG_OUTPUT.print(" &@ ");
-    DEBUG_OUTPUT.println(next_arg_index);
-#endif
-    if ((equal_sign_index == -1) || ((equal_sign_index > next_arg_index) && (next_arg_index != -1))) {
-#ifdef DEBUG_ESP_HTTP_SERVER
-      DEBUG_OUTPUT.print("arg missing value: ");
-      DEBUG_OUTPUT.println(iarg);
-#endif
-      if (next_arg_index == -1)
+void WebServer::_addArgument(const char* key, const char* value) {
+  if (_currentArgCount < HTTP_MAX_ARGS) {
+    _currentArgs[_currentArgCount].key = key;
+    _currentArgs[_currentArgCount].value = value;
+    _currentArgCount++;
+  }
+}
+
+size_t WebServer::_bodyReadBytes(WiFiClient& client, uint8_t* buf, size_t len) {
+  size_t done = 0;
+  if (_pendingLen) {
+    done = (len < _pendingLen) ? len : _pendingLen;
+    memcpy(buf, _pending, done);
+    _pending += done;
+    _pendingLen -= done;
+  }
+  unsigned long start = millis();
+  while (done < len && millis() - start < HTTP_MAX_POST_WAIT) {
+    size_t avail = client.available();
+    if (!avail) {
+      if (!client.connected())
         break;
-      pos = next_arg_index + 1;
+      delay(1);
       continue;
     }
-    RequestArgument& arg = _currentArgs[iarg];
-    arg.key = data.substring(pos, equal_sign_index);
-    arg.value = urlDecode(data.substring(equal_sign_index + 1, next_arg_index));
-#ifdef DEBUG_ESP_HTTP_SERVER
-    DEBUG_OUTPUT.print("arg ");
-    DEBUG_OUTPUT.print(iarg);
-    DEBUG_OUTPUT.print(" key: ");
-    DEBUG_OUTPUT.print(arg.key);
-    DEBUG_OUTPUT.print(" value: ");
-    DEBUG_OUTPUT.println(arg.value);
-#endif
-    ++iarg;
-    if (next_arg_index == -1)
-      break;
-    pos = next_arg_index + 1;
+    if (avail > len - done)
+      avail = len - done;
+    int got = client.read(buf + done, avail);
+    if (got > 0) {
+      done += got;
+      start = millis();
+    }
   }
-  _currentArgCount = iarg;
-#ifdef DEBUG_ESP_HTTP_SERVER
-  DEBUG_OUTPUT.print("args count: ");
-  DEBUG_OUTPUT.println(_currentArgCount);
-#endif
+  return done;
+}
 
+String WebServer::_bodyReadLine(WiFiClient& client) {
+  String line;
+  unsigned long start = millis();
+  while (millis() - start < HTTP_MAX_POST_WAIT) {
+    int c;
+    if (_pendingLen) {
+      c = (uint8_t) *_pending++;
+      _pendingLen--;
+    } else if (client.available()) {
+      c = client.read();
+    } else {
+      if (!client.connected())
+        break;
+      delay(1);
+      continue;
+    }
+    if (c == '\n')
+      break;
+    if (c != '\r')
+      line += (char) c;
+    start = millis();
+  }
+  return line;
 }
 
-void WebServer::_uploadWriteByte(uint8_t b){
-  if (_currentUpload.currentSize == HTTP_UPLOAD_BUFLEN){
-    if(_currentHandler && _currentHandler->canUpload(_currentUri))
-      _currentHandler->upload(*this, _currentUri, _currentUpload);
-    _currentUpload.totalSize += _currentUpload.currentSize;
-    _currentUpload.currentSize = 0;
+size_t WebServer::_bodyReadSome(WiFiClient& client, uint8_t* buf, size_t len) {
+  if (_pendingLen) {
+    size_t n = (len < _pendingLen) ? len : _pendingLen;
+    memmove(buf, _pending, n);
+    _pending += n;
+    _pendingLen -= n;
+    return n;
   }
-  _currentUpload.buf[_currentUpload.currentSize++] = b;
+  //a client that stops sending gives up its slot like in _bodyReadBytes
+  unsigned long start = millis();
+  while (!client.available()) {
+    if (!client.connected() || millis() - start >= HTTP_MAX_POST_WAIT)
+      return 0;
+    yield();
+  }
+  int got = client.read(buf, len);
+  return (got > 0) ? got : 0;
 }
 
-uint8_t WebServer::_uploadReadByte(WiFiClient& client){
-  int res = client.read();
-  if(res == -1){
-    while(!client.available() && client.connected())
-      yield();
-    res = client.read();
+void WebServer::_uploadData(size_t len) {
+  _currentUpload.currentSize = len;
+  if(_currentHandler && _currentHandler->canUpload(_currentUri))
+    _currentHandler->upload(*this, _currentUri, _currentUpload);
+  _currentUpload.totalSize += len;
+  _currentUpload.currentSize = 0;
+}
+
+//what is left of the head buffer or of a previous part is taken by the
+//first read of _uploadFile()
+static_assert(HTTP_UPLOAD_BUFLEN >= HTTP_HEAD_BUFLEN, "pending bytes must fit the upload buffer in one read");
+
+// File data is read straight into the upload buffer and searched in bulk
+// for the delimiter (Boyer-Moore-Horspool), the handler gets the buffer
+// each time it is full minus the few bytes which could still start a
+// delimiter. On success the last piece of data is left in the buffer and
+// what followed the delimiter is left pending.
+bool WebServer::_uploadFile(WiFiClient& client, const String& boundary) {
+  String delimiter = "\r\n--" + boundary;
+  const uint8_t* delim = (const uint8_t*) delimiter.c_str();
+  size_t delimLen = delimiter.length();
+  if (delimLen > 255)
+    return false;
+  uint8_t skip[256];
+  memset(skip, delimLen, sizeof(skip));
+  for (size_t i = 0; i < delimLen - 1; i++)
+    skip[delim[i]] = delimLen - 1 - i;
+
+  uint8_t* buf = _currentUpload.buf;
+  size_t fill = 0;
+  size_t pos = 0;   // delimiter can not start before
+  while (1) {
+    size_t got = _bodyReadSome(client, buf + fill, HTTP_UPLOAD_BUFLEN - fill);
+    if (!got)
+      return false;
+    fill += got;
+    while (pos + delimLen <= fill) {
+      uint8_t last = buf[pos + delimLen - 1];
+      if (last == delim[delimLen - 1] && memcmp(buf + pos, delim, delimLen - 1) == 0) {
+        //the first read took all the pending bytes, what follows the
+        //delimiter is only in buf
+        _pending = (const char*) buf + pos + delimLen;
+        _pendingLen = fill - pos - delimLen;
+        _currentUpload.currentSize = pos;
+        return true;
+      }
+      pos += skip[last];
+    }
+    if (fill == HTTP_UPLOAD_BUFLEN) {
+      _uploadData(pos);
+      fill -= pos;
+      memmove(buf, buf + pos, fill);
+      pos = 0;
+    }
   }
-  return (uint8_t)res;
 }
 
 bool WebServer::_parseForm(WiFiClient& client, String boundary, uint32_t len){
@@ -374,14 +471,14 @@ bool WebServer::_parseForm(WiFiClient& client, String boundary, uint32_t len){
   String line;
   int retry = 0;
   do {
-    line = client.readStringUntil('\r');
+    line = _bodyReadLine(client);
     ++retry;
   } while (line.length() == 0 && retry < 3);
 
-  client.readStringUntil('\n');
   //start reading the form
   if (line == ("--"+boundary)){
-    RequestArgument* postArgs = new RequestArgument[32];
+    //field names and values, the arguments point to them
+    _formStrings = new String[HTTP_MAX_ARGS * 2];
     int postArgsLen = 0;
     while(1){
       String argName;
@@ -390,8 +487,7 @@ bool WebServer::_parseForm(WiFiClient& client, String boundary, uint32_t len){
       String argFilename;
       bool argIsFile = false;
 
-      line = client.readStringUntil('\r');
-      client.readStringUntil('\n');
+      line = _bodyReadLine(client);
       if (line.length() > 19 && line.substring(0, 19).equalsIgnoreCase("Content-Disposition")){
         int nameStart = line.indexOf('=');
         if (nameStart != -1){
@@ -415,13 +511,11 @@ bool WebServer::_parseForm(WiFiClient& client, String boundary, uint32_t len){
           DEBUG_OUTPUT.println(argName);
 #endif
           argType = "text/plain";
-          line = client.readStringUntil('\r');
-          client.readStringUntil('\n');
+          line = _bodyReadLine(client);
           if (line.length() > 12 && line.substring(0, 12).equalsIgnoreCase("Content-Type")){
             argType = line.substring(line.indexOf(':')+2);
             //skip next line
-            client.readStringUntil('\r');
-            client.readStringUntil('\n');
+            _bodyReadLine(client);
           }
 #ifdef DEBUG_ESP_HTTP_SERVER
           DEBUG_OUTPUT.print("PostArg Type: ");
@@ -429,8 +523,7 @@ bool WebServer::_parseForm(WiFiClient& client, String boundary, uint32_t len){
 #endif
           if (!argIsFile){
             while(1){
-              line = client.readStringUntil('\r');
-              client.readStringUntil('\n');
+              line = _bodyReadLine(client);
               if (line.startsWith("--"+boundary)) break;
               if (argValue.length() > 0) argValue += "\n";
               argValue += line;
@@ -441,9 +534,11 @@ bool WebServer::_parseForm(WiFiClient& client, String boundary, uint32_t len){
             DEBUG_OUTPUT.println();
 #endif
 
-            RequestArgument& arg = postArgs[postArgsLen++];
-            arg.key = argName;
-            arg.value = argValue;
+            if (postArgsLen < HTTP_MAX_ARGS) {
+              _formStrings[postArgsLen * 2] = argName;
+              _formStrings[postArgsLen * 2 + 1] = argValue;
+              postArgsLen++;
+            }
 
             if (line == ("--"+boundary+"--")){
 #ifdef DEBUG_ESP_HTTP_SERVER
@@ -467,101 +562,44 @@ bool WebServer::_parseForm(WiFiClient& client, String boundary, uint32_t len){
             if(_currentHandler && _currentHandler->canUpload(_currentUri))
               _currentHandler->upload(*this, _currentUri, _currentUpload);
             _currentUpload.status = UPLOAD_FILE_WRITE;
-            uint8_t argByte = _uploadReadByte(client);
-readfile:
-            while(argByte != 0x0D){
-              if (!client.connected()) return _parseFormUploadAborted();
-              _uploadWriteByte(argByte);
-              argByte = _uploadReadByte(client);
-            }
-
-            argByte = _uploadReadByte(client);
-            if (!client.connected()) return _parseFormUploadAborted();
-            if (argByte == 0x0A){
-              argByte = _uploadReadByte(client);
-              if (!client.connected()) return _parseFormUploadAborted();
-              if ((char)argByte != '-'){
-                //continue reading the file
-                _uploadWriteByte(0x0D);
-                _uploadWriteByte(0x0A);
-                goto readfile;
-              } else {
-                argByte = _uploadReadByte(client);
-                if (!client.connected()) return _parseFormUploadAborted();
-                if ((char)argByte != '-'){
-                  //continue reading the file
-                  _uploadWriteByte(0x0D);
-                  _uploadWriteByte(0x0A);
-                  _uploadWriteByte((uint8_t)('-'));
-                  goto readfile;
-                }
-              }
-
-              uint8_t endBuf[boundary.length()];
-              client.readBytes(endBuf, boundary.length());
-
-              if (strstr((const char*)endBuf, boundary.c_str()) != NULL){
-                if(_currentHandler && _currentHandler->canUpload(_currentUri))
-                  _currentHandler->upload(*this, _currentUri, _currentUpload);
-                _currentUpload.totalSize += _currentUpload.currentSize;
-                _currentUpload.status = UPLOAD_FILE_END;
-                if(_currentHandler && _currentHandler->canUpload(_currentUri))
-                  _currentHandler->upload(*this, _currentUri, _currentUpload);
+            if (!_uploadFile(client, boundary)) return _parseFormUploadAborted();
+            _uploadData(_currentUpload.currentSize);
+            _currentUpload.status = UPLOAD_FILE_END;
+            if(_currentHandler && _currentHandler->canUpload(_currentUri))
+              _currentHandler->upload(*this, _currentUri, _currentUpload);
 #ifdef DEBUG_ESP_HTTP_SERVER
-                DEBUG_OUTPUT.print("End File: ");
-                DEBUG_OUTPUT.print(_currentUpload.filename);
-                DEBUG_OUTPUT.print(" Type: ");
-                DEBUG_OUTPUT.print(_currentUpload.type);
-                DEBUG_OUTPUT.print(" Size: ");
-                DEBUG_OUTPUT.println(_currentUpload.totalSize);
+            DEBUG_OUTPUT.print("End File: ");
+            DEBUG_OUTPUT.print(_currentUpload.filename);
+            DEBUG_OUTPUT.print(" Type: ");
+            DEBUG_OUTPUT.print(_currentUpload.type);
+            DEBUG_OUTPUT.print(" Size: ");
+            DEBUG_OUTPUT.println(_currentUpload.totalSize);
 #endif
-                line = client.readStringUntil(0x0D);
-                client.readStringUntil(0x0A);
-                if (line == "--"){
+            line = _bodyReadLine(client);
+            if (line == "--"){
 #ifdef DEBUG_ESP_HTTP_SERVER
-                  DEBUG_OUTPUT.println("Done Parsing POST");
+              DEBUG_OUTPUT.println("Done Parsing POST");
 #endif
-                  break;
-                }
-                continue;
-              } else {
-                _uploadWriteByte(0x0D);
-                _uploadWriteByte(0x0A);
-                _uploadWriteByte((uint8_t)('-'));
-                _uploadWriteByte((uint8_t)('-'));
-                uint32_t i = 0;
-                while(i < boundary.length()){
-                  _uploadWriteByte(endBuf[i++]);
-                }
-                argByte = _uploadReadByte(client);
-                goto readfile;
-              }
-            } else {
-              _uploadWriteByte(0x0D);
-              goto readfile;
+              break;
             }
-            break;
+            continue;
           }
         }
       }
     }
 
+    //form fields first, then the url arguments
+    RequestArgument urlArgs[HTTP_MAX_ARGS];
+    int urlArgCount = _currentArgCount;
+    memcpy(urlArgs, _currentArgs, sizeof(RequestArgument) * urlArgCount);
+    _currentArgCount = 0;
     int iarg;
-    int totalArgs = ((32 - postArgsLen) < _currentArgCount)?(32 - postArgsLen):_currentArgCount;
-    for (iarg = 0; iarg < totalArgs; iarg++){
-      RequestArgument& arg = postArgs[postArgsLen++];
-      arg.key = _currentArgs[iarg].key;
-      arg.value = _currentArgs[iarg].value;
-    }
-    if (_currentArgs) delete[] _currentArgs;
-    _currentArgs = new RequestArgument[postArgsLen];
     for (iarg = 0; iarg < postArgsLen; iarg++){
-      RequestArgument& arg = _currentArgs[iarg];
-      arg.key = postArgs[iarg].key;
-      arg.value = postArgs[iarg].value;
+      _addArgument(_formStrings[iarg * 2].c_str(), _formStrings[iarg * 2 + 1].c_str());
+    }
+    for (iarg = 0; iarg < urlArgCount; iarg++){
+      _addArgument(urlArgs[iarg].key, urlArgs[iarg].value);
     }
-    _currentArgCount = iarg;
-    if (postArgs) delete[] postArgs;
     return true;
   }
 #ifdef DEBUG_ESP_HTTP_SERVER
@@ -571,6 +609,24 @@ readfile:
   return false;
 }
 
+char* WebServer::_urlDecodeInPlace(char* text)
+{
+	char* out = text;
+	for (const char* in = text; *in; in++) {
+		if ((*in == '%') && in[1] && in[2]) {
+			char temp[] = { in[1], in[2], 0 };
+			*out++ = (char) strtol(temp, NULL, 16);
+			in += 2;
+		} else if (*in == '+') {
+			*out++ = ' ';
+		} else {
+			*out++ = *in;
+		}
+	}
+	*out = 0;
+	return text;
+}
+
 String WebServer::urlDecode(const String& text)
 {
 	String decoded = "";
@@ -26,6 +26,7 @@
 #include "WiFiServer.h"
 #include "WiFiClient.h"
 #include "WebServer.h"
+#include "WebSocket.h"
 #include "FS.h"
 #include "detail/RequestHandlersImpl.h"
 
@@ -37,22 +38,42 @@
 #endif
 
 const char * AUTHORIZATION_HEADER = "Authorization";
+const char * UPGRADE_HEADER = "Upgrade";
+const char * WEBSOCKET_KEY_HEADER = "Sec-WebSocket-Key";
+const char * RANGE_HEADER = "Range";
+const char * IF_RANGE_HEADER = "If-Range";
+//always collected, before the ones asked by collectHeaders()
+#define BUILTIN_HEADERS_COUNT 5
 
 WebServer::WebServer(IPAddress addr, int port)
 : _server(addr, port)
 , _currentMethod(HTTP_ANY)
 , _currentVersion(0)
-, _currentStatus(HC_NONE)
-, _statusChange(0)
+, _nextSlot(0)
 , _currentHandler(0)
 , _firstHandler(0)
 , _lastHandler(0)
+, _routes(0)
+, _routeCount(0)
 , _currentArgCount(0)
-, _currentArgs(0)
+, _pending(0)
+, _pendingLen(0)
+, _bodyBuf(0)
+, _formStrings(0)
 , _headerKeysCount(0)
 , _currentHeaders(0)
 , _contentLength(0)
+, _hostHeader("")
 , _chunked(false)
+, _clientDetached(false)
+, _requestKeepAlive(false)
+, _requestUpgrade(false)
+, _responseKeepAlive(false)
+, _keepAliveCount(0)
+, _headerSent(false)
+, _bodyLength(0)
+, _bodySent(0)
+, _chunkedEnd(false)
 {
 }
 
@@ -60,21 +81,36 @@ WebServer::WebServer(int port)
 : _server(port)
 , _currentMethod(HTTP_ANY)
 , _currentVersion(0)
-, _currentStatus(HC_NONE)
-, _statusChange(0)
+, _nextSlot(0)
 , _currentHandler(0)
 , _firstHandler(0)
 , _lastHandler(0)
+, _routes(0)
+, _routeCount(0)
 , _currentArgCount(0)
-, _currentArgs(0)
+, _pending(0)
+, _pendingLen(0)
+, _bodyBuf(0)
+, _formStrings(0)
 , _headerKeysCount(0)
 , _currentHeaders(0)
 , _contentLength(0)
+, _hostHeader("")
 , _chunked(false)
+, _clientDetached(false)
+, _requestKeepAlive(false)
+, _requestUpgrade(false)
+, _responseKeepAlive(false)
+, _keepAliveCount(0)
+, _headerSent(false)
+, _bodyLength(0)
+, _bodySent(0)
+, _chunkedEnd(false)
 {
 }
 
 WebServer::~WebServer() {
+  _resetRequest();
   if (_currentHeaders)
     delete[]_currentHeaders;
   _headerKeysCount = 0;
@@ -84,12 +120,18 @@ WebServer::~WebServer() {
     delete handler;
     handler = next;
   }
+  for (uint8_t i = 0; i < _routeCount; i++)
+    delete _routes[i].handler;
+  free(_routes);
   close();
 }
 
 void WebServer::begin() {
-  _currentStatus = HC_NONE;
+  for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++)
+    _releaseSlot(_slots[i]);
   _server.begin();
+  //small responses and keep-alive requests must not wait for delayed acks
+  _server.setNoDelay(true);
   if(!_headerKeysCount)
     collectHeaders(0, 0);
 }
@@ -141,7 +183,56 @@ void WebServer::on(const String &uri, HTTPMethod method, WebServer::THandlerFunc
 }
 
 void WebServer::on(const String &uri, HTTPMethod method, WebServer::THandlerFunction fn, WebServer::THandlerFunction ufn) {
-  _addRequestHandler(new FunctionRequestHandler(fn, ufn, uri, method));
+  _addRoute(uri, new FunctionRequestHandler(fn, ufn, uri, method));
+}
+
+static uint32_t _uriHash(const String& uri) {
+  uint32_t hash = 2166136261UL;
+  for (const char* p = uri.c_str(); *p; p++)
+    hash = (hash ^ (uint8_t)*p) * 16777619UL;
+  return hash;
+}
+
+void WebServer::_addRoute(const String& uri, RequestHandler* handler) {
+  Route* routes = (_routeCount < 255) ? (Route*) realloc(_routes, sizeof(Route) * (_routeCount + 1)) : NULL;
+  if (!routes) {
+    delete handler;
+    return;
+  }
+  _routes = routes;
+  // sorted by hash, routes with the same hash stay in registration order
+  uint32_t hash = _uriHash(uri);
+  uint8_t i = _routeCount;
+  while (i > 0 && _routes[i - 1].hash > hash) {
+    _routes[i] = _routes[i - 1];
+    i--;
+  }
+  _routes[i].hash = hash;
+  _routes[i].handler = handler;
+  _routeCount++;
+}
+
+RequestHandler* WebServer::_findHandler(HTTPMethod method, const String& uri) {
+  uint32_t hash = _uriHash(uri);
+  uint8_t low = 0;
+  uint8_t high = _routeCount;
+  while (low < high) {
+    uint8_t mid = (low + high) / 2;
+    if (_routes[mid].hash < hash)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  for (; low < _routeCount && _routes[low].hash == hash; low++) {
+    if (_routes[low].handler->canHandle(method, uri))
+      return _routes[low].handler;
+  }
+  RequestHandler* handler;
+  for (handler = _firstHandler; handler; handler = handler->next()) {
+    if (handler->canHandle(method, uri))
+      break;
+  }
+  return handler;
 }
 
 void WebServer::addHandler(RequestHandler* handler) {
@@ -164,67 +255,160 @@ void WebServer::serveStatic(const char* uri, FS& fs, const char* path, const cha
 }
 
 void WebServer::handleClient() {
-  if (_currentStatus == HC_NONE) {
-    WiFiClient client = _server.available();
-    if (!client) {
-      return;
+  // take every waiting client a slot can hold
+  while (_server.hasClient()) {
+    HTTPClientSlot* slot = _freeSlot();
+    if (!slot) {
+      break;
     }
-
 #ifdef DEBUG_ESP_HTTP_SERVER
     DEBUG_OUTPUT.println("New client");
 #endif
-
-    _currentClient = client;
-    _currentStatus = HC_WAIT_READ;
-    _statusChange = millis();
+    slot->client = _server.available();
+    slot->status = HC_WAIT_READ;
+    slot->statusChange = millis();
+    slot->keepAliveCount = 0;
   }
 
-  if (!_currentClient.connected()) {
-    _currentClient = WiFiClient();
-    _currentStatus = HC_NONE;
-    return;
+  // at most one request per call, slots take turns so none is starved
+  for (uint8_t n = 0; n < HTTP_MAX_CLIENTS; n++) {
+    uint8_t i = (_nextSlot + n) % HTTP_MAX_CLIENTS;
+    if (_handleSlot(_slots[i])) {
+      _nextSlot = (i + 1) % HTTP_MAX_CLIENTS;
+      break;
+    }
   }
+}
 
-  // Wait for data from client to become available
-  if (_currentStatus == HC_WAIT_READ) {
-    if (!_currentClient.available()) {
-      if (millis() - _statusChange > HTTP_MAX_DATA_WAIT) {
-        _currentClient = WiFiClient();
-        _currentStatus = HC_NONE;
-      }
-      yield();
-      return;
+HTTPClientSlot* WebServer::_freeSlot() {
+  HTTPClientSlot* idlest = NULL;
+  for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+    HTTPClientSlot& slot = _slots[i];
+    if (slot.status == HC_NONE || !slot.client.connected()) {
+      _releaseSlot(slot);
+      return &slot;
     }
-
-    if (!_parseRequest(_currentClient)) {
-      _currentClient = WiFiClient();
-      _currentStatus = HC_NONE;
-      return;
+    // a connection waiting to be closed or an idle persistent one can go
+    bool idle = (slot.status == HC_WAIT_CLOSE) ||
+                (slot.keepAliveCount > 0 && slot.received == 0 && !slot.client.available());
+    if (idle && (!idlest || (long)(slot.statusChange - idlest->statusChange) < 0)) {
+      idlest = &slot;
     }
-    _currentClient.setTimeout(HTTP_MAX_SEND_WAIT);
-    _contentLength = CONTENT_LENGTH_NOT_SET;
-    _handleRequest();
+  }
+  if (idlest) {
+    idlest->client.stop();
+    _releaseSlot(*idlest);
+  }
+  return idlest;
+}
 
-    if (!_currentClient.connected()) {
-      _currentClient = WiFiClient();
-      _currentStatus = HC_NONE;
-      return;
-    } else {
-      _currentStatus = HC_WAIT_CLOSE;
-      _statusChange = millis();
-      return;
+void WebServer::_releaseSlot(HTTPClientSlot& slot) {
+  slot.client = WiFiClient();
+  slot.status = HC_NONE;
+  slot.keepAliveCount = 0;
+  slot.received = 0;
+}
+
+bool WebServer::_handleSlot(HTTPClientSlot& slot) {
+  if (slot.status == HC_NONE) {
+    return false;
+  }
+
+  if (!slot.client.connected()) {
+    _releaseSlot(slot);
+    return false;
+  }
+
+  if (slot.status == HC_WAIT_CLOSE) {
+    if (millis() - slot.statusChange > HTTP_MAX_CLOSE_WAIT) {
+      _releaseSlot(slot);
     }
+    return false;
   }
 
-  if (_currentStatus == HC_WAIT_CLOSE) {
-    if (millis() - _statusChange > HTTP_MAX_CLOSE_WAIT) {
+  // Gather the request head as it arrives, other slots go on meanwhile
+  size_t avail = slot.client.available();
+  size_t room = HTTP_HEAD_BUFLEN - 1 - slot.received;
+  if (avail && room) {
+    if (avail > room)
+      avail = room;
+    int got = slot.client.read((uint8_t*)slot.buf + slot.received, avail);
+    if (got > 0) {
+      slot.received += got;
+      slot.statusChange = millis();
+    }
+  }
+  size_t headLen = _requestReady(slot);
+  if (!headLen) {
+    if (slot.received == HTTP_HEAD_BUFLEN - 1) {
+      // too large to be parsed, answer and drop it
+      _currentClient = slot.client;
+      _currentVersion = 1;
+      _contentLength = CONTENT_LENGTH_NOT_SET;
+      _requestKeepAlive = false;
+      send(431, "text/plain", "Request header too large");
       _currentClient = WiFiClient();
-      _currentStatus = HC_NONE;
-    } else {
-      yield();
-      return;
+      slot.client.stop();
+      _releaseSlot(slot);
+      return true;
     }
+    bool idle = slot.keepAliveCount > 0 && slot.received == 0;
+    if (millis() - slot.statusChange > (idle ? HTTP_KEEPALIVE_TIMEOUT : HTTP_MAX_DATA_WAIT)) {
+      slot.client.stop();
+      _releaseSlot(slot);
+    }
+    return false;
+  }
+
+  _currentClient = slot.client;
+  _keepAliveCount = slot.keepAliveCount;
+  if (!_parseRequest(_currentClient, slot.buf, headLen, slot.received)) {
+    _resetRequest();
+    _currentClient = WiFiClient();
+    slot.client.stop();
+    _releaseSlot(slot);
+    return true;
   }
+  _currentClient.setTimeout(HTTP_MAX_SEND_WAIT);
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  _clientDetached = false;
+  _headerSent = false;
+  _responseKeepAlive = false;
+  _bodyLength = 0;
+  _bodySent = 0;
+  _chunkedEnd = false;
+  _handleRequest();
+
+  // keep what was received after this request, it is the next one, a
+  // form read past its end leaves more than that and the connection closes
+  bool overflow = _pendingLen > HTTP_HEAD_BUFLEN - 1;
+  slot.received = overflow ? 0 : _pendingLen;
+  memmove(slot.buf, _pending, slot.received);
+  _resetRequest();
+
+  if (_clientDetached || !_currentClient.connected()) {
+    _clientDetached = false;
+    _releaseSlot(slot);
+  } else if (_responseKeepAlive && _responseComplete() && !overflow) {
+    slot.keepAliveCount++;
+    slot.status = HC_WAIT_READ;
+    slot.statusChange = millis();
+  } else {
+    slot.status = HC_WAIT_CLOSE;
+    slot.statusChange = millis();
+  }
+  // the slot keeps the connection, handlers only see it while they run
+  _currentClient = WiFiClient();
+  return true;
+}
+
+bool WebServer::_responseComplete() {
+  // a handler writing to client() directly leaves the framing unknown
+  if (!_headerSent)
+    return false;
+  if (_chunked)
+    return _chunkedEnd;
+  return _bodySent == _bodyLength;
 }
 
 void WebServer::close() {
@@ -240,6 +424,21 @@ void WebServer::stop() {
   close();
 }
 
+WiFiClient WebServer::upgradeWebSocket() {
+  if (!_requestUpgrade || !header(UPGRADE_HEADER).equalsIgnoreCase("websocket") || !hasHeader(WEBSOCKET_KEY_HEADER)) {
+    send(400, "text/plain", "WebSocket upgrade expected");
+    return WiFiClient();
+  }
+  String response = "HTTP/1.1 101 Switching Protocols\r\n"
+                    "Upgrade: websocket\r\n"
+                    "Connection: Upgrade\r\n"
+                    "Sec-WebSocket-Accept: ";
+  response += WebSocket::acceptKey(header(WEBSOCKET_KEY_HEADER));
+  response += "\r\n\r\n";
+  _currentClient.write(response.c_str(), response.length());
+  return detachClient();
+}
+
 void WebServer::sendHeader(const String& name, const String& value, bool first) {
   String headerLine = name;
   headerLine += ": ";
@@ -254,6 +453,51 @@ void WebServer::sendHeader(const String& name, const String& value, bool first)
   }
 }
 
+// 200 for the whole file, 206 with the range to send or 416
+int WebServer::_rangeRequest(size_t size, size_t& start, size_t& length) {
+  start = 0;
+  length = size;
+  String range = header(RANGE_HEADER);
+  //several ranges would need a multipart answer, the whole file does too
+  if (!range.startsWith("bytes=") || range.indexOf(',') != -1)
+    return 200;
+  String ifRange = header(IF_RANGE_HEADER);
+  if (ifRange.length() && _responseHeaders.indexOf("ETag: " + ifRange + "\r\n") == -1)
+    return 200;
+  const char* spec = range.c_str() + 6;
+  char* end;
+  if (*spec == '-') {
+    //last bytes
+    size_t suffix = strtoul(spec + 1, &end, 10);
+    if (end == spec + 1 || *end)
+      return 200;
+    if (!suffix || !size)
+      return 416;
+    if (suffix > size)
+      suffix = size;
+    start = size - suffix;
+    length = suffix;
+    return 206;
+  }
+  size_t first = strtoul(spec, &end, 10);
+  if (end == spec || *end != '-')
+    return 200;
+  size_t last = size - 1;
+  if (end[1]) {
+    const char* lastSpec = end + 1;
+    last = strtoul(lastSpec, &end, 10);
+    if (*end || last < first)
+      return 200;
+    if (last > size - 1)
+      last = size - 1;
+  }
+  if (first >= size)
+    return 416;
+  start = first;
+  length = last - first + 1;
+  return 206;
+}
+
 void WebServer::setContentLength(size_t contentLength) {
     _contentLength = contentLength;
 }
@@ -268,18 +512,35 @@ void WebServer::_prepareHeader(String& response, int code, const char* content_t
     if (!content_type)
         content_type = "text/html";
 
-    sendHeader("Content-Type", content_type, true);
-    if (_contentLength == CONTENT_LENGTH_NOT_SET) {
+    //a 304 has no body, the cached copy keeps its own type and length
+    if (code != 304)
+        sendHeader("Content-Type", content_type, true);
+    bool framed = true;
+    if (code == 304) {
+        _bodyLength = 0;
+    } else if (_contentLength == CONTENT_LENGTH_NOT_SET) {
         sendHeader("Content-Length", String(contentLength));
+        _bodyLength = contentLength;
     } else if (_contentLength != CONTENT_LENGTH_UNKNOWN) {
         sendHeader("Content-Length", String(_contentLength));
+        _bodyLength = _contentLength;
     } else if(_contentLength == CONTENT_LENGTH_UNKNOWN && _currentVersion){ //HTTP/1.1 or above client
       //let's do chunked
       _chunked = true;
       sendHeader("Accept-Ranges","none");
       sendHeader("Transfer-Encoding","chunked");
+    } else {
+      //HTTP/1.0 client, the end of the body is the end of the connection
+      framed = false;
+    }
+    _responseKeepAlive = framed && _requestKeepAlive && (_keepAliveCount + 1 < HTTP_MAX_KEEPALIVE_REQUESTS);
+    if (_responseKeepAlive) {
+      sendHeader("Connection", "keep-alive");
+      sendHeader("Keep-Alive", "timeout=" + String(HTTP_KEEPALIVE_TIMEOUT / 1000) + ", max=" + String(HTTP_MAX_KEEPALIVE_REQUESTS - _keepAliveCount - 1));
+    } else {
+      sendHeader("Connection", "close");
     }
-    sendHeader("Connection", "close");
+    _headerSent = true;
 
     response += _responseHeaders;
     response += "\r\n";
@@ -317,7 +578,7 @@ void WebServer::send_P(int code, PGM_P content_type, PGM_P content, size_t conte
     char type[64];
     memccpy_P((void*)type, (PGM_VOID_P)content_type, 0, sizeof(type));
     _prepareHeader(header, code, (const char* )type, contentLength);
-    sendContent(header);
+    _currentClient.write(header.c_str(), header.length());
     sendContent_P(content, contentLength);
 }
 
@@ -330,19 +591,25 @@ void WebServer::send(int code, const String& content_type, const String& content
 }
 
 void WebServer::sendContent(const String& content) {
+  sendContent(content.c_str(), content.length());
+}
+
+void WebServer::sendContent(const char* content, size_t len) {
   const char * footer = "\r\n";
-  size_t len = content.length();
   if(_chunked) {
     char * chunkSize = (char *)malloc(11);
     if(chunkSize){
-      sprintf(chunkSize, "%x%s", len, footer);
+      sprintf(chunkSize, "%x%s", (unsigned)len, footer);
       _currentClient.write(chunkSize, strlen(chunkSize));
       free(chunkSize);
     }
   }
-  _currentClient.write(content.c_str(), len);
+  _currentClient.write(content, len);
+  _bodySent += len;
   if(_chunked){
     _currentClient.write(footer, 2);
+    if (!len)
+      _chunkedEnd = true;
   }
 }
 
@@ -355,21 +622,24 @@ void WebServer::sendContent_P(PGM_P content, size_t size) {
   if(_chunked) {
     char * chunkSize = (char *)malloc(11);
     if(chunkSize){
-      sprintf(chunkSize, "%x%s", size, footer);
+      sprintf(chunkSize, "%x%s", (unsigned)size, footer);
       _currentClient.write(chunkSize, strlen(chunkSize));
       free(chunkSize);
     }
   }
   _currentClient.write_P(content, size);
+  _bodySent += size;
   if(_chunked){
     _currentClient.write(footer, 2);
+    if (!size)
+      _chunkedEnd = true;
   }
 }
 
 
 String WebServer::arg(String name) {
   for (int i = 0; i < _currentArgCount; ++i) {
-    if ( _currentArgs[i].key == name )
+    if (name == _currentArgs[i].key)
       return _currentArgs[i].value;
   }
   return String();
@@ -393,7 +663,7 @@ int WebServer::args() {
 
 bool WebServer::hasArg(String  name) {
   for (int i = 0; i < _currentArgCount; ++i) {
-    if (_currentArgs[i].key == name)
+    if (name == _currentArgs[i].key)
       return true;
   }
   return false;
@@ -409,13 +679,20 @@ String WebServer::header(String name) {
 }
 
 void WebServer::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
-  _headerKeysCount = headerKeysCount + 1;
+  _headerKeysCount = headerKeysCount + BUILTIN_HEADERS_COUNT;
   if (_currentHeaders)
      delete[]_currentHeaders;
-  _currentHeaders = new RequestArgument[_headerKeysCount];
+  _currentHeaders = new RequestHeader[_headerKeysCount];
   _currentHeaders[0].key = AUTHORIZATION_HEADER;
-  for (int i = 1; i < _headerKeysCount; i++){
-    _currentHeaders[i].key = headerKeys[i-1];
+  _currentHeaders[1].key = UPGRADE_HEADER;
+  _currentHeaders[2].key = WEBSOCKET_KEY_HEADER;
+  _currentHeaders[3].key = RANGE_HEADER;
+  _currentHeaders[4].key = IF_RANGE_HEADER;
+  for (int i = BUILTIN_HEADERS_COUNT; i < _headerKeysCount; i++){
+    _currentHeaders[i].key = headerKeys[i-BUILTIN_HEADERS_COUNT];
+  }
+  for (int i = 0; i < _headerKeysCount; i++){
+    _currentHeaders[i].value = "";
   }
 }
 
@@ -437,14 +714,14 @@ int WebServer::headers() {
 
 bool WebServer::hasHeader(String name) {
   for (int i = 0; i < _headerKeysCount; ++i) {
-    if ((_currentHeaders[i].key.equalsIgnoreCase(name)) &&  (_currentHeaders[i].value.length() > 0))
+    if ((_currentHeaders[i].key.equalsIgnoreCase(name)) &&  (_currentHeaders[i].value[0] != 0))
       return true;
   }
   return false;
 }
 
 String WebServer::hostHeader() {
-  return _hostHeader;
+  return String(_hostHeader);
 }
 
 void WebServer::onFileUpload(THandlerFunction fn) {
@@ -519,6 +796,7 @@ String WebServer::_responseCodeToString(int code) {
     case 415: return F("Unsupported Media Type");
     case 416: return F("Requested range not satisfiable");
     case 417: return F("Expectation Failed");
+    case 431: return F("Request Header Fields Too Large");
     case 500: return F("Internal Server Error");
     case 501: return F("Not Implemented");
     case 502: return F("Bad Gateway");
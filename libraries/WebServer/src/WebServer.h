@@ -1,6 +1,6 @@
 /*
   WebServer.h - Dead simple web-server.
-  Supports only one simultaneous client, knows how to handle GET and POST.
+  Serves a few simultaneous clients, knows how to handle GET and POST.
 
   Copyright (c) 2014 Ivan Grokhotkov. All rights reserved.
 
@@ -44,11 +44,33 @@ enum HTTPClientStatus { HC_NONE, HC_WAIT_READ, HC_WAIT_CLOSE };
 #define HTTP_UPLOAD_BUFLEN 2048
 #endif
 
+#ifndef HTTP_HEAD_BUFLEN
+#define HTTP_HEAD_BUFLEN 1024 //request line and headers must fit, small bodies are kept too
+#endif
+
+#ifndef HTTP_MAX_BODY_SIZE
+#define HTTP_MAX_BODY_SIZE 4096 //largest body kept in RAM, multipart ones are streamed, above it 413 is sent
+#endif
+
+#define HTTP_MAX_ARGS 32
+
 #define HTTP_MAX_DATA_WAIT 1000 //ms to wait for the client to send the request
 #define HTTP_MAX_POST_WAIT 1000 //ms to wait for POST data to arrive
 #define HTTP_MAX_SEND_WAIT 5000 //ms to wait for data chunk to be ACKed
 #define HTTP_MAX_CLOSE_WAIT 2000 //ms to wait for the client to close the connection
 
+#ifndef HTTP_KEEPALIVE_TIMEOUT
+#define HTTP_KEEPALIVE_TIMEOUT 2000 //ms to wait for the next request on a persistent connection
+#endif
+
+#ifndef HTTP_MAX_CLIENTS
+#define HTTP_MAX_CLIENTS 4 //connections held at once, one waiting client does not block the others
+#endif
+
+#ifndef HTTP_MAX_KEEPALIVE_REQUESTS
+#define HTTP_MAX_KEEPALIVE_REQUESTS 32 //requests served before a persistent connection is closed
+#endif
+
 #define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
 #define CONTENT_LENGTH_NOT_SET ((size_t) -2)
 
@@ -64,6 +86,16 @@ typedef struct {
   uint8_t buf[HTTP_UPLOAD_BUFLEN];
 } HTTPUpload;
 
+// one connection of the pool, requests are still handled one at a time
+typedef struct {
+  WiFiClient       client;
+  HTTPClientStatus status;
+  unsigned long    statusChange;
+  uint8_t          keepAliveCount;
+  uint16_t         received;
+  char             buf[HTTP_HEAD_BUFLEN]; // request as received, parsed in place
+} HTTPClientSlot;
+
 #include "detail/RequestHandler.h"
 
 namespace fs {
@@ -98,6 +130,12 @@ public:
   String uri() { return _currentUri; }
   HTTPMethod method() { return _currentMethod; }
   WiFiClient client() { return _currentClient; }
+  // hand the connection over to the caller, the server forgets it once the
+  // handler returns and the caller is responsible for answering and closing
+  WiFiClient detachClient() { _clientDetached = true; return _currentClient; }
+  // answer a WebSocket handshake and detach the connection, a 400 is sent
+  // and an unconnected client returned if the request is not an upgrade
+  WiFiClient upgradeWebSocket();
   HTTPUpload& upload() { return _currentUpload; }
 
   String arg(String name);        // get request argument value by name
@@ -127,41 +165,53 @@ public:
   void setContentLength(size_t contentLength);
   void sendHeader(const String& name, const String& value, bool first = false);
   void sendContent(const String& content);
+  void sendContent(const char* content, size_t size);
   void sendContent_P(PGM_P content);
   void sendContent_P(PGM_P content, size_t size);
 
   static String urlDecode(const String& text);
 
-#ifdef ESP8266
-template<typename T> size_t streamFile(T &file, const String& contentType){
-  setContentLength(file.size());
-  if (String(file.name()).endsWith(".gz") &&
-      contentType != "application/x-gzip" &&
-      contentType != "application/octet-stream"){
-    sendHeader("Content-Encoding", "gzip");
-  }
-  send(200, contentType, "");
-  return _currentClient.write(file);
-}
-#else
+// a single byte range is honoured with a 206, If-Range only matches the
+// ETag set by the caller with sendHeader() before
 template<typename T> size_t streamFile(T &file, const String& contentType){
 #define STREAMFILE_BUFSIZE 2*1460
-  setContentLength(file.size());
+  size_t start, length;
+  int code = _rangeRequest(file.size(), start, length);
+  if (code == 416) {
+    sendHeader("Content-Range", "bytes */" + String(file.size()));
+    send(416);
+    return 0;
+  }
+  if (code == 206) {
+    sendHeader("Content-Range", "bytes " + String(start) + "-" + String(start + length - 1) + "/" + String(file.size()));
+    file.seek(start);
+  }
+  sendHeader("Accept-Ranges", "bytes");
+  setContentLength(length);
   if (String(file.name()).endsWith(".gz") &&
       contentType != "application/x-gzip" &&
       contentType != "application/octet-stream") {
     sendHeader("Content-Encoding", "gzip");
   }
-  send(200, contentType, "");
+  send(code, contentType, "");
+#ifdef ESP8266
+  if (code == 200) {
+    size_t sent = _currentClient.write(file);
+    _bodySent += sent;
+    return sent;
+  }
+#endif
   uint8_t *buf = (uint8_t *)malloc(STREAMFILE_BUFSIZE);
   if (buf == NULL) {
     //DBG_OUTPUT_PORT.printf("streamFile malloc failed");
     return 0;
   }
   size_t totalBytesOut = 0;
-  while (client().connected() && (file.available() > 0)) {
+  while (client().connected() && (file.available() > 0) && (totalBytesOut < length)) {
     int bytesOut;
-    int bytesIn = file.read(buf, STREAMFILE_BUFSIZE);
+    size_t toRead = length - totalBytesOut;
+    if (toRead > STREAMFILE_BUFSIZE) toRead = STREAMFILE_BUFSIZE;
+    int bytesIn = file.read(buf, toRead);
     if (bytesIn <= 0) break;
     while (1) {
       bytesOut = 0;
@@ -176,31 +226,52 @@ template<typename T> size_t streamFile(T &file, const String& contentType){
     totalBytesOut += bytesOut;
     yield();
   }
-  if (totalBytesOut != file.size()) {
+  _bodySent += totalBytesOut;
+  if (totalBytesOut != length) {
     //DBG_OUTPUT_PORT.printf("file size %d bytes out %d\r\n",
     //    file.size(), totalBytesOut);
   }
   free(buf);
   return totalBytesOut;
 }
-#endif
 
 protected:
   void _addRequestHandler(RequestHandler* handler);
+  void _addRoute(const String& uri, RequestHandler* handler);
+  RequestHandler* _findHandler(HTTPMethod method, const String& uri);
   void _handleRequest();
-  bool _parseRequest(WiFiClient& client);
-  void _parseArguments(String data);
+  size_t _requestReady(HTTPClientSlot& slot);
+  bool _parseRequest(WiFiClient& client, char* buf, size_t headLen, size_t received);
+  void _parseArguments(char* data);
+  void _addArgument(const char* key, const char* value);
+  void _resetRequest();
+  static char* _urlDecodeInPlace(char* text);
+  size_t _bodyReadBytes(WiFiClient& client, uint8_t* buf, size_t len);
+  String _bodyReadLine(WiFiClient& client);
   static String _responseCodeToString(int code);
   bool _parseForm(WiFiClient& client, String boundary, uint32_t len);
   bool _parseFormUploadAborted();
-  void _uploadWriteByte(uint8_t b);
-  uint8_t _uploadReadByte(WiFiClient& client);
+  size_t _bodyReadSome(WiFiClient& client, uint8_t* buf, size_t len);
+  bool _uploadFile(WiFiClient& client, const String& boundary);
+  void _uploadData(size_t len);
   void _prepareHeader(String& response, int code, const char* content_type, size_t contentLength);
   bool _collectHeader(const char* headerName, const char* headerValue);
-
+  bool _responseComplete();
+  HTTPClientSlot* _freeSlot();
+  bool _handleSlot(HTTPClientSlot& slot);
+  void _releaseSlot(HTTPClientSlot& slot);
+  static bool _parseConnectionHeader(const char* value, bool keepAlive);
+  int _rangeRequest(size_t size, size_t& start, size_t& length);
+
+  // slices of the request buffer, or of _formStrings for multipart fields
   struct RequestArgument {
+    const char* key;
+    const char* value;
+  };
+
+  struct RequestHeader {
     String key;
-    String value;
+    const char* value;
   };
 
   WiFiServer  _server;
@@ -209,26 +280,54 @@ protected:
   HTTPMethod  _currentMethod;
   String      _currentUri;
   uint8_t     _currentVersion;
-  HTTPClientStatus _currentStatus;
-  unsigned long _statusChange;
+  HTTPClientSlot _slots[HTTP_MAX_CLIENTS];
+  uint8_t     _nextSlot;
+
+  // routes added with on() are kept sorted by a hash of their uri and
+  // found by binary search, handlers added with addHandler() or
+  // serveStatic() may match several uris and are tried after, in order
+  struct Route {
+    uint32_t hash;
+    RequestHandler* handler;
+  };
 
   RequestHandler*  _currentHandler;
   RequestHandler*  _firstHandler;
   RequestHandler*  _lastHandler;
+  Route*           _routes;
+  uint8_t          _routeCount;
   THandlerFunction _notFoundHandler;
   THandlerFunction _fileUploadHandler;
 
   int              _currentArgCount;
-  RequestArgument* _currentArgs;
+  RequestArgument  _currentArgs[HTTP_MAX_ARGS];
   HTTPUpload       _currentUpload;
 
+  // body bytes received with the head, read before the client
+  const char*      _pending;
+  size_t           _pendingLen;
+  char*            _bodyBuf;
+  String*          _formStrings;
+
   int              _headerKeysCount;
-  RequestArgument* _currentHeaders;
+  RequestHeader*   _currentHeaders;
   size_t           _contentLength;
   String           _responseHeaders;
 
-  String           _hostHeader;
+  const char*      _hostHeader;
   bool             _chunked;
+  bool             _clientDetached;
+
+  // persistent connection state, a connection is only kept open when the
+  // response was framed by the server and fully sent
+  bool             _requestKeepAlive;
+  bool             _requestUpgrade;
+  bool             _responseKeepAlive;
+  uint8_t          _keepAliveCount;
+  bool             _headerSent;
+  size_t           _bodyLength;
+  size_t           _bodySent;
+  bool             _chunkedEnd;
 
 };
 
@@ -0,0 +1,265 @@
+/*
+  WebSocket.cpp - WebSocket framing (RFC 6455) over a connection upgraded
+  by the web server.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <Arduino.h>
+#include <libb64/cencode.h>
+#include "WiFiClient.h"
+#include "WebSocket.h"
+
+static const char WS_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static inline uint32_t _rol(uint32_t value, uint8_t bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+// only used once per handshake, so small rather than fast
+static void _sha1(const uint8_t* data, size_t len, uint8_t digest[20]) {
+  uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+  uint8_t block[64];
+  uint32_t w[16];
+  uint64_t bits = (uint64_t)len * 8;
+  size_t total = ((len + 8) / 64 + 1) * 64;
+  for (size_t offset = 0; offset < total; offset += 64) {
+    for (size_t i = 0; i < 64; i++) {
+      size_t pos = offset + i;
+      if (pos < len)
+        block[i] = data[pos];
+      else if (pos == len)
+        block[i] = 0x80;
+      else if (pos >= total - 8)
+        block[i] = (uint8_t)(bits >> ((total - 1 - pos) * 8));
+      else
+        block[i] = 0;
+    }
+    for (int i = 0; i < 16; i++) {
+      w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+             ((uint32_t)block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+      if (i >= 16) {
+        w[i & 15] = _rol(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15], 1);
+      }
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      uint32_t t = _rol(a, 5) + f + e + k + w[i & 15];
+      e = d;
+      d = c;
+      c = _rol(b, 30);
+      b = a;
+      a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+  for (int i = 0; i < 20; i++) {
+    digest[i] = (uint8_t)(h[i / 4] >> (24 - (i % 4) * 8));
+  }
+}
+
+String WebSocket::acceptKey(const String& key) {
+  String text = key;
+  text.trim();
+  text += WS_GUID;
+  uint8_t digest[20];
+  _sha1((const uint8_t*)text.c_str(), text.length(), digest);
+  char encoded[base64_encode_expected_len(20) + 1];
+  int len = base64_encode_chars((const char*)digest, 20, encoded);
+  encoded[len] = 0;
+  return String(encoded);
+}
+
+WebSocket::WebSocket()
+: _attached(false)
+, _state(WS_STATE_HEADER)
+, _opcode(0)
+, _headerLen(0)
+, _headerNeed(2)
+, _remaining(0)
+, _maskIndex(0)
+, _controlLen(0)
+{
+}
+
+void WebSocket::attach(WiFiClient client) {
+  _client = client;
+  _client.setNoDelay(true);
+  _attached = true;
+  _state = WS_STATE_HEADER;
+  _headerLen = 0;
+  _headerNeed = 2;
+  _remaining = 0;
+}
+
+bool WebSocket::connected() {
+  if (!_attached)
+    return false;
+  if (!_client.connected()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void WebSocket::close() {
+  if (!_attached)
+    return;
+  _client.stop();
+  _client = WiFiClient();
+  _attached = false;
+}
+
+bool WebSocket::_readHeader() {
+  while (_headerLen < _headerNeed) {
+    if (!_client.available())
+      return false;
+    _header[_headerLen++] = _client.read();
+    if (_headerLen == 2) {
+      uint8_t len = _header[1] & 0x7F;
+      _headerNeed = 2 + (len == 126 ? 2 : (len == 127 ? 8 : 0)) + ((_header[1] & 0x80) ? 4 : 0);
+    }
+  }
+  uint8_t pos = 2;
+  uint64_t len = _header[1] & 0x7F;
+  if (len == 126) {
+    len = ((uint16_t)_header[2] << 8) | _header[3];
+    pos = 4;
+  } else if (len == 127) {
+    len = 0;
+    for (; pos < 10; pos++)
+      len = (len << 8) | _header[pos];
+  }
+  _opcode = _header[0] & 0x0F;
+  _headerLen = 0;
+  _headerNeed = 2;
+  // frames from a client must be masked, a control frame must fit in one
+  if (!(_header[1] & 0x80) || len > 0xFFFFFFFF ||
+      ((_opcode & 0x08) && len > WS_MAX_CONTROL_PAYLOAD)) {
+    close();
+    return false;
+  }
+  memcpy(_mask, _header + pos, 4);
+  _maskIndex = 0;
+  _remaining = (uint32_t)len;
+  if (_opcode & 0x08) {
+    _controlLen = 0;
+    _state = WS_STATE_CONTROL;
+  } else {
+    _state = WS_STATE_PAYLOAD;
+  }
+  return true;
+}
+
+void WebSocket::_handleControl() {
+  switch (_opcode) {
+    case WS_PING:
+      sendFrame(_control, _controlLen, WS_PONG);
+      break;
+    case WS_CLOSE:
+      // echo the status code then drop the connection
+      sendFrame(_control, _controlLen < 2 ? _controlLen : 2, WS_CLOSE);
+      close();
+      break;
+    default:
+      break;
+  }
+}
+
+size_t WebSocket::read(uint8_t* buf, size_t len) {
+  size_t done = 0;
+  while (_attached && done < len) {
+    if (_state == WS_STATE_HEADER) {
+      if (!_readHeader())
+        break;
+      continue;
+    }
+    if (_remaining > 0) {
+      size_t avail = _client.available();
+      if (!avail)
+        break;
+      uint8_t* dst = (_state == WS_STATE_CONTROL) ? _control + _controlLen : buf + done;
+      size_t n = (_state == WS_STATE_CONTROL) ? _remaining : len - done;
+      if (n > _remaining)
+        n = _remaining;
+      if (n > avail)
+        n = avail;
+      int got = _client.read(dst, n);
+      if (got <= 0)
+        break;
+      for (int i = 0; i < got; i++) {
+        dst[i] ^= _mask[_maskIndex];
+        _maskIndex = (_maskIndex + 1) & 3;
+      }
+      _remaining -= got;
+      if (_state == WS_STATE_CONTROL)
+        _controlLen += got;
+      else
+        done += got;
+    }
+    if (_remaining == 0) {
+      if (_state == WS_STATE_CONTROL)
+        _handleControl();
+      _state = WS_STATE_HEADER;
+    }
+  }
+  return done;
+}
+
+size_t WebSocket::sendFrame(const uint8_t* data, size_t len, WSOpcode opcode) {
+  if (!_attached)
+    return 0;
+  uint8_t header[10];
+  uint8_t headerLen = 2;
+  header[0] = 0x80 | opcode;
+  if (len < 126) {
+    header[1] = len;
+  } else if (len < 65536) {
+    header[1] = 126;
+    header[2] = len >> 8;
+    header[3] = len & 0xFF;
+    headerLen = 4;
+  } else {
+    header[1] = 127;
+    for (uint8_t i = 0; i < 8; i++)
+      header[9 - i] = (uint8_t)((uint64_t)len >> (i * 8));
+    headerLen = 10;
+  }
+  // a frame cut short leaves the peer reading the next one as payload,
+  // the connection cannot be used any further
+  if (_client.write(header, headerLen) != headerLen || (len && _client.write(data, len) != len)) {
+    close();
+    return 0;
+  }
+  return len;
+}
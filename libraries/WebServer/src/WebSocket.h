@@ -0,0 +1,76 @@
+/*
+  WebSocket.h - WebSocket framing (RFC 6455) over a connection upgraded
+  by the web server.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <Arduino.h>
+#include "WiFiClient.h"
+
+enum WSOpcode { WS_CONTINUATION = 0x0, WS_TEXT = 0x1, WS_BINARY = 0x2,
+                WS_CLOSE = 0x8, WS_PING = 0x9, WS_PONG = 0xA };
+
+#define WS_MAX_CONTROL_PAYLOAD 125
+
+// One connection, obtained from WebServer::upgradeWebSocket().
+// Data frames are handed to the caller as a plain byte stream, the payload
+// is read straight into the caller buffer and unmasked there. Ping and
+// close frames are answered internally. A frame is sent by a single call,
+// nothing can be written in the middle of it, and a short write closes the
+// connection.
+class WebSocket
+{
+public:
+  WebSocket();
+
+  void attach(WiFiClient client);
+  bool connected();
+  void close();
+
+  // payload bytes of received data frames, 0 if nothing is available
+  size_t read(uint8_t* buf, size_t len);
+
+  // payload bytes sent, 0 if the connection was closed
+  size_t sendFrame(const uint8_t* data, size_t len, WSOpcode opcode = WS_BINARY);
+
+  // value of Sec-WebSocket-Accept for a Sec-WebSocket-Key
+  static String acceptKey(const String& key);
+
+protected:
+  enum State { WS_STATE_HEADER, WS_STATE_PAYLOAD, WS_STATE_CONTROL };
+
+  bool _readHeader();
+  void _handleControl();
+
+  WiFiClient _client;
+  bool       _attached;
+  uint8_t    _state;
+  uint8_t    _opcode;
+  uint8_t    _header[14];
+  uint8_t    _headerLen;
+  uint8_t    _headerNeed;
+  uint32_t   _remaining;
+  uint8_t    _mask[4];
+  uint8_t    _maskIndex;
+  uint8_t    _control[WS_MAX_CONTROL_PAYLOAD];
+  uint8_t    _controlLen;
+};
+
+#endif //WEBSOCKET_H
@@ -0,0 +1,51 @@
+/*
+  tests/test.h - checks of the host tests. A test program runs its checks
+  from main() and returns TEST_RESULT(), ctest reports it failed when a
+  check did not hold.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+inline int &test_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_failures()++; \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(expected, actual) do { \
+        if (!((expected) == (actual))) { \
+            printf("%s:%d: CHECK_EQUAL(%s, %s) failed\n", __FILE__, __LINE__, #expected, #actual); \
+            test_failures()++; \
+        } \
+    } while (0)
+
+#define TEST_RESULT() (printf("%s: %d failure(s)\n", __FILE__, test_failures()), test_failures() ? 1 : 0)
+
+// fresh directory for eeprom.bin and spiffs/, left in place for a look
+// after a failure
+inline std::string test_dataDir(const char *name)
+{
+    std::string dir = std::string("/tmp/esp3d_test_") + name + "_" + std::to_string(getpid());
+    std::string command = "rm -rf " + dir;
+    if (system(command.c_str()) != 0) {
+        printf("cannot clear %s\n", dir.c_str());
+    }
+    return dir;
+}
@@ -0,0 +1,196 @@
+/*
+  tests/test_containers.cpp - the fixed capacity containers keep their
+  items in order and refuse what does not fit, the session table of the
+  web interface is built on them.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "test.h"
+
+#include <vector>
+
+#include "config.h"
+#include "containers.h"
+#include "webinterface.h"
+
+struct Item
+{
+    int value = 0;
+    Item *_next = nullptr;
+};
+
+// counts the live objects of an ObjectPool
+struct Counted
+{
+    static int alive;
+    int value = 7;
+    Counted()
+    {
+        alive++;
+    }
+    ~Counted()
+    {
+        alive--;
+    }
+};
+int Counted::alive = 0;
+
+static void testStaticVector()
+{
+    StaticVector<int, 4> v;
+    CHECK_EQUAL(4u, v.capacity());
+    CHECK(v.isEmpty());
+    for (int i = 0; i < 4; i++) {
+        CHECK(v.push(i * 10));
+    }
+    CHECK(v.isFull());
+    CHECK(!v.push(40));
+    CHECK_EQUAL(4u, v.size());
+
+    v.erase(1);
+    CHECK_EQUAL(3u, v.size());
+    CHECK_EQUAL(0, v[0]);
+    CHECK_EQUAL(20, v[1]);
+    CHECK_EQUAL(30, v[2]);
+    v.erase(2);
+    int sum = 0;
+    for (int x : v) {
+        sum += x;
+    }
+    CHECK_EQUAL(20, sum);
+    v.clear();
+    CHECK(v.isEmpty() && v.begin() == v.end());
+}
+
+static void testIntrusiveList()
+{
+    Item items[4];
+    IntrusiveList<Item> list;
+    CHECK(list.first() == nullptr);
+    CHECK(list.pop() == nullptr);
+    for (int i = 0; i < 4; i++) {
+        items[i].value = i;
+        list.push(&items[i]);
+    }
+    CHECK_EQUAL(4u, list.size());
+    // last pushed comes first
+    CHECK(list.first() == &items[3]);
+
+    // unlink while walking: drop the odd values
+    Item *previous = nullptr;
+    Item *current = list.first();
+    while (current) {
+        if (current->value % 2) {
+            current = list.unlink(previous, current);
+        } else {
+            previous = current;
+            current = current->_next;
+        }
+    }
+    CHECK_EQUAL(2u, list.size());
+    CHECK(list.first() == &items[2]);
+    CHECK(items[2]._next == &items[0]);
+    CHECK(items[3]._next == nullptr);
+
+    CHECK(list.pop() == &items[2]);
+    CHECK(list.pop() == &items[0]);
+    CHECK(list.pop() == nullptr);
+    CHECK_EQUAL(0u, list.size());
+}
+
+static void testObjectPool()
+{
+    ObjectPool<Counted, 3> pool;
+    CHECK_EQUAL(3u, pool.capacity());
+    CHECK_EQUAL(0, Counted::alive);
+    Counted *a = pool.acquire();
+    Counted *b = pool.acquire();
+    Counted *c = pool.acquire();
+    CHECK(a && b && c && a != b && b != c && a != c);
+    CHECK_EQUAL(3, Counted::alive);
+    CHECK_EQUAL(7, b->value);
+    CHECK(pool.acquire() == nullptr);
+    CHECK_EQUAL(3u, pool.used());
+
+    b->value = 1;
+    pool.release(b);
+    CHECK_EQUAL(2, Counted::alive);
+    CHECK_EQUAL(2u, pool.used());
+    // the slot is reused and the object built again
+    Counted *d = pool.acquire();
+    CHECK(d == b);
+    CHECK_EQUAL(7, d->value);
+    pool.release(a);
+    pool.release(c);
+    pool.release(d);
+    CHECK_EQUAL(0u, pool.used());
+    CHECK_EQUAL(0, Counted::alive);
+
+    // churn in any order
+    std::vector<Counted *> taken;
+    srand(2);
+    for (int i = 0; i < 10000; i++) {
+        if (!taken.empty() && (rand() % 2 || taken.size() == 3)) {
+            size_t pos = rand() % taken.size();
+            pool.release(taken[pos]);
+            taken.erase(taken.begin() + pos);
+        } else {
+            Counted *item = pool.acquire();
+            CHECK(item != nullptr);
+            taken.push_back(item);
+        }
+        if (pool.used() != taken.size() || Counted::alive != (int)taken.size()) {
+            CHECK(false);
+            break;
+        }
+    }
+}
+
+// the session table of the web interface, a pool and a list of auth_ip
+static void testSessions()
+{
+    ObjectPool<auth_ip, MAX_AUTH_IP> pool;
+    IntrusiveList<auth_ip> sessions;
+    for (int i = 0; i < MAX_AUTH_IP; i++) {
+        auth_ip *session = pool.acquire();
+        CHECK(session != nullptr);
+        session->ip = IPAddress(192, 168, 0, i);
+        snprintf(session->sessionID, sizeof(session->sessionID), "%016X", i);
+        sessions.push(session);
+    }
+    // one more login than MAX_AUTH_IP is refused
+    CHECK(pool.acquire() == nullptr);
+
+    // a logout frees its slot for the next login
+    auth_ip *previous = nullptr;
+    for (auth_ip *current = sessions.first(); current; previous = current, current = current->_next) {
+        if (current->ip == IPAddress(192, 168, 0, 4)) {
+            sessions.unlink(previous, current);
+            pool.release(current);
+            break;
+        }
+    }
+    CHECK_EQUAL((size_t)MAX_AUTH_IP - 1, sessions.size());
+    auth_ip *session = pool.acquire();
+    CHECK(session != nullptr);
+    sessions.push(session);
+    CHECK_EQUAL((size_t)MAX_AUTH_IP, pool.used());
+    while ((session = sessions.pop())) {
+        pool.release(session);
+    }
+    CHECK_EQUAL(0u, pool.used());
+}
+
+
+int main()
+{
+    testStaticVector();
+    testIntrusiveList();
+    testObjectPool();
+    testSessions();
+    return TEST_RESULT();
+}
@@ -0,0 +1,172 @@
+/*
+  tests/test_host.cpp - the shims of host/ behave like the ESP8266 core
+  where the sketch depends on it.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "test.h"
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <FS.h>
+#include <WiFiClient.h>
+#include <WiFiServer.h>
+
+
+static void testString()
+{
+    String s(F("abc"));
+    s += 12;
+    s += '-';
+    s += 3000000000UL;
+    CHECK(s == "abc12-3000000000");
+    CHECK_EQUAL(String("x") + -5 + "y", String("x-5y"));
+    CHECK(String(255, HEX) == "ff");
+    CHECK(String(1.5, 1) == "1.5");
+
+    String t("  hello world \r\n");
+    t.trim();
+    CHECK(t == "hello world");
+    CHECK_EQUAL(6, t.indexOf("world"));
+    CHECK_EQUAL(-1, t.indexOf("World"));
+    CHECK_EQUAL(9, t.lastIndexOf('l'));
+    CHECK(t.substring(6) == "world");
+    CHECK(t.substring(6, 100) == "world");
+    CHECK(t.substring(100) == "");
+    CHECK(t.startsWith("hello") && t.endsWith("world") && !t.endsWith("hello world!"));
+    CHECK(t.equalsIgnoreCase("HELLO WORLD"));
+
+    t.replace("o", "00");
+    CHECK(t == "hell00 w00rld");
+    t.remove(4, 2);
+    CHECK(t == "hell w00rld");
+    t.remove(4);
+    CHECK(t == "hell");
+    t.toUpperCase();
+    CHECK(t == "HELL");
+    CHECK_EQUAL(-42L, String("-42abc").toInt());
+    CHECK_EQUAL('\0', t.charAt(10));
+
+    char buf[4];
+    String("abcdef").toCharArray(buf, sizeof(buf));
+    CHECK(strcmp(buf, "abc") == 0);
+}
+
+static void testFS()
+{
+    CHECK(!SPIFFS.open("/a.txt", "w"));
+    CHECK(SPIFFS.begin());
+
+    File f = SPIFFS.open("/a.txt", "w");
+    CHECK(f);
+    f.println("hello");
+    f.close();
+    f = SPIFFS.open("/dir/b.txt", "a");
+    f.write((const uint8_t *)"12345678", 8);
+    f.close();
+
+    CHECK(SPIFFS.exists("/a.txt"));
+    CHECK(!SPIFFS.exists("/dir"));
+    CHECK(SPIFFS.exists("/dir/b.txt"));
+    // SPIFFS_OBJ_NAME_LEN
+    CHECK(!SPIFFS.open("/0123456789012345678901234567890", "w"));
+
+    f = SPIFFS.open("/a.txt", "r");
+    CHECK_EQUAL(7u, f.size());
+    CHECK(strcmp(f.name(), "/a.txt") == 0);
+    CHECK(f.readStringUntil('\n') == "hello\r");
+    CHECK_EQUAL(0, f.available());
+    CHECK(f.seek(1, fs::SeekSet));
+    CHECK_EQUAL('e', f.read());
+    f.close();
+
+    Dir dir = SPIFFS.openDir("/");
+    CHECK(dir.next() && dir.fileName() == "/a.txt" && dir.fileSize() == 7);
+    CHECK(dir.next() && dir.fileName() == "/dir/b.txt" && dir.fileSize() == 8);
+    CHECK(!dir.next());
+    dir = SPIFFS.openDir("/dir");
+    CHECK(dir.next() && dir.fileName() == "/dir/b.txt");
+    CHECK(!dir.next());
+
+    CHECK(SPIFFS.rename("/dir/b.txt", "/c.txt"));
+    CHECK(!SPIFFS.rename("/c.txt", "/a.txt"));
+    CHECK(SPIFFS.remove("/c.txt"));
+    CHECK(!SPIFFS.remove("/c.txt"));
+    CHECK(SPIFFS.usedBytes() == 256);
+    CHECK(SPIFFS.format());
+    CHECK(!SPIFFS.openDir("/").next());
+}
+
+static void testEEPROM()
+{
+    EEPROM.begin(1024);
+    // erased flash
+    CHECK_EQUAL(0xff, EEPROM.read(10));
+    EEPROM.write(10, 0x42);
+    CHECK(EEPROM.commit());
+    CHECK_EQUAL(1u, EEPROM.eraseCount());
+    // nothing changed, nothing erased
+    EEPROM.write(10, 0x42);
+    CHECK(EEPROM.commit());
+    CHECK_EQUAL(1u, EEPROM.eraseCount());
+    EEPROM.end();
+
+    EEPROM.begin(1024);
+    CHECK_EQUAL(0x42, EEPROM.read(10));
+    EEPROM.end();
+}
+
+static void testSockets()
+{
+    WiFiServer server(0);
+    server.begin();
+    CHECK(server.localPort() != 0);
+
+    WiFiClient client;
+    CHECK(client.connect(IPAddress(127, 0, 0, 1), server.localPort()));
+    unsigned long start = millis();
+    while (!server.hasClient() && millis() - start < 1000) {
+        delay(1);
+    }
+    WiFiClient accepted = server.available();
+    CHECK(accepted.connected());
+    CHECK(accepted.availableForWrite() > 0);
+
+    CHECK_EQUAL(5u, client.write((const uint8_t *)"hello", 5));
+    start = millis();
+    while (accepted.available() < 5 && millis() - start < 1000) {
+        delay(1);
+    }
+    uint8_t buf[8];
+    CHECK_EQUAL(5, accepted.read(buf, sizeof(buf)));
+    CHECK(memcmp(buf, "hello", 5) == 0);
+    CHECK_EQUAL(0, accepted.read(buf, sizeof(buf)));
+    CHECK_EQUAL(-1, accepted.read());
+
+    // copies share the connection
+    WiFiClient copy = accepted;
+    copy.print("bye");
+    client.stop();
+    start = millis();
+    while (accepted.connected() && millis() - start < 1000) {
+        delay(1);
+    }
+    CHECK(!accepted.connected());
+    accepted.stop();
+    CHECK(!copy.connected());
+}
+
+
+int main()
+{
+    host_setDataDir(test_dataDir("host"));
+    testString();
+    testFS();
+    testEEPROM();
+    testSockets();
+    return TEST_RESULT();
+}
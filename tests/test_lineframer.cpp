@@ -0,0 +1,141 @@
+/*
+  tests/test_lineframer.cpp - LineFramer splits the serial and TCP streams
+  into lines however the bytes are cut, and keeps to its buffer.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "test.h"
+
+#include <string>
+#include <vector>
+
+#include "lineframer.h"
+
+static std::vector<std::string> lines;
+
+static void onLine(const char *line, size_t len)
+{
+    // the view is NUL terminated at len
+    CHECK_EQUAL(len, strlen(line));
+    lines.push_back(std::string(line, len));
+}
+
+template<size_t N>
+static void feed(LineFramer<N> &framer, const char *text)
+{
+    framer.feed((const uint8_t *)text, strlen(text));
+}
+
+static void testEndOfLine()
+{
+    LineFramer<16> framer(onLine);
+    lines.clear();
+    feed(framer, "ok\nwait\rT:20 /0\r\n\r\n\n");
+    CHECK_EQUAL(3u, lines.size());
+    CHECK(lines[0] == "ok");
+    CHECK(lines[1] == "wait");
+    CHECK(lines[2] == "T:20 /0");
+}
+
+// the UART and TCP reads cut the stream anywhere, even between CR and LF
+static void testSplitReads()
+{
+    const char *text = "ok T:210.0 /210.0\r\necho:busy: processing\r\nok\r\n";
+    std::vector<std::string> whole;
+    {
+        LineFramer<64> framer(onLine);
+        lines.clear();
+        feed(framer, text);
+        whole = lines;
+    }
+    CHECK_EQUAL(3u, whole.size());
+    for (size_t cut = 1; cut < strlen(text); cut++) {
+        LineFramer<64> framer(onLine);
+        lines.clear();
+        framer.feed((const uint8_t *)text, cut);
+        framer.feed((const uint8_t *)text + cut, strlen(text) - cut);
+        CHECK(lines == whole);
+    }
+    // a byte at a time
+    LineFramer<64> framer(onLine);
+    lines.clear();
+    for (const char *p = text; *p; p++) {
+        framer.feed((uint8_t)*p);
+    }
+    CHECK(lines == whole);
+}
+
+static void testFullBuffer()
+{
+    // exactly N characters fit
+    LineFramer<8> framer(onLine);
+    lines.clear();
+    feed(framer, "01234567\n");
+    CHECK_EQUAL(1u, lines.size());
+    CHECK(lines[0] == "01234567");
+    // a full buffer does not leak into the next line
+    feed(framer, "ab\n");
+    CHECK_EQUAL(2u, lines.size());
+    CHECK(lines[1] == "ab");
+}
+
+static void testOverlongLines()
+{
+    LineFramer<8> truncate(onLine, 1, LineOverflow_Truncate);
+    lines.clear();
+    feed(truncate, "0123456789ABCDEF\nok\n");
+    CHECK_EQUAL(2u, lines.size());
+    CHECK(lines[0] == "01234567");
+    CHECK(lines[1] == "ok");
+
+    LineFramer<8> discard(onLine, 1, LineOverflow_Discard);
+    lines.clear();
+    feed(discard, "0123456789ABCDEF\nok\n012345678\r\n01234567\n");
+    CHECK_EQUAL(2u, lines.size());
+    CHECK(lines[0] == "ok");
+    CHECK(lines[1] == "01234567");
+}
+
+static void testCommentsAndNoise()
+{
+    LineFramer<32> framer(onLine);
+    lines.clear();
+    feed(framer, "G1 X10 ; move\nG28;home\n; only a comment\n");
+    CHECK_EQUAL(2u, lines.size());
+    CHECK(lines[0] == "G1 X10 ");
+    CHECK(lines[1] == "G28");
+
+    // a non printable byte restarts the line
+    lines.clear();
+    const uint8_t noisy[] = { 'o', 'k', 0x01, 'o', 'k', ' ', '1', '\n', 0xFF, 0x00, 'w', 'a', 'i', 't', '\n' };
+    framer.feed(noisy, sizeof(noisy));
+    CHECK_EQUAL(2u, lines.size());
+    CHECK(lines[0] == "ok 1");
+    CHECK(lines[1] == "wait");
+}
+
+static void testMinLength()
+{
+    LineFramer<32> framer(onLine, 4);
+    lines.clear();
+    feed(framer, "ok\nM105\nG28\n[ESP800]\n");
+    CHECK_EQUAL(2u, lines.size());
+    CHECK(lines[0] == "M105");
+    CHECK(lines[1] == "[ESP800]");
+}
+
+
+int main()
+{
+    testEndOfLine();
+    testSplitReads();
+    testFullBuffer();
+    testOverlongLines();
+    testCommentsAndNoise();
+    testMinLength();
+    return TEST_RESULT();
+}
@@ -0,0 +1,356 @@
+/*
+  tests/test_printersimulator.cpp - the simulated printer speaks the
+  dialects the sketch expects, and SdUploader saves files on it.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "test.h"
+
+#include <vector>
+
+#include <Arduino.h>
+#include <PrinterSimulator.h>
+#include "config.h"
+#include "responseclassifier.h"
+#include "sdupload.h"
+
+static_assert(PrinterSimulator::Firmware_Repetier4DV == REPETIER4DV, "firmware ids of config.h");
+static_assert(PrinterSimulator::Firmware_Marlin == MARLIN, "firmware ids of config.h");
+static_assert(PrinterSimulator::Firmware_MarlinKimbra == MARLINKIMBRA, "firmware ids of config.h");
+static_assert(PrinterSimulator::Firmware_Smoothieware == SMOOTHIEWARE, "firmware ids of config.h");
+static_assert(PrinterSimulator::Firmware_Repetier == REPETIER, "firmware ids of config.h");
+
+
+// lines received within timeout ms, until one starts with stop when given
+static std::vector<std::string> receive(uint32_t timeout, const char *stop = "ok")
+{
+    std::vector<std::string> lines;
+    std::string line;
+    unsigned long start = millis();
+    while (millis() - start < timeout) {
+        int c = Serial.read();
+        if (c < 0) {
+            delay(0);
+            continue;
+        }
+        if (c == '\r') {
+            continue;
+        }
+        if (c != '\n') {
+            line += (char)c;
+            continue;
+        }
+        lines.push_back(line);
+        if (stop && line.compare(0, strlen(stop), stop) == 0) {
+            break;
+        }
+        line.clear();
+    }
+    return lines;
+}
+
+static std::vector<std::string> command(const char *text, uint32_t timeout = 1000)
+{
+    Serial.println(text);
+    return receive(timeout);
+}
+
+static bool contains(const std::vector<std::string> &lines, const std::string &line)
+{
+    for (const std::string &l : lines) {
+        if (l == line) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::string startingWith(const std::vector<std::string> &lines, const std::string &prefix)
+{
+    for (const std::string &l : lines) {
+        if (l.compare(0, prefix.size(), prefix) == 0) {
+            return l;
+        }
+    }
+    return "";
+}
+
+static uint32_t classify(const std::string &line)
+{
+    Response response;
+    ResponseClassifier::classify(line.c_str(), line.size(), response);
+    return response.flags;
+}
+
+static std::string numbered(long n, const char *text)
+{
+    char buf[128];
+    int len = snprintf(buf, sizeof(buf), "N%ld %s", n, text);
+    uint8_t checksum = 0;
+    for (int i = 0; i < len; i++) {
+        checksum ^= (uint8_t)buf[i];
+    }
+    snprintf(buf + len, sizeof(buf) - len, "*%u", checksum);
+    return buf;
+}
+
+static void testMarlin()
+{
+    PrinterSimulator printer(PrinterSimulator::Firmware_Marlin);
+    CONFIG::SetFirmwareTarget(MARLIN);
+    Serial.attach(&printer);
+    Serial.begin(115200);
+
+    // 6 bytes out and 40 back, 10 bits each
+    unsigned long start = micros();
+    std::vector<std::string> lines = command("M105");
+    unsigned long elapsed = micros() - start;
+    CHECK_EQUAL(1u, lines.size());
+    lines.resize(1);
+    CHECK(lines[0] == "ok T:20.00 /0.00 B:20.00 /0.00 @:0 B@:0");
+    CHECK(classify(lines[0]) & Response_Ok);
+    CHECK(classify(lines[0]) & Response_Temperature);
+    CHECK(elapsed >= 46 * 10 * 1000000UL / 115200);
+
+    lines = command("M115");
+    CHECK(lines.size() >= 2 && lines[0].find("FIRMWARE_NAME:Marlin") == 0);
+    lines = command("M999");
+    CHECK(contains(lines, "echo:Unknown command: \"M999\""));
+
+    // line numbers and checksums
+    lines = command(numbered(1, "G1 X10").c_str());
+    CHECK(contains(lines, "ok"));
+    std::string bad = numbered(2, "G1 X20");
+    bad[bad.size() - 1] ^= 1;
+    lines = command(bad.c_str());
+    CHECK(contains(lines, "Error:checksum mismatch, Last Line: 1"));
+    CHECK(contains(lines, "Resend: 2"));
+    CHECK(classify("Resend: 2") & Response_Resend);
+    lines = command(numbered(3, "G1 X30").c_str());
+    CHECK(contains(lines, "Error:Line Number is not Last Line Number+1, Last Line: 1"));
+    CHECK(contains(lines, "Resend: 2"));
+    lines = command("G1 X40*12");
+    CHECK(contains(lines, "Error:No Line Number with checksum, Last Line: 1"));
+    lines = command("M110 N10");
+    lines = command(numbered(11, "M114").c_str());
+    CHECK(contains(lines, "X:10.00 Y:0.00 Z:0.00 E:0.00 Count X:0 Y:0 Z:0"));
+    CHECK_EQUAL(3u, printer.stats().resends);
+
+    // busy keepalive while a long command runs
+    Serial.attach(nullptr);
+    PrinterSimulator::Options options;
+    options.busyInterval = 30;
+    options.temperatureInterval = 100;
+    options.advancedOk = true;
+    PrinterSimulator busy(PrinterSimulator::Firmware_Marlin, options);
+    Serial.attach(&busy);
+    lines = command("G4 P100");
+    CHECK_EQUAL(4u, lines.size());
+    lines.resize(4);
+    CHECK(lines[0] == "echo:busy: processing");
+    CHECK(classify(lines[0]) & Response_Busy);
+    CHECK(lines[3] == "ok N0 P15 B4");
+
+    // temperature reports while heating, then auto-reports
+    lines = command("M109 S22", 2000);
+    CHECK(contains(lines, "echo:busy: processing"));
+    std::string report = startingWith(lines, " T:");
+    CHECK(report.find(" T:21.") == 0);
+    CHECK(report.find(" /22.00 B:20.00 /0.00 @:0 B@:0 W:?") == 8);
+    CHECK(!lines.empty() && lines.back() == "ok N0 P15 B4");
+    CHECK(busy.temperature(0) >= 22.0f);
+    command("M155 S0.05");
+    lines = receive(300, nullptr);
+    CHECK(lines.size() >= 2);
+    lines.resize(2);
+    CHECK(lines[0] == " T:22.00 /22.00 B:20.00 /0.00 @:0 B@:0");
+    CHECK(classify(lines[0]) & Response_Temperature);
+    command("M155 S0");
+    Serial.attach(nullptr);
+}
+
+static void testRepetier()
+{
+    PrinterSimulator::Options options;
+    options.waitInterval = 50;
+    PrinterSimulator printer(PrinterSimulator::Firmware_Repetier, options);
+    CONFIG::SetFirmwareTarget(REPETIER);
+    Serial.attach(&printer);
+    Serial.begin(250000);
+
+    std::vector<std::string> lines = command(numbered(1, "M105").c_str());
+    CHECK_EQUAL(2u, lines.size());
+    lines.resize(2);
+    CHECK(lines[0] == "T:20.00 /0 B:20.00 /0 B@:0 @:0");
+    CHECK(lines[1] == "ok 1");
+
+    // a wrong line is asked again, the ones following it are skipped
+    Serial.print((numbered(3, "G1 X1") + "\n" + numbered(4, "G1 X2") + "\n").c_str());
+    lines = receive(200, "skip");
+    CHECK(contains(lines, "Error:expected line 2 got 3"));
+    CHECK(contains(lines, "Resend:2"));
+    CHECK(contains(lines, "skip 4"));
+    lines = command(numbered(2, "G1 X3").c_str());
+    CHECK(contains(lines, "ok 2"));
+
+    lines = receive(200, "wait");
+    CHECK(!lines.empty() && lines.back() == "wait");
+    CHECK(classify("wait") & Response_Wait);
+    Serial.attach(nullptr);
+}
+
+static void testSmoothieware()
+{
+    PrinterSimulator printer(PrinterSimulator::Firmware_Smoothieware);
+    CONFIG::SetFirmwareTarget(SMOOTHIEWARE);
+    Serial.attach(&printer);
+    Serial.begin(115200);
+
+    std::vector<std::string> lines = command("M105");
+    CHECK_EQUAL(1u, lines.size());
+    lines.resize(1);
+    CHECK(lines[0] == "ok T:20.0 /0.0 @0 B:20.0 /0.0 @0");
+    CHECK(classify(lines[0]) & Response_Temperature);
+    lines = command("M28 /sd/test.g");
+    CHECK(contains(lines, "Writing to file: /sd/test.g"));
+    command("G1 X1");
+    lines = command("M29");
+    CHECK(contains(lines, "Done saving file."));
+    CHECK(printer.files().at("test.g") == "G1 X1\n");
+    lines = command("M20");
+    CHECK(contains(lines, "test.g 6"));
+    Serial.attach(nullptr);
+}
+
+static void testBuffers()
+{
+    // with no baud rate everything arrives at once: 4 moves are queued and
+    // the receive buffer holds what it can of the rest
+    PrinterSimulator::Options options;
+    options.moveTime = 100000;
+    PrinterSimulator printer(PrinterSimulator::Firmware_Marlin, options);
+    Serial.begin(0);
+    Serial.attach(&printer);
+    Serial.setRxBufferSize(8);
+    for (int i = 0; i < 40; i++) {
+        Serial.print("G1 X1\n");
+    }
+    CHECK(printer.stats().rxOverruns > 0);
+    CHECK_EQUAL(40u * 6, printer.stats().bytesReceived + printer.stats().rxOverruns);
+    Serial.attach(nullptr);
+
+    // the board keeps the first bytes of an answer it does not read
+    PrinterSimulator chatty(PrinterSimulator::Firmware_Marlin);
+    Serial.attach(&chatty);
+    Serial.println("M115");
+    delay(10);
+    CHECK_EQUAL(8, Serial.available());
+    CHECK(chatty.stats().boardOverruns > 0);
+    CHECK(Serial.readString() == "FIRMWARE");
+    Serial.setRxBufferSize(SERIAL_RX_BUFFER_SIZE);
+    Serial.attach(nullptr);
+}
+
+// what the printer saved once every line is acknowledged, before M29
+static std::string upload(PrinterSimulator &printer, uint8_t fw, const std::string &gcode, bool &done)
+{
+    CONFIG::SetFirmwareTarget(fw);
+    Serial.attach(&printer);
+    done = SdUploader::begin("/test.gco") &&
+           SdUploader::write((const uint8_t *)gcode.data(), gcode.size()) &&
+           SdUploader::end();
+    auto file = printer.files().find("/test.gco");
+    std::string saved = (file == printer.files().end()) ? "" : file->second;
+    Serial.println("M29");
+    receive(500, "Done");
+    Serial.attach(nullptr);
+    return saved;
+}
+
+static void testUpload()
+{
+    std::string gcode = "; generated\nG28\nG1 Z0.2 F1200 ; first layer\n\n";
+    std::string expected = "G28\nG1 Z0.2 F1200\n";
+    for (int i = 0; i < 300; i++) {
+        std::string line = "G1 X" + std::to_string(i % 200) + ".5 Y" + std::to_string(i * 7 % 200) + " E" + std::to_string(i) + ".25\n";
+        gcode += line;
+        expected += line;
+    }
+    Serial.begin(1000000);
+    bool done;
+    static const PrinterSimulator::Firmware firmwares[] = {
+        PrinterSimulator::Firmware_Marlin, PrinterSimulator::Firmware_Repetier, PrinterSimulator::Firmware_Smoothieware
+    };
+    for (PrinterSimulator::Firmware firmware : firmwares) {
+        PrinterSimulator printer(firmware);
+        CHECK(upload(printer, firmware, gcode, done) == expected);
+        CHECK(done);
+        CHECK(!printer.isSaving());
+        CHECK_EQUAL(0u, printer.stats().resends);
+    }
+
+    // corrupted bytes are asked again and the file still arrives whole; M28
+    // has no checksum, the seed leaves it alone
+    PrinterSimulator::Options options;
+    options.corruptRate = 0.002;
+    options.seed = 7;
+    static const PrinterSimulator::Firmware numbered[] = {
+        PrinterSimulator::Firmware_Marlin, PrinterSimulator::Firmware_Repetier
+    };
+    for (PrinterSimulator::Firmware firmware : numbered) {
+        PrinterSimulator printer(firmware, options);
+        CHECK(upload(printer, firmware, gcode, done) == expected);
+        CHECK(done);
+        CHECK(printer.stats().corrupted > 0);
+        CHECK(printer.stats().resends > 0);
+    }
+
+    // a printer without SD card refuses M28
+    options = PrinterSimulator::Options();
+    options.sdCard = false;
+    PrinterSimulator nocard(PrinterSimulator::Firmware_Marlin, options);
+    upload(nocard, MARLIN, gcode, done);
+    CHECK(!done);
+}
+
+static void testErrorInjection()
+{
+    // the same seed damages the same bytes
+    PrinterSimulator::Options options;
+    options.corruptRate = 0.01;
+    options.dropRate = 0.01;
+    options.seed = 3;
+    PrinterSimulator first(PrinterSimulator::Firmware_Smoothieware, options);
+    PrinterSimulator second(PrinterSimulator::Firmware_Smoothieware, options);
+    std::string data(5000, 'x');
+    first.write((const uint8_t *)data.data(), data.size());
+    second.write((const uint8_t *)data.data(), data.size());
+    CHECK(first.stats().corrupted > 20 && first.stats().corrupted < 80);
+    CHECK(first.stats().dropped > 20 && first.stats().dropped < 80);
+    CHECK_EQUAL(first.stats().corrupted, second.stats().corrupted);
+    CHECK_EQUAL(first.stats().dropped, second.stats().dropped);
+
+    // lost oks
+    options = PrinterSimulator::Options();
+    options.lostOkRate = 1;
+    PrinterSimulator mute(PrinterSimulator::Firmware_Marlin, options);
+    Serial.attach(&mute);
+    CHECK(command("G28", 300).empty());
+    CHECK_EQUAL(1u, mute.stats().lostOks);
+    Serial.attach(nullptr);
+}
+
+int main()
+{
+    testMarlin();
+    testRepetier();
+    testSmoothieware();
+    testBuffers();
+    testUpload();
+    testErrorInjection();
+    return TEST_RESULT();
+}
@@ -0,0 +1,128 @@
+/*
+  tests/test_responseclassifier.cpp - ResponseClassifier flags and fields
+  on Marlin, Repetier and Smoothieware answers.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "test.h"
+
+#include <string>
+
+#include "config.h"
+#include "responseclassifier.h"
+
+static Response response;
+
+static uint16_t classify(const char *line)
+{
+    ResponseClassifier::classify(line, strlen(line), response);
+    return response.flags;
+}
+
+static std::string field(const char *line, ResponseField f)
+{
+    return ResponseClassifier::field(line, response, f);
+}
+
+static void testMarlin()
+{
+    ResponseClassifier::setFirmwareTarget(MARLIN);
+    CHECK_EQUAL(Response_Ok, classify("ok"));
+    CHECK_EQUAL(Response_Ok | Response_Temperature, classify("ok T:210.0 /210.0 B:60.0 /60.0 @:64 B@:0"));
+    CHECK_EQUAL(Response_Temperature, classify(" T:209.8 /210.0 B:59.9 /60.0 @:70 B@:12 W:?"));
+    // Marlin reports its messages with echo:
+    const char *busy = "echo:busy: processing";
+    CHECK_EQUAL(Response_Status | Response_Busy, classify(busy));
+    CHECK(field(busy, ResponseField_Status) == "busy: processing");
+    CHECK_EQUAL(0, classify("Status:not for Marlin"));
+    const char *error = "Error:Printer halted. kill() called!";
+    CHECK_EQUAL(Response_Error, classify(error));
+    CHECK(field(error, ResponseField_Error) == "Printer halted. kill() called!");
+    const char *resend = "Resend: 42";
+    CHECK_EQUAL(Response_Resend, classify(resend));
+    CHECK(field(resend, ResponseField_Resend) == " 42");
+    const char *position = "X:10.00 Y:20.00 Z:0.30 E:0.00 Count X:800 Y:1600 Z:120";
+    CHECK_EQUAL(Response_Position, classify(position));
+    CHECK(field(position, ResponseField_Position) == "10.00 Y:20.00 Z:0.30 E:0.00 Count X:800 Y:1600 Z:120");
+    const char *progress = "SD printing byte 1234/56789";
+    CHECK_EQUAL(Response_SdProgress, classify(progress));
+    CHECK(field(progress, ResponseField_SdProgress) == "1234/56789");
+    CHECK_EQUAL(Response_SdIdle, classify("Not SD printing"));
+    CHECK_EQUAL(Response_SdIdle, classify("Done printing file"));
+    const char *esp = "echo:[ESP800]";
+    CHECK_EQUAL(Response_Status | Response_EspCommand, classify(esp));
+    CHECK(field(esp, ResponseField_EspCommand) == "800]");
+}
+
+static void testRepetier()
+{
+    ResponseClassifier::setFirmwareTarget(REPETIER);
+    CHECK_EQUAL(Response_Ok, classify("ok 1234"));
+    CHECK_EQUAL(Response_Wait, classify("wait"));
+    CHECK_EQUAL(Response_Temperature, classify("T:210.00 /210 B:60.00 /60 B@:0 @:64"));
+    const char *resend = "Resend:1236";
+    CHECK_EQUAL(Response_Resend, classify(resend));
+    CHECK(field(resend, ResponseField_Resend) == "1236");
+    const char *info = "Info:Continue printing";
+    CHECK_EQUAL(Response_Info, classify(info));
+    CHECK(field(info, ResponseField_Info) == "Continue printing");
+    const char *status = "Status:heating";
+    CHECK_EQUAL(Response_Status, classify(status));
+    CHECK(field(status, ResponseField_Status) == "heating");
+    CHECK_EQUAL(Response_Error | Response_FormatError, classify("Error:Format error"));
+    // echo: is a status only for Marlin
+    CHECK_EQUAL(0, classify("echo:hello"));
+    // ok and wait count at the start of the line only
+    CHECK_EQUAL(0, classify("look at this"));
+    CHECK_EQUAL(0, classify("no wait"));
+}
+
+static void testSmoothieware()
+{
+    ResponseClassifier::setFirmwareTarget(SMOOTHIEWARE);
+    CHECK_EQUAL(Response_Ok | Response_Temperature, classify("ok T:210.0 /210.0 @255 B:60.0 /60.0 @0"));
+    CHECK_EQUAL(Response_Position, classify("X:10.0000 Y:20.0000 Z:0.3000 E:0.0000"));
+    const char *error = "error:Unsupported command - M999";
+    CHECK_EQUAL(Response_Error, classify(error));
+    CHECK(field(error, ResponseField_Error) == "Unsupported command - M999");
+    const char *info = "info: Temperature reached";
+    CHECK_EQUAL(Response_Info, classify(info));
+    CHECK(field(info, ResponseField_Info) == " Temperature reached");
+    const char *warning = "warning:probe failed";
+    CHECK_EQUAL(Response_Status, classify(warning));
+    CHECK(field(warning, ResponseField_Status) == "probe failed");
+    // the capitalized messages belong to the other firmwares
+    CHECK_EQUAL(0, classify("Error:not for Smoothieware"));
+    CHECK_EQUAL(0, classify("Info:not for Smoothieware"));
+    CHECK_EQUAL(0, classify("Status:not for Smoothieware"));
+}
+
+// only the first match of a kind is reported, truncated patterns never
+static void testEdges()
+{
+    ResponseClassifier::setFirmwareTarget(REPETIER);
+    const char *twice = "Info:one Info:two";
+    CHECK_EQUAL(Response_Info, classify(twice));
+    CHECK(field(twice, ResponseField_Info) == "one Info:two");
+    CHECK_EQUAL(0, classify("Resend"));
+    CHECK_EQUAL(0, classify("SD printing byte"));
+    CHECK_EQUAL(0, classify(""));
+    // the length bounds the scan, not the NUL
+    const char *line = "ok T:20";
+    ResponseClassifier::classify(line, 2, response);
+    CHECK_EQUAL(Response_Ok, response.flags);
+}
+
+
+int main()
+{
+    testMarlin();
+    testRepetier();
+    testSmoothieware();
+    testEdges();
+    return TEST_RESULT();
+}
@@ -0,0 +1,234 @@
+/*
+  tests/test_sdupload.cpp - SdUploader against a scripted printer that
+  answers each line as soon as it is written: resend requests, plain and
+  numbered oks, and the firmwares without line numbers.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "test.h"
+
+#include <deque>
+#include <map>
+#include <string>
+
+#include <Arduino.h>
+#include "config.h"
+#include "sdupload.h"
+
+// ScriptedPrinter
+// Checks line numbers like Marlin and Repetier: a line whose number is not
+// the expected one, or one the test marked as corrupted, gets "Resend:"
+// followed by "ok", so every line in flight after a bad one asks for the
+// same line again.
+class ScriptedPrinter : public SerialDevice
+{
+public:
+    // "ok", "ok N<n>" or "ok <n>"
+    enum OkStyle
+    {
+        Ok_Plain,
+        Ok_Marlin,
+        Ok_Repetier
+    };
+
+    explicit ScriptedPrinter(bool numbered, OkStyle okStyle = Ok_Plain)
+        : _numbered(numbered), _okStyle(okStyle) {}
+
+    std::string saved;
+    // times each line number was received
+    std::map<long, int> received;
+    // line number -> how many of its next copies arrive corrupted
+    std::map<long, int> corrupt;
+    uint32_t resends = 0;
+
+    int available() override
+    {
+        return _rx.size();
+    }
+    int read() override
+    {
+        if (_rx.empty()) {
+            return -1;
+        }
+        int c = _rx.front();
+        _rx.pop_front();
+        return c;
+    }
+    int peek() override
+    {
+        return _rx.empty() ? -1 : _rx.front();
+    }
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        for (size_t i = 0; i < size; i++) {
+            if (buffer[i] == '\n') {
+                onLine(_line);
+                _line.clear();
+            } else if (buffer[i] != '\r') {
+                _line += (char)buffer[i];
+            }
+        }
+        return size;
+    }
+
+private:
+    bool _numbered;
+    OkStyle _okStyle;
+    std::deque<uint8_t> _rx;
+    std::string _line;
+    long _expected = 1;
+    bool _saving = false;
+
+    void answer(const std::string &text)
+    {
+        _rx.insert(_rx.end(), text.begin(), text.end());
+        _rx.push_back('\n');
+    }
+
+    void ok(long n)
+    {
+        if (_okStyle == Ok_Marlin) {
+            answer("ok N" + std::to_string(n));
+        } else if (_okStyle == Ok_Repetier) {
+            answer("ok " + std::to_string(n));
+        } else {
+            answer("ok");
+        }
+    }
+
+    void onLine(std::string line)
+    {
+        if (line.compare(0, 4, "M110") == 0) {
+            _expected = 1;
+            answer("ok");
+            return;
+        }
+        if (line.compare(0, 3, "M28") == 0) {
+            _saving = true;
+            answer("Writing to file: test.gco");
+            answer("ok");
+            return;
+        }
+        if (!_numbered) {
+            saved += line + "\n";
+            answer("ok");
+            return;
+        }
+        CHECK(line[0] == 'N');
+        long n = strtol(line.c_str() + 1, NULL, 10);
+        received[n]++;
+        bool bad = corrupt[n] > 0;
+        if (bad) {
+            corrupt[n]--;
+        }
+        if (bad || (n != _expected)) {
+            resends++;
+            answer("Resend: " + std::to_string(_expected));
+            answer("ok");
+            return;
+        }
+        size_t text = line.find(' ') + 1;
+        saved += line.substr(text, line.rfind('*') - text) + "\n";
+        _expected++;
+        ok(n);
+    }
+};
+
+static std::string gcode(int lines)
+{
+    std::string text;
+    for (int i = 0; i < lines; i++) {
+        text += "G1 X" + std::to_string(i) + " Y" + std::to_string(i * 3) + "\n";
+    }
+    return text;
+}
+
+static bool upload(ScriptedPrinter &printer, uint8_t fw, const std::string &text)
+{
+    CONFIG::SetFirmwareTarget(fw);
+    Serial.attach(&printer);
+    bool done = SdUploader::begin("/test.gco") &&
+                SdUploader::write((const uint8_t *)text.data(), text.size()) &&
+                SdUploader::end();
+    Serial.attach(nullptr);
+    return done;
+}
+
+// a bad line is sent once more for its own Resend, the copies of the same
+// request caused by the lines in flight behind it are ignored
+static void testResend()
+{
+    static const ScriptedPrinter::OkStyle styles[] = {
+        ScriptedPrinter::Ok_Plain, ScriptedPrinter::Ok_Marlin, ScriptedPrinter::Ok_Repetier
+    };
+    std::string text = gcode(40);
+    for (ScriptedPrinter::OkStyle style : styles) {
+        ScriptedPrinter printer(true, style);
+        printer.corrupt[3] = 1;
+        printer.corrupt[20] = 1;
+        CHECK(upload(printer, MARLIN, text));
+        CHECK(printer.saved == text);
+        CHECK_EQUAL(2, printer.received[3]);
+        CHECK_EQUAL(2, printer.received[20]);
+        // the lines in flight behind are sent again once, nothing else
+        for (long n = 1; n <= 40; n++) {
+            CHECK(printer.received[n] <= 2);
+        }
+        CHECK_EQUAL(1, printer.received[1]);
+        CHECK_EQUAL(1, printer.received[40]);
+        CHECK(printer.resends >= 2);
+    }
+}
+
+// the resent line fails again: its Resend looks like the copies already
+// ignored, the acknowledge timeout sends it once more
+static void testResendFailsAgain()
+{
+    ScriptedPrinter printer(true);
+    printer.corrupt[5] = 2;
+    std::string text = gcode(12);
+    unsigned long start = millis();
+    CHECK(upload(printer, MARLIN, text));
+    CHECK(printer.saved == text);
+    CHECK_EQUAL(3, printer.received[5]);
+    CHECK(millis() - start >= SD_UPLOAD_ACK_TIMEOUT);
+}
+
+// with plain oks, those answering the lines in flight after a Resend do
+// not acknowledge the resent lines
+static void testUnnumberedOks()
+{
+    ScriptedPrinter printer(true, ScriptedPrinter::Ok_Plain);
+    for (long n = 2; n <= 60; n += 7) {
+        printer.corrupt[n] = 1;
+    }
+    std::string text = gcode(60);
+    CHECK(upload(printer, REPETIER, text));
+    CHECK(printer.saved == text);
+    for (long n = 2; n <= 60; n += 7) {
+        CHECK_EQUAL(2, printer.received[n]);
+    }
+}
+
+// Smoothieware gets plain lines, one at a time
+static void testUnnumberedFirmware()
+{
+    ScriptedPrinter printer(false);
+    std::string text = "; comment\nG28\n\n  G1 X1 ; move\n" + gcode(10);
+    CHECK(upload(printer, SMOOTHIEWARE, text));
+    CHECK(printer.saved == "G28\nG1 X1\n" + gcode(10));
+}
+
+
+int main()
+{
+    testResend();
+    testResendFailsAgain();
+    testUnnumberedOks();
+    testUnnumberedFirmware();
+    return TEST_RESULT();
+}
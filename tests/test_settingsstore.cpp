@@ -0,0 +1,220 @@
+/*
+  tests/test_settingsstore.cpp - the settings journal on the SPIFFS of the
+  host: commits survive a restart, a torn or corrupted record is dropped
+  with what follows, the journal is compacted once full, and a compaction
+  interrupted before its rename is finished at the next boot.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "test.h"
+
+#include <string>
+
+#include <EEPROM.h>
+#include <FS.h>
+
+#include "settingsstore.h"
+
+// record header, then one run of block offset and length
+static const uint32_t SNAPSHOT_SIZE = 8 + 4 + EEPROM_SIZE;
+
+static std::string readFile(const char *filename)
+{
+    std::string content;
+    File file = SPIFFS.open(filename, "r");
+    if (file) {
+        content.resize(file.size());
+        file.read((uint8_t *)&content[0], content.size());
+        file.close();
+    }
+    return content;
+}
+
+static void writeFile(const char *filename, const std::string &content)
+{
+    File file = SPIFFS.open(filename, "w");
+    file.write((const uint8_t *)content.data(), content.size());
+    file.close();
+}
+
+static uint32_t fileSize(const char *filename)
+{
+    return readFile(filename).size();
+}
+
+// a restart: the image is loaded again from flash
+static void reboot()
+{
+    SettingsStore::begin();
+}
+
+static void set(int pos, uint8_t value)
+{
+    SettingsStore::write(pos, value);
+    CHECK(SettingsStore::commit());
+}
+
+static void format()
+{
+    SPIFFS.format();
+    EEPROM.begin(EEPROM_SIZE);
+    for (int i = 0; i < EEPROM_SIZE; i++) {
+        EEPROM.write(i, 0x11);
+    }
+    EEPROM.commit();
+    EEPROM.end();
+    reboot();
+}
+
+// the first boot takes the EEPROM sector and starts a journal
+static void testMigration()
+{
+    format();
+    CHECK_EQUAL(0x11, SettingsStore::read(100));
+    CHECK_EQUAL(SNAPSHOT_SIZE, fileSize(SETTINGS_FILE));
+    set(100, 1);
+    set(700, 2);
+    CHECK(fileSize(SETTINGS_FILE) > SNAPSHOT_SIZE);
+    reboot();
+    CHECK_EQUAL(1, SettingsStore::read(100));
+    CHECK_EQUAL(2, SettingsStore::read(700));
+    CHECK_EQUAL(0x11, SettingsStore::read(101));
+}
+
+// a power loss in the middle of the last append, cut anywhere
+static void testTornRecord()
+{
+    for (uint32_t cut = 1;; cut += 7) {
+        format();
+        set(100, 1);
+        uint32_t whole = fileSize(SETTINGS_FILE);
+        SettingsStore::write(100, 2);
+        SettingsStore::write(700, 2);
+        CHECK(SettingsStore::commit());
+        std::string journal = readFile(SETTINGS_FILE);
+        if (whole + cut >= journal.size()) {
+            break;
+        }
+        writeFile(SETTINGS_FILE, journal.substr(0, whole + cut));
+        reboot();
+        CHECK_EQUAL(1, SettingsStore::read(100));
+        CHECK_EQUAL(0x11, SettingsStore::read(700));
+        // the damaged journal is rewritten before anything is appended
+        CHECK_EQUAL(SNAPSHOT_SIZE, fileSize(SETTINGS_FILE));
+        set(700, 3);
+        reboot();
+        CHECK_EQUAL(1, SettingsStore::read(100));
+        CHECK_EQUAL(3, SettingsStore::read(700));
+    }
+}
+
+static void testBadCrc()
+{
+    format();
+    set(100, 1);
+    uint32_t first = fileSize(SETTINGS_FILE);
+    set(100, 2);
+    set(700, 3);
+
+    // a bit flipped in the second record drops it and the third one
+    std::string journal = readFile(SETTINGS_FILE);
+    std::string damaged = journal;
+    damaged[first + 8 + 4 + 3] ^= 0x04;
+    writeFile(SETTINGS_FILE, damaged);
+    reboot();
+    CHECK_EQUAL(1, SettingsStore::read(100));
+    CHECK_EQUAL(0x11, SettingsStore::read(700));
+
+    // nothing left of the journal, the EEPROM sector is taken again
+    damaged = journal;
+    damaged[8 + 4] ^= 0x01;
+    writeFile(SETTINGS_FILE, damaged);
+    reboot();
+    CHECK_EQUAL(0x11, SettingsStore::read(100));
+    CHECK_EQUAL(0x11, SettingsStore::read(700));
+    CHECK_EQUAL(SNAPSHOT_SIZE, fileSize(SETTINGS_FILE));
+
+    // a header pointing past the end of the file
+    set(100, 4);
+    journal = readFile(SETTINGS_FILE);
+    journal[SNAPSHOT_SIZE + 2] = (char)0xFF;
+    writeFile(SETTINGS_FILE, journal);
+    reboot();
+    CHECK_EQUAL(0x11, SettingsStore::read(100));
+}
+
+// once full, the journal is rewritten as one snapshot with every value
+static void testCompaction()
+{
+    format();
+    bool compacted = false;
+    uint32_t previous = fileSize(SETTINGS_FILE);
+    for (int i = 0; i < 400 && !compacted; i++) {
+        set(i % 2 ? 100 : 700, (uint8_t)i);
+        uint32_t size = fileSize(SETTINGS_FILE);
+        compacted = size < previous;
+        previous = size;
+        CHECK(size <= SETTINGS_JOURNAL_SIZE + SNAPSHOT_SIZE);
+    }
+    CHECK(compacted);
+    CHECK_EQUAL(SNAPSHOT_SIZE, previous);
+    CHECK(!SPIFFS.exists(SETTINGS_FILE_NEW));
+    uint8_t at100 = SettingsStore::read(100);
+    uint8_t at700 = SettingsStore::read(700);
+    reboot();
+    CHECK_EQUAL(at100, SettingsStore::read(100));
+    CHECK_EQUAL(at700, SettingsStore::read(700));
+    CHECK_EQUAL(0x11, SettingsStore::read(101));
+}
+
+// the snapshot is written aside, the journal removed, then renamed
+static void testInterruptedRename()
+{
+    format();
+    set(100, 1);
+    set(700, 2);
+    CHECK(SettingsStore::compact());
+    std::string snapshot = readFile(SETTINGS_FILE);
+    CHECK_EQUAL(SNAPSHOT_SIZE, snapshot.size());
+
+    // power lost after the removal, before the rename
+    CHECK(SPIFFS.rename(SETTINGS_FILE, SETTINGS_FILE_NEW));
+    reboot();
+    CHECK(SPIFFS.exists(SETTINGS_FILE));
+    CHECK(!SPIFFS.exists(SETTINGS_FILE_NEW));
+    CHECK_EQUAL(1, SettingsStore::read(100));
+    CHECK_EQUAL(2, SettingsStore::read(700));
+    CHECK(readFile(SETTINGS_FILE) == snapshot);
+    set(100, 3);
+    reboot();
+    CHECK_EQUAL(3, SettingsStore::read(100));
+
+    // power lost before the removal, the journal is still the one to trust
+    std::string journal = readFile(SETTINGS_FILE);
+    writeFile(SETTINGS_FILE_NEW, snapshot);
+    reboot();
+    CHECK_EQUAL(3, SettingsStore::read(100));
+    CHECK(readFile(SETTINGS_FILE) == journal);
+    // the next compaction replaces what was left aside
+    CHECK(SettingsStore::compact());
+    CHECK(!SPIFFS.exists(SETTINGS_FILE_NEW));
+    reboot();
+    CHECK_EQUAL(3, SettingsStore::read(100));
+}
+
+
+int main()
+{
+    host_setDataDir(test_dataDir("settingsstore"));
+    SPIFFS.begin();
+    testMigration();
+    testTornRecord();
+    testBadCrc();
+    testCompaction();
+    testInterruptedRename();
+    return TEST_RESULT();
+}
@@ -0,0 +1,190 @@
+/*
+  tests/test_storestrings.cpp - the rolling message lists keep the last
+  strings in order, truncated to their maximum length, whatever the
+  wrapping of their buffer.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "test.h"
+
+#include <deque>
+#include <string>
+
+#include "storestrings.h"
+
+// what STORESTRINGS_CLASS is expected to hold, in the simplest way
+class Model
+{
+private:
+    size_t _maxsize;
+    size_t _length;
+
+public:
+    std::deque<std::string> strings;
+
+    Model(size_t maxsize, size_t length) : _maxsize(maxsize), _length(length) {}
+
+    void add(const std::string &string)
+    {
+        if (strings.size() == _maxsize) {
+            strings.pop_front();
+        }
+        if (string.size() > _length) {
+            strings.push_back(string.substr(0, _length - 3) + "...");
+        } else {
+            strings.push_back(string);
+        }
+    }
+};
+
+static bool same(STORESTRINGS_CLASS &store, const Model &model)
+{
+    if (store.size() != (int)model.strings.size()) {
+        return false;
+    }
+    for (int i = 0; i < store.size(); i++) {
+        if (model.strings[i] != store.get(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testRolling()
+{
+    STORESTRINGS_CLASS store;
+    CHECK_EQUAL(0, store.size());
+    CHECK(store.get(0) == NULL);
+    for (int i = 0; i < STORESTRINGS_DEFAULT_SIZE + 3; i++) {
+        CHECK(store.add(String("message ") + i));
+    }
+    CHECK_EQUAL(STORESTRINGS_DEFAULT_SIZE, store.size());
+    CHECK(strcmp(store.get(0), "message 3") == 0);
+    CHECK(strcmp(store.get(STORESTRINGS_DEFAULT_SIZE - 1), "message 18") == 0);
+    CHECK(store.get(STORESTRINGS_DEFAULT_SIZE) == NULL);
+    CHECK(store.get(-1) == NULL);
+    CHECK_EQUAL(5, store.get_index("message 8"));
+    CHECK_EQUAL(-1, store.get_index("message 2"));
+}
+
+static void testTruncation()
+{
+    // "..." needs 4 characters at least
+    STORESTRINGS_CLASS tiny(4, 2);
+    CHECK_EQUAL(4, tiny.getlength());
+    CHECK(!tiny.setlength(3));
+
+    STORESTRINGS_CLASS store(4, 10);
+    store.add("0123456789");
+    store.add("0123456789A");
+    store.add("");
+    CHECK(strcmp(store.get(0), "0123456789") == 0);
+    CHECK(strcmp(store.get(1), "0123456...") == 0);
+    CHECK(strcmp(store.get(2), "") == 0);
+
+    // a new size or length empties the list
+    CHECK(store.setlength(20));
+    CHECK_EQUAL(0, store.size());
+    store.add("0123456789A");
+    CHECK(strcmp(store.get(0), "0123456789A") == 0);
+    CHECK(store.setsize(8));
+    CHECK_EQUAL(0, store.size());
+    CHECK(store.setsize(8));
+}
+
+static void testSequence()
+{
+    STORESTRINGS_CLASS first(3, 20);
+    STORESTRINGS_CLASS second(3, 20);
+    first.add("a");
+    second.add("b");
+    first.add("c");
+    CHECK(first.getseq(1) > second.getseq(0));
+    CHECK(second.getseq(0) > first.getseq(0));
+    CHECK_EQUAL(first.getseq(1), STORESTRINGS_CLASS::lastseq());
+    CHECK_EQUAL(0u, first.getseq(2));
+    CHECK(first.gettime(0) <= millis());
+
+    uint32_t seen = first.getseq(0);
+    CHECK_EQUAL(1, first.first_after(seen));
+    CHECK_EQUAL(2, first.first_after(first.getseq(1)));
+    CHECK_EQUAL(0, first.first_after(0));
+
+    // clear() keeps the numbering going
+    first.clear();
+    CHECK_EQUAL(0, first.size());
+    first.add("d");
+    CHECK(first.getseq(0) > seen);
+    CHECK_EQUAL(0, first.first_after(seen));
+}
+
+static void testRemove()
+{
+    STORESTRINGS_CLASS store(5, 10);
+    Model model(5, 10);
+    const char *const strings[] = {"one", "two", "three", "four", "five", "six"};
+    for (const char *s : strings) {
+        store.add(s);
+        model.add(s);
+    }
+    uint32_t seq = store.getseq(3);
+    CHECK(store.remove(2));
+    model.strings.erase(model.strings.begin() + 2);
+    CHECK(same(store, model));
+    CHECK_EQUAL(seq, store.getseq(2));
+    CHECK(store.remove(0));
+    model.strings.pop_front();
+    CHECK(same(store, model));
+    CHECK(!store.remove(3));
+    CHECK(!store.remove(-1));
+    store.add("seven");
+    model.add("seven");
+    CHECK(same(store, model));
+}
+
+// random lengths wrap the buffer at every possible place, the list must
+// stay the same as the model
+static void testAgainstModel()
+{
+    srand(1);
+    const size_t sizes[] = {1, 2, 5, 16, 40};
+    const size_t lengths[] = {4, 10, 33, 100};
+    int mismatches = 0;
+    for (size_t maxsize : sizes) {
+        for (size_t length : lengths) {
+            STORESTRINGS_CLASS store(maxsize, length);
+            Model model(maxsize, length);
+            for (int i = 0; i < 20000; i++) {
+                if (rand() % 10 == 0 && !model.strings.empty()) {
+                    int pos = rand() % model.strings.size();
+                    store.remove(pos);
+                    model.strings.erase(model.strings.begin() + pos);
+                } else {
+                    std::string s(rand() % (length + 20), 'a' + i % 26);
+                    store.add(s.c_str());
+                    model.add(s);
+                }
+                if (!same(store, model)) {
+                    mismatches++;
+                    break;
+                }
+            }
+        }
+    }
+    CHECK_EQUAL(0, mismatches);
+}
+
+
+int main()
+{
+    testRolling();
+    testTruncation();
+    testSequence();
+    testRemove();
+    testAgainstModel();
+    return TEST_RESULT();
+}
@@ -0,0 +1,306 @@
+/*
+  tests/test_webserver.cpp - the bundled WebServer over loopback: requests
+  parsed however they are cut, heads and bodies over the limits refused,
+  and clients that are slow to send their request or stop sending a body
+  do not hold up the others for long.
+
+  Copyright (c) 2018 Eugene Shelkovin. All rights reserved.
+  This file is distributed under MIT license.
+  MIT license may not be applied to the whole software or its files which
+  are not explicitly marked as those distributed under MIT license.
+*/
+
+#include "test.h"
+#include "netclient.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ESP8266WebServer.h>
+
+static double now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// runs handleClient() like the sketch loop until body returns
+static void serve(ESP8266WebServer &server, std::function<void()> body)
+{
+    std::atomic<bool> done(false);
+    std::thread client([&]() {
+        body();
+        done = true;
+    });
+    while (!done) {
+        server.handleClient();
+    }
+    client.join();
+}
+
+static const char *const UPLOAD_HEAD =
+    "POST /upload HTTP/1.1\r\n"
+    "Host: esp3d\r\n"
+    "Content-Type: multipart/form-data; boundary=XyZ\r\n"
+    "Content-Length: 100000\r\n"
+    "\r\n"
+    "--XyZ\r\n"
+    "Content-Disposition: form-data; name=\"file\"; filename=\"a.gcode\"\r\n"
+    "Content-Type: application/octet-stream\r\n"
+    "\r\n";
+
+// a server answering /echo with its "b" argument and saving uploads
+struct EchoServer
+{
+    uint16_t port;
+    ESP8266WebServer server;
+    std::string uploaded;
+
+    EchoServer() : port(NetClient::freePort()), server(port)
+    {
+        server.on("/echo", HTTP_ANY, [this]() {
+            server.send(200, "text/plain", server.arg("b"));
+        }, [this]() {
+            HTTPUpload &upload = server.upload();
+            if (upload.status == UPLOAD_FILE_WRITE) {
+                uploaded.append((const char *)upload.buf, upload.currentSize);
+            }
+        });
+        server.begin();
+    }
+
+    // sends the parts with a pause between them, returns the status
+    int request(const std::vector<std::string> &parts, std::string &body)
+    {
+        int status = -1;
+        serve(server, [&]() {
+            NetClient net;
+            if (!net.connect(port)) {
+                return;
+            }
+            for (size_t i = 0; i < parts.size(); i++) {
+                if (i) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+                }
+                net.send(parts[i]);
+            }
+            status = net.readResponse(body, 3000, port);
+        });
+        return status;
+    }
+
+    int request(const std::string &text, std::string &body)
+    {
+        return request(std::vector<std::string>{text}, body);
+    }
+};
+
+// the head comes in several reads, cut anywhere even between CR and LF,
+// and the body after it
+static void testSplitHead()
+{
+    EchoServer echo;
+    std::string body;
+    CHECK_EQUAL(200, echo.request({ "GE", "T /echo?b=one HTTP/1.1\r", "\nHost: esp3d\r\n\r", "\n" }, body));
+    CHECK(body == "one");
+    CHECK_EQUAL(200, echo.request({
+        "POST /echo HTTP/1.1\r\nHost: esp3d\r\nContent-Type: application/x-www-form-urlencoded\r\n",
+        "Content-Length: 9\r\n\r\n",
+        "a=1&",
+        "b=two"
+    }, body));
+    CHECK(body == "two");
+}
+
+// HTTP_HEAD_BUFLEN - 1 bytes of head at most, 431 above
+static void testHeadTooLarge()
+{
+    EchoServer echo;
+    std::string body;
+    std::string start = "GET /echo?b=fits HTTP/1.1\r\nHost: esp3d\r\nX-Padding: ";
+    std::string end = "\r\n\r\n";
+    std::string fits = start + std::string(HTTP_HEAD_BUFLEN - 1 - start.size() - end.size(), 'x') + end;
+    CHECK_EQUAL(HTTP_HEAD_BUFLEN - 1, fits.size());
+    CHECK_EQUAL(200, echo.request(fits, body));
+    CHECK(body == "fits");
+    std::string over = start + std::string(HTTP_HEAD_BUFLEN, 'x') + end;
+    CHECK_EQUAL(431, echo.request(over, body));
+}
+
+// bodies kept in RAM stop at HTTP_MAX_BODY_SIZE, larger ones get 413
+// before they are sent
+static void testBodyTooLarge()
+{
+    EchoServer echo;
+    std::string body;
+    std::string head = "POST /echo HTTP/1.1\r\nHost: esp3d\r\nContent-Type: text/plain\r\nContent-Length: ";
+    std::string largest(HTTP_MAX_BODY_SIZE, 'x');
+    CHECK_EQUAL(200, echo.request(head + std::to_string(largest.size()) + "\r\n\r\n" + largest, body));
+    CHECK_EQUAL(413, echo.request(head + std::to_string(HTTP_MAX_BODY_SIZE + 1) + "\r\n\r\n", body));
+    CHECK_EQUAL(413, echo.request(head + "99999999999999999999\r\n\r\n", body));
+}
+
+// media types are matched whatever their case
+static void testContentTypeCase()
+{
+    EchoServer echo;
+    std::string body;
+    CHECK_EQUAL(200, echo.request("POST /echo HTTP/1.1\r\nHost: esp3d\r\n"
+                                  "Content-Type: Application/X-WWW-Form-Urlencoded\r\nContent-Length: 5\r\n\r\nb=two", body));
+    CHECK(body == "two");
+    std::string part = "--XyZ\r\n"
+                       "Content-Disposition: form-data; name=\"file\"; filename=\"a.gcode\"\r\n"
+                       "Content-Type: application/octet-stream\r\n"
+                       "\r\n"
+                       "G28\nG1 X10\n"
+                       "\r\n--XyZ--\r\n";
+    CHECK_EQUAL(200, echo.request("POST /echo?b=up HTTP/1.1\r\nHost: esp3d\r\n"
+                                  "Content-Type: Multipart/Form-Data; boundary=XyZ\r\n"
+                                  "Content-Length: " + std::to_string(part.size()) + "\r\n\r\n" + part, body));
+    CHECK(body == "up");
+    CHECK(echo.uploaded == "G28\nG1 X10\n");
+}
+
+// the delimiter after the file data arrives in two reads, cut anywhere,
+// with the data before it smaller and larger than the upload buffer; a
+// second file follows what was read past the first one
+static void testUploadSplitBoundary()
+{
+    EchoServer echo;
+    std::string body;
+    std::string head = "--XyZ\r\n"
+                       "Content-Disposition: form-data; name=\"file\"; filename=\"a.gcode\"\r\n"
+                       "Content-Type: application/octet-stream\r\n"
+                       "\r\n";
+    std::string second = "--XyZ\r\n"
+                         "Content-Disposition: form-data; name=\"file\"; filename=\"b.gcode\"\r\n"
+                         "Content-Type: application/octet-stream\r\n"
+                         "\r\n"
+                         "M84\n"
+                         "\r\n--XyZ--\r\n";
+    std::string delimiter = "\r\n--XyZ\r\n";
+    static const size_t sizes[] = { 10, HTTP_UPLOAD_BUFLEN - 4, HTTP_UPLOAD_BUFLEN * 2 + 100 };
+    for (size_t size : sizes) {
+        std::string data;
+        for (size_t i = 0; data.size() < size; i++) {
+            data += "G1 X" + std::to_string(i % 200) + "\n";
+        }
+        data.resize(size);
+        for (size_t cut = 1; cut < delimiter.size(); cut += 3) {
+            std::string form = head + data + delimiter + second;
+            std::string start = "POST /echo?b=split HTTP/1.1\r\nHost: esp3d\r\n"
+                                "Content-Type: multipart/form-data; boundary=XyZ\r\n"
+                                "Content-Length: " + std::to_string(form.size()) + "\r\n\r\n";
+            size_t split = head.size() + data.size() + cut;
+            echo.uploaded.clear();
+            CHECK_EQUAL(200, echo.request({ start + form.substr(0, split), form.substr(split) }, body));
+            CHECK(body == "split");
+            CHECK(echo.uploaded == data + "M84\n");
+        }
+    }
+}
+
+// while some clients trickle their request head a byte at a time and
+// others stop in the middle of a file upload, a client sending plain GET
+// requests is still answered; the stalled uploads lose their connection
+// after HTTP_MAX_POST_WAIT
+static void testSlowClients()
+{
+    const int TRICKLING = 2;
+    const int STALLED = 2;
+    const int REQUESTS = 100;
+    uint16_t port = NetClient::freePort();
+    ESP8266WebServer server(port);
+    int aborted = 0;
+    server.on("/ping", HTTP_GET, [&server]() {
+        server.send(200, "text/plain", "pong");
+    });
+    server.on("/upload", HTTP_POST, [&server]() {
+        server.send(200, "text/plain", "done");
+    }, [&server, &aborted]() {
+        aborted += server.upload().status == UPLOAD_FILE_ABORTED;
+    });
+    server.begin();
+
+    std::vector<double> latencies;
+    std::vector<double> dropped(STALLED, 0);
+    int failures = 0;
+    serve(server, [&]() {
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> slow;
+        for (int i = 0; i < TRICKLING; i++) {
+            slow.emplace_back([&]() {
+                NetClient net;
+                std::string request = "GET /ping HTTP/1.1\r\nHost: esp3d\r\n\r\n";
+                std::string body;
+                while (!stop && net.connect(port)) {
+                    for (size_t c = 0; c < request.size() && !stop; c++) {
+                        net.send(request.substr(c, 1));
+                        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    }
+                    net.readResponse(body, 5000, port);
+                }
+            });
+        }
+        for (int i = 0; i < STALLED; i++) {
+            slow.emplace_back([&, i]() {
+                NetClient net;
+                net.connect(port);
+                double start = now();
+                net.send(UPLOAD_HEAD + std::string(1000, 'G'));
+                // nothing more is sent, wait for the server to close
+                while (net.receive(5000)) {
+                }
+                dropped[i] = now() - start;
+            });
+        }
+        // let the uploads reach the file data
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        NetClient net;
+        std::string body;
+        net.connect(port);
+        for (int i = 0; i < REQUESTS; i++) {
+            double start = now();
+            net.send("GET /ping HTTP/1.1\r\nHost: esp3d\r\n\r\n");
+            if (net.readResponse(body, 5000, port) != 200 || body != "pong") {
+                failures++;
+                net.connect(port);
+            }
+            latencies.push_back(now() - start);
+        }
+        stop = true;
+        for (std::thread &t : slow) {
+            t.join();
+        }
+    });
+
+    std::sort(latencies.begin(), latencies.end());
+    double p50 = latencies[latencies.size() / 2];
+    double p99 = latencies[latencies.size() * 99 / 100];
+    double worst = latencies.back();
+    printf("fast client latency p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", p50 * 1e3, p99 * 1e3, worst * 1e3);
+    CHECK_EQUAL(0, failures);
+    // the stalled uploads are waited for one after the other, nothing else
+    CHECK(p50 < 0.05);
+    CHECK(worst < STALLED * HTTP_MAX_POST_WAIT / 1000.0 + 1);
+    CHECK_EQUAL(STALLED, aborted);
+    for (double t : dropped) {
+        CHECK(t > 0 && t < STALLED * HTTP_MAX_POST_WAIT / 1000.0 + 1);
+    }
+}
+
+
+int main()
+{
+    testSplitHead();
+    testHeadTooLarge();
+    testBodyTooLarge();
+    testContentTypeCase();
+    testUploadSplitBoundary();
+    testSlowClients();
+    return TEST_RESULT();
+}